@@ -23,10 +23,34 @@
 
 #include <functional>
 #include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
 
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "schnorr.h"
+#include "pool.h"
+#include "wire.h"
+#include "logger.h"
+#include "noncepool.h"
+#include "ecschnorr.h"
+#include "keyring.h"
+#include "sigd.h"
+#include "sigclient.h"
+#include "shmring.h"
+#include "musig.h"
+#include "halfagg.h"
+#include "paramgen.h"
 using namespace EE488;
 
 #define __msg_out(X)    std::cout << (X)
@@ -39,9 +63,17 @@ private:
     std::string name;               // Who am I?
     SchnorrSignature sig_manager;   // Signature Manager
 
+    std::vector<unsigned char> inbox;   // Last received record, wire format
+
+    std::unique_ptr<msig_t> musig;      // Co-signing session, if any
+
     /* Rx */
     int rx_signature();
     int rx_pgq();
+    int rx_pk();
+
+    int rx_musig_nonce(const size_t);
+    int rx_musig_partial(const size_t);
 
 public:
     Communicator(const char* arg_name) : name(arg_name) {}
@@ -62,29 +94,226 @@ public:
 
     /* Setter */
     int set_toy(bool arg_toy) { return sig_manager.set_toy(arg_toy); }
+    int set_deterministic(bool arg_det) { return sig_manager.set_deterministic(arg_det); }
+    int set_curve(const int arg_nid) { return sig_manager.set_curve(arg_nid); }
 
-    /* Tx */
+    /* Tx
+     *  Records are encoded into the inbox of the receiver, which parses them 
+     *  back. Nothing but the bytes crosses over. */
     void tx_signature(Communicator& arg_to) {
-        arg_to.get_manager().set_signature_pair(
-            const_cast<BIGNUM*>(sig_manager.get_signature_s()),
-            const_cast<BIGNUM*>(sig_manager.get_signature_e())
-        );
+        const size_t w = get_sig_width(sig_manager.get_q());
+
+        arg_to.inbox.resize(get_sig_len(w));
+        do_encode_sig(arg_to.inbox.data(), arg_to.inbox.size(), 
+            sig_manager.get_signature_s(), sig_manager.get_signature_e(), w);
+
+        arg_to.rx_signature();
     };
 
     void tx_pqg(Communicator& arg_to) {
-        arg_to.get_manager().set_pqg(
-            const_cast<BIGNUM*>(sig_manager.get_p()),
-            const_cast<BIGNUM*>(sig_manager.get_q()),
-            const_cast<BIGNUM*>(sig_manager.get_g())
-        );
+        arg_to.inbox.resize(get_pqg_len(
+            get_pk_width(sig_manager.get_p()), BN_num_bytes(sig_manager.get_q())));
+        do_encode_pqg(arg_to.inbox.data(), arg_to.inbox.size(), 
+            sig_manager.get_p(), sig_manager.get_q(), sig_manager.get_g());
+
+        arg_to.rx_pgq();
     };
 
     void tx_pk(Communicator& arg_to) {
-        arg_to.get_manager().set_pk(
-            const_cast<BIGNUM*>(sig_manager.get_pk()));
+        const size_t w = get_pk_width(sig_manager.get_p());
+
+        arg_to.inbox.resize(get_pk_len(w));
+        do_encode_pk(arg_to.inbox.data(), arg_to.inbox.size(), sig_manager.get_pk(), w);
+
+        arg_to.rx_pk();
+    }
+
+    /* Tx over a ShmRing, between processes
+     *  A signature record is encoded straight into the next slot, the ring
+     *  of get_sig_len(w) records. The receiver parses it in its slot. Both
+     *  block only while the ring is full or empty. -1 when full and the
+     *  receiver closed, or after the timeout in ms. */
+    int tx_signature(shmring_t& arg_ring, const long arg_timeout_ms = 0) {
+        const size_t w = get_sig_width(sig_manager.get_q());
+
+        if (get_sig_len(w) != arg_ring.get_record_len() ||
+            arg_ring.do_wait_writable(arg_timeout_ms) == 0)
+            return -1;
+
+        if (do_encode_sig(arg_ring.get_slot(0), get_sig_len(w),
+            sig_manager.get_signature_s(), sig_manager.get_signature_e(), w) < 0)
+            return -1;
+
+        arg_ring.do_commit(1);
+        return 0;
+    }
+
+    int rx_signature(shmring_t& arg_ring) {
+        WireSigView view;
+        bnw_t sig_s, sig_e;
+
+        if (arg_ring.do_wait_readable() == 0)
+            return -1;      // Finished
+
+        const int ret_code = (do_parse_sig(arg_ring.get_record(0), arg_ring.get_record_len(), view) < 0 ||
+            do_load_sig(view, sig_s.actor, sig_e.actor) != 0) ? -1 : 0;
+
+        arg_ring.do_release(1);
+
+        if (ret_code == 0)
+            sig_manager.set_signature_pair(sig_s.actor, sig_e.actor);
+
+        return ret_code;
+    }
+
+    /* MuSig, refer to musig.h
+     *  Co-signers of one (p, q, g), each keyed by do_keygen_pqg, list the
+     *  pks of all in one order. Round 1 sends (R1, R2) as two pk records,
+     *  round 2 the partial s_i with e as a signature record. The receiver
+     *  takes them at the index of the sender. musig_finish leaves the
+     *  aggregate (s, e) as the signature, for tx_signature. */
+    int musig_begin(const std::vector<const BIGNUM*>& arg_pks) {
+        musig = std::make_unique<msig_t>(sig_manager.do_export_key(), arg_pks.data(), arg_pks.size());
+        return (musig->get_self() < musig->get_nsigners()) ? 0 : -1;
+    }
+
+    int musig_nonce() {
+        bnw_t r1, r2;
+        return musig->do_nonce_gen(r1.actor, r2.actor);
+    }
+
+    int musig_sign(const int arg_nbits) {
+        bnw_t s;
+        return musig->do_partial_sign(sig_manager.get_mstr(),
+            std::strlen(reinterpret_cast<const char*>(sig_manager.get_mstr())), s.actor, arg_nbits);
+    }
+
+    int musig_finish() {
+        bnw_t s, e;
+
+        if (musig->do_aggregate(s.actor, e.actor) != 0)
+            return -1;
+
+        sig_manager.set_signature_pair(s.actor, e.actor);
+        return 0;
+    }
+
+    /* The aggregate of the pks as own pk, for a verifier of the domain. */
+    int musig_key(const std::vector<const BIGNUM*>& arg_pks) {
+        const sdm_t domain(sig_manager.get_p(), sig_manager.get_q(), sig_manager.get_g(), sig_manager.is_toy(), 0);
+        bnw_t agg;
+
+        if (do_musig_key_agg(agg.actor, nullptr, domain, arg_pks.data(), arg_pks.size()) != 0)
+            return -1;
+
+        sig_manager.set_pk(agg.actor);
+        return 0;
+    }
+
+    int tx_musig_nonce(Communicator& arg_to) {
+        const size_t self = musig->get_self();
+        const size_t w = get_pk_width(sig_manager.get_p());
+        const size_t len = get_pk_len(w);
+
+        arg_to.inbox.resize(2 * len);
+        do_encode_pk(arg_to.inbox.data(), len, musig->get_r1(self), w);
+        do_encode_pk(arg_to.inbox.data() + len, len, musig->get_r2(self), w);
+
+        return arg_to.rx_musig_nonce(self);
+    }
+
+    int tx_musig_partial(Communicator& arg_to) {
+        const size_t self = musig->get_self();
+        const size_t w = get_sig_width(sig_manager.get_q());
+
+        arg_to.inbox.resize(get_sig_len(w));
+        do_encode_sig(arg_to.inbox.data(), arg_to.inbox.size(),
+            musig->get_partial(self), musig->get_challenge(), w);
+
+        return arg_to.rx_musig_partial(self);
     }
+
+    const msig_t* get_musig() const { return musig.get(); }
 };
 
+/*
+ * Communicator Rx
+ */
+int Communicator::rx_signature() {
+    WireSigView view;
+    bnw_t sig_s, sig_e;
+
+    if (do_parse_sig(inbox.data(), inbox.size(), view) < 0 ||
+        do_load_sig(view, sig_s.actor, sig_e.actor) != 0)
+        return -1;
+
+    sig_manager.set_signature_pair(sig_s.actor, sig_e.actor);
+    return 0;
+}
+
+
+
+int Communicator::rx_pgq() {
+    WirePqgView view;
+    bnw_t p, q, g;
+
+    if (do_parse_pqg(inbox.data(), inbox.size(), view) < 0 ||
+        do_load_pqg(view, p.actor, q.actor, g.actor) != 0)
+        return -1;
+
+    sig_manager.set_pqg(p.actor, q.actor, g.actor);
+    return 0;
+}
+
+
+
+int Communicator::rx_pk() {
+    WirePkView view;
+    bnw_t pk;
+
+    if (do_parse_pk(inbox.data(), inbox.size(), view) < 0 ||
+        do_load_pk(view, pk.actor) != 0)
+        return -1;
+
+    sig_manager.set_pk(pk.actor);
+    return 0;
+}
+
+
+
+int Communicator::rx_musig_nonce(const size_t arg_from) {
+    const size_t len = inbox.size() / 2;
+    WirePkView view1, view2;
+    bnw_t r1, r2;
+
+    if (musig == nullptr ||
+        do_parse_pk(inbox.data(), len, view1) < 0 || do_load_pk(view1, r1.actor) != 0 ||
+        do_parse_pk(inbox.data() + len, len, view2) < 0 || do_load_pk(view2, r2.actor) != 0)
+        return -1;
+
+    return musig->set_nonce(arg_from, r1.actor, r2.actor);
+}
+
+
+
+int Communicator::rx_musig_partial(const size_t arg_from) {
+    WireSigView view;
+    bnw_t s_i, e;
+
+    if (musig == nullptr ||
+        do_parse_sig(inbox.data(), inbox.size(), view) < 0 ||
+        do_load_sig(view, s_i.actor, e.actor) != 0)
+        return -1;
+
+    /* Of another challenge, thus of another message or nonces. */
+    if (BN_cmp(e.actor, musig->get_challenge()) != 0)
+        return -1;
+
+    return musig->set_partial(arg_from, s_i.actor);
+}
+
+
+
 /*
  * Test functions
  */
@@ -99,11 +328,36 @@ void __test_sig_and_verify_1024_success();
 void __test_self_sign_and_verify_small_toy();
 void __test_self_sign_and_verify_large_toy();
 void __test_sig_and_verify_2048_success();
+void __test_batch_verify_1024();
+void __test_stream_sign_and_verify();
+void __test_shared_key_threads();
+void __test_batch_sign_pool();
+void __test_zero_alloc_sign_verify();
+void __test_wire_bulk();
+void __test_stats_stages();
+void __test_async_logger();
+void __test_nonce_pool_sign();
+void __test_deterministic_nonce();
+void __test_ec_sign_and_verify();
+void __test_fixed_mont();
+void __test_batch_challenge();
+void __test_registered_midstate();
+void __test_compact_verifier();
+void __test_keyring_mmap();
+void __test_verify_cache();
+void __test_sign_daemon();
+void __test_shm_ring();
+void __test_musig();
+void __test_half_agg();
+void __test_param_race();
 
 /* main
  */
 int main() {
 
+    /* Before any OpenSSL allocation. */
+    do_install_alloc_counter();
+
     __msg_out("[EE488] HW5, Author: SukJoon Oh\n");
 
     testf = std::vector<__test_func__>{
@@ -116,7 +370,29 @@ int main() {
         __test_sig_and_verify_1024_success,
         __test_self_sign_and_verify_small_toy,
         __test_self_sign_and_verify_large_toy,
-        __test_sig_and_verify_2048_success
+        __test_sig_and_verify_2048_success,
+        __test_batch_verify_1024,
+        __test_stream_sign_and_verify,
+        __test_shared_key_threads,
+        __test_batch_sign_pool,
+        __test_zero_alloc_sign_verify,
+        __test_wire_bulk,
+        __test_stats_stages,
+        __test_async_logger,
+        __test_nonce_pool_sign,
+        __test_deterministic_nonce,
+        __test_ec_sign_and_verify,
+        __test_fixed_mont,
+        __test_batch_challenge,
+        __test_registered_midstate,
+        __test_compact_verifier,
+        __test_keyring_mmap,
+        __test_verify_cache,
+        __test_sign_daemon,
+        __test_shm_ring,
+        __test_musig,
+        __test_half_agg,
+        __test_param_race
 
     };
     
@@ -527,4 +803,2535 @@ void __test_sig_and_verify_2048_success() {
     
     if (rc) __msg_out("> Not verified, Failed.\n");
     else    __msg_out("> Verified, OK.\n");
-}
\ No newline at end of file
+}
+
+
+/* 
+ * __test_batch_verify_1024
+ */
+void __test_batch_verify_1024() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Alice signs several messages, and ships the commitment r along
+     * with each (s, e). Bob checks all of them at once with do_batch_verify.
+     * One of the messages Bob holds is not the one Alice signed, one s is
+     * off by one, and one signature comes without r. The batch should point
+     * out exactly the tampered ones. Then Alice sends r' = p - g^k, hashed 
+     * into e, which do_verify refuses. The batch should refuse it as well,
+     * whatever the weights.
+     * 
+     * Once on a DSA domain of do_keygen, verified one by one, and once on
+     * p = 2qk + 1 with a prime k, where the batch runs.
+     */
+
+    const int promised_bit_l = 1024;
+    const int nsigs = 8;
+    const int bad_idx = 5;
+    const int bad_s_idx = 3;
+
+    auto run_batch = [&](Communicator& alice, Communicator& bob) {
+        std::vector<std::string> msgs;
+        std::vector<bnw_t> sigs_s(nsigs), sigs_e(nsigs), sigs_r(nsigs);
+
+        for (int i = 0; i < nsigs; i++) {
+            msgs.push_back("batch message " + std::to_string(i));
+
+            alice.prepare_msg(msgs.back().c_str());
+            alice.generate_sig(promised_bit_l);
+
+            BN_copy(sigs_s[i].actor, alice.get_manager().get_signature_s());
+            BN_copy(sigs_e[i].actor, alice.get_manager().get_signature_e());
+            BN_copy(sigs_r[i].actor, alice.get_manager().get_signature_r());
+        }
+
+        msgs[bad_idx] = "tampered message";
+
+        BN_add_word(sigs_s[bad_s_idx].actor, 1);
+        BN_nnmod(sigs_s[bad_s_idx].actor, sigs_s[bad_s_idx].actor, alice.get_manager().get_q(), get_thread_ctx());
+
+        std::vector<SchnorrBatchItem> items;
+        for (int i = 0; i < nsigs; i++) {
+            items.push_back(SchnorrBatchItem{
+                alice.get_manager().get_pk(),
+                reinterpret_cast<const unsigned char*>(msgs[i].c_str()),
+                msgs[i].length(),
+                sigs_s[i].actor,
+                sigs_e[i].actor,
+                (i == 0) ? nullptr : sigs_r[i].actor
+            });
+        }
+
+        std::vector<int> results;
+        int rc = bob.get_manager().do_batch_verify(items, results, promised_bit_l);
+
+        std::cout << "  Bob is verifying " << nsigs << " signatures in a batch\n";
+
+        bool ok = (rc == 2);
+        for (int i = 0; i < nsigs; i++)
+            ok = ok && (results[i] == ((i == bad_idx || i == bad_s_idx) ? 1 : 0));
+
+        /* s = k + x * e, e = H(m || r'), r' = p - g^k of order 2q. */
+        const skey_t alice_key = alice.get_manager().do_export_key();
+        const std::string forged_msg = "forged message";
+
+        bnw_t k, r, e, s;
+        SHA256_CTX sha_context;
+
+        do_rand_nonce(k.actor, alice_key.get_domain()->get_q(), get_thread_ctx());
+        alice_key.get_domain()->do_gexp(r.actor, k.actor, get_thread_ctx());
+        BN_sub(r.actor, alice_key.get_domain()->get_p(), r.actor);
+
+        SHA256_Init(&sha_context);
+        SHA256_Update(&sha_context, forged_msg.c_str(), forged_msg.length());
+        do_challenge_final(e.actor, &sha_context, r.actor, alice_key.get_domain()->get_p(), false, promised_bit_l, nullptr);
+        alice_key.do_respond(s.actor, k.actor, e.actor, get_thread_ctx());
+
+        ok = ok && (alice_key.do_verify(
+            reinterpret_cast<const unsigned char*>(forged_msg.c_str()), forged_msg.length(), 
+            s.actor, e.actor, promised_bit_l) != 0);
+
+        std::vector<SchnorrBatchItem> forged_items = { items[1], items[2] };
+        forged_items.push_back(SchnorrBatchItem{
+            alice.get_manager().get_pk(),
+            reinterpret_cast<const unsigned char*>(forged_msg.c_str()),
+            forged_msg.length(),
+            s.actor, e.actor, r.actor
+        });
+
+        /* An even weight of r' passed the batch half of the time. */
+        for (int run = 0; run < 32; run++) {
+            rc = bob.get_manager().do_batch_verify(forged_items, results, promised_bit_l);
+            ok = ok && (rc == 1) && (results[0] == 0) && (results[1] == 0) && (results[2] == 1);
+        }
+
+        return ok;
+    };
+
+    Communicator alice("Alice");
+    Communicator bob("Bob");
+
+    alice.prepare_key(promised_bit_l, 0);
+    alice.tx_pqg(bob);
+
+    bool ok = !bob.get_manager().do_batch_safe() && run_batch(alice, bob);
+
+    /* (p - 1) / 2q is a prime of 863 bits. */
+    Communicator carol("Carol");
+    Communicator dave("Dave");
+    bnw_t p, q, g;
+
+    BN_hex2bn(&p.actor, 
+        "E2C445325AECEC03ECA4900BA1185D8F5D51D544F8792DB82B990A416F588A34"
+        "F4BD01BAD1FC082A056CA873C638746785C7CBB23AAB75A2D6388C67CDCD8910"
+        "6FCF07E5657F4F86EBEF55430390414458A4418B1C69F7BC0380F4970D55B7A0"
+        "6DF00D95ABD1AB24F4F015C616FAF94B00B71F0D2A39A463A0E96FF6F652437B");
+    BN_hex2bn(&q.actor, "FDDB6E615FA190A814B5593FBCB322F7B85F6187");
+    BN_hex2bn(&g.actor, 
+        "4F2A052F86A7027B61F48BE66CA70A98A3E794FA1CE0AAE65927AEA240ACD1A9"
+        "B0D2F6D6123790C071281C7F525F6F408DFB84C163597843FAEBDE44E27D7D2E"
+        "C2201B6743F7FF39A228BAFB6693241792CDD780DF085B61B070503F8CA8658F"
+        "E59203885403C399AA38DEB3281D1A715CFA59FC74EC9EE40F13802B6618C3ED");
+
+    carol.get_manager().set_pqg(p.actor, q.actor, g.actor);
+    carol.get_manager().do_keygen_pqg();
+    carol.tx_pqg(dave);
+
+    ok = ok && dave.get_manager().do_batch_safe() && run_batch(carol, dave);
+
+    if (ok) __msg_out("> Tampered ones found, OK.\n");
+    else    __msg_out("> Batch result mismatch, Failed.\n");
+}
+
+
+
+/* 
+ * __test_stream_sign_and_verify
+ */
+void __test_stream_sign_and_verify() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* The message here is larger than MAX_SLEN, and has zero bytes in it.
+     * Thus it cannot be registered by prepare_msg. Alice and Bob feed it
+     * chunk by chunk with the streaming interface instead.
+     * 
+     * A streamed short message should also be verified by the ordinary
+     * do_regmsg/do_verify path, and a pre-hashed digest likewise.
+     */
+
+    const int promised_bit_l = 1024;
+    const size_t chunk_len = 4096;
+
+    std::vector<unsigned char> large_msg(4 * MAX_SLEN);
+    for (size_t i = 0; i < large_msg.size(); i++)
+        large_msg[i] = static_cast<unsigned char>(i % 251);
+
+    Communicator alice("Alice");
+    Communicator bob("Bob");
+
+    alice.prepare_key(promised_bit_l, 0);
+    alice.tx_pqg(bob);
+    alice.tx_pk(bob);
+
+    auto feed = [&](SchnorrSignature& arg_manager) {
+        arg_manager.do_stream_init();
+        for (size_t off = 0; off < large_msg.size(); off += chunk_len)
+            arg_manager.do_stream_update(
+                &large_msg[off], std::min(chunk_len, large_msg.size() - off));
+    };
+
+    feed(alice.get_manager());
+    alice.get_manager().do_sign_final(promised_bit_l);
+    alice.tx_signature(bob);
+
+    feed(bob.get_manager());
+    int rc = bob.get_manager().do_verify_final(promised_bit_l);
+
+    if (rc) __msg_out("> Large message not verified, Failed.\n");
+    else    __msg_out("> Large message verified, OK.\n");
+
+    /* Streamed, then verified as a registered message. */
+    const char* msg_1 = "message 1";
+
+    alice.get_manager().do_stream_init();
+    alice.get_manager().do_stream_update(msg_1, 4);
+    alice.get_manager().do_stream_update(msg_1 + 4, std::strlen(msg_1) - 4);
+    alice.get_manager().do_sign_final(promised_bit_l);
+    alice.tx_signature(bob);
+
+    bob.prepare_msg(msg_1);
+    rc = bob.run_verify(promised_bit_l);
+
+    if (rc) __msg_out("> Streamed message not verified by do_verify, Failed.\n");
+    else    __msg_out("> Streamed message verified by do_verify, OK.\n");
+
+    /* Pre-hashed, Bob holds a different digest. */
+    unsigned char digest[SHA256_DIGEST_LENGTH] = { 0, };
+    SHA256(large_msg.data(), large_msg.size(), digest);
+
+    alice.get_manager().do_stream_digest(digest, sizeof(digest));
+    alice.get_manager().do_sign_final(promised_bit_l);
+    alice.tx_signature(bob);
+
+    digest[0] ^= 0x01;
+    bob.get_manager().do_stream_digest(digest, sizeof(digest));
+    rc = bob.get_manager().do_verify_final(promised_bit_l);
+
+    if (rc) __msg_out("> Wrong digest not verified, OK.\n");
+    else    __msg_out("> Wrong digest verified, Failed.\n");
+}
+
+
+
+/* 
+ * __test_shared_key_threads
+ */
+void __test_shared_key_threads() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Alice exports her key once, and several threads sign and verify
+     * with the very same SchnorrKey at the same time, without a lock.
+     * Bob holds the public half only. Each thread also checks that a 
+     * signature over a different message is refused.
+     */
+
+    const int promised_bit_l = 1024;
+    const int nthreads = 4;
+    const int nrounds = 25;
+
+    Communicator alice("Alice");
+    alice.prepare_key(promised_bit_l, 0);
+
+    const skey_t alice_key = alice.get_manager().do_export_key();
+    const skey_t bob_key = alice.get_manager().do_export_key(false);
+
+    std::atomic<int> nfails(0);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < nthreads; t++) {
+        workers.emplace_back([&, t]() {
+            bnw_t sig_s, sig_e;
+
+            for (int i = 0; i < nrounds; i++) {
+                std::string msg = "thread " + std::to_string(t) + " message " + std::to_string(i);
+                std::string other = msg + "!";
+
+                auto pmsg = reinterpret_cast<const unsigned char*>(msg.c_str());
+                auto pother = reinterpret_cast<const unsigned char*>(other.c_str());
+
+                if (alice_key.do_sign(pmsg, msg.length(), sig_s.actor, sig_e.actor, promised_bit_l) != 0 ||
+                    bob_key.do_verify(pmsg, msg.length(), sig_s.actor, sig_e.actor, promised_bit_l) != 0 ||
+                    bob_key.do_verify(pother, other.length(), sig_s.actor, sig_e.actor, promised_bit_l) != 1)
+                    nfails++;
+            }
+        });
+    }
+
+    for (auto& w: workers) w.join();
+
+    /* Should also match the instance interface. */
+    const char* msg_1 = "message 1";
+    bnw_t sig_s, sig_e;
+
+    alice_key.do_sign(
+        reinterpret_cast<const unsigned char*>(msg_1), std::strlen(msg_1), 
+        sig_s.actor, sig_e.actor, promised_bit_l);
+
+    alice.get_manager().set_signature_pair(sig_s.actor, sig_e.actor);
+    alice.prepare_msg(msg_1);
+    
+    if (alice.run_verify(promised_bit_l) != 0) nfails++;
+
+    if (nfails) __msg_out("> Shared key failed, Failed.\n");
+    else    __msg_out("> Shared key among threads, OK.\n");
+}
+
+
+
+/* 
+ * __test_batch_sign_pool
+ */
+void __test_batch_sign_pool() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Alice signs a large batch of log records at once with 
+     * do_batch_sign, spread over a work-stealing pool. Bob verifies every
+     * signature, all of them in a single do_batch_verify with the r's.
+     */
+
+    const int promised_bit_l = 1024;
+    const size_t nmsgs = 200;
+
+    Communicator alice("Alice");
+    Communicator bob("Bob");
+
+    alice.prepare_key(promised_bit_l, 0);
+    alice.tx_pqg(bob);
+
+    const skey_t alice_key = alice.get_manager().do_export_key();
+
+    std::vector<std::string> records;
+    for (size_t i = 0; i < nmsgs; i++)
+        records.push_back("log record #" + std::to_string(i));
+
+    std::vector<std::string_view> views(records.begin(), records.end());
+    std::vector<ssig_t> sigs(nmsgs);
+
+    ThreadPool pool(4);
+    int rc = alice_key.do_batch_sign(views.data(), nmsgs, sigs.data(), promised_bit_l, &pool);
+
+    std::vector<SchnorrBatchItem> items;
+    for (size_t i = 0; i < nmsgs; i++) {
+        items.push_back(SchnorrBatchItem{
+            alice_key.get_pk(),
+            reinterpret_cast<const unsigned char*>(records[i].c_str()),
+            records[i].length(),
+            sigs[i].s.actor,
+            sigs[i].e.actor,
+            sigs[i].r.actor
+        });
+    }
+
+    std::vector<int> results;
+    rc += bob.get_manager().do_batch_verify(items, results, promised_bit_l);
+
+    std::cout << "  Alice signed " << nmsgs << " records over " << pool.get_nthreads() << " threads\n";
+
+    if (rc) __msg_out("> Batch signatures not verified, Failed.\n");
+    else    __msg_out("> Batch signatures verified, OK.\n");
+}
+
+
+
+/*
+ * __test_zero_alloc_sign_verify
+ */
+void __test_zero_alloc_sign_verify() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* After the first round warms up the scratch of this thread, 
+     * signing and verifying should not touch the heap anymore.
+     */
+
+    const int promised_bit_l = 1024;
+    const int nrounds = 32;
+
+    Communicator alice("Alice");
+    alice.prepare_key(promised_bit_l, 0);
+
+    const skey_t alice_key = alice.get_manager().do_export_key();
+
+    const char* msg_1 = "message 1";
+    auto pmsg = reinterpret_cast<const unsigned char*>(msg_1);
+    bnw_t sig_s, sig_e;
+
+    int nfails = 0;
+
+    for (int i = 0; i < 2; i++) {
+        if (alice_key.do_sign(pmsg, std::strlen(msg_1), sig_s.actor, sig_e.actor, promised_bit_l) != 0 ||
+            alice_key.do_verify(pmsg, std::strlen(msg_1), sig_s.actor, sig_e.actor, promised_bit_l) != 0)
+            nfails++;
+    }
+
+    /* Zero before here means the counter was not installed. */
+    const unsigned long nallocs = get_alloc_count();
+    if (nallocs == 0) nfails++;
+
+    for (int i = 0; i < nrounds; i++) {
+        if (alice_key.do_sign(pmsg, std::strlen(msg_1), sig_s.actor, sig_e.actor, promised_bit_l) != 0 ||
+            alice_key.do_verify(pmsg, std::strlen(msg_1), sig_s.actor, sig_e.actor, promised_bit_l) != 0)
+            nfails++;
+    }
+
+    const unsigned long ndiff = get_alloc_count() - nallocs;
+
+    std::cout << "  " << ndiff << " allocations over " << nrounds << " rounds\n";
+
+    if (nfails || ndiff) 
+        __msg_out("> Allocated in steady state, Failed.\n");
+    else    __msg_out("> Signed and verified without allocation, OK.\n");
+}
+
+
+
+/*
+ * __test_wire_bulk
+ */
+void __test_wire_bulk() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Alice ships a batch of signatures to Bob as one buffer of fixed-size
+     * records. Bob decodes all of them in place and verifies each with
+     * her public key, which came over the wire as well. Broken records
+     * should be refused.
+     */
+
+    const int promised_bit_l = 2048;
+    const size_t nmsgs = 256;
+    const int nrounds = 64;
+
+    Communicator alice("Alice");
+    Communicator bob("Bob");
+
+    alice.prepare_key(promised_bit_l, 0);
+    alice.tx_pqg(bob);
+    alice.tx_pk(bob);
+
+    const skey_t alice_key = alice.get_manager().do_export_key();
+    const skey_t bob_key = bob.get_manager().do_export_key(false);
+
+    std::vector<std::string> records;
+    for (size_t i = 0; i < nmsgs; i++)
+        records.push_back("log record #" + std::to_string(i));
+
+    std::vector<std::string_view> views(records.begin(), records.end());
+    std::vector<ssig_t> sigs(nmsgs), recv(nmsgs);
+
+    int nfails = alice_key.do_batch_sign(views.data(), nmsgs, sigs.data(), promised_bit_l, nullptr);
+
+    const size_t w = get_sig_width(alice.get_manager().get_q());
+    std::vector<unsigned char> buf(get_sig_len(w) * nmsgs);
+
+    using clock = std::chrono::steady_clock;
+    auto t_begin = clock::now();
+
+    long nbytes = 0;
+    for (int i = 0; i < nrounds; i++)
+        nbytes = do_encode_sigs(buf.data(), buf.size(), sigs.data(), nmsgs, w);
+
+    auto t_mid = clock::now();
+
+    for (int i = 0; i < nrounds; i++)
+        if (do_decode_sigs(buf.data(), buf.size(), recv.data(), nmsgs) != nbytes) nfails++;
+
+    auto t_end = clock::now();
+
+    for (size_t i = 0; i < nmsgs; i++) {
+        auto pmsg = reinterpret_cast<const unsigned char*>(records[i].c_str());
+
+        if (BN_cmp(sigs[i].s.actor, recv[i].s.actor) || BN_cmp(sigs[i].e.actor, recv[i].e.actor) ||
+            bob_key.do_verify(pmsg, records[i].length(), recv[i].s.actor, recv[i].e.actor, promised_bit_l) != 0)
+            nfails++;
+    }
+
+    auto do_rate = [&](clock::duration arg_d) {
+        double sec = std::chrono::duration<double>(arg_d).count();
+        return (nbytes * nrounds) / sec / (1 << 20);
+    };
+
+    std::cout << "  " << nmsgs << " records of " << get_sig_len(w) << " bytes, encode "
+        << static_cast<long>(do_rate(t_mid - t_begin)) << " MB/s, decode " 
+        << static_cast<long>(do_rate(t_end - t_mid)) << " MB/s\n";
+
+    /* Truncated, wrong tag, wrong version */
+    WireSigView sig_view;
+    WirePkView pk_view;
+
+    if (do_parse_sig(buf.data(), get_sig_len(w) - 1, sig_view) != -1) nfails++;
+    if (do_parse_pk(buf.data(), buf.size(), pk_view) != -1) nfails++;
+
+    buf[1] = WIRE_VERSION + 1;
+    if (do_decode_sigs(buf.data(), buf.size(), recv.data(), nmsgs) != -1) nfails++;
+
+    /* Too short to hold the number */
+    unsigned char small[8];
+    if (do_encode_pk(small, sizeof(small), alice_key.get_pk(), 4) != -1) nfails++;
+
+    if (nfails) __msg_out("> Wire records broken, Failed.\n");
+    else    __msg_out("> Signatures shipped over the wire, OK.\n");
+}
+
+
+
+/*
+ * __test_stats_stages
+ */
+void __test_stats_stages() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* With __STATS, every sign and verify should be counted once, and
+     * split into its stages. Reset should clear all. Without it, the
+     * snapshot is always empty.
+     */
+
+    const int promised_bit_l = 1024;
+    const int nrounds = 50;
+
+    Communicator alice("Alice");
+    alice.prepare_key(promised_bit_l, 0);
+
+    const skey_t alice_key = alice.get_manager().do_export_key();
+
+    const char* msg_1 = "message 1";
+    auto pmsg = reinterpret_cast<const unsigned char*>(msg_1);
+    bnw_t sig_s, sig_e;
+
+    SchnorrSignature::reset_stats();
+
+    for (int i = 0; i < nrounds; i++) {
+        alice_key.do_sign(pmsg, std::strlen(msg_1), sig_s.actor, sig_e.actor, promised_bit_l);
+        alice_key.do_verify(pmsg, std::strlen(msg_1), sig_s.actor, sig_e.actor, promised_bit_l);
+    }
+    alice_key.do_verify(pmsg, std::strlen(msg_1) - 1, sig_s.actor, sig_e.actor, promised_bit_l);
+
+    StatsSnapshot snap = SchnorrSignature::get_stats();
+    int nfails = 0;
+
+    if (snap.enabled) {
+        if (snap.counters[COUNT_SIGN] != nrounds ||
+            snap.counters[COUNT_VERIFY] != nrounds + 1 ||
+            snap.counters[COUNT_VERIFY_FAIL] != 1)
+            nfails++;
+
+        for (int st: { STAGE_SIGN_NONCE, STAGE_SIGN_COMMIT, STAGE_SIGN_HASH, STAGE_SIGN_FINAL })
+            if (snap.stages[st].count != nrounds) nfails++;
+
+        if (snap.stages[STAGE_VERIFY_COMMIT].get_percentile_ns(0.5) == 0) nfails++;
+
+        for (int st = 0; st < NSTAGES; st++) {
+            if (snap.stages[st].count == 0) continue;
+
+            std::cout << "  " << get_stage_name(st) 
+                << ": n=" << snap.stages[st].count
+                << ", mean=" << static_cast<long>(snap.stages[st].get_mean_ns()) << "ns"
+                << ", p99<=" << snap.stages[st].get_percentile_ns(0.99) << "ns\n";
+        }
+
+        SchnorrSignature::reset_stats();
+        snap = SchnorrSignature::get_stats();
+
+        if (snap.counters[COUNT_SIGN] || snap.stages[STAGE_SIGN_COMMIT].count) nfails++;
+    }
+    else {
+        std::cout << "  Built without __STATS\n";
+        if (snap.counters[COUNT_SIGN] || snap.stages[STAGE_SIGN_COMMIT].count) nfails++;
+    }
+
+    if (nfails) __msg_out("> Stage statistics wrong, Failed.\n");
+    else    __msg_out("> Stage statistics counted, OK.\n");
+}
+
+
+
+/*
+ * __test_async_logger
+ */
+void __test_async_logger() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Several threads log at once into a file. Every record should end up
+     * in the file as a whole line, or be counted as dropped when the ring
+     * is full. Records below the level should not be written at all.
+     */
+
+    const char* path = "./logger-test.log";
+    const int nthreads = 4;
+    const int nrecords = 2000;
+
+    std::remove(path);
+
+    logger_t& logger = Logger::get_instance();
+    const int prev_level = get_log_level();
+    const unsigned long prev_dropped = logger.get_ndropped();
+
+    logger.do_flush();
+    logger.set_stdout(false);
+    logger.set_file(path);
+    set_log_level(LOG_DEBUG);
+
+    std::vector<std::thread> workers;
+    auto t_begin = std::chrono::steady_clock::now();
+
+    for (int t = 0; t < nthreads; t++) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < nrecords; i++) {
+                logger.do_logf(LOG_DEBUG, __FUNCTION__, "thread %d record %d", t, i);
+                do_log(LOG_TRACE, __FUNCTION__, "Below the level");
+            }
+        });
+    }
+
+    for (auto& w: workers) w.join();
+
+    auto t_end = std::chrono::steady_clock::now();
+
+    logger.do_flush();
+    logger.set_file(nullptr);
+    logger.set_stdout(true);
+    set_log_level(prev_level);
+
+    /* Count lines */
+    int nlines = 0, nbelow = 0;
+    char line[LOG_SLOT_LEN + 1];
+
+    FILE* fp = std::fopen(path, "r");
+    while (fp != nullptr && std::fgets(line, sizeof(line), fp) != nullptr) {
+        if (std::strstr(line, "Below the level")) nbelow++;
+        else if (std::strstr(line, " record ")) nlines++;
+    }
+    if (fp != nullptr) std::fclose(fp);
+
+    std::remove(path);
+
+    const unsigned long ndropped = logger.get_ndropped() - prev_dropped;
+    const double ns = std::chrono::duration<double, std::nano>(t_end - t_begin).count();
+
+    std::cout << "  " << nlines << " written, " << ndropped << " dropped, " 
+        << static_cast<long>(ns / (nthreads * nrecords)) << "ns per record\n";
+
+    if (nbelow || nlines + ndropped != static_cast<unsigned long>(nthreads * nrecords)) 
+        __msg_out("> Records lost, Failed.\n");
+    else    __msg_out("> Records written or counted, OK.\n");
+}
+
+
+
+/*
+ * __test_nonce_pool_sign
+ */
+void __test_nonce_pool_sign() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Alice fills a pool of (k, r) before a burst of signatures. During
+     * the burst every signature should come from the pool, verify, and
+     * use its own r. Latency is compared with the same key without pool.
+     */
+
+    const int promised_bit_l = 2048;
+    const size_t nmsgs = 200;
+
+    Communicator alice("Alice");
+    alice.prepare_key(promised_bit_l, 0);
+
+    skey_t alice_key = alice.get_manager().do_export_key();
+    const skey_t plain_key = alice_key;
+
+    auto pool = std::make_shared<npool_t>(alice_key.share_domain(), 256);
+    int nfails = alice_key.set_nonce_pool(pool);
+
+    pool->do_wait_full();
+
+    std::vector<std::string> records;
+    for (size_t i = 0; i < nmsgs; i++)
+        records.push_back("burst record #" + std::to_string(i));
+
+    std::vector<ssig_t> sigs(nmsgs);
+    std::vector<double> lat_pool, lat_plain;
+    bnw_t sig_s, sig_e;
+
+    for (size_t i = 0; i < nmsgs; i++) {
+        auto pmsg = reinterpret_cast<const unsigned char*>(records[i].c_str());
+
+        auto t_0 = std::chrono::steady_clock::now();
+        if (alice_key.do_sign(pmsg, records[i].length(), 
+            sigs[i].s.actor, sigs[i].e.actor, promised_bit_l, sigs[i].r.actor) != 0)
+            nfails++;
+        auto t_1 = std::chrono::steady_clock::now();
+        plain_key.do_sign(pmsg, records[i].length(), sig_s.actor, sig_e.actor, promised_bit_l);
+        auto t_2 = std::chrono::steady_clock::now();
+
+        lat_pool.push_back(std::chrono::duration<double, std::micro>(t_1 - t_0).count());
+        lat_plain.push_back(std::chrono::duration<double, std::micro>(t_2 - t_1).count());
+    }
+
+    for (size_t i = 0; i < nmsgs; i++) {
+        auto pmsg = reinterpret_cast<const unsigned char*>(records[i].c_str());
+
+        if (plain_key.do_verify(pmsg, records[i].length(), 
+            sigs[i].s.actor, sigs[i].e.actor, promised_bit_l) != 0)
+            nfails++;
+    }
+
+    /* No r twice */
+    std::sort(sigs.begin(), sigs.end(), [](const ssig_t& a, const ssig_t& b) {
+        return BN_cmp(a.r.actor, b.r.actor) < 0; });
+
+    for (size_t i = 1; i < nmsgs; i++)
+        if (BN_cmp(sigs[i - 1].r.actor, sigs[i].r.actor) == 0) nfails++;
+
+    if (pool->get_nhits() != nmsgs || pool->get_nmisses() != 0) nfails++;
+
+    /* Other domain refused */
+    Communicator bob("Bob");
+    bob.prepare_key(1024, 0);
+    skey_t bob_key = bob.get_manager().do_export_key();
+
+    if (bob_key.set_nonce_pool(pool) != -1) nfails++;
+
+    /* A pool used less than half is filled up again on request. */
+    {
+        npool_t partial(alice_key.share_domain(), 16);
+        bnw_t k, r;
+
+        partial.do_wait_full();
+
+        for (int i = 0; i < 3; i++)
+            if (partial.do_take(k.actor, r.actor, get_thread_ctx()) != 0) nfails++;
+
+        partial.do_wait_full();
+
+        if (partial.get_size() != partial.get_capacity() || partial.get_nmisses() != 0) nfails++;
+    }
+
+    std::sort(lat_pool.begin(), lat_pool.end());
+    std::sort(lat_plain.begin(), lat_plain.end());
+
+    std::cout << "  p50/p99 with pool " 
+        << static_cast<int>(lat_pool[nmsgs / 2]) << "/" << static_cast<int>(lat_pool[nmsgs * 99 / 100]) 
+        << "us, without " 
+        << static_cast<int>(lat_plain[nmsgs / 2]) << "/" << static_cast<int>(lat_plain[nmsgs * 99 / 100]) << "us\n";
+
+    if (nfails) __msg_out("> Pooled signatures wrong, Failed.\n");
+    else    __msg_out("> Pooled signatures verified, OK.\n");
+}
+
+
+
+/*
+ * __test_deterministic_nonce
+ */
+void __test_deterministic_nonce() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* k should match the vectors of RFC 6979, A.2.1 (DSA, 1024 bits, 
+     * SHA-256). Then a deterministic key signs the same message to the 
+     * same (s, e) every time, through all three interfaces. On a toy 
+     * domain, whose e is cut by bitn, two bitn should give two k, else 
+     * (s_1 - s_2) / (e_1 - e_2) would be sk. A q over NONCE_MAX_BYTES 
+     * should refuse the deterministic nonce, and sign nothing rather than
+     * s = x * e.
+     */
+
+    int nfails = 0;
+
+    {
+        BIGNUM* q = nullptr;
+        BIGNUM* x = nullptr;
+        BIGNUM* expect = nullptr;
+        bnw_t k;
+
+        BN_hex2bn(&q, "996F967F6C8E388D9E28D01E205FBA957A5698B1");
+        BN_hex2bn(&x, "411602CB19A6CCC34494D79D98EF1E7ED5AF25F7");
+
+        const char* vectors[][2] = {
+            { "sample", "519BA0546D0C39202A7D34D7DFA5E760B318BCFB" },
+            { "test",   "5A67592E8128E03A417B0484410FB72C0B630E1A" }
+        };
+
+        for (auto& v: vectors) {
+            unsigned char h1[SHA256_DIGEST_LENGTH];
+            SHA256(reinterpret_cast<const unsigned char*>(v[0]), std::strlen(v[0]), h1);
+
+            BN_hex2bn(&expect, v[1]);
+
+            if (do_derive_nonce(k.actor, q, x, h1, sizeof(h1), get_thread_ctx()) != 0 ||
+                BN_cmp(k.actor, expect) != 0)
+                nfails++;
+        }
+
+        BN_free(q), BN_free(x), BN_free(expect);
+    }
+
+    const int promised_bit_l = 1024;
+    const char* msg_1 = "message 1";
+    const char* msg_2 = "message 2";
+
+    Communicator alice("Alice");
+    alice.set_deterministic(true);
+    alice.prepare_key(promised_bit_l, 0);
+
+    const skey_t alice_key = alice.get_manager().do_export_key();
+    auto pmsg = reinterpret_cast<const unsigned char*>(msg_1);
+
+    bnw_t s_1, e_1, s_2, e_2;
+
+    alice_key.do_sign(pmsg, std::strlen(msg_1), s_1.actor, e_1.actor, promised_bit_l);
+    alice_key.do_sign(pmsg, std::strlen(msg_1), s_2.actor, e_2.actor, promised_bit_l);
+
+    if (!alice_key.is_deterministic() ||
+        BN_cmp(s_1.actor, s_2.actor) || BN_cmp(e_1.actor, e_2.actor) ||
+        alice_key.do_verify(pmsg, std::strlen(msg_1), s_1.actor, e_1.actor, promised_bit_l) != 0)
+        nfails++;
+
+    /* Instance, same (s, e) */
+    alice.prepare_msg(msg_1);
+    alice.generate_sig(promised_bit_l);
+
+    if (BN_cmp(s_1.actor, alice.get_manager().get_signature_s()) ||
+        BN_cmp(e_1.actor, alice.get_manager().get_signature_e()))
+        nfails++;
+
+    /* Streamed in two chunks, same (s, e) */
+    SchnorrSignature& manager = alice.get_manager();
+    manager.do_stream_init();
+    manager.do_stream_update(msg_1, 4);
+    manager.do_stream_update(msg_1 + 4, std::strlen(msg_1) - 4);
+    manager.do_sign_final(promised_bit_l);
+
+    if (BN_cmp(s_1.actor, manager.get_signature_s()) ||
+        BN_cmp(e_1.actor, manager.get_signature_e()))
+        nfails++;
+
+    /* Other message, other signature */
+    alice_key.do_sign(reinterpret_cast<const unsigned char*>(msg_2), std::strlen(msg_2), 
+        s_2.actor, e_2.actor, promised_bit_l);
+
+    if (BN_cmp(e_1.actor, e_2.actor) == 0) nfails++;
+
+    /* Toy, "hello" at bitn 16 and 20 */
+    {
+        Communicator dave("Dave");
+        dave.set_toy(true);
+        dave.set_deterministic(true);
+        dave.prepare_key(512, 160);
+        dave.prepare_msg("hello");
+
+        SchnorrSignature& toy = dave.get_manager();
+        const skey_t toy_key = toy.do_export_key();
+        const BIGNUM* q = toy.get_q();
+
+        auto phello = reinterpret_cast<const unsigned char*>("hello");
+        bnw_t r_16, r_20, s_16, e_16, s_20, e_20, x;
+
+        toy_key.do_sign(phello, 5, s_16.actor, e_16.actor, 16, r_16.actor);
+        toy_key.do_sign(phello, 5, s_20.actor, e_20.actor, 20, r_20.actor);
+
+        /* x = (s_16 - s_20) / (e_16 - e_20) mod q, were k the same, g^x = pk */
+        BN_mod_sub(s_2.actor, s_16.actor, s_20.actor, q, get_thread_ctx());
+        BN_mod_sub(e_2.actor, e_16.actor, e_20.actor, q, get_thread_ctx());
+        BN_mod_inverse(e_2.actor, e_2.actor, q, get_thread_ctx());
+        BN_mod_mul(x.actor, s_2.actor, e_2.actor, q, get_thread_ctx());
+
+        if (BN_cmp(r_16.actor, r_20.actor) == 0 ||
+            !BN_mod_exp(x.actor, toy.get_g(), x.actor, toy.get_p(), get_thread_ctx()) ||
+            BN_cmp(x.actor, toy.get_pk()) == 0 ||
+            toy_key.do_verify(phello, 5, s_16.actor, e_16.actor, 16) != 0 ||
+            toy_key.do_verify(phello, 5, s_20.actor, e_20.actor, 20) != 0)
+            nfails++;
+
+        /* The instance takes bitn the same way. */
+        if (toy.do_sign(16) != 0 ||
+            BN_cmp(toy.get_signature_s(), s_16.actor) || BN_cmp(toy.get_signature_e(), e_16.actor))
+            nfails++;
+    }
+
+    /* Toy of q of 520 bits, set before the keys and after. */
+    {
+        Communicator carol("Carol");
+        carol.set_toy(true);
+        carol.set_deterministic(true);
+        carol.prepare_key(640, 520);
+        carol.prepare_msg(msg_1);
+
+        SchnorrSignature& wide = carol.get_manager();
+        skey_t wide_key = wide.do_export_key();
+
+        if (wide.do_sign(16) != -1 || wide.is_sign_ready() || !BN_is_zero(wide.get_signature_s()) ||
+            wide.set_deterministic(true) || wide_key.is_deterministic() || wide_key.set_deterministic(true))
+            nfails++;
+    }
+
+    if (nfails) __msg_out("> Deterministic nonce wrong, Failed.\n");
+    else    __msg_out("> Deterministic signatures reproduced, OK.\n");
+}
+
+
+
+/*
+ * __test_ec_sign_and_verify
+ */
+void __test_ec_sign_and_verify() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Vectors 0, 1 and 3 of BIP-340 over secp256k1 should be signed to 
+     * the byte, 4 should verify, and the failure vectors 5 to 14 should 
+     * not: pk off the curve or not below p, R of odd y, negated message or
+     * s, R at infinity, r off the curve or not below p, s not below n. 
+     * The built-in multiplications should meet EC_POINT_mul for random 
+     * and edge scalars. Then Alice and Bob run the usual flow on the 
+     * curve, and a key of P-256 signs in the 64 byte form.
+     */
+
+    int nfails = 0;
+
+    auto do_hex = [](const char* arg_hex, unsigned char* arg_out) {
+        for (size_t i = 0; arg_hex[2 * i] != '\0'; i++)
+            std::sscanf(arg_hex + 2 * i, "%2hhx", &arg_out[i]);
+    };
+
+    const char* vectors[][5] = {
+        {   // sk, pk, aux, msg, sig
+            "0000000000000000000000000000000000000000000000000000000000000003",
+            "F9308A019258C31049344F85F89D5229B531C845836F99B08601F113BCE036F9",
+            "0000000000000000000000000000000000000000000000000000000000000000",
+            "0000000000000000000000000000000000000000000000000000000000000000",
+            "E907831F80848D1069A5371B402410364BDF1C5F8307B0084C55F1CE2DCA8215"
+            "25F66A4A85EA8B71E482A74F382D2CE5EBEEE8FDB2172F477DF4900D310536C0"
+        },
+        {
+            "B7E151628AED2A6ABF7158809CF4F3C762E7160F38B4DA56A784D9045190CFEF",
+            "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659",
+            "0000000000000000000000000000000000000000000000000000000000000001",
+            "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+            "6896BD60EEAE296DB48A229FF71DFE071BDE413E6D43F917DC8DCF8C78DE3341"
+            "8906D11AC976ABCCB20B091292BFF4EA897EFCB639EA871CFA95F6DE339E4B0A"
+        },
+        {
+            "0B432B2677937381AEF05BB02A66ECD012773062CF3FA2549E44F58ED2401710",
+            "25D1DFF95105F5253C4022F628A996AD3A0D95FBF21D468A1B33F8C160D8F517",
+            "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+            "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+            "7EB0509757E246F19449885651611CB965ECC1A187DD51B64FDA1EDC9637D5EC"
+            "97582B9CB13DB3933705B32BA982AF5AF25FD78881EBB32771FC5922EFC66EA3"
+        }
+    };
+
+    /* Verify only, pk, msg, sig and the result: 0, 1, or -1 for a pk off
+     *  the curve, which makes no key. */
+    const char* k1_pk = "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659";
+    const char* k1_msg = "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89";
+
+    const struct {
+        const char* pk;
+        const char* msg;
+        const char* sig;
+        int expect;
+    } verify_vectors[] = {
+        {   // 4, r of leading zeros
+            "D69C3509BB99E412E68B0FE8544E72837DFA30746D8BE2AA65975F29D22DC7B9",
+            "4DF3C3F68FCC83B27E9D42C90431A72499F17875C81A599B566C9889B9696703",
+            "00000000000000000000003B78CE563F89A0ED9414F5AA28AD0D96D6795F9C63"
+            "76AFB1548AF603B3EB45C9F8207DEE1060CB71C04E80F593060B07D28308D7F4", 0
+        },
+        {   // 5, pk not on the curve
+            "EEFDEA4CDB677750A420FEE807EACF21EB9898AE79B9768766E4FAA04A2D4A34", k1_msg,
+            "6CFF5C3BA86C69EA4B7376F31A9BCB4F74C1976089B2D9963DA2E5543E177769"
+            "69E89B4C5564D00349106B8497785DD7D1D713A8AE82B32FA79D5F7FC407D39B", -1
+        },
+        {   // 6, R of odd y
+            k1_pk, k1_msg,
+            "FFF97BD5755EEEA420453A14355235D382F6472F8568A18B2F057A1460297556"
+            "3CC27944640AC607CD107AE10923D9EF7A73C643E166BE5EBEAFA34B1AC553E2", 1
+        },
+        {   // 7, negated message
+            k1_pk, k1_msg,
+            "1FA62E331EDBC21C394792D2AB1100A7B432B013DF3F6FF4F99FCB33E0E1515F"
+            "28890B3EDB6E7189B630448B515CE4F8622A954CFE545735AAEA5134FCCDB2BD", 1
+        },
+        {   // 8, negated s
+            k1_pk, k1_msg,
+            "6CFF5C3BA86C69EA4B7376F31A9BCB4F74C1976089B2D9963DA2E5543E177769"
+            "961764B3AA9B2FFCB6EF947B6887A226E8D7C93E00C5ED0C1834FF0D0C2E6DA6", 1
+        },
+        {   // 9, s * G - e * P at infinity, r of 0
+            k1_pk, k1_msg,
+            "0000000000000000000000000000000000000000000000000000000000000000"
+            "123DDA8328AF9C23A94C1FEECFD123BA4FB73476F0D594DCB65C6425BD186051", 1
+        },
+        {   // 10, the same, r of 1
+            k1_pk, k1_msg,
+            "0000000000000000000000000000000000000000000000000000000000000001"
+            "7615FBAF5AE28864013C099742DEADB4DBA87F11AC6754F93780D5A1837CF197", 1
+        },
+        {   // 11, r not the x of a point
+            k1_pk, k1_msg,
+            "4A298DACAE57395A15D0795DDBFD1DCB564DA82B0F269BC70A74F8220429BA1D"
+            "69E89B4C5564D00349106B8497785DD7D1D713A8AE82B32FA79D5F7FC407D39B", 1
+        },
+        {   // 12, r = p
+            k1_pk, k1_msg,
+            "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F"
+            "69E89B4C5564D00349106B8497785DD7D1D713A8AE82B32FA79D5F7FC407D39B", 1
+        },
+        {   // 13, s = n
+            k1_pk, k1_msg,
+            "6CFF5C3BA86C69EA4B7376F31A9BCB4F74C1976089B2D9963DA2E5543E177769"
+            "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141", 1
+        },
+        {   // 14, pk not below p
+            "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC30", k1_msg,
+            "6CFF5C3BA86C69EA4B7376F31A9BCB4F74C1976089B2D9963DA2E5543E177769"
+            "69E89B4C5564D00349106B8497785DD7D1D713A8AE82B32FA79D5F7FC407D39B", -1
+        }
+    };
+
+    auto k1 = get_ec_domain(EC_SECP256K1);
+
+    for (auto& v: vectors) {
+        unsigned char sk[32], pk[32], aux[32], msg[32], expect[64], sig[64];
+        bnw_t sk_num;
+
+        do_hex(v[0], sk), do_hex(v[1], pk), do_hex(v[2], aux), do_hex(v[3], msg), do_hex(v[4], expect);
+        BN_bin2bn(sk, sizeof(sk), sk_num.actor);
+
+        eckey_t key(k1, pk, sk_num.actor);      // pk should match
+        eckey_t pub(k1, pk, nullptr);
+
+        if (!key.is_sk_ready() || 
+            key.do_sign(msg, sizeof(msg), sig, aux) != 0 ||
+            std::memcmp(sig, expect, sizeof(sig)) != 0 ||
+            pub.do_verify(msg, sizeof(msg), sig) != 0)
+            nfails++;
+
+        sig[63] ^= 0x01;
+        if (pub.do_verify(msg, sizeof(msg), sig) != 1) nfails++;
+    }
+
+    for (auto& v: verify_vectors) {
+        unsigned char pk[32], msg[32], sig[64];
+
+        do_hex(v.pk, pk), do_hex(v.msg, msg), do_hex(v.sig, sig);
+
+        const eckey_t pub(k1, pk, nullptr);
+
+        if (pub.is_pk_ready() != (v.expect != -1) || pub.do_verify(msg, sizeof(msg), sig) != v.expect)
+            nfails++;
+    }
+
+    /* The base of vectors 5 to 14 verifies, thus each fails by its own flaw. */
+    {
+        unsigned char pk[32], msg[32], sig[64];
+
+        do_hex(k1_pk, pk), do_hex(k1_msg, msg), do_hex(verify_vectors[1].sig, sig);
+        if (eckey_t(k1, pk, nullptr).do_verify(msg, sizeof(msg), sig) != 0) nfails++;
+    }
+
+    /* Secp256k1 against EC_POINT_mul: k * G, s * G + e * P, and the sum of 
+     *  four by do_multi_mul, of random scalars, then of 1, 2 and n - 1. */
+    {
+        const EC_GROUP* group = k1->get_group();
+        BN_CTX* ctx = get_thread_ctx();
+
+        const int ntrials = 64;
+        const size_t nmulti = 4;
+        int nwrong = 0;
+
+        auto do_same = [&](const EC_POINT* arg_point, const unsigned char* arg_x, const unsigned char* arg_y) {
+            bnw_t x, y, ex, ey;
+
+            return EC_POINT_get_affine_coordinates(group, arg_point, ex.actor, ey.actor, ctx) == 1 &&
+                BN_bin2bn(arg_x, EC_KEY_BYTES, x.actor) != nullptr &&
+                BN_bin2bn(arg_y, EC_KEY_BYTES, y.actor) != nullptr &&
+                BN_cmp(x.actor, ex.actor) == 0 && BN_cmp(y.actor, ey.actor) == 0;
+        };
+
+        for (int t = 0; t < ntrials + 3; t++) {
+            bnw_t s, d, x, y;
+            std::vector<bnw_t> scalars(nmulti);
+            std::vector<const BIGNUM*> exps(nmulti);
+            std::vector<EcPub> pubs(nmulti);
+            std::vector<std::shared_ptr<EC_POINT>> points(nmulti + 1);
+
+            unsigned char rx[EC_KEY_BYTES], ry[EC_KEY_BYTES];
+            bool same = true;
+
+            for (auto& point: points)
+                point.reset(EC_POINT_new(group), EC_POINT_free);
+
+            EC_POINT* expect = points[nmulti].get();
+
+            for (size_t i = 0; i <= nmulti; i++) {
+                BIGNUM* k = (i == 0) ? s.actor : scalars[i - 1].actor;
+
+                if (t < ntrials) BN_rand_range(k, k1->get_n());
+                else if (t == ntrials) BN_one(k);
+                else if (t == ntrials + 1) BN_set_word(k, 2);
+                else BN_sub(k, k1->get_n(), BN_value_one());
+
+                if (BN_is_zero(k)) BN_one(k);
+            }
+
+            /* P_i of even y, from the x of random multiples of G */
+            for (size_t i = 0; i < nmulti && same; i++) {
+                BN_rand_range(d.actor, k1->get_n());
+                exps[i] = scalars[i].actor;
+
+                same = k1->do_base_mul(rx, ry, d.actor, ctx) == 0 && k1->do_lift_x(pubs[i], rx, ctx) == 0 &&
+                    BN_bin2bn(pubs[i].x, EC_KEY_BYTES, x.actor) != nullptr &&
+                    BN_bin2bn(pubs[i].y, EC_KEY_BYTES, y.actor) != nullptr &&
+                    EC_POINT_set_affine_coordinates(group, points[i].get(), x.actor, y.actor, ctx) == 1;
+            }
+
+            /* k * G */
+            same = same && k1->do_base_mul(rx, ry, s.actor, ctx) == 0 &&
+                EC_POINT_mul(group, expect, s.actor, nullptr, nullptr, ctx) == 1 &&
+                do_same(expect, rx, ry);
+
+            /* s * G + e * P */
+            same = same && k1->do_dual_mul(rx, ry, s.actor, pubs[0], exps[0], ctx) == 0 &&
+                EC_POINT_mul(group, expect, s.actor, points[0].get(), exps[0], ctx) == 1 &&
+                do_same(expect, rx, ry);
+
+            /* s * G + e_1 * P_1 + ... + e_4 * P_4, P_i added one by one */
+            same = same && k1->do_multi_mul(rx, ry, s.actor, pubs.data(), exps.data(), nmulti, ctx) == 0 &&
+                EC_POINT_mul(group, expect, s.actor, nullptr, nullptr, ctx) == 1;
+
+            for (size_t i = 0; i < nmulti && same; i++)
+                same = EC_POINT_mul(group, points[i].get(), nullptr, points[i].get(), exps[i], ctx) == 1 &&
+                    EC_POINT_add(group, expect, expect, points[i].get(), ctx) == 1;
+
+            same = same && do_same(expect, rx, ry);
+
+            if (!same) nwrong++;
+        }
+
+        if (nwrong) nfails++;
+    }
+
+    /* Same flow as the subgroup of p, (s, e) over the wire. */
+    const char* msg_1 = "message 1";
+    const char* msg_2 = "message 2";
+
+    Communicator alice("Alice");
+    Communicator bob("Bob");
+
+    alice.set_curve(EC_SECP256K1);
+    bob.set_curve(EC_SECP256K1);
+
+    alice.prepare_key(0, 0);
+    alice.tx_pk(bob);
+
+    alice.prepare_msg(msg_1);
+    alice.generate_sig(0);
+    alice.tx_signature(bob);
+
+    bob.prepare_msg(msg_1);
+    if (bob.run_verify(0) != 0) nfails++;
+
+    bob.prepare_msg(msg_2);
+    if (bob.run_verify(0) != 1) nfails++;
+
+    std::cout << "  Public key " << get_pk_width(alice.get_manager().get_p()) << " bytes, "
+        << "signature " << 2 * get_sig_width(alice.get_manager().get_q()) << " bytes\n";
+
+    /* P-256, 64 byte form, through the exported key */
+    Communicator carol("Carol");
+    carol.set_curve(EC_P256);
+    carol.prepare_key(0, 0);
+
+    const eckey_t carol_key = carol.get_manager().do_export_eckey();
+    const eckey_t carol_pub = carol.get_manager().do_export_eckey(false);
+    unsigned char sig[EC_SIG_BYTES];
+
+    auto pmsg = reinterpret_cast<const unsigned char*>(msg_1);
+
+    if (carol_key.do_sign(pmsg, std::strlen(msg_1), sig) != 0 ||
+        carol_pub.is_sk_ready() ||
+        carol_pub.do_verify(pmsg, std::strlen(msg_1), sig) != 0 ||
+        carol_pub.do_verify(reinterpret_cast<const unsigned char*>(msg_2), std::strlen(msg_2), sig) != 1)
+        nfails++;
+
+    if (nfails) __msg_out("> Curve signatures wrong, Failed.\n");
+    else    __msg_out("> Curve signatures verified, OK.\n");
+}
+
+
+
+/*
+ * __test_fixed_mont
+ */
+void __test_fixed_mont() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Each size of p the engine takes, against BN_mod_exp on a random odd
+     * modulus: two bases at once, the fixed base table, a zero exponent and
+     * the base m - 1.
+     */
+
+    int nfails = 0;
+    BN_CTX* ctx = get_thread_ctx();
+
+    for (const int bits: {1024, 2048, 3072}) {
+        bnw_t m, b_1, b_2, e_1, e_2, r, x, y;
+
+        BN_rand(m.actor, bits, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ODD);
+
+        auto engine = get_mont_engine(m.actor);
+        if (engine == nullptr) {
+            std::cout << "  " << bits << " bits, no engine, BIGNUM path\n";
+            continue;
+        }
+
+        BN_rand_range(b_1.actor, m.actor);
+        BN_rand_range(b_2.actor, m.actor);
+        BN_rand(e_1.actor, bits - 1, BN_RAND_TOP_ANY, BN_RAND_BOTTOM_ANY);
+        BN_rand(e_2.actor, bits - 1, BN_RAND_TOP_ANY, BN_RAND_BOTTOM_ANY);
+
+        /* b_1^e_1 * b_2^e_2 */
+        const BIGNUM* bases[2] = { b_1.actor, b_2.actor };
+        const BIGNUM* exps[2] = { e_1.actor, e_2.actor };
+
+        BN_mod_exp(x.actor, b_1.actor, e_1.actor, m.actor, ctx);
+        BN_mod_exp(y.actor, b_2.actor, e_2.actor, m.actor, ctx);
+        BN_mod_mul(x.actor, x.actor, y.actor, m.actor, ctx);
+
+        if (engine->do_multi_exp(r.actor, bases, exps, 2) != 0 ||
+            BN_cmp(r.actor, x.actor))
+            nfails++;
+
+        /* Fixed base table, g^e_1 */
+        std::vector<uint64_t> table;
+        const int wbits = 4;
+        const int nwindows = (bits + wbits - 1) / wbits;
+
+        BN_mod_exp(x.actor, b_1.actor, e_1.actor, m.actor, ctx);
+
+        if (engine->do_build_table(table, b_1.actor, nwindows, wbits) != 0 ||
+            engine->do_table_exp(r.actor, table, nwindows, wbits, e_1.actor) != 0 ||
+            BN_cmp(r.actor, x.actor))
+            nfails++;
+
+        /* Exponent zero */
+        BN_zero(e_2.actor);
+        if (engine->do_multi_exp(r.actor, bases, &exps[1], 1) != 0 ||
+            !BN_is_one(r.actor))
+            nfails++;
+
+        /* Base m - 1, odd exponent */
+        BN_sub(b_2.actor, m.actor, BN_value_one());
+        BN_set_bit(e_1.actor, 0);
+
+        if (engine->do_multi_exp(r.actor, &bases[1], exps, 1) != 0 ||
+            BN_cmp(r.actor, b_2.actor))
+            nfails++;
+    }
+
+    if (nfails) __msg_out("> Fixed-limb exponentiation wrong, Failed.\n");
+    else    __msg_out("> Fixed-limb exponentiation matched, OK.\n");
+
+    /* do_jacobi against BN_kronecker, a at random and a just below m. The
+     *  latter shares the top bits with m, thus the passes the top bits guess
+     *  wrong are redone. */
+    nfails = 0;
+
+    for (const int bits: {64, 65, 200, 1024, 2048}) {
+        bnw_t m, a, d;
+
+        for (int i = 0; i < 64; i++) {
+            BN_rand(m.actor, bits, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ODD);
+
+            if (i % 2) {
+                BN_rand(d.actor, std::min(1 + i, bits - 1), BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ANY);
+                BN_sub(a.actor, m.actor, d.actor);
+            }
+            else
+                BN_rand_range(a.actor, m.actor);
+
+            if (do_jacobi(a.actor, m.actor) != BN_kronecker(a.actor, m.actor, ctx))
+                nfails++;
+        }
+    }
+
+    if (nfails) __msg_out("> Jacobi symbol wrong, Failed.\n");
+    else    __msg_out("> Jacobi symbol matched, OK.\n");
+}
+
+
+
+/*
+ * __test_batch_challenge
+ */
+void __test_batch_challenge() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* 37 messages of 0 to 300 bytes with r of 1 to 256 bytes, padded to
+     * a p of 2048 bits, thus lanes of different block counts and a last
+     * group not full. Every e should be the one do_challenge_final gives, 
+     * toy and not. Then r with a zero byte inside should count as a whole.
+     */
+    const size_t n = 37;
+    int nfails = 0;
+
+    bnw_t p;
+    BN_set_bit(p.actor, 2048);
+    BN_sub_word(p.actor, 1);
+
+    std::vector<std::vector<unsigned char>> msgs(n);
+    std::vector<bnw_t> rs(n), es(n);
+
+    std::vector<const unsigned char*> pmsgs(n);
+    std::vector<size_t> lens(n);
+    std::vector<const BIGNUM*> prs(n);
+    std::vector<BIGNUM*> pes(n);
+
+    for (size_t i = 0; i < n; i++) {
+        msgs[i].resize((i * 53) % 301);
+        RAND_bytes(msgs[i].data(), static_cast<int>(msgs[i].size()));
+        BN_rand(rs[i].actor, static_cast<int>(8 * (1 + (i * 71) % 256)), BN_RAND_TOP_ANY, BN_RAND_BOTTOM_ANY);
+
+        pmsgs[i] = msgs[i].data();
+        lens[i] = msgs[i].size();
+        prs[i] = rs[i].actor;
+        pes[i] = es[i].actor;
+    }
+
+    for (const bool toy: {false, true}) {
+        if (do_batch_challenge(pes.data(), pmsgs.data(), lens.data(), prs.data(), n, p.actor, toy, 20) != 0) {
+            nfails++;
+            continue;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            bnw_t e;
+            SHA256_CTX sha_context;
+
+            SHA256_Init(&sha_context);
+            SHA256_Update(&sha_context, msgs[i].data(), msgs[i].size());
+            do_challenge_final(e.actor, &sha_context, rs[i].actor, p.actor, toy, 20, nullptr);
+
+            if (BN_cmp(e.actor, es[i].actor)) nfails++;
+        }
+    }
+
+    /* 0xab 00 .. and 0xab 00 .. 01 differ after the zero only. */
+    {
+        bnw_t r1, r2, e1, e2;
+        SHA256_CTX sha_context;
+
+        BN_set_word(r1.actor, 0xab);
+        BN_lshift(r1.actor, r1.actor, 2000);
+        BN_copy(r2.actor, r1.actor);
+        BN_add_word(r2.actor, 1);
+
+        SHA256_Init(&sha_context);
+        do_challenge_final(e1.actor, &sha_context, r1.actor, p.actor, false, 20, nullptr);
+        SHA256_Init(&sha_context);
+        do_challenge_final(e2.actor, &sha_context, r2.actor, p.actor, false, 20, nullptr);
+
+        if (BN_cmp(e1.actor, e2.actor) == 0) nfails++;
+    }
+
+    std::cout << "  " << get_sha256_lanes() << " lanes\n";
+
+    if (nfails) __msg_out("> Batch challenges wrong, Failed.\n");
+    else    __msg_out("> Batch challenges matched, OK.\n");
+}
+
+
+
+/*
+ * __test_registered_midstate
+ */
+void __test_registered_midstate() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Bob registers a 64 KB document once, and verifies the signatures of
+     * Alice and Carol over it, each twice, with no prepare_msg in between.
+     * The registered message should stay as it is, H(m) should not move,
+     * and a signature over another message should still fail.
+     */
+    const int promised_bit_l = 1024;
+    const std::string doc(64 * 1024, 'd');
+    const char* msg_other = "another document";
+
+    int nfails = 0;
+
+    Communicator bob("Bob");
+    bob.prepare_msg(doc.c_str());
+
+    BIGNUM* h_before = bob.get_manager().do_hash(0);
+
+    for (const char* name: {"Alice", "Carol"}) {
+        Communicator signer(name);
+
+        signer.prepare_key(promised_bit_l, 0);
+        signer.tx_pqg(bob);
+        signer.tx_pk(bob);
+
+        signer.prepare_msg(doc.c_str());
+        signer.generate_sig(promised_bit_l);
+        signer.tx_signature(bob);
+
+        if (bob.run_verify(promised_bit_l) != 0) nfails++;
+        if (bob.run_verify(promised_bit_l) != 0) nfails++;
+
+        /* Signed twice on one registration, both verify. */
+        signer.generate_sig(promised_bit_l);
+        signer.tx_signature(bob);
+
+        if (bob.run_verify(promised_bit_l) != 0) nfails++;
+
+        signer.prepare_msg(msg_other);
+        signer.generate_sig(promised_bit_l);
+        signer.tx_signature(bob);
+
+        if (bob.run_verify(promised_bit_l) == 0) nfails++;
+    }
+
+    BIGNUM* h_after = bob.get_manager().do_hash(0);
+
+    if (std::strlen(reinterpret_cast<const char*>(bob.get_manager().get_mstr())) != doc.size() ||
+        h_before == nullptr || h_after == nullptr || BN_cmp(h_before, h_after))
+        nfails++;
+
+    BN_free(h_before);
+    BN_free(h_after);
+
+    if (nfails) __msg_out("> Registered message changed, Failed.\n");
+    else    __msg_out("> Verified on one registration, OK.\n");
+}
+
+
+
+/*
+ * __test_compact_verifier
+ */
+void __test_compact_verifier() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* 10000 verifiers of one 2048 bit domain from bytes, one of them
+     * Alice's, the rest other keys of the domain. Each should hold well 
+     * under 1 KB, Alice's should verify her signature and the others
+     * should not. pk of 0, 1, p - 1 or off the subgroup should not be
+     * held, and verify nothing, not even (s, e = H(m)).
+     */
+    const int promised_bit_l = 2048;
+    const size_t nkeys = 10000;
+    const size_t alice_at = nkeys / 2;
+    const char* msg_1 = "message 1";
+
+    int nfails = 0;
+
+    Communicator alice("Alice");
+    alice.prepare_key(promised_bit_l, 0);
+
+    SchnorrSignature& manager = alice.get_manager();
+    const sver_t exported = manager.do_export_verifier();
+
+    auto domain = manager.do_export_key(false).share_domain();
+
+    /* pk of every key in |p| bytes, g^i * pk of Alice, thus of the subgroup. */
+    const size_t width = BN_num_bytes(manager.get_p());
+    std::vector<unsigned char> pk_bytes(nkeys * width);
+
+    {
+        bnw_t pk;
+        BN_copy(pk.actor, manager.get_pk());
+
+        for (size_t n = 0; n < nkeys; n++) {
+            const size_t i = (alice_at + n) % nkeys;
+
+            BN_bn2binpad(pk.actor, &pk_bytes[i * width], static_cast<int>(width));
+            BN_mod_mul(pk.actor, pk.actor, manager.get_g(), manager.get_p(), get_thread_ctx());
+        }
+    }
+
+    std::vector<sver_t> verifiers;
+    verifiers.reserve(nkeys);
+
+    const unsigned long allocs_before = get_alloc_count();
+
+    for (size_t i = 0; i < nkeys; i++)
+        verifiers.emplace_back(domain, &pk_bytes[i * width], width);
+
+    const unsigned long allocs = get_alloc_count() - allocs_before;
+
+    size_t total = 0;
+    for (const auto& v: verifiers) total += v.get_size();
+
+    /* Signed by Alice */
+    bnw_t s, e;
+    auto pmsg = reinterpret_cast<const unsigned char*>(msg_1);
+
+    manager.do_export_key().do_sign(pmsg, std::strlen(msg_1), s.actor, e.actor, 0);
+
+    if (verifiers[alice_at].do_verify(pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != 0 ||
+        exported.do_verify(pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != 0 ||
+        verifiers[alice_at + 1].do_verify(pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != 1 ||
+        verifiers[alice_at].do_verify(pmsg, std::strlen(msg_1) - 1, s.actor, e.actor, 0) != 1)
+        nfails++;
+
+    if (total / nkeys >= 1024) nfails++;
+
+    /* Bad keys, e = H(m) and any s */
+    {
+        bnw_t bad, h;
+        SHA256_CTX sha_context;
+
+        SHA256_Init(&sha_context);
+        SHA256_Update(&sha_context, msg_1, std::strlen(msg_1));
+        do_challenge_final(h.actor, &sha_context, bad.actor, manager.get_p(), false, 0, nullptr);
+
+        for (int i = 0; i < 4; i++) {
+            if (i < 2) BN_set_word(bad.actor, i);
+            else if (i == 2) BN_sub(bad.actor, manager.get_p(), BN_value_one());
+            else BN_add(bad.actor, manager.get_pk(), manager.get_p()), BN_rshift1(bad.actor, bad.actor);
+
+            const sver_t verifier(domain, bad.actor);
+
+            if (verifier.is_valid() || domain->do_check_pk(bad.actor, get_thread_ctx()) != -1 ||
+                verifier.do_verify(pmsg, std::strlen(msg_1), s.actor, h.actor, 0) != -1)
+                nfails++;
+        }
+
+        if (!verifiers[alice_at].is_valid() || domain->do_check_pk(manager.get_pk(), get_thread_ctx()) != 0)
+            nfails++;
+
+        /* Beside the verifier, the domain refuses 0 itself. */
+        BN_zero(bad.actor);
+        if (domain->do_verify(bad.actor, pmsg, std::strlen(msg_1), s.actor, h.actor, 0) != -1)
+            nfails++;
+    }
+
+    std::cout << "  " << total / nkeys << " bytes per key, "
+        << allocs / nkeys << " allocations per key, "
+        << "SchnorrSignature " << sizeof(SchnorrSignature) << " bytes\n";
+
+    if (nfails) __msg_out("> Compact verifier wrong, Failed.\n");
+    else    __msg_out("> Compact verifiers verified, OK.\n");
+}
+
+
+
+/*
+ * __test_keyring_mmap
+ */
+void __test_keyring_mmap() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* 100000 keys of one 1024 bit domain, Alice's among random ones, by ids
+     * spread over 64 bits. The keyring is written, mapped twice, every id
+     * should be found, Alice's signature should verify by her id only, an
+     * unknown id or a slot of pk 0 should be -1, and a file cut short 
+     * should not open, nor one whose counts wrap the sizes around 64 bits.
+     */
+    const int promised_bit_l = 1024;
+    const size_t nkeys = 100000;
+    const size_t alice_at = 4321;
+    const char* path = "./keyring-test.kr";
+    const char* msg_1 = "message 1";
+
+    int nfails = 0;
+
+    Communicator alice("Alice");
+    alice.prepare_key(promised_bit_l, 0);
+
+    SchnorrSignature& manager = alice.get_manager();
+
+    std::vector<uint64_t> ids(nkeys);
+    std::vector<bnw_t> pks(nkeys);
+    std::vector<const BIGNUM*> ppks(nkeys);
+
+    for (size_t i = 0; i < nkeys; i++) {
+        ids[i] = (i + 1) * 0x9e3779b97f4a7c15ULL;
+
+        if (i == alice_at) BN_copy(pks[i].actor, manager.get_pk());
+        else if (i == alice_at + 2) BN_zero(pks[i].actor);
+        else    BN_rand_range(pks[i].actor, manager.get_p());
+
+        ppks[i] = pks[i].actor;
+    }
+
+    if (do_write_keyring(path, manager.get_p(), manager.get_q(), manager.get_g(), false,
+        ids.data(), ppks.data(), nkeys) != 0)
+        nfails++;
+
+    /* A duplicate id is refused. */
+    ids[1] = ids[0];
+    if (do_write_keyring("./keyring-dup.kr", manager.get_p(), manager.get_q(), manager.get_g(), false,
+        ids.data(), ppks.data(), 2) != -1)
+        nfails++;
+    ids[1] = 2 * 0x9e3779b97f4a7c15ULL;
+
+    kring_t ring, other;
+
+    auto t_open = std::chrono::steady_clock::now();
+    if (ring.do_open(path) != 0 || other.do_open(path) != 0) nfails++;
+    auto open_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t_open).count();
+
+    /* Every id, in the mapping, as written. */
+    size_t nfound = 0;
+    auto t_find = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < nkeys; i++) {
+        WirePkView view;
+        bnw_t pk;
+
+        if (ring.do_find(ids[i], view) == 0 && do_load_pk(view, pk.actor) == 0 &&
+            BN_cmp(pk.actor, pks[i].actor) == 0)
+            nfound++;
+    }
+
+    auto find_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t_find).count();
+
+    if (nfound != nkeys || ring.get_nkeys() != nkeys) nfails++;
+
+    /* Alice's signature by her id */
+    bnw_t s, e;
+    auto pmsg = reinterpret_cast<const unsigned char*>(msg_1);
+
+    manager.do_export_key().do_sign(pmsg, std::strlen(msg_1), s.actor, e.actor, 0);
+
+    if (ring.do_verify(ids[alice_at], pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != 0 ||
+        other.do_verify(ids[alice_at], pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != 0 ||
+        ring.do_verify(ids[alice_at + 1], pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != 1 ||
+        ring.do_verify(ids[alice_at + 2], pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != -1 ||
+        ring.do_verify(12345, pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != -1)
+        nfails++;
+
+    const size_t len = ring.get_len();
+
+    ring.do_close();
+    other.do_close();
+
+    /* nkeys = index_cap = 2^61 and a slot of 16 bytes, whose products wrap to 0. */
+    {
+        unsigned char arr_orig[24];
+        unsigned char arr_crafted[24] = { 0, };
+
+        arr_crafted[0] = arr_crafted[16] = 0x20;    // nkeys, index_cap
+        arr_crafted[15] = 16;                       // slot_len
+
+        FILE* fp = std::fopen(path, "r+b");
+
+        if (fp == nullptr ||
+            std::fseek(fp, 16, SEEK_SET) != 0 || std::fread(arr_orig, 1, 24, fp) != 24 ||
+            std::fseek(fp, 16, SEEK_SET) != 0 || std::fwrite(arr_crafted, 1, 24, fp) != 24 ||
+            std::fflush(fp) != 0 || kring_t().do_open(path) != -1 ||
+            std::fseek(fp, 16, SEEK_SET) != 0 || std::fwrite(arr_orig, 1, 24, fp) != 24)
+            nfails++;
+
+        if (fp != nullptr) std::fclose(fp);
+    }
+
+    /* Cut short, thus not a keyring. */
+    if (::truncate(path, len - KEYRING_PAGE) != 0 || kring_t().do_open(path) != -1)
+        nfails++;
+
+    /* Secret keys of a daemon, back by slot, of the owner alone, not for verify. */
+    {
+        const char* sk_path = "./keyring-test-sk.kr";
+        const uint64_t sk_ids[2] = { 7, 3 };
+        bnw_t sks[2];
+        const BIGNUM* psks[2] = { sks[0].actor, sks[1].actor };
+
+        for (auto& sk: sks)
+            do_rand_nonce(sk.actor, manager.get_q(), get_thread_ctx());
+
+        kring_t secret;
+        struct stat st;
+
+        if (do_write_keyring(sk_path, manager.get_p(), manager.get_q(), manager.get_g(), false,
+            sk_ids, psks, 2, true) != 0 ||
+            ::stat(sk_path, &st) != 0 || (st.st_mode & 0777) != 0600 ||
+            secret.do_open(sk_path) != 0 || !secret.is_secret())
+            nfails++;
+
+        for (uint64_t i = 0; i < 3; i++) {
+            uint64_t id = 0;
+            WirePkView view;
+            bnw_t sk;
+
+            if (i < 2 && (secret.do_get_slot(i, id, view) != 0 || id != sk_ids[i] ||
+                do_load_pk(view, sk.actor) != 0 || BN_cmp(sk.actor, sks[i].actor) != 0))
+                nfails++;
+
+            if (i == 2 && secret.do_get_slot(i, id, view) != -1) nfails++;
+        }
+
+        if (secret.do_verify(7, pmsg, std::strlen(msg_1), s.actor, e.actor, 0) != -1) nfails++;
+
+        secret.do_close();
+        std::remove(sk_path);
+    }
+
+    std::cout << "  " << len / 1024 << " KB, opened in " << open_us << " us, "
+        << find_ns / nkeys << " ns per lookup and load\n";
+
+    std::remove(path);
+
+    if (nfails) __msg_out("> Keyring wrong, Failed.\n");
+    else    __msg_out("> Keyring verified by id, OK.\n");
+}
+
+
+
+/*
+ * __test_verify_cache
+ */
+void __test_verify_cache() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* 32 signatures of Alice, 1024 bits, each verified 10 times through a
+     * cache on her key. The first round misses, the rest should hit, also
+     * through an exported verifier sharing the cache. A wrong e should never
+     * verify, nor go in. Then 1000 signatures through a cache of the least
+     * size should evict, yet verify all the same.
+     */
+    const int promised_bit_l = 1024;
+    const size_t nmsgs = 32;
+    const size_t nrounds = 10;
+    const size_t nmany = 1000;
+
+    int nfails = 0;
+
+    Communicator alice("Alice");
+    alice.prepare_key(promised_bit_l, 0);
+
+    SchnorrSignature& manager = alice.get_manager();
+    skey_t key = manager.do_export_key();
+    const sver_t exported = manager.do_export_verifier();
+
+    auto cache = std::make_shared<vcache_t>();
+    key.set_verify_cache(cache);
+
+    std::vector<std::string> msgs(nmany);
+    std::vector<bnw_t> ss(nmany), es(nmany);
+
+    for (size_t i = 0; i < nmany; i++) {
+        msgs[i] = "message " + std::to_string(i);
+        key.do_sign(reinterpret_cast<const unsigned char*>(msgs[i].data()), msgs[i].size(),
+            ss[i].actor, es[i].actor, 0);
+    }
+
+    using clock = std::chrono::steady_clock;
+    double miss_ns = 0, hit_ns = 0;
+
+    for (size_t r = 0; r < nrounds; r++) {
+        auto t_begin = clock::now();
+
+        for (size_t i = 0; i < nmsgs; i++) {
+            if (key.do_verify(reinterpret_cast<const unsigned char*>(msgs[i].data()), msgs[i].size(),
+                ss[i].actor, es[i].actor, 0) != 0)
+                nfails++;
+        }
+
+        const double ns = std::chrono::duration<double, std::nano>(clock::now() - t_begin).count();
+
+        if (r == 0) miss_ns = ns / nmsgs;
+        else    hit_ns += ns / nmsgs / (nrounds - 1);
+    }
+
+    vcstats_t stats = cache->get_stats();
+
+    if (stats.hits != nmsgs * (nrounds - 1) || stats.misses != nmsgs || stats.inserts != nmsgs)
+        nfails++;
+
+    std::cout << "  miss " << miss_ns / 1000 << " us, hit " << hit_ns / 1000 << " us, hit rate "
+        << stats.get_hit_rate() << ", " << stats.bytes / 1024 << " KB\n";
+
+    /* The same tuple from the exported verifier */
+    if (exported.do_verify(reinterpret_cast<const unsigned char*>(msgs[0].data()), msgs[0].size(),
+        ss[0].actor, es[0].actor, 0, cache.get()) != 0 ||
+        cache->get_stats().hits != stats.hits + 1)
+        nfails++;
+
+    /* Wrong e, twice, never cached */
+    bnw_t bad_e;
+    BN_add_word(BN_copy(bad_e.actor, es[0].actor), 1);
+
+    for (int i = 0; i < 2; i++) {
+        if (key.do_verify(reinterpret_cast<const unsigned char*>(msgs[0].data()), msgs[0].size(),
+            ss[0].actor, bad_e.actor, 0) != 1)
+            nfails++;
+    }
+
+    if (cache->get_stats().inserts != nmsgs)
+        nfails++;
+
+    /* More than fits */
+    auto small = std::make_shared<vcache_t>(0);
+    key.set_verify_cache(small);
+
+    for (size_t r = 0; r < 2; r++) {
+        for (size_t i = 0; i < nmany; i++) {
+            if (key.do_verify(reinterpret_cast<const unsigned char*>(msgs[i].data()), msgs[i].size(),
+                ss[i].actor, es[i].actor, 0) != 0)
+                nfails++;
+        }
+    }
+
+    stats = small->get_stats();
+
+    if (stats.entries > stats.capacity || stats.evictions == 0 ||
+        stats.hits + stats.misses != 2 * nmany)
+        nfails++;
+
+    std::cout << "  " << stats.capacity << " entries in " << stats.bytes << " bytes, "
+        << stats.evictions << " evictions, hit rate " << stats.get_hit_rate() << "\n";
+
+    if (nfails) __msg_out("> Verify cache wrong, Failed.\n");
+    else    __msg_out("> Verify cache hit, OK.\n");
+}
+
+
+
+/*
+ * __test_sign_daemon
+ */
+void __test_sign_daemon() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* A daemon holds Alice's 1024 bit key as id 7, on a pool of two. Four
+     * clients at once sign 64 messages each in one go and verify them back,
+     * one of them altered, which should not verify. Their signatures should
+     * verify locally too, by the domain and pk fetched on connect. Then a
+     * client as a Communicator, and a key id the daemon does not hold. The
+     * requests should have come in fewer batches.
+     */
+    const int promised_bit_l = 1024;
+    const size_t nclients = 4;
+    const size_t nmsgs = 64;
+    const char* path = "./sigd-test.sock";
+    const uint64_t alice_id = 7;
+
+    int nfails = 0;
+
+    Communicator alice("Alice");
+    alice.prepare_key(promised_bit_l, 0);
+
+    sigd_t daemon(2);
+
+    if (daemon.do_add_key(alice_id, std::make_shared<skey_t>(alice.get_manager().do_export_key())) != 0 ||
+        daemon.do_listen(path) != 0) {
+        __msg_out("> Daemon not listening, Failed.\n");
+        return;
+    }
+
+    std::thread server([&]() { daemon.do_serve(); });
+
+    /* Of the owner alone, whatever the umask. */
+    struct stat st;
+    if (::stat(path, &st) != 0 || (st.st_mode & 0777) != 0600)
+        nfails++;
+
+    std::atomic<int> nclient_fails(0);
+    std::vector<std::thread> clients;
+
+    auto t_begin = std::chrono::steady_clock::now();
+
+    for (size_t c = 0; c < nclients; c++) {
+        clients.emplace_back([&, c]() {
+            sigc_t client(("Client " + std::to_string(c)).c_str());
+
+            if (client.do_connect(path, alice_id) != 0) {
+                nclient_fails += nmsgs;
+                return;
+            }
+
+            std::vector<std::string> msgs(nmsgs);
+            std::vector<std::string_view> views(nmsgs);
+            std::vector<ssig_t> sigs(nmsgs);
+            std::vector<int> results(nmsgs);
+
+            for (size_t i = 0; i < nmsgs; i++) {
+                msgs[i] = "message " + std::to_string(c) + "-" + std::to_string(i);
+                views[i] = msgs[i];
+            }
+
+            nclient_fails += client.do_sign_many(views.data(), nmsgs, sigs.data(), 0);
+
+            /* The last one altered */
+            msgs[nmsgs - 1][0] = 'M';
+            views[nmsgs - 1] = msgs[nmsgs - 1];
+
+            if (client.do_verify_many(views.data(), sigs.data(), nmsgs, results.data(), 0) != 1 ||
+                results[nmsgs - 1] != 1)
+                nclient_fails++;
+
+            /* Locally, by what do_connect fetched */
+            auto domain = std::make_shared<const sdm_t>(
+                client.get_p(), client.get_q(), client.get_g(), false, 0);
+            const sver_t verifier(domain, client.get_pk());
+
+            for (size_t i = 0; i + 1 < nmsgs; i++) {
+                if (results[i] != 0 || verifier.do_verify(
+                    reinterpret_cast<const unsigned char*>(msgs[i].data()), msgs[i].size(),
+                    sigs[i].s.actor, sigs[i].e.actor, 0) != 0)
+                    nclient_fails++;
+            }
+        });
+    }
+
+    for (auto& t: clients) t.join();
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_begin).count();
+
+    nfails += nclient_fails;
+
+    /* As a Communicator */
+    sigc_t bob("Bob");
+
+    if (bob.do_connect(path, alice_id) != 0 ||
+        bob.prepare_msg("message 1") != 0 ||
+        bob.generate_sig(0) != 0 ||
+        bob.run_verify(0) != 0 ||
+        bob.prepare_msg("message 2") != 0 ||
+        bob.run_verify(0) != 1)
+        nfails++;
+
+    if (sigc_t("Carol").do_connect(path, alice_id + 1) != -1)
+        nfails++;
+
+    bob.do_close();
+
+    /* Dave sends key requests without reading. The daemon should stop
+     *  reading him once his replies are held back, thus his sends block
+     *  long before 64 MB, and every reply should still come, in order. */
+    {
+        const size_t cap = 64 << 20;
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, path);
+
+        std::vector<unsigned char> frame;
+        size_t nsent = 0, sent_bytes = 0, frame_off = 0;
+        bool blocked = false;
+
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+            nfails++;
+        else {
+            /* Blocked once not writable for half a second. */
+            while (sent_bytes < cap) {
+                if (frame_off == frame.size()) {
+                    frame.clear(), frame_off = 0;
+                    do_append_request(frame, SIGD_OP_KEY, static_cast<uint32_t>(nsent++), alice_id, 0, nullptr, 0);
+                }
+
+                const ssize_t n = ::send(fd, &frame[frame_off], frame.size() - frame_off, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+                if (n > 0) {
+                    frame_off += static_cast<size_t>(n), sent_bytes += static_cast<size_t>(n);
+                    continue;
+                }
+
+                pollfd pfd = { fd, POLLOUT, 0 };
+
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && ::poll(&pfd, 1, 500) > 0)
+                    continue;
+
+                blocked = (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+                break;
+            }
+
+            /* Replies read, and the frame cut by the full buffer finished
+             *  as the daemon reads again. */
+            std::vector<unsigned char> in(1 << 16);
+            size_t in_len = 0, nreplies = 0;
+            bool in_order = true;
+
+            while (nreplies < nsent) {
+                const bool pending = frame_off < frame.size();
+                pollfd pfd = { fd, static_cast<short>(POLLIN | (pending ? POLLOUT : 0)), 0 };
+
+                if (::poll(&pfd, 1, 5000) <= 0) break;
+
+                if (pfd.revents & POLLOUT) {
+                    const ssize_t n = ::send(fd, &frame[frame_off], frame.size() - frame_off, MSG_DONTWAIT | MSG_NOSIGNAL);
+                    if (n > 0) frame_off += static_cast<size_t>(n);
+                }
+
+                if (!(pfd.revents & POLLIN)) continue;
+
+                if (in.size() - in_len < 4096) in.resize(2 * in.size());
+
+                const ssize_t n = ::read(fd, &in[in_len], in.size() - in_len);
+                if (n <= 0) break;
+                in_len += static_cast<size_t>(n);
+
+                size_t off = 0;
+                SigdReply reply;
+
+                for (long m; (m = do_parse_reply(&in[off], in_len - off, reply)) > 0; off += static_cast<size_t>(m)) {
+                    in_order = in_order && reply.seq == nreplies && reply.status == SIGD_OK;
+                    nreplies++;
+                }
+
+                std::memmove(in.data(), &in[off], in_len - off);
+                in_len -= off;
+            }
+
+            if (!blocked || nreplies != nsent || !in_order)
+                nfails++;
+
+            std::cout << "  " << nsent << " requests sent without reading, " << nreplies << " replies\n";
+        }
+
+        if (fd >= 0) ::close(fd);
+    }
+
+    daemon.do_stop();
+    server.join();
+
+    const sigdstats_t stats = daemon.get_stats();
+
+    if (stats.requests < nclients * 2 * nmsgs || stats.batches >= stats.requests)
+        nfails++;
+
+    std::cout << "  " << stats.requests << " requests in " << stats.batches << " batches, largest "
+        << stats.largest << ", " << nclients * 2 * nmsgs / elapsed << " requests/s\n";
+
+    if (nfails) __msg_out("> Daemon wrong, Failed.\n");
+    else    __msg_out("> Daemon signed and verified, OK.\n");
+}
+
+
+
+/*
+ * __test_shm_ring
+ */
+void __test_shm_ring() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* A child process writes 2^20 records of 64 signatures of Alice, each
+     * a signature record and the index of its message, into a shared ring
+     * of 4096. The parent reads them in place, in order, and verifies one
+     * in 2^14 from its slot. Then Alice sends her signature to Bob as a
+     * Communicator over another ring, which Bob should verify. Over a ring
+     * of 4 that Bob never empties, Alice's fifth send should time out,
+     * and once Bob closes, fail at once.
+     */
+    const int promised_bit_l = 1024;
+    const size_t nsigs = 64;
+    const size_t nrecords = 1 << 20;
+    const size_t verify_every = 1 << 14;
+    const char* name = "/ee488-ring-test";
+
+    int nfails = 0;
+
+    Communicator alice("Alice");
+    Communicator bob("Bob");
+    alice.prepare_key(promised_bit_l, 0);
+
+    const skey_t key = alice.get_manager().do_export_key();
+    const sver_t verifier = alice.get_manager().do_export_verifier();
+
+    const size_t w = get_sig_width(alice.get_manager().get_q());
+    const size_t record_len = get_sig_len(w) + 4;
+
+    std::vector<std::string> msgs(nsigs);
+    std::vector<unsigned char> records(nsigs * record_len);
+
+    for (size_t i = 0; i < nsigs; i++) {
+        bnw_t s, e;
+        unsigned char* record = &records[i * record_len];
+
+        msgs[i] = "message " + std::to_string(i);
+        key.do_sign(reinterpret_cast<const unsigned char*>(msgs[i].data()), msgs[i].size(), s.actor, e.actor, 0);
+
+        do_encode_sig(record, get_sig_len(w), s.actor, e.actor, w);
+        record[record_len - 1] = static_cast<unsigned char>(i);
+    }
+
+    shmring_t ring;
+
+    if (ring.do_create(name, record_len) != 0) {
+        __msg_out("> Shared ring not created, Failed.\n");
+        return;
+    }
+
+    std::cout.flush();
+    auto t_begin = std::chrono::steady_clock::now();
+
+    const pid_t pid = ::fork();
+
+    if (pid == 0) {
+        /* Producer, by the name, as another program would. */
+        shmring_t tx;
+        if (tx.do_open(name) != 0)
+            ::_exit(1);
+
+        for (size_t i = 0; i < nrecords;) {
+            const size_t n = std::min(nrecords - i, tx.do_wait_writable());
+
+            for (size_t j = 0; j < n; j++)
+                std::memcpy(tx.get_slot(j), &records[((i + j) % nsigs) * record_len], record_len);
+
+            tx.do_commit(n);
+            i += n;
+        }
+
+        tx.do_finish();
+        ::_exit(0);
+    }
+
+    size_t nread = 0, nbad = 0, nverified = 0;
+    size_t n;
+
+    while (pid > 0 && (n = ring.do_wait_readable()) > 0) {
+        for (size_t j = 0; j < n; j++, nread++) {
+            const unsigned char* record = ring.get_record(j);
+            const size_t idx = record[record_len - 1];
+            WireSigView view;
+
+            if (idx != nread % nsigs || do_parse_sig(record, record_len, view) < 0) {
+                nbad++;
+                continue;
+            }
+
+            if (nread % verify_every == 0) {
+                bnw_t s, e;
+
+                if (do_load_sig(view, s.actor, e.actor) == 0 && verifier.do_verify(
+                    reinterpret_cast<const unsigned char*>(msgs[idx].data()), msgs[idx].size(),
+                    s.actor, e.actor, 0) == 0)
+                    nverified++;
+            }
+        }
+
+        ring.do_release(n);
+    }
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_begin).count();
+
+    int status = -1;
+    if (pid < 0 || ::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        nfails++;
+
+    if (nread != nrecords || nbad != 0 || nverified != nrecords / verify_every)
+        nfails++;
+
+    std::cout << "  " << nread << " records of " << record_len << " bytes, "
+        << nread / elapsed / 1e6 << " M records/s\n";
+
+    ring.do_close();
+
+    /* As Communicators */
+    shmring_t link;
+
+    alice.tx_pqg(bob);
+    alice.tx_pk(bob);
+    alice.prepare_msg("message 1");
+    bob.prepare_msg("message 1");
+    alice.generate_sig(0);
+
+    if (link.do_create("/ee488-ring-link", get_sig_len(w), 4) != 0 ||
+        alice.tx_signature(link) != 0 ||
+        bob.rx_signature(link) != 0 ||
+        bob.run_verify(0) != 0)
+        nfails++;
+
+    /* Bob gone */
+    {
+        shmring_t rx, tx;
+        int nsent = 0;
+
+        if (rx.do_create("/ee488-ring-gone", get_sig_len(w), 4) != 0 || tx.do_open("/ee488-ring-gone") != 0)
+            nfails++;
+
+        while (nsent < 8 && alice.tx_signature(tx, 50) == 0) nsent++;
+
+        auto t_wait = std::chrono::steady_clock::now();
+        rx.do_close();
+
+        if (nsent != 4 || alice.tx_signature(tx) != -1 || tx.do_push(&records[0], 1) != 0 ||
+            std::chrono::steady_clock::now() - t_wait > std::chrono::milliseconds(50))
+            nfails++;
+    }
+
+    if (nfails) __msg_out("> Shared ring wrong, Failed.\n");
+    else    __msg_out("> Shared ring verified in place, OK.\n");
+}
+
+
+
+/*
+ * __test_musig
+ */
+void __test_musig() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Alice, Bob, Carol and Dave co-sign one message in Alice's 1024 bit
+     * domain. Each sends its nonces, then its partial signature, to every
+     * other, who should take them. All should end with the same (s, e),
+     * which Eve verifies once under the aggregate of the four keys, and not
+     * for another message. Then two sessions by hand: an altered partial
+     * should be refused, a session should not sign twice, and a key not
+     * listed should not sign at all.
+     */
+    const int promised_bit_l = 1024;
+    const char* msg = "message co-signed";
+
+    int nfails = 0;
+
+    Communicator alice("Alice"), bob("Bob"), carol("Carol"), dave("Dave");
+    Communicator eve("Eve");
+
+    std::vector<Communicator*> signers = { &alice, &bob, &carol, &dave };
+    std::vector<const BIGNUM*> pks;
+
+    alice.prepare_key(promised_bit_l, 0);
+
+    for (auto signer: signers) {
+        if (signer != &alice) {
+            alice.tx_pqg(*signer);
+
+            if (signer->get_manager().do_keygen_pqg() != 0)
+                nfails++;
+        }
+
+        pks.push_back(signer->get_manager().get_pk());
+    }
+
+    for (auto signer: signers) {
+        if (signer->prepare_msg(msg) != 0 ||
+            signer->musig_begin(pks) != 0 ||
+            signer->musig_nonce() != 0)
+            nfails++;
+    }
+
+    /* Round 1 */
+    for (auto from: signers) {
+        for (auto to: signers) {
+            if (from != to && from->tx_musig_nonce(*to) != 0)
+                nfails++;
+        }
+    }
+
+    /* Round 2 */
+    for (auto signer: signers) {
+        if (signer->musig_sign(0) != 0)
+            nfails++;
+    }
+
+    if (alice.musig_sign(0) != -1)
+        nfails++;
+
+    for (auto from: signers) {
+        for (auto to: signers) {
+            if (from != to && from->tx_musig_partial(*to) != 0)
+                nfails++;
+        }
+    }
+
+    for (auto signer: signers) {
+        if (signer->musig_finish() != 0 ||
+            BN_cmp(signer->get_manager().get_signature_s(), alice.get_manager().get_signature_s()) != 0 ||
+            BN_cmp(signer->get_manager().get_signature_e(), alice.get_manager().get_signature_e()) != 0)
+            nfails++;
+    }
+
+    /* One verification for all four */
+    alice.tx_pqg(eve);
+
+    if (eve.musig_key(pks) != 0 ||
+        BN_cmp(eve.get_manager().get_pk(), alice.get_musig()->get_agg_pk()) != 0)
+        nfails++;
+
+    eve.prepare_msg(msg);
+    alice.tx_signature(eve);
+
+    auto t_begin = std::chrono::steady_clock::now();
+
+    if (eve.run_verify(0) != 0)
+        nfails++;
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_begin).count();
+
+    eve.prepare_msg("message altered");
+
+    if (eve.run_verify(0) == 0)
+        nfails++;
+
+    std::cout << "  " << signers.size() << " signers, one signature of "
+        << get_sig_len(get_sig_width(alice.get_manager().get_q())) << " bytes, verified in "
+        << elapsed * 1e6 << " us\n";
+
+    /* By hand */
+    const skey_t key_a = alice.get_manager().do_export_key();
+    const skey_t key_b = bob.get_manager().do_export_key();
+    const skey_t key_c = carol.get_manager().do_export_key();
+
+    const BIGNUM* pair[2] = { key_a.get_pk(), key_b.get_pk() };
+    const unsigned char* m = reinterpret_cast<const unsigned char*>(msg);
+
+    msig_t sa(key_a, pair, 2), sb(key_b, pair, 2), sc(key_c, pair, 2);
+    bnw_t r1, r2, s_a, s_b, bad, s, e;
+
+    if (sa.do_nonce_gen(r1.actor, r2.actor) != 0 || sb.set_nonce(0, r1.actor, r2.actor) != 0 ||
+        sb.do_nonce_gen(r1.actor, r2.actor) != 0 || sa.set_nonce(1, r1.actor, r2.actor) != 0 ||
+        sa.do_partial_sign(m, std::strlen(msg), s_a.actor, 0) != 0 ||
+        sb.do_partial_sign(m, std::strlen(msg), s_b.actor, 0) != 0)
+        nfails++;
+
+    BN_mod_add(bad.actor, s_b.actor, BN_value_one(), key_a.get_domain()->get_q(), get_thread_ctx());
+
+    if (sa.set_partial(1, bad.actor) != -1 ||
+        sa.do_aggregate(s.actor, e.actor) != -1 ||
+        sa.set_partial(1, s_b.actor) != 0 ||
+        sa.do_aggregate(s.actor, e.actor) != 0 ||
+        sver_t(key_a.share_domain(), sa.get_agg_pk()).do_verify(m, std::strlen(msg), s.actor, e.actor, 0) != 0)
+        nfails++;
+
+    if (sa.do_partial_sign(m, std::strlen(msg), s_a.actor, 0) != -1 ||
+        sc.get_self() != 2 ||
+        sc.do_nonce_gen(r1.actor, r2.actor) != -1)
+        nfails++;
+
+    if (nfails) __msg_out("> MuSig wrong, Failed.\n");
+    else    __msg_out("> MuSig verified once, OK.\n");
+}
+
+
+
+/*
+ * __test_half_agg
+ */
+void __test_half_agg() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* 16 keys of secp256k1 sign 1024 records in the 64 byte form, and Alice
+     * signs two more by do_sign as a Communicator, in (s, e). All go into
+     * one aggregate of about half the size, which should verify once, and
+     * not with two messages swapped, two signatures reordered, a byte of s
+     * or of an R altered, or a length off. An (s, e) that does not verify
+     * should not go in. Then the same over P-256. The sizes and the times of
+     * the aggregate verify and of one by one are printed.
+     */
+    const size_t nkeys = 16;
+    const size_t nsigs = 1024;
+
+    int nfails = 0;
+
+    for (const int nid: { EC_SECP256K1, EC_P256 }) {
+        auto domain = get_ec_domain(nid);
+        const size_t n = (nid == EC_SECP256K1) ? nsigs : nsigs / 16;
+
+        std::vector<std::unique_ptr<eckey_t>> keys;
+
+        for (size_t i = 0; i < nkeys; i++) {
+            bnw_t sk;
+            do_rand_nonce(sk.actor, domain->get_n(), get_thread_ctx());
+            keys.emplace_back(std::make_unique<eckey_t>(domain, nullptr, sk.actor));
+        }
+
+        std::vector<std::string> msgs(n + 2);
+        std::vector<unsigned char> sigs(n * EC_SIG_BYTES);
+        std::vector<EcHalfAggItem> items(n + 2);
+
+        for (size_t i = 0; i < n; i++) {
+            const eckey_t& key = *keys[i % nkeys];
+
+            msgs[i] = "record " + std::to_string(i);
+            key.do_sign(reinterpret_cast<const unsigned char*>(msgs[i].data()), msgs[i].size(), &sigs[i * EC_SIG_BYTES]);
+
+            items[i] = { key.get_pk(), reinterpret_cast<const unsigned char*>(msgs[i].data()), msgs[i].size(),
+                &sigs[i * EC_SIG_BYTES], nullptr, nullptr };
+        }
+
+        /* Two of do_sign, in (s, e) */
+        Communicator alice("Alice");
+        alice.set_curve(nid);
+        alice.prepare_key(0, 0);
+
+        const eckey_t alice_pub = alice.get_manager().do_export_eckey(false);
+        bnw_t ss[2], es[2];
+
+        for (size_t i = 0; i < 2; i++) {
+            msgs[n + i] = "record of Alice " + std::to_string(i);
+
+            alice.prepare_msg(msgs[n + i].c_str());
+            alice.generate_sig(0);
+
+            BN_copy(ss[i].actor, alice.get_manager().get_signature_s());
+            BN_copy(es[i].actor, alice.get_manager().get_signature_e());
+
+            items[n + i] = { alice_pub.get_pk(), reinterpret_cast<const unsigned char*>(msgs[n + i].data()),
+                msgs[n + i].size(), nullptr, ss[i].actor, es[i].actor };
+        }
+
+        const size_t total = n + 2;
+        std::vector<unsigned char> agg(get_halfagg_len(total));
+
+        if (do_half_aggregate(agg.data(), *domain, items.data(), total) != 0)
+            nfails++;
+
+        auto t_begin = std::chrono::steady_clock::now();
+
+        if (do_half_verify(*domain, items.data(), total, agg.data(), agg.size()) != 0)
+            nfails++;
+
+        const double agg_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_begin).count();
+
+        t_begin = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < n; i++) {
+            if (keys[i % nkeys]->do_verify(items[i].msg, items[i].msg_len, items[i].sig) != 0)
+                nfails++;
+        }
+
+        const double one_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_begin).count();
+
+        /* Messages swapped */
+        std::swap(items[3].msg, items[4 + nkeys].msg);
+        std::swap(items[3].msg_len, items[4 + nkeys].msg_len);
+
+        if (do_half_verify(*domain, items.data(), total, agg.data(), agg.size()) != 1)
+            nfails++;
+
+        std::swap(items[3].msg, items[4 + nkeys].msg);
+        std::swap(items[3].msg_len, items[4 + nkeys].msg_len);
+
+        /* Two signatures reordered, R along, thus other randomizers. */
+        std::vector<unsigned char> moved(agg);
+        std::vector<EcHalfAggItem> reordered(items);
+
+        std::swap(reordered[1], reordered[2]);
+        std::swap_ranges(&moved[1 * EC_KEY_BYTES], &moved[2 * EC_KEY_BYTES], &moved[2 * EC_KEY_BYTES]);
+
+        if (do_half_verify(*domain, reordered.data(), total, moved.data(), moved.size()) != 1)
+            nfails++;
+
+        /* s, then an R */
+        agg[agg.size() - 1] ^= 0x01;
+        if (do_half_verify(*domain, items.data(), total, agg.data(), agg.size()) != 1)
+            nfails++;
+        agg[agg.size() - 1] ^= 0x01;
+
+        agg[5 * EC_KEY_BYTES + 7] ^= 0x01;
+        if (do_half_verify(*domain, items.data(), total, agg.data(), agg.size()) != 1)
+            nfails++;
+        agg[5 * EC_KEY_BYTES + 7] ^= 0x01;
+
+        if (do_half_verify(*domain, items.data(), total, agg.data(), agg.size() - 1) != -1 ||
+            do_half_verify(*domain, items.data(), total, agg.data(), agg.size()) != 0)
+            nfails++;
+
+        /* An (s, e) of another message */
+        items[n].msg = items[n + 1].msg, items[n].msg_len = items[n + 1].msg_len;
+        BN_add_word(es[0].actor, 1);
+
+        if (do_half_aggregate(agg.data(), *domain, items.data(), total) != -1)
+            nfails++;
+
+        std::cout << "  " << ((nid == EC_SECP256K1) ? "secp256k1" : "P-256") << ", " << total
+            << " signatures of " << total * EC_SIG_BYTES << " bytes into " << agg.size() << ", verified in "
+            << agg_elapsed * 1e3 << " ms, " << n << " one by one in " << one_elapsed * 1e3 << " ms\n";
+    }
+
+    if (nfails) __msg_out("> Half-aggregation wrong, Failed.\n");
+    else    __msg_out("> Half-aggregate verified, OK.\n");
+}
+
+
+
+/*
+ * __test_param_race
+ */
+void __test_param_race() {
+    std::cout << "Test <" << __FUNCTION__ << ">\n";
+
+    /* Four racers search (p, q, g) of 1024 bits, and toy (p, q) of 512 and
+     * 64 bits. The winner should be one of them, p and q prime, q of p - 1,
+     * and g of order q. A deadline of 1 ms at 3072 bits should stop all four
+     * soon after, and fail. Then Alice keys herself by do_keygen over four,
+     * Bob should verify her, and Carol should fail past her deadline.
+     */
+    const size_t nracers = 4;
+
+    int nfails = 0;
+
+    BN_CTX* ctx = get_thread_ctx();
+
+    auto is_group = [&](const BIGNUM* p, const BIGNUM* q, const BIGNUM* g) {
+        bnw_t r;
+
+        if (BN_check_prime(p, ctx, nullptr) != 1 || BN_check_prime(q, ctx, nullptr) != 1 ||
+            !BN_sub(r.actor, p, BN_value_one()) || !BN_mod(r.actor, r.actor, q, ctx) || !BN_is_zero(r.actor))
+            return false;
+
+        return g == nullptr || (BN_mod_exp(r.actor, g, q, p, ctx) && BN_is_one(r.actor) && !BN_is_one(g));
+    };
+
+    {
+        pgen_t generator(nracers);
+        bnw_t p, q, g;
+
+        if (generator.do_generate_dsa(p.actor, q.actor, g.actor, 1024) != 0 ||
+            generator.get_stats().winner < 0 || generator.get_stats().winner >= static_cast<int>(nracers) ||
+            BN_num_bits(p.actor) != 1024 || !is_group(p.actor, q.actor, g.actor))
+            nfails++;
+
+        std::cout << "  DSA 1024 bits by racer " << generator.get_stats().winner << " of " << nracers << " in "
+            << generator.get_stats().elapsed_ms << " ms, " << generator.get_stats().callbacks << " callbacks\n";
+
+        if (generator.do_generate_toy(p.actor, q.actor, 512, 64) != 0 ||
+            BN_num_bits(p.actor) != 512 || BN_num_bits(q.actor) != 64 || !is_group(p.actor, q.actor, nullptr))
+            nfails++;
+
+        std::cout << "  Toy 512/64 bits by racer " << generator.get_stats().winner << " in "
+            << generator.get_stats().elapsed_ms << " ms\n";
+    }
+
+    {
+        pgen_t generator(nracers, 1);
+        bnw_t p, q, g;
+
+        if (generator.do_generate_dsa(p.actor, q.actor, g.actor, 3072) != -1 ||
+            !generator.get_stats().timed_out || generator.get_stats().winner != -1 ||
+            generator.get_stats().elapsed_ms > 1000)
+            nfails++;
+
+        std::cout << "  DSA 3072 bits, deadline 1 ms, stopped in " << generator.get_stats().elapsed_ms << " ms\n";
+    }
+
+    /* Through do_keygen */
+    Communicator alice("Alice"), bob("Bob"), carol("Carol");
+
+    alice.get_manager().set_keygen_threads(nracers);
+
+    if (alice.prepare_key(1024, 0) != 0)
+        nfails++;
+
+    alice.tx_pqg(bob);
+    alice.tx_pk(bob);
+
+    alice.prepare_msg("message 1");
+    bob.prepare_msg("message 1");
+    alice.generate_sig(0);
+    alice.tx_signature(bob);
+
+    if (bob.run_verify(0) != 0)
+        nfails++;
+
+    carol.get_manager().set_keygen_threads(nracers);
+    carol.get_manager().set_keygen_deadline(1);
+
+    if (carol.prepare_key(3072, 0) != -1 || carol.get_manager().is_pk_ready())
+        nfails++;
+
+    if (nfails) __msg_out("> Parameter race wrong, Failed.\n");
+    else    __msg_out("> Parameter race won and stopped, OK.\n");
+}
@@ -0,0 +1,565 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+/* Microbenchmarks of SchnorrSignature.
+ *  Usage: ./bench.run [--json] [--iters=N] [--keygen-iters=N] [--bits=1024,2048,3072,toy]
+ *                     [--threads=1,8,64] [--curves=secp256k1,p256]
+ *
+ *  For each size, measures do_keygen, do_hash, do_sign and do_verify one call
+ *  at a time, and reports ops/sec and p50/p99/p999 latency. do_keygen runs
+ *  do_rkeygen, or do_tkeygen when toyed. do_hash runs do_rhash likewise,
+ *  and hash_batch do_batch_challenge of MBSHA_LANES_MAX signatures at once.
+ *
+ *  Then, for the first real size, SchnorrKey::do_sign with a random k against
+ *  a deterministic k (RFC 6979) on each number of threads sharing the key.
+ *  The iterations are split over the threads, ops/sec is over the wall time.
+ *
+ *  Last, do_keygen, do_sign and do_verify of SchnorrSignature on each curve.
+ */
+
+#ifdef __PRINT
+#undef __PRINT
+#endif
+
+#include <iostream>
+#include <iomanip>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <string>
+#include <vector>
+
+#include <cstring>
+#include <algorithm>
+
+#include "schnorr.h"
+#include "ecschnorr.h"
+using namespace EE488;
+
+
+/* Toy parameters, same as __test_self_sign_and_verify_large_toy */
+const int TOY_BIT_L = 64;
+const int TOY_BIT_N = 20;
+
+const int WARMUP_ITERS = 8;
+
+
+struct BenchConfig {
+    bool json = false;
+    int iters = 2000;
+    int keygen_iters = 3;
+    std::vector<int> bits = { 1024, 2048, 3072, 0 };   // 0 for toy
+    std::vector<int> threads = { 1, 8, 64 };
+    std::vector<int> curves = { EC_SECP256K1, EC_P256 };
+};
+
+
+struct BenchResult {
+    std::string op;
+    std::string curve;      // Empty for the subgroup of p
+    int bits;
+    bool toy;
+    int iters;
+    int threads;
+    double ops_per_sec;
+    double p50_ns, p99_ns, p999_ns;
+};
+
+
+/*
+ * do_summarize
+ *  Sorts the latencies in place.
+ */
+BenchResult do_summarize(
+    const std::string& arg_op,
+    const int arg_bits,
+    const int arg_nthreads,
+    std::vector<double>& arg_lat,
+    const double arg_total_ns) {
+
+    std::sort(arg_lat.begin(), arg_lat.end());
+
+    auto do_pct = [&](const double arg_p) {
+        size_t idx = static_cast<size_t>(arg_p * (arg_lat.size() - 1) + 0.5);
+        return arg_lat[std::min(idx, arg_lat.size() - 1)];
+    };
+
+    return BenchResult{
+        arg_op,
+        "",
+        arg_bits == 0 ? TOY_BIT_L : arg_bits,
+        arg_bits == 0,
+        static_cast<int>(arg_lat.size()),
+        arg_nthreads,
+        arg_lat.size() / (arg_total_ns * 1e-9),
+        do_pct(0.50), do_pct(0.99), do_pct(0.999)
+    };
+}
+
+
+
+/*
+ * do_measure
+ *  Runs arg_prep untimed, then arg_op timed, arg_iters times.
+ */
+BenchResult do_measure(
+    const std::string& arg_op,
+    const int arg_bits,
+    const int arg_iters,
+    const int arg_warmup,
+    const std::function<void()>& arg_prep,
+    const std::function<void()>& arg_op_func) {
+
+    using clock = std::chrono::steady_clock;
+
+    std::vector<double> lat;
+    lat.reserve(arg_iters);
+
+    for (int i = 0; i < arg_warmup; i++) {
+        arg_prep();
+        arg_op_func();
+    }
+
+    double total_ns = 0;
+
+    for (int i = 0; i < arg_iters; i++) {
+        arg_prep();
+
+        auto t_begin = clock::now();
+        arg_op_func();
+        auto t_end = clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(t_end - t_begin).count();
+
+        lat.push_back(ns);
+        total_ns += ns;
+    }
+
+    return do_summarize(arg_op, arg_bits, 1, lat, total_ns);
+}
+
+
+
+/*
+ * do_measure_threads
+ *  Splits arg_iters over arg_nthreads, each calling arg_op_func with its own
+ *  index. ops/sec is over the wall time, the latencies of all are merged.
+ */
+BenchResult do_measure_threads(
+    const std::string& arg_op,
+    const int arg_bits,
+    const int arg_iters,
+    const int arg_nthreads,
+    const std::function<void(int)>& arg_op_func) {
+
+    using clock = std::chrono::steady_clock;
+
+    std::vector<std::vector<double>> lats(arg_nthreads);
+    std::vector<std::thread> workers;
+    std::atomic<bool> go(false);   // Thread creation is not timed
+
+    for (int t = 0; t < arg_nthreads; t++) {
+        const int niters = arg_iters / arg_nthreads + (t < arg_iters % arg_nthreads ? 1 : 0);
+
+        workers.emplace_back([&, t, niters]() {
+            lats[t].reserve(niters);
+
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            for (int i = 0; i < niters; i++) {
+                auto t_op = clock::now();
+                arg_op_func(t);
+                lats[t].push_back(std::chrono::duration<double, std::nano>(clock::now() - t_op).count());
+            }
+        });
+    }
+
+    auto t_begin = clock::now();
+    go.store(true, std::memory_order_release);
+
+    for (auto& w: workers) w.join();
+
+    double wall_ns = std::chrono::duration<double, std::nano>(clock::now() - t_begin).count();
+
+    std::vector<double> lat;
+    lat.reserve(arg_iters);
+
+    for (auto& l: lats) lat.insert(lat.end(), l.begin(), l.end());
+
+    return do_summarize(arg_op, arg_bits, arg_nthreads, lat, wall_ns);
+}
+
+
+
+/*
+ * do_bench_size
+ */
+void do_bench_size(const BenchConfig& arg_cfg, const int arg_bits, std::vector<BenchResult>& arg_results) {
+
+    const bool toy = (arg_bits == 0);
+    const int bit_l = toy ? TOY_BIT_L : arg_bits;
+    const int bit_n = toy ? TOY_BIT_N : 0;
+
+    const char* msg = "The quick brown fox jumps over the lazy dog";
+
+    SchnorrSignature manager;
+    manager.set_toy(toy);
+
+    /* Key generation is slow for real sizes, thus fewer rounds. */
+    arg_results.push_back(do_measure(
+        "keygen", arg_bits, toy ? arg_cfg.iters : arg_cfg.keygen_iters, toy ? WARMUP_ITERS : 0,
+        []() {},
+        [&]() { manager.do_keygen(bit_l, bit_n); }
+    ));
+
+    /* A fresh key for the rest. do_regmsg hashes m and keeps the midstate,
+     *  do_hash takes H(m) from it, thus both are timed. */
+    manager.do_keygen(bit_l, bit_n);
+
+    arg_results.push_back(do_measure(
+        "hash", arg_bits, arg_cfg.iters, WARMUP_ITERS,
+        []() {},
+        [&]() { manager.do_regmsg(msg); BN_free(manager.do_hash(bit_n)); }
+    ));
+
+    /* Challenges of MBSHA_LANES_MAX signatures per call, as do_batch_verify
+     *  hashes them. */
+    {
+        auto pmsg = reinterpret_cast<const unsigned char*>(msg);
+        const size_t msg_len = std::strlen(msg);
+
+        bnw_t es[MBSHA_LANES_MAX];
+        BIGNUM* pes[MBSHA_LANES_MAX];
+        const unsigned char* pmsgs[MBSHA_LANES_MAX];
+        const BIGNUM* prs[MBSHA_LANES_MAX];
+        size_t lens[MBSHA_LANES_MAX];
+
+        for (size_t i = 0; i < MBSHA_LANES_MAX; i++) {
+            pes[i] = es[i].actor, pmsgs[i] = pmsg, lens[i] = msg_len;
+            prs[i] = manager.get_p();
+        }
+
+        arg_results.push_back(do_measure(
+            "hash_batch", arg_bits, arg_cfg.iters, WARMUP_ITERS,
+            []() {},
+            [&]() { do_batch_challenge(pes, pmsgs, lens, prs, MBSHA_LANES_MAX, manager.get_p(), toy, bit_n); }
+        ));
+    }
+
+    /* Registered once, sign and verify hash only r on from it. */
+    manager.do_regmsg(msg);
+
+    arg_results.push_back(do_measure(
+        "sign", arg_bits, arg_cfg.iters, WARMUP_ITERS,
+        []() {},
+        [&]() { manager.do_sign(bit_n); }
+    ));
+
+    /* Verify the last signature over and over. */
+    arg_results.push_back(do_measure(
+        "verify", arg_bits, arg_cfg.iters, WARMUP_ITERS,
+        []() {},
+        [&]() {
+            if (manager.do_verify(bit_n) != 0)
+                std::cerr << "Error, bench signature not verified.\n";
+        }
+    ));
+}
+
+
+
+/*
+ * do_bench_nonce
+ *  One key shared by all threads, as do_sign is const. Each thread keeps
+ *  its own (s, e).
+ */
+void do_bench_nonce(const BenchConfig& arg_cfg, const int arg_bits, std::vector<BenchResult>& arg_results) {
+
+    const char* msg = "The quick brown fox jumps over the lazy dog";
+    auto pmsg = reinterpret_cast<const unsigned char*>(msg);
+    const size_t msg_len = std::strlen(msg);
+
+    SchnorrSignature manager;
+    manager.do_keygen(arg_bits, 0);
+
+    skey_t random_key = manager.do_export_key();
+    skey_t determ_key = manager.do_export_key();
+    determ_key.set_deterministic(true);
+
+    for (int nthreads: arg_cfg.threads) {
+        std::vector<bnw_t> sig_s(nthreads), sig_e(nthreads);
+
+        for (auto* key: { &random_key, &determ_key }) {
+            /* Warms up the thread's BN_CTX and the Montgomery tables. */
+            key->do_sign(pmsg, msg_len, sig_s[0].actor, sig_e[0].actor, 0);
+
+            arg_results.push_back(do_measure_threads(
+                key->is_deterministic() ? "sign_determ" : "sign_random", 
+                arg_bits, arg_cfg.iters, nthreads,
+                [&](int arg_t) {
+                    if (key->do_sign(pmsg, msg_len, sig_s[arg_t].actor, sig_e[arg_t].actor, 0) != 0)
+                        std::cerr << "Error, bench signing failed.\n";
+                }
+            ));
+        }
+    }
+}
+
+
+
+/*
+ * do_bench_curve
+ */
+void do_bench_curve(const BenchConfig& arg_cfg, const int arg_nid, std::vector<BenchResult>& arg_results) {
+
+    const char* msg = "The quick brown fox jumps over the lazy dog";
+
+    SchnorrSignature manager;
+    manager.set_curve(arg_nid);
+
+    const size_t first = arg_results.size();
+
+    /* Fast enough, thus as many rounds as the rest. */
+    arg_results.push_back(do_measure(
+        "keygen", 256, arg_cfg.iters, WARMUP_ITERS,
+        []() {},
+        [&]() { manager.do_keygen(0, 0); }
+    ));
+
+    manager.do_keygen(0, 0);
+    manager.do_regmsg(msg);
+
+    arg_results.push_back(do_measure(
+        "sign", 256, arg_cfg.iters, WARMUP_ITERS,
+        []() {},
+        [&]() { manager.do_sign(0); }
+    ));
+
+    arg_results.push_back(do_measure(
+        "verify", 256, arg_cfg.iters, WARMUP_ITERS,
+        []() {},
+        [&]() {
+            if (manager.do_verify(0) != 0)
+                std::cerr << "Error, bench signature not verified.\n";
+        }
+    ));
+
+    for (size_t i = first; i < arg_results.size(); i++)
+        arg_results[i].curve = OBJ_nid2sn(arg_nid);
+}
+
+
+
+/*
+ * do_print_table, do_print_json
+ */
+void do_print_table(const std::vector<BenchResult>& arg_results) {
+
+    std::cout << std::left
+        << std::setw(12) << "op" << std::setw(10) << "bits" << std::right
+        << std::setw(8) << "iters" << std::setw(8) << "threads" << std::setw(14) << "ops/sec"
+        << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)" << std::setw(12) << "p999(us)" << "\n";
+
+    std::cout << std::fixed;
+
+    for (auto& r: arg_results) {
+        std::string bits = r.toy ? std::to_string(r.bits) + "/" + std::to_string(TOY_BIT_N) : std::to_string(r.bits);
+
+        if (!r.curve.empty())
+            bits = r.curve;
+
+        std::cout << std::left
+            << std::setw(12) << r.op << std::setw(10) << bits << std::right
+            << std::setw(8) << r.iters
+            << std::setw(8) << r.threads
+            << std::setw(14) << std::setprecision(1) << r.ops_per_sec
+            << std::setw(12) << std::setprecision(2) << r.p50_ns / 1e3
+            << std::setw(12) << r.p99_ns / 1e3
+            << std::setw(12) << r.p999_ns / 1e3 << "\n";
+    }
+}
+
+
+
+void do_print_json(const std::vector<BenchResult>& arg_results) {
+
+    std::cout << "{\n  \"openssl\": \"" << OpenSSL_version(OPENSSL_VERSION) << "\",\n"
+        << "  \"results\": [\n";
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (size_t i = 0; i < arg_results.size(); i++) {
+        auto& r = arg_results[i];
+
+        std::cout << "    {\"op\": \"" << r.op << "\", \"bits\": " << r.bits
+            << ", \"toy\": " << (r.toy ? "true" : "false")
+            << ", \"curve\": \"" << r.curve << "\""
+            << ", \"iters\": " << r.iters
+            << ", \"threads\": " << r.threads
+            << ", \"ops_per_sec\": " << r.ops_per_sec
+            << ", \"p50_ns\": " << r.p50_ns
+            << ", \"p99_ns\": " << r.p99_ns
+            << ", \"p999_ns\": " << r.p999_ns << "}"
+            << (i + 1 < arg_results.size() ? ",\n" : "\n");
+    }
+
+    std::cout << "  ]\n}\n";
+}
+
+
+
+/*
+ * do_parse_list
+ *  "1024,2048,toy" into numbers, toy as 0.
+ */
+std::vector<int> do_parse_list(const std::string& arg_list) {
+
+    std::vector<int> items;
+    size_t pos = 0;
+
+    while (pos <= arg_list.length()) {
+        size_t next = arg_list.find(',', pos);
+        if (next == std::string::npos) next = arg_list.length();
+
+        std::string item = arg_list.substr(pos, next - pos);
+        items.push_back(item == "toy" ? 0 : std::stoi(item));
+
+        pos = next + 1;
+    }
+
+    return items;
+}
+
+
+
+/*
+ * do_parse_args
+ */
+int do_parse_args(int argc, char* argv[], BenchConfig& arg_cfg) {
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+
+        if (arg == "--json")
+            arg_cfg.json = true;
+
+        else if (arg.rfind("--iters=", 0) == 0)
+            arg_cfg.iters = std::stoi(arg.substr(8));
+
+        else if (arg.rfind("--keygen-iters=", 0) == 0)
+            arg_cfg.keygen_iters = std::stoi(arg.substr(15));
+
+        else if (arg.rfind("--bits=", 0) == 0)
+            arg_cfg.bits = do_parse_list(arg.substr(7));
+
+        else if (arg.rfind("--threads=", 0) == 0)
+            arg_cfg.threads = do_parse_list(arg.substr(10));
+
+        else if (arg.rfind("--curves=", 0) == 0) {
+            arg_cfg.curves.clear();
+
+            for (size_t pos = 9; pos <= arg.length();) {
+                size_t next = arg.find(',', pos);
+                if (next == std::string::npos) next = arg.length();
+
+                std::string item = arg.substr(pos, next - pos);
+
+                if (item == "secp256k1")    arg_cfg.curves.push_back(EC_SECP256K1);
+                else if (item == "p256")    arg_cfg.curves.push_back(EC_P256);
+                else if (item != "none") {
+                    std::cerr << "Error, unknown curve " << item << ".\n";
+                    return -1;
+                }
+
+                pos = next + 1;
+            }
+        }
+
+        else {
+            std::cerr << "Usage: " << argv[0]
+                << " [--json] [--iters=N] [--keygen-iters=N] [--bits=1024,2048,3072,toy] [--threads=1,8,64]\n"
+                << "    [--curves=secp256k1,p256,none]\n";
+            return -1;
+        }
+    }
+
+    if (arg_cfg.iters < 1 || arg_cfg.keygen_iters < 1) {
+        std::cerr << "Error, iterations should be positive.\n";
+        return -1;
+    }
+
+    for (int t: arg_cfg.threads) {
+        if (t < 1) {
+            std::cerr << "Error, threads should be positive.\n";
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+
+/* main
+ */
+int main(int argc, char* argv[]) {
+
+    BenchConfig cfg;
+
+    try {
+        if (do_parse_args(argc, argv, cfg) != 0)
+            return 1;
+    }
+    catch (const std::exception&) {
+        std::cerr << "Error, malformed number in arguments.\n";
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+
+    for (int bits: cfg.bits) {
+        if (!cfg.json)
+            std::cerr << "Running " << (bits == 0 ? std::string("toy") : std::to_string(bits)) << " bits...\n";
+
+        do_bench_size(cfg, bits, results);
+    }
+
+    /* Nonce modes on the first real size */
+    auto real = std::find_if(cfg.bits.begin(), cfg.bits.end(), [](int b) { return b != 0; });
+
+    if (real != cfg.bits.end() && !cfg.threads.empty()) {
+        if (!cfg.json)
+            std::cerr << "Running nonce modes, " << *real << " bits...\n";
+
+        do_bench_nonce(cfg, *real, results);
+    }
+
+    for (int nid: cfg.curves) {
+        if (!cfg.json)
+            std::cerr << "Running " << OBJ_nid2sn(nid) << "...\n";
+
+        do_bench_curve(cfg, nid, results);
+    }
+
+    if (cfg.json)   do_print_json(results);
+    else            do_print_table(results);
+
+    return 0;
+}
@@ -0,0 +1,681 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <cstring>
+#include <mutex>
+#include <map>
+#include <vector>
+
+#include "./ecschnorr.h"
+
+
+namespace {
+
+    const char* tag_names[EE488::EC_NTAGS] = {
+        "BIP0340/aux",
+        "BIP0340/nonce",
+        "BIP0340/challenge",
+        "HalfAgg/randomizer"
+    };
+
+    struct PointDeleter {
+        void operator()(EC_POINT* arg_point) const { EC_POINT_free(arg_point); }
+    };
+
+    using point_ptr = std::unique_ptr<EC_POINT, PointDeleter>;
+};
+
+
+
+/*
+ * EcDomain Actions */
+EE488::EcDomain::EcDomain(const int arg_nid) :
+    group(EC_GROUP_new_by_curve_name(arg_nid)),
+    nid(arg_nid) {
+
+    for (int i = 0; i < EC_NTAGS; i++) {
+        unsigned char arr_tag[SHA256_DIGEST_LENGTH];
+        SHA256(reinterpret_cast<const unsigned char*>(tag_names[i]), std::strlen(tag_names[i]), arr_tag);
+
+        SHA256_Init(&tags[i]);
+        SHA256_Update(&tags[i], arr_tag, sizeof(arr_tag));
+        SHA256_Update(&tags[i], arr_tag, sizeof(arr_tag));
+    }
+
+    if (group == nullptr)
+        return;
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+
+    /* Only curves of 32 byte coordinates and order. */
+    if (!EC_GROUP_get_curve(group, p.actor, nullptr, nullptr, tbn_ctx) ||
+        !EC_GROUP_get_order(group, n.actor, tbn_ctx) ||
+        BN_num_bytes(p.actor) != EC_KEY_BYTES ||
+        BN_num_bytes(n.actor) != EC_KEY_BYTES) {
+
+        EC_GROUP_free(group);
+        group = nullptr;
+        return;
+    }
+
+    /* The group stays for p, n and G either way. */
+    if (nid == EC_SECP256K1)
+        k1.reset(new Secp256k1());
+
+    else if (!EC_GROUP_precompute_mult(group, tbn_ctx)) {
+        EC_GROUP_free(group);
+        group = nullptr;
+    }
+}
+
+
+
+EE488::EcDomain::~EcDomain() {
+
+    if (group != nullptr)
+        EC_GROUP_free(group);
+}
+
+
+
+/*
+ * do_tagged_hash
+ */
+void EE488::EcDomain::do_tagged_hash(
+    unsigned char* arg_out,
+    const int arg_tag,
+    const unsigned char* arg_a,
+    const unsigned char* arg_b,
+    const unsigned char* arg_msg, size_t arg_len) const {
+
+    SHA256_CTX sha_context = tags[arg_tag];    // Prefix absorbed already
+
+    SHA256_Update(&sha_context, arg_a, EC_KEY_BYTES);
+
+    if (arg_b != nullptr)
+        SHA256_Update(&sha_context, arg_b, EC_KEY_BYTES);
+
+    if (arg_msg != nullptr)
+        SHA256_Update(&sha_context, arg_msg, arg_len);
+
+    SHA256_Final(arg_out, &sha_context);
+}
+
+
+
+/*
+ * do_lift_x
+ */
+int EE488::EcDomain::do_lift_x(EcPub& arg_pub, const unsigned char* arg_x, BN_CTX* arg_ctx) const {
+
+    std::memcpy(arg_pub.x, arg_x, EC_KEY_BYTES);
+    arg_pub.point.reset();
+
+    if (k1 != nullptr)
+        return k1->do_lift_x(arg_pub.y, arg_x) ? 1 : 0;
+
+    BN_CTX_start(arg_ctx);
+
+    BIGNUM* tbn_x = BN_CTX_get(arg_ctx);
+    BIGNUM* tbn_y = BN_CTX_get(arg_ctx);
+    std::shared_ptr<EC_POINT> point(EC_POINT_new(group), PointDeleter());
+
+    int ret_code = -1;
+
+    if (tbn_y == nullptr || point == nullptr)
+        goto out;
+
+    BN_bin2bn(arg_x, EC_KEY_BYTES, tbn_x);
+    ret_code = 1;
+
+    if (BN_cmp(tbn_x, p.actor) >= 0 ||
+        !EC_POINT_set_compressed_coordinates(group, point.get(), tbn_x, 0, arg_ctx) ||
+        !EC_POINT_get_affine_coordinates(group, point.get(), nullptr, tbn_y, arg_ctx))
+        goto out;
+
+    BN_bn2binpad(tbn_y, arg_pub.y, EC_KEY_BYTES);
+    arg_pub.point = point;
+
+    ret_code = 0;
+
+out:
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_base_mul
+ */
+int EE488::EcDomain::do_base_mul(
+    unsigned char* arg_x,
+    unsigned char* arg_y,
+    const BIGNUM* arg_k,
+    BN_CTX* arg_ctx) const {
+
+    if (k1 != nullptr) {
+        unsigned char arr_k[EC_KEY_BYTES];
+        BN_bn2binpad(arg_k, arr_k, EC_KEY_BYTES);
+
+        int ret_code = k1->do_base_mul(arg_x, arg_y, arr_k);
+        OPENSSL_cleanse(arr_k, sizeof(arr_k));
+
+        return ret_code;
+    }
+
+    BN_CTX_start(arg_ctx);
+
+    BIGNUM* tbn_x = BN_CTX_get(arg_ctx);
+    BIGNUM* tbn_y = BN_CTX_get(arg_ctx);
+    point_ptr point(EC_POINT_new(group));
+
+    int ret_code = -1;
+
+    if (tbn_y != nullptr && point != nullptr &&
+        EC_POINT_mul(group, point.get(), arg_k, nullptr, nullptr, arg_ctx) &&
+        EC_POINT_get_affine_coordinates(group, point.get(), tbn_x, tbn_y, arg_ctx)) {
+
+        BN_bn2binpad(tbn_x, arg_x, EC_KEY_BYTES);
+        BN_bn2binpad(tbn_y, arg_y, EC_KEY_BYTES);
+        ret_code = 0;
+    }
+
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_dual_mul
+ */
+int EE488::EcDomain::do_dual_mul(
+    unsigned char* arg_x,
+    unsigned char* arg_y,
+    const BIGNUM* arg_s,
+    const EcPub& arg_pub,
+    const BIGNUM* arg_e,
+    BN_CTX* arg_ctx) const {
+
+    if (k1 != nullptr) {
+        unsigned char arr_s[EC_KEY_BYTES], arr_e[EC_KEY_BYTES];
+
+        BN_bn2binpad(arg_s, arr_s, EC_KEY_BYTES);
+        BN_bn2binpad(arg_e, arr_e, EC_KEY_BYTES);
+
+        return k1->do_dual_mul(arg_x, arg_y, arr_s, arg_pub.x, arg_pub.y, arr_e);
+    }
+
+    if (arg_pub.point == nullptr)
+        return -1;
+
+    BN_CTX_start(arg_ctx);
+
+    BIGNUM* tbn_x = BN_CTX_get(arg_ctx);
+    BIGNUM* tbn_y = BN_CTX_get(arg_ctx);
+    point_ptr point(EC_POINT_new(group));
+
+    int ret_code = -1;
+
+    if (tbn_y == nullptr || point == nullptr ||
+        !EC_POINT_mul(group, point.get(), arg_s, arg_pub.point.get(), arg_e, arg_ctx))
+        goto out;
+
+    ret_code = 1;
+
+    if (EC_POINT_is_at_infinity(group, point.get()) ||
+        !EC_POINT_get_affine_coordinates(group, point.get(), tbn_x, tbn_y, arg_ctx))
+        goto out;
+
+    BN_bn2binpad(tbn_x, arg_x, EC_KEY_BYTES);
+    BN_bn2binpad(tbn_y, arg_y, EC_KEY_BYTES);
+    ret_code = 0;
+
+out:
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_multi_mul
+ */
+int EE488::EcDomain::do_multi_mul(
+    unsigned char* arg_x,
+    unsigned char* arg_y,
+    const BIGNUM* arg_s,
+    const EcPub* arg_pubs,
+    const BIGNUM* const* arg_es,
+    const size_t arg_n,
+    BN_CTX* arg_ctx) const {
+
+    if (k1 != nullptr) {
+        unsigned char arr_s[EC_KEY_BYTES];
+        std::vector<unsigned char> es(arg_n * EC_KEY_BYTES);
+        std::vector<const unsigned char*> xs(arg_n), ys(arg_n), eps(arg_n);
+
+        if (arg_s != nullptr)
+            BN_bn2binpad(arg_s, arr_s, EC_KEY_BYTES);
+
+        for (size_t i = 0; i < arg_n; i++) {
+            if (BN_bn2binpad(arg_es[i], &es[i * EC_KEY_BYTES], EC_KEY_BYTES) < 0)
+                return -1;
+
+            xs[i] = arg_pubs[i].x, ys[i] = arg_pubs[i].y;
+            eps[i] = &es[i * EC_KEY_BYTES];
+        }
+
+        return k1->do_multi_mul(arg_x, arg_y, (arg_s != nullptr) ? arr_s : nullptr,
+            xs.data(), ys.data(), eps.data(), arg_n);
+    }
+
+    std::vector<const EC_POINT*> points(arg_n);
+
+    for (size_t i = 0; i < arg_n; i++) {
+        if (arg_pubs[i].point == nullptr)
+            return -1;
+
+        points[i] = arg_pubs[i].point.get();
+    }
+
+    BN_CTX_start(arg_ctx);
+
+    BIGNUM* tbn_x = BN_CTX_get(arg_ctx);
+    BIGNUM* tbn_y = BN_CTX_get(arg_ctx);
+    point_ptr point(EC_POINT_new(group));
+
+    int ret_code = -1;
+
+    /* Interleaved wNAF of OpenSSL, with the precomputed multiples of G. */
+    if (tbn_y == nullptr || point == nullptr ||
+        !EC_POINTs_mul(group, point.get(), arg_s, arg_n, points.data(),
+            const_cast<const BIGNUM**>(arg_es), arg_ctx))
+        goto out;
+
+    ret_code = 1;
+
+    if (EC_POINT_is_at_infinity(group, point.get()) ||
+        !EC_POINT_get_affine_coordinates(group, point.get(), tbn_x, tbn_y, arg_ctx))
+        goto out;
+
+    BN_bn2binpad(tbn_x, arg_x, EC_KEY_BYTES);
+    BN_bn2binpad(tbn_y, arg_y, EC_KEY_BYTES);
+    ret_code = 0;
+
+out:
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * get_ec_domain
+ */
+std::shared_ptr<const EE488::ecdm_t> EE488::get_ec_domain(const int arg_nid) {
+
+    static std::mutex lock;
+    static std::map<int, std::shared_ptr<const ecdm_t>> domains;
+
+    if (arg_nid != EC_SECP256K1 && arg_nid != EC_P256)
+        return nullptr;
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto& domain = domains[arg_nid];
+
+    if (domain == nullptr) {
+        auto fresh = std::make_shared<const ecdm_t>(arg_nid);
+
+        if (!fresh->is_ready())
+            return nullptr;
+
+        domain = fresh;
+    }
+
+    return domain;
+}
+
+
+
+/*
+ * EcSchnorrKey Actions */
+EE488::EcSchnorrKey::EcSchnorrKey(
+    std::shared_ptr<const ecdm_t> arg_domain,
+    const unsigned char* arg_pk,
+    const BIGNUM* arg_sk) :
+        domain(arg_domain),
+        pk{},
+        pk_ready(false),
+        sk_ready(false),
+        deterministic(false) {
+
+    if (domain == nullptr || !domain->is_ready())
+        return;
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+
+    if (arg_sk != nullptr) {
+        unsigned char arr_y[EC_KEY_BYTES];
+
+        /* d in [1, n - 1], P = d * G. d is negated when P has odd y. */
+        if (!BN_is_zero(arg_sk) && !BN_is_negative(arg_sk) &&
+            BN_cmp(arg_sk, domain->get_n()) < 0 &&
+            domain->do_base_mul(pk.x, arr_y, arg_sk, tbn_ctx) == 0 &&
+            BN_copy(sk.actor, arg_sk) != nullptr) {
+
+            if (arr_y[EC_KEY_BYTES - 1] & 1)
+                BN_sub(sk.actor, domain->get_n(), sk.actor);
+
+            /* -P shares x, thus the lift gives the even one. */
+            sk_ready = pk_ready = (domain->do_lift_x(pk, pk.x, tbn_ctx) == 0);
+        }
+
+        /* A given public key should match the secret. */
+        if (arg_pk != nullptr && pk_ready && std::memcmp(arg_pk, pk.x, EC_KEY_BYTES) != 0)
+            sk_ready = pk_ready = false;
+
+        if (!sk_ready)
+            BN_clear(sk.actor);
+    }
+    else if (arg_pk != nullptr)
+        pk_ready = (domain->do_lift_x(pk, arg_pk, tbn_ctx) == 0);
+}
+
+
+
+/*
+ * do_sign_core
+ */
+int EE488::EcSchnorrKey::do_sign_core(
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    const unsigned char* arg_aux,
+    unsigned char* arg_rx,
+    BIGNUM* arg_s,
+    BIGNUM* arg_e) const {
+
+    if (!sk_ready)
+        return -1;
+
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_SIGN);
+
+    const BIGNUM* n = domain->get_n();
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_k = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_x = BN_CTX_get(tbn_ctx);
+
+    unsigned char arr_aux[EC_KEY_BYTES] = { 0, };
+    unsigned char arr_t[EC_KEY_BYTES];
+    unsigned char arr_d[EC_KEY_BYTES];
+    unsigned char arr_ry[EC_KEY_BYTES];
+    unsigned char arr_hash[SHA256_DIGEST_LENGTH];
+
+    int ret_code = -1;
+
+    if (tbn_x == nullptr)
+        goto out;
+
+    if (arg_aux != nullptr)
+        std::memcpy(arr_aux, arg_aux, sizeof(arr_aux));
+    else if (!deterministic && RAND_bytes(arr_aux, sizeof(arr_aux)) != 1)
+        goto out;
+
+    /* t = d xor H_aux(a), k = H_nonce(t || P.x || m) mod n */
+    BN_bn2binpad(sk.actor, arr_d, EC_KEY_BYTES);
+    domain->do_tagged_hash(arr_hash, EC_TAG_AUX, arr_aux, nullptr, nullptr, 0);
+
+    for (size_t i = 0; i < EC_KEY_BYTES; i++)
+        arr_t[i] = arr_d[i] ^ arr_hash[i];
+
+    domain->do_tagged_hash(arr_hash, EC_TAG_NONCE, arr_t, pk.x, arg_msg, arg_len);
+
+    BN_bin2bn(arr_hash, sizeof(arr_hash), tbn_k);
+
+    if (!BN_nnmod(tbn_k, tbn_k, n, tbn_ctx) || BN_is_zero(tbn_k))
+        goto out;
+
+    __STAT_LAP__(timer, STAGE_SIGN_NONCE);
+
+    /* R = k * G, then k negated when R has odd y. */
+    if (domain->do_base_mul(arg_rx, arr_ry, tbn_k, tbn_ctx) != 0)
+        goto out;
+
+    if (arr_ry[EC_KEY_BYTES - 1] & 1)
+        BN_sub(tbn_k, n, tbn_k);
+
+    __STAT_LAP__(timer, STAGE_SIGN_COMMIT);
+
+    domain->do_tagged_hash(arr_hash, EC_TAG_CHALLENGE, arg_rx, pk.x, arg_msg, arg_len);
+
+    BN_bin2bn(arr_hash, sizeof(arr_hash), arg_e);
+    BN_nnmod(arg_e, arg_e, n, tbn_ctx);
+
+    __STAT_LAP__(timer, STAGE_SIGN_HASH);
+
+    /* s = k + e * d mod n */
+    if (!BN_mod_mul(tbn_x, arg_e, sk.actor, n, tbn_ctx) ||
+        !BN_mod_add(arg_s, tbn_x, tbn_k, n, tbn_ctx))
+        goto out;
+
+    __STAT_LAP__(timer, STAGE_SIGN_FINAL);
+
+    ret_code = 0;
+
+out:
+    OPENSSL_cleanse(arr_t, sizeof(arr_t));
+    OPENSSL_cleanse(arr_d, sizeof(arr_d));
+
+    if (tbn_k != nullptr)
+        BN_clear(tbn_k);
+
+    BN_CTX_end(tbn_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_sign
+ */
+int EE488::EcSchnorrKey::do_sign(
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    unsigned char* arg_sig,
+    const unsigned char* arg_aux) const {
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_s = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_e = BN_CTX_get(tbn_ctx);
+
+    int ret_code = -1;
+
+    if (tbn_e != nullptr &&
+        do_sign_core(arg_msg, arg_len, arg_aux, arg_sig, tbn_s, tbn_e) == 0) {
+
+        BN_bn2binpad(tbn_s, arg_sig + EC_KEY_BYTES, EC_KEY_BYTES);
+        ret_code = 0;
+    }
+
+    BN_CTX_end(tbn_ctx);
+
+    return ret_code;
+}
+
+
+
+int EE488::EcSchnorrKey::do_sign(
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    BIGNUM* arg_s,
+    BIGNUM* arg_e,
+    const unsigned char* arg_aux) const {
+
+    unsigned char arr_rx[EC_KEY_BYTES];
+
+    return do_sign_core(arg_msg, arg_len, arg_aux, arr_rx, arg_s, arg_e);
+}
+
+
+
+/*
+ * do_verify
+ */
+int EE488::EcSchnorrKey::do_verify(
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    const unsigned char* arg_sig) const {
+
+    if (!pk_ready)
+        return -1;
+
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_VERIFY);
+
+    const BIGNUM* n = domain->get_n();
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_r = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_s = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_e = BN_CTX_get(tbn_ctx);
+
+    unsigned char arr_rx[EC_KEY_BYTES];
+    unsigned char arr_ry[EC_KEY_BYTES];
+    unsigned char arr_hash[SHA256_DIGEST_LENGTH];
+    int ret_code = -1;
+
+    if (tbn_e == nullptr)
+        goto out;
+
+    BN_bin2bn(arg_sig, EC_KEY_BYTES, tbn_r);
+    BN_bin2bn(arg_sig + EC_KEY_BYTES, EC_KEY_BYTES, tbn_s);
+
+    ret_code = 1;
+
+    if (BN_cmp(tbn_r, domain->get_p()) >= 0 || BN_cmp(tbn_s, n) >= 0)
+        goto out;
+
+    domain->do_tagged_hash(arr_hash, EC_TAG_CHALLENGE, arg_sig, pk.x, arg_msg, arg_len);
+
+    BN_bin2bn(arr_hash, sizeof(arr_hash), tbn_e);
+    BN_nnmod(tbn_e, tbn_e, n, tbn_ctx);
+
+    __STAT_LAP__(timer, STAGE_VERIFY_HASH);
+
+    /* R = s * G + (n - e) * P, a single double-scalar multiplication. */
+    if (!BN_is_zero(tbn_e))
+        BN_sub(tbn_e, n, tbn_e);
+
+    if ((ret_code = domain->do_dual_mul(arr_rx, arr_ry, tbn_s, pk, tbn_e, tbn_ctx)) != 0)
+        goto out;
+
+    __STAT_LAP__(timer, STAGE_VERIFY_COMMIT);
+
+    ret_code = (!(arr_ry[EC_KEY_BYTES - 1] & 1) &&
+        std::memcmp(arr_rx, arg_sig, EC_KEY_BYTES) == 0) ? 0 : 1;
+
+out:
+    BN_CTX_end(tbn_ctx);
+
+    if (ret_code != 0)
+        __STAT_COUNT__(COUNT_VERIFY_FAIL);
+
+    return ret_code;
+}
+
+
+
+int EE488::EcSchnorrKey::do_verify(
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    const BIGNUM* arg_s,
+    const BIGNUM* arg_e) const {
+
+    if (!pk_ready)
+        return -1;
+
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_VERIFY);
+
+    const BIGNUM* n = domain->get_n();
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_ne = BN_CTX_get(tbn_ctx);
+
+    unsigned char arr_rx[EC_KEY_BYTES];
+    unsigned char arr_ry[EC_KEY_BYTES];
+    unsigned char arr_hash[SHA256_DIGEST_LENGTH];
+    int ret_code = -1;
+
+    if (tbn_ne == nullptr)
+        goto out;
+
+    ret_code = 1;
+
+    if (BN_is_negative(arg_s) || BN_is_negative(arg_e) ||
+        BN_cmp(arg_s, n) >= 0 || BN_cmp(arg_e, n) >= 0)
+        goto out;
+
+    /* R = s * G + (n - e) * P, of even y */
+    BN_zero(tbn_ne);
+
+    if (!BN_is_zero(arg_e))
+        BN_sub(tbn_ne, n, arg_e);
+
+    if ((ret_code = domain->do_dual_mul(arr_rx, arr_ry, arg_s, pk, tbn_ne, tbn_ctx)) != 0)
+        goto out;
+
+    ret_code = 1;
+
+    if (arr_ry[EC_KEY_BYTES - 1] & 1)
+        goto out;
+
+    __STAT_LAP__(timer, STAGE_VERIFY_COMMIT);
+
+    domain->do_tagged_hash(arr_hash, EC_TAG_CHALLENGE, arr_rx, pk.x, arg_msg, arg_len);
+
+    BN_bin2bn(arr_hash, sizeof(arr_hash), tbn_ne);
+    BN_nnmod(tbn_ne, tbn_ne, n, tbn_ctx);
+
+    __STAT_LAP__(timer, STAGE_VERIFY_HASH);
+
+    ret_code = BN_cmp(tbn_ne, arg_e) ? 1 : 0;
+
+out:
+    BN_CTX_end(tbn_ctx);
+
+    if (ret_code != 0)
+        __STAT_COUNT__(COUNT_VERIFY_FAIL);
+
+    return ret_code;
+}
@@ -0,0 +1,190 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_ECSCHNORR_H
+#define __EE488_ECSCHNORR_H
+
+#include <memory>
+
+#include "./schnorr.h"
+#include "./secp256k1.h"
+
+#ifdef __OPENSSL
+#include <openssl/ec.h>
+#include <openssl/obj_mac.h>
+#endif
+
+
+namespace EE488 {
+
+    const int EC_SECP256K1 = NID_secp256k1;
+    const int EC_P256 = NID_X9_62_prime256v1;
+
+    const size_t EC_KEY_BYTES = 32;     // x-only public key
+    const size_t EC_SIG_BYTES = 64;     // R.x || s
+
+    enum {
+        EC_TAG_AUX = 0x00,
+        EC_TAG_NONCE,
+        EC_TAG_CHALLENGE,
+        EC_TAG_HALFAGG,                 // Randomizers of halfagg.h
+        EC_NTAGS
+    };
+
+
+    /* Public point, affine coordinates of 32 bytes, big-endian. The
+     *  EC_POINT is kept only when the curve goes through OpenSSL. */
+    struct EcPub {
+        unsigned char x[EC_KEY_BYTES];
+        unsigned char y[EC_KEY_BYTES];
+        std::shared_ptr<EC_POINT> point;
+    };
+
+
+    /*
+     * class EcDomain
+     *  A curve of 256 bits, with what is derived from it once: multiples of
+     *  the generator, and the midstates of the BIP-340 tagged hashes,
+     *  SHA256(SHA256(tag) || SHA256(tag) || ...), whose prefix is exactly
+     *  one block. secp256k1 runs on the built-in Secp256k1, P-256 on
+     *  EC_POINT_mul. Points in and out are bytes either way. Immutable after
+     *  construction.
+     */
+    class EcDomain {
+    private:
+        EC_GROUP* group;
+        bnw_t p, n;
+        int nid;
+
+        std::unique_ptr<const Secp256k1> k1;    // nullptr unless secp256k1
+
+        SHA256_CTX tags[EC_NTAGS];
+
+    public:
+        EcDomain(const int);
+        EcDomain(const EcDomain&) = delete;
+        ~EcDomain();
+
+        EcDomain& operator =(const EcDomain&) = delete;
+
+        /* H_tag(a || b || m) into 32 bytes. b may be nullptr. */
+        void do_tagged_hash(
+            unsigned char*,
+            const int,
+            const unsigned char*,
+            const unsigned char*,
+            const unsigned char*, size_t) const;
+
+        /* P of even y whose x is the 32 bytes given, 1 if there is none. */
+        int do_lift_x(EcPub&, const unsigned char*, BN_CTX*) const;
+
+        /* k * G as x and y, -1 if infinity or on error. k below n. */
+        int do_base_mul(unsigned char*, unsigned char*, const BIGNUM*, BN_CTX*) const;
+
+        /* s * G + e * P as x and y, 1 if infinity, -1 on error. Variable
+         *  time, for public values only. */
+        int do_dual_mul(
+            unsigned char*, unsigned char*,
+            const BIGNUM*, const EcPub&, const BIGNUM*, BN_CTX*) const;
+
+        /* s * G + e_1 * P_1 + ... + e_n * P_n, the same. s may be nullptr. */
+        int do_multi_mul(
+            unsigned char*, unsigned char*,
+            const BIGNUM*, const EcPub*, const BIGNUM* const*, const size_t, BN_CTX*) const;
+
+        /* Midstate of a tag, its prefix absorbed, for hashes of many parts. */
+        const SHA256_CTX& get_tag(const int arg_tag) const { return tags[arg_tag]; }
+
+        const EC_GROUP* get_group() const { return group; }
+        const BIGNUM* get_p() const { return p.actor; }
+        const BIGNUM* get_n() const { return n.actor; }
+        int get_nid() const { return nid; }
+
+        bool is_ready() const { return group != nullptr; }
+        bool is_builtin() const { return k1 != nullptr; }
+    };
+
+    using ecdm_t = EcDomain;
+
+    /* Shared domain of a curve, built on first use. nullptr when the curve
+     *  is not supported, EC_SECP256K1 and EC_P256 are. */
+    std::shared_ptr<const ecdm_t> get_ec_domain(const int);
+
+
+    /*
+     * class EcSchnorrKey
+     *  Schnorr over a curve as BIP-340 does. The public key is the x of P
+     *  with even y, 32 bytes, and the secret is negated when needed to match.
+     *  A signature is R.x || s, 64 bytes, with R of even y, where
+     *      e = H_challenge(R.x || P.x || m) mod n,  s = k + e * d mod n.
+     *  The same signature also reads as (s, e), as SchnorrSignature carries
+     *  it. k comes from H_nonce over the secret, P.x, m and 32 bytes of
+     *  auxiliary randomness, which are zeros when deterministic. Const and
+     *  re-entrant, as SchnorrKey.
+     */
+    class EcSchnorrKey {
+    private:
+        std::shared_ptr<const ecdm_t> domain;
+        EcPub pk;                               // Lifted once
+
+        bnw_t sk;
+        bool pk_ready, sk_ready;
+
+        bool deterministic;
+
+        int do_sign_core(
+            const unsigned char*, size_t,
+            const unsigned char*,       // aux
+            unsigned char*,             // R.x
+            BIGNUM*, BIGNUM*) const;    // s, e
+
+    public:
+        /* From the x-only public key, or from the secret alone when the key
+         *  is nullptr. is_pk_ready is false if the point is not on the curve. */
+        EcSchnorrKey(std::shared_ptr<const ecdm_t>, const unsigned char*, const BIGNUM*);
+        ~EcSchnorrKey() { BN_clear(sk.actor); }
+
+        /* 64 bytes. aux of 32 bytes is optional, drawn from the RNG if
+         *  nullptr and not deterministic. */
+        int do_sign(
+            const unsigned char*, size_t,
+            unsigned char*,
+            const unsigned char* = nullptr) const;
+
+        /* 0 when verified, 1 when not, -1 on error. */
+        int do_verify(const unsigned char*, size_t, const unsigned char*) const;
+
+        /* (s, e) form, R = s * G - e * P, then e is compared. */
+        int do_sign(const unsigned char*, size_t, BIGNUM*, BIGNUM*, const unsigned char* = nullptr) const;
+        int do_verify(const unsigned char*, size_t, const BIGNUM*, const BIGNUM*) const;
+
+        bool set_deterministic(const bool arg_det) { return (deterministic = arg_det); }
+        bool is_deterministic() const { return deterministic; }
+
+        const ecdm_t* get_domain() const { return domain.get(); }
+        std::shared_ptr<const ecdm_t> share_domain() const { return domain; }
+        const unsigned char* get_pk() const { return pk.x; }
+        const BIGNUM* get_sk() const { return sk.actor; }
+
+        bool is_pk_ready() const { return pk_ready; }
+        bool is_sk_ready() const { return sk_ready; }
+    };
+
+    using eckey_t = EcSchnorrKey;
+}
+
+#endif
@@ -0,0 +1,257 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./halfagg.h"
+
+
+namespace {
+
+    /* R.x || P.x || len(m) || m, the length as 8 bytes big-endian. */
+    void do_update_item(SHA256_CTX* arg_ctx, const unsigned char* arg_rx, const EE488::EcHalfAggItem& arg_item) {
+        unsigned char arr_len[8];
+
+        for (int i = 0; i < 8; i++)
+            arr_len[i] = static_cast<unsigned char>(static_cast<uint64_t>(arg_item.msg_len) >> (56 - 8 * i));
+
+        SHA256_Update(arg_ctx, arg_rx, EE488::EC_KEY_BYTES);
+        SHA256_Update(arg_ctx, arg_item.pk, EE488::EC_KEY_BYTES);
+        SHA256_Update(arg_ctx, arr_len, sizeof(arr_len));
+        SHA256_Update(arg_ctx, arg_item.msg, arg_item.msg_len);
+    }
+
+    /* z_i of the items so far, 1 for the first. The running context goes on. */
+    bool do_randomizer(BIGNUM* arg_z, const SHA256_CTX* arg_ctx, const size_t arg_i, const BIGNUM* arg_n, BN_CTX* arg_bn_ctx) {
+        if (arg_i == 0)
+            return BN_one(arg_z);
+
+        SHA256_CTX sha_context = *arg_ctx;
+        unsigned char arr_digest[SHA256_DIGEST_LENGTH];
+
+        return SHA256_Final(arr_digest, &sha_context) &&
+            BN_bin2bn(arr_digest, sizeof(arr_digest), arg_z) != nullptr &&
+            BN_nnmod(arg_z, arg_z, arg_n, arg_bn_ctx);
+    }
+};
+
+
+
+/*
+ * do_half_aggregate
+ */
+int EE488::do_half_aggregate(
+    unsigned char* arg_out,
+    const ecdm_t& arg_domain,
+    const EcHalfAggItem* arg_items,
+    const size_t arg_n) {
+
+    if (arg_n == 0)
+        return -1;
+
+    const BIGNUM* n = arg_domain.get_n();
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_acc = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_s = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_z = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_t = BN_CTX_get(tbn_ctx);
+
+    SHA256_CTX sha_context = arg_domain.get_tag(EC_TAG_HALFAGG);
+    int ret_code = -1;
+
+    if (tbn_t == nullptr)
+        goto out;
+
+    BN_zero(tbn_acc);
+
+    for (size_t i = 0; i < arg_n; i++) {
+        const EcHalfAggItem& item = arg_items[i];
+        unsigned char* rx = arg_out + i * EC_KEY_BYTES;
+
+        if (item.sig != nullptr) {
+            std::memcpy(rx, item.sig, EC_KEY_BYTES);
+
+            if (BN_bin2bn(item.sig, EC_KEY_BYTES, tbn_t) == nullptr ||
+                BN_bin2bn(item.sig + EC_KEY_BYTES, EC_KEY_BYTES, tbn_s) == nullptr ||
+                BN_cmp(tbn_t, arg_domain.get_p()) >= 0 || BN_cmp(tbn_s, n) >= 0)
+                goto out;
+        }
+        else {
+            /* R = s * G + (n - e) * P, of even y, and e of it, as do_verify. */
+            EcPub pub;
+            unsigned char arr_ry[EC_KEY_BYTES];
+            unsigned char arr_hash[SHA256_DIGEST_LENGTH];
+
+            if (item.s == nullptr || item.e == nullptr ||
+                BN_is_negative(item.s) || BN_is_negative(item.e) ||
+                BN_cmp(item.s, n) >= 0 || BN_cmp(item.e, n) >= 0 ||
+                arg_domain.do_lift_x(pub, item.pk, tbn_ctx) != 0)
+                goto out;
+
+            BN_zero(tbn_t);
+
+            if ((!BN_is_zero(item.e) && !BN_sub(tbn_t, n, item.e)) ||
+                arg_domain.do_dual_mul(rx, arr_ry, item.s, pub, tbn_t, tbn_ctx) != 0 ||
+                (arr_ry[EC_KEY_BYTES - 1] & 1))
+                goto out;
+
+            arg_domain.do_tagged_hash(arr_hash, EC_TAG_CHALLENGE, rx, item.pk, item.msg, item.msg_len);
+
+            if (BN_bin2bn(arr_hash, sizeof(arr_hash), tbn_t) == nullptr ||
+                !BN_nnmod(tbn_t, tbn_t, n, tbn_ctx) ||
+                BN_cmp(tbn_t, item.e) != 0 ||
+                BN_copy(tbn_s, item.s) == nullptr)
+                goto out;
+        }
+
+        do_update_item(&sha_context, rx, item);
+
+        /* s += z_i * s_i */
+        if (!do_randomizer(tbn_z, &sha_context, i, n, tbn_ctx) ||
+            !BN_mod_mul(tbn_t, tbn_z, tbn_s, n, tbn_ctx) ||
+            !BN_mod_add(tbn_acc, tbn_acc, tbn_t, n, tbn_ctx))
+            goto out;
+    }
+
+    if (BN_bn2binpad(tbn_acc, arg_out + arg_n * EC_KEY_BYTES, EC_KEY_BYTES) < 0)
+        goto out;
+
+    ret_code = 0;
+
+out:
+    BN_CTX_end(tbn_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_half_verify
+ */
+int EE488::do_half_verify(
+    const ecdm_t& arg_domain,
+    const EcHalfAggItem* arg_items,
+    const size_t arg_n,
+    const unsigned char* arg_agg,
+    size_t arg_len) {
+
+    if (arg_n == 0 || arg_len != get_halfagg_len(arg_n))
+        return -1;
+
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_VERIFY);
+
+    const BIGNUM* n = arg_domain.get_n();
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_s = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_e = BN_CTX_get(tbn_ctx);
+
+    /* R_i, then each distinct P once, with the sum of its z_i * e_i. An
+     *  archive of few signers is thus a multiplication of about n points. */
+    std::vector<EcPub> pubs(2 * arg_n);
+    std::vector<bnw_t> scalars(2 * arg_n);
+    std::vector<const BIGNUM*> exps(2 * arg_n);
+    std::unordered_map<std::string, size_t> signers;
+    size_t npoints = 0;
+
+    SHA256_CTX sha_context = arg_domain.get_tag(EC_TAG_HALFAGG);
+
+    unsigned char arr_hash[SHA256_DIGEST_LENGTH];
+    unsigned char arr_x[EC_KEY_BYTES], arr_y[EC_KEY_BYTES];
+
+    int ret_code = -1;
+
+    if (tbn_e == nullptr || BN_bin2bn(arg_agg + arg_n * EC_KEY_BYTES, EC_KEY_BYTES, tbn_s) == nullptr)
+        goto out;
+
+    ret_code = 1;
+
+    if (BN_cmp(tbn_s, n) >= 0)
+        goto out;
+
+    for (size_t i = 0; i < arg_n; i++) {
+        const EcHalfAggItem& item = arg_items[i];
+        const unsigned char* rx = arg_agg + i * EC_KEY_BYTES;
+
+        const size_t at_r = npoints++;
+        BIGNUM* z = scalars[at_r].actor;
+
+        /* An R off the curve fails, a pk off the curve is an error. */
+        if ((ret_code = arg_domain.do_lift_x(pubs[at_r], rx, tbn_ctx)) != 0)
+            goto out;
+
+        auto found = signers.emplace(std::string(reinterpret_cast<const char*>(item.pk), EC_KEY_BYTES), npoints);
+        const size_t at_p = found.first->second;
+
+        if (found.second) {
+            npoints++;
+
+            if (arg_domain.do_lift_x(pubs[at_p], item.pk, tbn_ctx) != 0) {
+                ret_code = -1;
+                goto out;
+            }
+
+            BN_zero(scalars[at_p].actor);
+        }
+
+        ret_code = -1;
+
+        /* e_i = H_challenge(R.x || P.x || m) mod n */
+        arg_domain.do_tagged_hash(arr_hash, EC_TAG_CHALLENGE, rx, item.pk, item.msg, item.msg_len);
+        do_update_item(&sha_context, rx, item);
+
+        if (BN_bin2bn(arr_hash, sizeof(arr_hash), tbn_e) == nullptr ||
+            !BN_nnmod(tbn_e, tbn_e, n, tbn_ctx) ||
+            !do_randomizer(z, &sha_context, i, n, tbn_ctx) ||
+            !BN_mod_mul(tbn_e, z, tbn_e, n, tbn_ctx) ||
+            !BN_mod_add(scalars[at_p].actor, scalars[at_p].actor, tbn_e, n, tbn_ctx))
+            goto out;
+    }
+
+    for (size_t i = 0; i < npoints; i++)
+        exps[i] = scalars[i].actor;
+
+    __STAT_LAP__(timer, STAGE_VERIFY_HASH);
+
+    /* (n - s) * G + sum of z_i * R_i + (z_i * e_i) * P_i is infinity. */
+    if (!BN_is_zero(tbn_s) && !BN_sub(tbn_s, n, tbn_s))
+        goto out;
+
+    ret_code = arg_domain.do_multi_mul(arr_x, arr_y, tbn_s, pubs.data(), exps.data(), npoints, tbn_ctx);
+
+    __STAT_LAP__(timer, STAGE_VERIFY_COMMIT);
+
+    if (ret_code >= 0)
+        ret_code = (ret_code == 1) ? 0 : 1;
+
+out:
+    BN_CTX_end(tbn_ctx);
+
+    if (ret_code != 0)
+        __STAT_COUNT__(COUNT_VERIFY_FAIL);
+
+    return ret_code;
+}
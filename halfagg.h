@@ -0,0 +1,67 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_HALFAGG_H
+#define __EE488_HALFAGG_H
+
+#include <cstddef>
+
+#include "./ecschnorr.h"
+
+
+namespace EE488 {
+
+    /*
+     * Half-aggregation
+     *  n signatures of EcSchnorrKey, of any signers and messages, into
+     *      R_1.x || ... || R_n.x || s,  s = z_1 * s_1 + ... + z_n * s_n mod n,
+     *  32 * (n + 1) bytes for 64 * n. z_1 = 1, and z_i is H_randomizer of
+     *  (R_j.x || P_j.x || len(m_j) || m_j) for all j up to i, thus no s_i
+     *  can be traded against another. Offline, without the signers. The
+     *  aggregate holds iff
+     *      s * G = sum of z_i * R_i + (z_i * e_i) * P_i,
+     *  checked by one multi-scalar multiplication over 2n points. The
+     *  x-only R of BIP-340 is what makes it half, thus curves only.
+     */
+    inline size_t get_halfagg_len(const size_t arg_n) { return (arg_n + 1) * EC_KEY_BYTES; }
+
+    /*
+     * struct EcHalfAggItem
+     *  A (pk, message, signature) tuple. The signature is R.x || s of 64
+     *  bytes, or (s, e) of do_sign when sig is nullptr, whose R is recovered
+     *  as s * G - e * P. Verify reads pk and the message only.
+     */
+    struct EcHalfAggItem {
+        const unsigned char* pk;    // x-only, 32 bytes
+        const unsigned char* msg;
+        size_t msg_len;
+
+        const unsigned char* sig;   // nullptr for (s, e)
+        const BIGNUM* s;
+        const BIGNUM* e;
+    };
+
+    /* Aggregate into get_halfagg_len(n) bytes. 64 byte signatures are not
+     *  verified, a bad one makes a bad aggregate. (s, e) is, by the way its
+     *  R is recovered, and refused when it does not hold. 0, or -1. */
+    int do_half_aggregate(unsigned char*, const ecdm_t&, const EcHalfAggItem*, const size_t);
+
+    /* 0 when all n verified, 1 when not, -1 on error. */
+    int do_half_verify(const ecdm_t&, const EcHalfAggItem*, const size_t, const unsigned char*, size_t);
+}
+
+#endif
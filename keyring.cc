@@ -0,0 +1,372 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "./keyring.h"
+
+
+namespace {
+
+    inline void do_put_u32(unsigned char* arg_out, const uint32_t arg_val) {
+        for (int i = 0; i < 4; i++)
+            arg_out[i] = static_cast<unsigned char>(arg_val >> (24 - 8 * i));
+    }
+
+    inline void do_put_u64(unsigned char* arg_out, const uint64_t arg_val) {
+        for (int i = 0; i < 8; i++)
+            arg_out[i] = static_cast<unsigned char>(arg_val >> (56 - 8 * i));
+    }
+
+    inline uint32_t do_get_u32(const unsigned char* arg_in) {
+        uint32_t val = 0;
+        for (int i = 0; i < 4; i++) val = (val << 8) | arg_in[i];
+        return val;
+    }
+
+    inline uint64_t do_get_u64(const unsigned char* arg_in) {
+        uint64_t val = 0;
+        for (int i = 0; i < 8; i++) val = (val << 8) | arg_in[i];
+        return val;
+    }
+
+    inline uint64_t get_page_up(const uint64_t arg_len) {
+        return (arg_len + EE488::KEYRING_PAGE - 1) / EE488::KEYRING_PAGE * EE488::KEYRING_PAGE;
+    }
+
+    /* Bucket of an id, the finalizer of splitmix64. Ids are often serial,
+     *  thus mixed before taking the low bits. */
+    inline uint64_t get_bucket(uint64_t arg_id, const uint64_t arg_cap) {
+        arg_id ^= arg_id >> 30, arg_id *= 0xbf58476d1ce4e5b9ULL;
+        arg_id ^= arg_id >> 27, arg_id *= 0x94d049bb133111ebULL;
+        arg_id ^= arg_id >> 31;
+
+        return arg_id & (arg_cap - 1);
+    }
+
+    bool do_write_all(const int arg_fd, const unsigned char* arg_buf, size_t arg_len) {
+        while (arg_len > 0) {
+            const ssize_t n = ::write(arg_fd, arg_buf, arg_len);
+
+            if (n <= 0) return false;
+
+            arg_buf += n;
+            arg_len -= static_cast<size_t>(n);
+        }
+
+        return true;
+    }
+};
+
+
+
+/*
+ * do_write_keyring
+ */
+int EE488::do_write_keyring(
+    const char* arg_path,
+    const BIGNUM* arg_p,
+    const BIGNUM* arg_q,
+    const BIGNUM* arg_g,
+    const bool arg_toy,
+    const uint64_t* arg_ids,
+    const BIGNUM* const* arg_pks,
+    const size_t arg_n,
+    const bool arg_secret) {
+
+    const size_t w = get_pk_width(arg_p);
+    const size_t pqg_len = get_pqg_len(w, BN_num_bytes(arg_q));
+
+    /* id, then the pk record, up to a multiple of 8. */
+    const uint64_t slot_len = (8 + get_pk_len(w) + 7) / 8 * 8;
+
+    uint64_t index_cap = 1;
+    while (index_cap < 2 * arg_n) index_cap <<= 1;
+
+    const uint64_t keys_off = get_page_up(KEYRING_HDR_LEN + pqg_len);
+    const uint64_t index_off = keys_off + get_page_up(arg_n * slot_len);
+    const uint64_t file_len = index_off + get_page_up(index_cap * KEYRING_BUCKET_LEN);
+
+    /* Header and keys */
+    std::vector<unsigned char> head(index_off, 0);
+
+    std::memcpy(head.data(), KEYRING_MAGIC, sizeof(KEYRING_MAGIC));
+    do_put_u32(&head[8], KEYRING_VERSION);
+    do_put_u32(&head[12], (arg_toy ? KEYRING_FLAG_TOY : 0) | (arg_secret ? KEYRING_FLAG_SECRET : 0));
+    do_put_u64(&head[16], arg_n);
+    do_put_u64(&head[24], slot_len);
+    do_put_u64(&head[32], index_cap);
+    do_put_u64(&head[40], keys_off);
+    do_put_u64(&head[48], index_off);
+    do_put_u64(&head[56], file_len);
+    do_put_u32(&head[64], static_cast<uint32_t>(pqg_len));
+
+    if (do_encode_pqg(&head[KEYRING_HDR_LEN], pqg_len, arg_p, arg_q, arg_g) < 0)
+        return -1;
+
+    /* Index, the slot of each id */
+    std::vector<unsigned char> index(get_page_up(index_cap * KEYRING_BUCKET_LEN), 0);
+
+    for (size_t i = 0; i < arg_n; i++) {
+        unsigned char* slot = &head[keys_off + i * slot_len];
+
+        do_put_u64(slot, arg_ids[i]);
+        if (do_encode_pk(slot + 8, get_pk_len(w), arg_pks[i], w) < 0) {
+            OPENSSL_cleanse(head.data(), head.size());
+            return -1;
+        }
+
+        uint64_t b = get_bucket(arg_ids[i], index_cap);
+
+        while (do_get_u64(&index[b * KEYRING_BUCKET_LEN + 8]) != 0) {
+            if (do_get_u64(&index[b * KEYRING_BUCKET_LEN]) == arg_ids[i]) {
+                OPENSSL_cleanse(head.data(), head.size());
+                return -1;      // Duplicate
+            }
+
+            b = (b + 1) & (index_cap - 1);
+        }
+
+        do_put_u64(&index[b * KEYRING_BUCKET_LEN], arg_ids[i]);
+        do_put_u64(&index[b * KEYRING_BUCKET_LEN + 8], i + 1);
+    }
+
+    /* Into a temporary file, renamed over the path when complete. A secret
+     *  one is of the owner alone, whatever the umask. */
+    const std::string tmp_path = std::string(arg_path) + ".tmp";
+
+    const int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, arg_secret ? 0600 : 0644);
+    if (fd < 0) {
+        OPENSSL_cleanse(head.data(), head.size());
+        return -1;
+    }
+
+    const bool written =
+        (!arg_secret || ::fchmod(fd, 0600) == 0) &&
+        do_write_all(fd, head.data(), head.size()) &&
+        do_write_all(fd, index.data(), index.size()) &&
+        ::fsync(fd) == 0;
+
+    ::close(fd);
+
+    if (arg_secret)
+        OPENSSL_cleanse(head.data(), head.size());
+
+    if (!written || std::rename(tmp_path.c_str(), arg_path) != 0) {
+        ::unlink(tmp_path.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+/*
+ * Keyring Actions */
+EE488::Keyring::Keyring() :
+    fd(-1), base(nullptr), len(0),
+    nkeys(0), slot_len(0), index_cap(0), secret(false),
+    keys(nullptr), index(nullptr) { }
+
+
+
+EE488::Keyring::~Keyring() {
+    do_close();
+}
+
+
+
+/*
+ * do_open
+ */
+int EE488::Keyring::do_open(const char* arg_path) {
+
+    do_close();
+
+    fd = ::open(arg_path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < KEYRING_PAGE) {
+        do_close();
+        return -1;
+    }
+
+    void* mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        do_close();
+        return -1;
+    }
+
+    base = static_cast<const unsigned char*>(mapped);
+    len = static_cast<size_t>(st.st_size);
+
+    /* The header, checked against the size of the file before any use. The
+     *  counts by division, their products may wrap around 64 bits. */
+    const uint64_t flags = do_get_u32(base + 12);
+    const uint64_t keys_off = do_get_u64(base + 40);
+    const uint64_t index_off = do_get_u64(base + 48);
+    const uint64_t pqg_len = do_get_u32(base + 64);
+
+    nkeys = do_get_u64(base + 16);
+    slot_len = do_get_u64(base + 24);
+    index_cap = do_get_u64(base + 32);
+
+    WirePqgView pqg;
+
+    if (std::memcmp(base, KEYRING_MAGIC, sizeof(KEYRING_MAGIC)) != 0 ||
+        do_get_u32(base + 8) != KEYRING_VERSION ||
+        do_get_u64(base + 56) != len ||
+        index_cap == 0 || (index_cap & (index_cap - 1)) != 0 || index_cap < nkeys ||
+        slot_len < 8 + WIRE_HDR_LEN ||
+        KEYRING_HDR_LEN + pqg_len > keys_off ||
+        keys_off > index_off || index_off > len ||
+        nkeys > (index_off - keys_off) / slot_len ||
+        index_cap > (len - index_off) / KEYRING_BUCKET_LEN ||
+        do_parse_pqg(base + KEYRING_HDR_LEN, pqg_len, pqg) < 0) {
+
+        do_close();
+        return -1;
+    }
+
+    keys = base + keys_off;
+    index = base + index_off;
+    secret = (flags & KEYRING_FLAG_SECRET) != 0;
+
+    /* Lookups land anywhere in the index. */
+    ::madvise(mapped, len, MADV_RANDOM);
+
+    bnw_t p, q, g;
+    do_load_pqg(pqg, p.actor, q.actor, g.actor);
+
+    domain = std::make_shared<const sdm_t>(
+        p.actor, q.actor, g.actor, (flags & KEYRING_FLAG_TOY) != 0, 0);
+
+    return 0;
+}
+
+
+
+/*
+ * do_close
+ */
+void EE488::Keyring::do_close() {
+
+    if (base != nullptr)
+        ::munmap(const_cast<unsigned char*>(base), len);
+
+    if (fd >= 0)
+        ::close(fd);
+
+    fd = -1, base = nullptr, len = 0;
+    nkeys = slot_len = index_cap = 0;
+    secret = false;
+    keys = index = nullptr;
+
+    domain.reset();
+}
+
+
+
+/*
+ * do_find
+ */
+int EE488::Keyring::do_find(const uint64_t arg_id, WirePkView& arg_view) const {
+
+    if (base == nullptr)
+        return -1;
+
+    uint64_t b = get_bucket(arg_id, index_cap);
+
+    for (uint64_t n = 0; n < index_cap; n++) {
+        const unsigned char* bucket = index + b * KEYRING_BUCKET_LEN;
+        const uint64_t slot = do_get_u64(bucket + 8);
+
+        if (slot == 0 || slot > nkeys)
+            return -1;
+
+        if (do_get_u64(bucket) == arg_id) {
+            const unsigned char* entry = keys + (slot - 1) * slot_len;
+
+            return do_parse_pk(entry + 8, slot_len - 8, arg_view) < 0 ? -1 : 0;
+        }
+
+        b = (b + 1) & (index_cap - 1);
+    }
+
+    return -1;
+}
+
+
+
+/*
+ * do_get_slot
+ */
+int EE488::Keyring::do_get_slot(const uint64_t arg_i, uint64_t& arg_id, WirePkView& arg_view) const {
+
+    if (base == nullptr || arg_i >= nkeys)
+        return -1;
+
+    const unsigned char* entry = keys + arg_i * slot_len;
+
+    arg_id = do_get_u64(entry);
+
+    return do_parse_pk(entry + 8, slot_len - 8, arg_view) < 0 ? -1 : 0;
+}
+
+
+
+/*
+ * do_verify
+ */
+int EE488::Keyring::do_verify(
+    const uint64_t arg_id,
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    const BIGNUM* arg_s,
+    const BIGNUM* arg_e,
+    const int arg_bitn,
+    vcache_t* arg_cache) const {
+
+    WirePkView view;
+
+    if (secret || do_find(arg_id, view) != 0)
+        return -1;
+
+    /* pk from the mapping into the thread's scratch, for this call only. */
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_pk = BN_CTX_get(tbn_ctx);
+    int ret_code = -1;
+
+    if (tbn_pk != nullptr && do_load_pk(view, tbn_pk) == 0)
+        ret_code = domain->do_verify(tbn_pk, arg_msg, arg_len, arg_s, arg_e, arg_bitn, arg_cache);
+
+    BN_CTX_end(tbn_ctx);
+
+    return ret_code;
+}
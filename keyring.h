@@ -0,0 +1,134 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_KEYRING_H
+#define __EE488_KEYRING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "./schnorr.h"
+#include "./wire.h"
+
+
+namespace EE488 {
+
+    /*
+     * Keyring file
+     *  Public keys of one domain by a 64 bit key id, read through mmap. All
+     *  integers are big-endian, as the wire format. Three parts, each
+     *  starting on a page:
+     *
+     *  Header: magic[8] | version (u32) | flags (u32) | nkeys (u64)
+     *          | slot_len (u64) | index_cap (u64) | keys_off (u64)
+     *          | index_off (u64) | file_len (u64) | pqg_len (u32) | pqg
+     *  Keys  : nkeys slots of slot_len, id (u64) | pk record of wire.h
+     *  Index : index_cap buckets, id (u64) | slot + 1 (u64), 0 if empty.
+     *          Open addressing, linear probing from a hash of the id, at
+     *          most half full.
+     *
+     *  The pqg is a domain record of wire.h. flags bit 0 is the toy, bit 1
+     *  a secret keyring: sk in place of pk, of mode 0600, as a signing
+     *  daemon keeps its keys.
+     */
+    const char KEYRING_MAGIC[8] = { 'E', 'E', '4', '8', '8', 'K', 'R', 'G' };
+    const uint32_t KEYRING_VERSION = 1;
+    const uint32_t KEYRING_FLAG_TOY = 1;
+    const uint32_t KEYRING_FLAG_SECRET = 2;
+
+    const size_t KEYRING_PAGE = 4096;
+    const size_t KEYRING_HDR_LEN = 72;      // Up to pqg
+    const size_t KEYRING_BUCKET_LEN = 16;
+
+    /* Writes n (id, pk) of the domain into a keyring at the path, through a
+     *  temporary file renamed over it, thus readers never see half of one.
+     *  -1 on a duplicate id, a pk that does not fit, or a failed write. A
+     *  secret keyring takes (id, sk) instead. */
+    int do_write_keyring(
+        const char*,
+        const BIGNUM*, const BIGNUM*, const BIGNUM*,   // p, q, g
+        const bool,                                     // toy
+        const uint64_t*,
+        const BIGNUM* const*,
+        const size_t,
+        const bool = false);                            // secret
+
+
+    /*
+     * class Keyring
+     *  A keyring file, mapped read-only. Opening reads the header and the
+     *  domain, nothing per key, thus takes the same time for any number of
+     *  keys, and the pages are shared with every other process that maps
+     *  the file. A lookup probes the index in place and points into the key
+     *  array, pk becomes a BIGNUM only on do_verify, in the BN_CTX of the
+     *  thread. Immutable once open, thus shared among threads.
+     */
+    class Keyring {
+    private:
+        int fd;
+        const unsigned char* base;
+        size_t len;
+
+        uint64_t nkeys, slot_len, index_cap;
+        bool secret;
+        const unsigned char* keys;
+        const unsigned char* index;
+
+        std::shared_ptr<const sdm_t> domain;
+
+    public:
+        Keyring();
+        Keyring(const Keyring&) = delete;
+        ~Keyring();
+
+        Keyring& operator =(const Keyring&) = delete;
+
+        /* 0 when mapped, -1 if the file is not a keyring or is cut short. */
+        int do_open(const char*);
+        void do_close();
+
+        /* pk of the id in the mapping, -1 if there is no such id. */
+        int do_find(const uint64_t, WirePkView&) const;
+
+        /* id and pk of the i-th slot, in the order written, for loading all
+         *  keys of a secret keyring. -1 past the last. */
+        int do_get_slot(const uint64_t, uint64_t&, WirePkView&) const;
+
+        /* SchnorrDomain::do_verify with pk of the id. 0 verified, 1 not,
+         *  -1 if there is no such id, or the keyring is secret. */
+        int do_verify(
+            const uint64_t,
+            const unsigned char*, size_t,
+            const BIGNUM*, const BIGNUM*,
+            const int,
+            vcache_t* = nullptr) const;
+
+        uint64_t get_nkeys() const { return nkeys; }
+        size_t get_len() const { return len; }
+
+        const sdm_t* get_domain() const { return domain.get(); }
+        std::shared_ptr<const sdm_t> share_domain() const { return domain; }
+
+        bool is_open() const { return base != nullptr; }
+        bool is_secret() const { return secret; }
+    };
+
+    using kring_t = Keyring;
+}
+
+#endif
@@ -0,0 +1,303 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+
+#include "./logger.h"
+
+
+namespace {
+
+    const char* level_tags[] = { "", "E", "I", "D", "T" };
+
+    int do_initial_level() {
+
+        const char* env = std::getenv("EE488_LOG");
+
+        if (env != nullptr) {
+            if (!std::strcmp(env, "error")) return EE488::LOG_ERROR;
+            if (!std::strcmp(env, "info"))  return EE488::LOG_INFO;
+            if (!std::strcmp(env, "debug")) return EE488::LOG_DEBUG;
+            if (!std::strcmp(env, "trace")) return EE488::LOG_TRACE;
+            if (!std::strcmp(env, "off"))   return EE488::LOG_OFF;
+        }
+
+#ifdef __PRINT
+        return EE488::LOG_TRACE;
+#else
+        return EE488::LOG_OFF;
+#endif
+    }
+
+    /* "\t[D] fname:: ", returns its length. */
+    size_t do_put_prefix(char* arg_out, const int arg_level, const char* arg_fname) {
+        int len = std::snprintf(arg_out, EE488::LOG_SLOT_LEN, "\t[%s] %s:: ",
+            level_tags[(arg_level >= 0 && arg_level <= EE488::LOG_TRACE) ? arg_level : 0], arg_fname);
+
+        return std::min<size_t>(std::max(len, 0), EE488::LOG_SLOT_LEN - 2);
+    }
+};
+
+
+std::atomic<int> EE488::log_level(do_initial_level());
+
+
+
+/*
+ * Logger Actions */
+EE488::Logger::Logger() :
+    slots(new Slot[LOG_NSLOTS]),
+    head(0),
+    tail(0),
+    stopping(false),
+    ndropped(0),
+    file(nullptr),
+    to_stdout(true) {
+
+    for (size_t i = 0; i < LOG_NSLOTS; i++)
+        slots[i].seq.store(i, std::memory_order_relaxed);
+
+    drainer = std::thread(&Logger::do_work, this);
+}
+
+
+
+EE488::Logger::~Logger() {
+
+    stopping = true;
+    drainer.join();
+
+    do_drain();     // Whatever came in the meantime
+
+    if (file != nullptr)
+        std::fclose(file);
+}
+
+
+
+EE488::Logger& EE488::Logger::get_instance() {
+
+    static Logger logger;
+    return logger;
+}
+
+
+
+/*
+ * do_claim
+ */
+EE488::Logger::Slot* EE488::Logger::do_claim() {
+
+    /* Bounded MPSC ring. A slot whose seq equals the position is free. */
+    size_t pos = head.load(std::memory_order_relaxed);
+
+    for (;;) {
+        Slot* slot = &slots[pos & (LOG_NSLOTS - 1)];
+        const size_t seq = slot->seq.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                return slot;
+        }
+        else if (diff < 0) {
+            ndropped.fetch_add(1, std::memory_order_relaxed);   // Full
+            return nullptr;
+        }
+        else
+            pos = head.load(std::memory_order_relaxed);
+    }
+}
+
+
+
+void EE488::Logger::do_publish(Slot* arg_slot, size_t arg_len) {
+
+    /* Records are text. Raw bytes, e.g. of r in a hashed string, are dotted. */
+    for (size_t i = 0; i < arg_len; i++) {
+        const unsigned char c = arg_slot->text[i];
+
+        if ((c < 0x20 && c != '\t') || c >= 0x7f)
+            arg_slot->text[i] = '.';
+    }
+
+    arg_slot->text[arg_len++] = '\n';
+    arg_slot->len = arg_len;
+
+    /* seq of a claimed slot is its position, thus pos + 1. */
+    arg_slot->seq.store(arg_slot->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+
+/*
+ * do_log, do_logf, do_log_bn
+ */
+void EE488::Logger::do_log(const int arg_level, const char* arg_fname, const char* arg_msg) {
+
+    Slot* slot = do_claim();
+    if (slot == nullptr) return;
+
+    size_t len = do_put_prefix(slot->text, arg_level, arg_fname);
+    size_t msg_len = std::min(std::strlen(arg_msg), LOG_SLOT_LEN - 1 - len);
+
+    std::memcpy(slot->text + len, arg_msg, msg_len);
+
+    do_publish(slot, len + msg_len);
+}
+
+
+
+void EE488::Logger::do_logf(const int arg_level, const char* arg_fname, const char* arg_fmt, ...) {
+
+    Slot* slot = do_claim();
+    if (slot == nullptr) return;
+
+    size_t len = do_put_prefix(slot->text, arg_level, arg_fname);
+
+    va_list args;
+    va_start(args, arg_fmt);
+    int nwritten = std::vsnprintf(slot->text + len, LOG_SLOT_LEN - 1 - len, arg_fmt, args);
+    va_end(args);
+
+    len += std::min<size_t>(std::max(nwritten, 0), LOG_SLOT_LEN - 2 - len);
+
+    do_publish(slot, len);
+}
+
+
+
+void EE488::Logger::do_log_bn(const int arg_level, const char* arg_fname, const char* arg_label, const BIGNUM* arg_num) {
+
+    /* Hex, as BN_print_fp does, without BN_bn2hex allocating. */
+    static const char digits[] = "0123456789ABCDEF";
+    unsigned char arr_bin[LOG_SLOT_LEN / 2];
+
+    Slot* slot = do_claim();
+    if (slot == nullptr) return;
+
+    size_t len = do_put_prefix(slot->text, arg_level, arg_fname);
+    size_t label_len = std::min(std::strlen(arg_label), LOG_SLOT_LEN - 1 - len);
+
+    std::memcpy(slot->text + len, arg_label, label_len);
+    len += label_len;
+
+    const int nbytes = BN_num_bytes(arg_num);
+
+    if (nbytes == 0 && len < LOG_SLOT_LEN - 1)
+        slot->text[len++] = '0';
+
+    else if (nbytes <= static_cast<int>(sizeof(arr_bin))) {
+        BN_bn2bin(arg_num, arr_bin);
+
+        for (int i = 0; i < nbytes && len + 2 < LOG_SLOT_LEN; i++) {
+            slot->text[len++] = digits[arr_bin[i] >> 4];
+            slot->text[len++] = digits[arr_bin[i] & 0xf];
+        }
+    }
+
+    do_publish(slot, len);
+}
+
+
+
+/*
+ * do_drain
+ */
+size_t EE488::Logger::do_drain() {
+
+    /* The only consumer. Stops at the first slot not written yet. */
+    std::lock_guard<std::mutex> guard(sink_lock);
+
+    size_t pos = tail.load(std::memory_order_relaxed);
+    size_t ndone = 0;
+
+    for (;;) {
+        Slot* slot = &slots[pos & (LOG_NSLOTS - 1)];
+
+        if (slot->seq.load(std::memory_order_acquire) != pos + 1)
+            break;
+
+        if (to_stdout)          std::fwrite(slot->text, 1, slot->len, stdout);
+        if (file != nullptr)    std::fwrite(slot->text, 1, slot->len, file);
+
+        slot->seq.store(pos + LOG_NSLOTS, std::memory_order_release);
+        pos++, ndone++;
+    }
+
+    if (ndone) {
+        if (to_stdout)          std::fflush(stdout);
+        if (file != nullptr)    std::fflush(file);
+    }
+
+    tail.store(pos, std::memory_order_release);
+
+    return ndone;
+}
+
+
+
+void EE488::Logger::do_work() {
+
+    /* Polls with a short sleep when idle, thus producers need no wakeup. */
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (do_drain() == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+
+
+/*
+ * do_flush
+ */
+void EE488::Logger::do_flush() {
+
+    const size_t target = head.load(std::memory_order_acquire);
+
+    while (tail.load(std::memory_order_acquire) < target)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+
+
+/*
+ * Sinks */
+int EE488::Logger::set_file(const char* arg_path) {
+
+    std::lock_guard<std::mutex> guard(sink_lock);
+
+    if (file != nullptr)
+        std::fclose(file), file = nullptr;
+
+    if (arg_path == nullptr)
+        return 0;
+
+    file = std::fopen(arg_path, "a");
+    return (file == nullptr) ? -1 : 0;
+}
+
+
+
+void EE488::Logger::set_stdout(const bool arg_on) {
+
+    std::lock_guard<std::mutex> guard(sink_lock);
+    to_stdout = arg_on;
+}
@@ -0,0 +1,129 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_LOGGER_H
+#define __EE488_LOGGER_H
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <openssl/bn.h>
+
+
+namespace EE488 {
+
+    enum LogLevel {
+        LOG_OFF = 0,
+        LOG_ERROR,
+        LOG_INFO,
+        LOG_DEBUG,
+        LOG_TRACE       // Values of numbers, messages
+    };
+
+    const size_t LOG_NSLOTS = 1024;         // Power of two
+    const size_t LOG_SLOT_LEN = 1024;       // Longer records are cut
+
+    /* Current level. Checked before anything is formatted, thus a disabled
+     *  record costs a single load. Initial level is LOG_TRACE when built
+     *  with __PRINT, LOG_OFF otherwise. EE488_LOG=error|info|debug|trace|off
+     *  in the environment overrides it. */
+    extern std::atomic<int> log_level;
+
+    inline bool is_log_enabled(const int arg_level) {
+        return arg_level <= log_level.load(std::memory_order_relaxed);
+    }
+
+    inline void set_log_level(const int arg_level) { log_level.store(arg_level, std::memory_order_relaxed); }
+    inline int get_log_level() { return log_level.load(std::memory_order_relaxed); }
+
+
+    /*
+     * class Logger
+     *  Records are formatted by the caller into a slot of a bounded ring,
+     *  and written out by a background thread. Producers never block nor
+     *  touch a file: a slot is claimed by a CAS on the head, and when the
+     *  ring is full, the record is dropped and counted. Started on its
+     *  first record, drained at exit.
+     */
+    class Logger {
+    private:
+        struct Slot {
+            std::atomic<size_t> seq;    // pos when free, pos + 1 when written
+            size_t len;
+            char text[LOG_SLOT_LEN];
+        };
+
+        std::unique_ptr<Slot[]> slots;
+
+        alignas(64) std::atomic<size_t> head;   // Next slot to claim
+        alignas(64) std::atomic<size_t> tail;   // Next slot to write out
+
+        std::atomic<bool> stopping;
+        std::atomic<unsigned long> ndropped;
+
+        std::mutex sink_lock;                   // Sinks, not the ring
+        FILE* file;
+        bool to_stdout;
+
+        std::thread drainer;
+
+        Slot* do_claim();
+        void do_publish(Slot*, size_t);
+        size_t do_drain();
+        void do_work();
+
+    public:
+        Logger();
+        ~Logger();
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        static Logger& get_instance();
+
+        void do_log(const int, const char*, const char*);
+        void do_logf(const int, const char*, const char*, ...) __attribute__((format(printf, 4, 5)));
+        void do_log_bn(const int, const char*, const char*, const BIGNUM*);
+
+        /* Blocks until every record logged before the call is written. */
+        void do_flush();
+
+        /* Sinks. The file is appended to, nullptr closes it. */
+        int set_file(const char*);
+        void set_stdout(const bool);
+
+        unsigned long get_ndropped() const { return ndropped.load(std::memory_order_relaxed); }
+    };
+
+    using logger_t = Logger;
+
+
+    /* Shorthands, check the level first. */
+    inline void do_log(const int arg_level, const char* arg_fname, const char* arg_msg) {
+        if (is_log_enabled(arg_level)) Logger::get_instance().do_log(arg_level, arg_fname, arg_msg);
+    }
+
+    inline void do_log_bn(const int arg_level, const char* arg_fname, const char* arg_label, const BIGNUM* arg_num) {
+        if (is_log_enabled(arg_level)) Logger::get_instance().do_log_bn(arg_level, arg_fname, arg_label, arg_num);
+    }
+}
+
+#endif
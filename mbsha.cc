@@ -0,0 +1,381 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "./schnorr.h"
+#include "./mbsha.h"
+
+/* The kernels need AVX2 or AVX-512, checked at run time. The rest of the
+ *  build stays on the baseline ISA. */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define __EE488_MBSHA_SIMD
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
+
+namespace {
+
+    const size_t SHA_BLOCK = 64;
+
+    const uint32_t SHA_IV[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    const uint32_t SHA_K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+
+    /* Blocks of a message after padding: 0x80, zeros, 64 bit length. */
+    size_t get_nblocks(const EE488::shain_t& arg_in) {
+        return (arg_in.head_len + arg_in.tail_len + 9 + SHA_BLOCK - 1) / SHA_BLOCK;
+    }
+
+
+    /*
+     * get_block
+     *  Block j of head || tail, padded. Points into head when the block
+     *  lies there as a whole, otherwise is put together in arg_scratch.
+     */
+    const unsigned char* get_block(const EE488::shain_t& arg_in, const size_t arg_j, unsigned char* arg_scratch) {
+
+        const size_t off = arg_j * SHA_BLOCK;
+
+        if (off + SHA_BLOCK <= arg_in.head_len)
+            return arg_in.head + off;
+
+        const size_t total = arg_in.head_len + arg_in.tail_len;
+
+        if (off >= arg_in.head_len && off + SHA_BLOCK <= total)
+            return arg_in.tail + (off - arg_in.head_len);
+
+        std::memset(arg_scratch, 0, SHA_BLOCK);
+
+        if (off < arg_in.head_len)
+            std::memcpy(arg_scratch, arg_in.head + off, arg_in.head_len - off);
+
+        const size_t tail_from = std::max(off, arg_in.head_len);
+        const size_t tail_to = std::min(off + SHA_BLOCK, total);
+
+        if (tail_to > tail_from)
+            std::memcpy(arg_scratch + (tail_from - off), arg_in.tail + (tail_from - arg_in.head_len), tail_to - tail_from);
+
+        if (total >= off && total < off + SHA_BLOCK)
+            arg_scratch[total - off] = 0x80;
+
+        /* Length in bits, big-endian, at the end of the last block. */
+        if (arg_j + 1 == get_nblocks(arg_in)) {
+            const uint64_t bits = static_cast<uint64_t>(total) * 8;
+
+            for (int i = 0; i < 8; i++)
+                arg_scratch[SHA_BLOCK - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+        }
+
+        return arg_scratch;
+    }
+
+
+    uint32_t get_be32(const unsigned char* arg_p) {
+        return (uint32_t(arg_p[0]) << 24) | (uint32_t(arg_p[1]) << 16) |
+            (uint32_t(arg_p[2]) << 8) | uint32_t(arg_p[3]);
+    }
+
+
+    /*
+     * Lanes
+     *  State and schedule words of all lanes, word major, thus a vector
+     *  load takes word i of every lane.
+     */
+    template <size_t LANES>
+    struct Lanes {
+        alignas(64) uint32_t h[8][LANES];
+        alignas(64) uint32_t w[16][LANES];
+    };
+
+
+    /*
+     * do_group
+     *  Up to LANES messages through KERNEL, in lockstep by block. A lane
+     *  past its last block gets a zero block, and the kernel leaves its
+     *  state as it is by the mask of active lanes.
+     */
+    template <size_t LANES, void (*KERNEL)(Lanes<LANES>&, const uint32_t)>
+    void do_group(unsigned char* arg_out, const EE488::shain_t* arg_in, const size_t arg_n) {
+
+        static const unsigned char zero_block[SHA_BLOCK] = { 0, };
+
+        Lanes<LANES> lanes;
+        unsigned char arr_scratch[LANES][SHA_BLOCK];
+        size_t arr_nblocks[LANES] = { 0, };
+        size_t maxb = 0;
+
+        for (size_t l = 0; l < arg_n; l++) {
+            arr_nblocks[l] = get_nblocks(arg_in[l]);
+            maxb = std::max(maxb, arr_nblocks[l]);
+        }
+
+        for (size_t i = 0; i < 8; i++)
+            for (size_t l = 0; l < LANES; l++)
+                lanes.h[i][l] = SHA_IV[i];
+
+        for (size_t j = 0; j < maxb; j++) {
+            uint32_t mask = 0;
+
+            for (size_t l = 0; l < LANES; l++) {
+                const unsigned char* block = zero_block;
+
+                if (j < arr_nblocks[l]) {
+                    block = get_block(arg_in[l], j, arr_scratch[l]);
+                    mask |= 1u << l;
+                }
+
+                for (size_t i = 0; i < 16; i++)
+                    lanes.w[i][l] = get_be32(block + 4 * i);
+            }
+
+            KERNEL(lanes, mask);
+        }
+
+        for (size_t l = 0; l < arg_n; l++)
+            for (size_t i = 0; i < 8; i++) {
+                const uint32_t word = lanes.h[i][l];
+                unsigned char* out = arg_out + 32 * l + 4 * i;
+
+                out[0] = static_cast<unsigned char>(word >> 24);
+                out[1] = static_cast<unsigned char>(word >> 16);
+                out[2] = static_cast<unsigned char>(word >> 8);
+                out[3] = static_cast<unsigned char>(word);
+            }
+    }
+
+
+#ifdef __EE488_MBSHA_SIMD
+
+    bool has_avx512() {
+        static const bool supported = __builtin_cpu_supports("avx512f");
+        return supported;
+    }
+
+    bool has_avx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    /* SHA extensions, CPUID.(7, 0).EBX bit 29. OpenSSL hashes a block with
+     *  them in less time than 8 lanes of AVX2 take per lane. */
+    bool has_sha_ni() {
+        static const bool supported = [] {
+            unsigned int a, b, c, d;
+            return __get_cpuid_count(7, 0, &a, &b, &c, &d) && ((b >> 29) & 1);
+        }();
+        return supported;
+    }
+
+
+    /*
+     * do_compress_x16
+     *  One block of each of 16 lanes, the rounds of FIPS 180-4 on a lane
+     *  per 32 bits of a zmm. Rotations are vprord, Ch, Maj and the three
+     *  way XORs a vpternlogd each.
+     */
+    __attribute__((target("avx512f")))
+    void do_compress_x16(Lanes<16>& arg_lanes, const uint32_t arg_mask) {
+
+        __m512i w[16], s[8];
+
+        for (int i = 0; i < 16; i++)
+            w[i] = _mm512_load_si512(arg_lanes.w[i]);
+
+        for (int i = 0; i < 8; i++)
+            s[i] = _mm512_load_si512(arg_lanes.h[i]);
+
+        __m512i a = s[0], b = s[1], c = s[2], d = s[3];
+        __m512i e = s[4], f = s[5], g = s[6], h = s[7];
+
+#pragma GCC unroll 64
+        for (int t = 0; t < 64; t++) {
+            if (t >= 16) {
+                const __m512i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+
+                const __m512i s0 = _mm512_ternarylogic_epi32(
+                    _mm512_maskz_ror_epi32(0xFFFF, w15, 7), _mm512_maskz_ror_epi32(0xFFFF, w15, 18), _mm512_maskz_srli_epi32(0xFFFF, w15, 3), 0x96);
+                const __m512i s1 = _mm512_ternarylogic_epi32(
+                    _mm512_maskz_ror_epi32(0xFFFF, w2, 17), _mm512_maskz_ror_epi32(0xFFFF, w2, 19), _mm512_maskz_srli_epi32(0xFFFF, w2, 10), 0x96);
+
+                w[t & 15] = _mm512_add_epi32(
+                    _mm512_add_epi32(w[t & 15], s0), _mm512_add_epi32(w[(t - 7) & 15], s1));
+            }
+
+            const __m512i sig1 = _mm512_ternarylogic_epi32(
+                _mm512_maskz_ror_epi32(0xFFFF, e, 6), _mm512_maskz_ror_epi32(0xFFFF, e, 11), _mm512_maskz_ror_epi32(0xFFFF, e, 25), 0x96);
+            const __m512i ch = _mm512_ternarylogic_epi32(e, f, g, 0xCA);
+
+            const __m512i t1 = _mm512_add_epi32(
+                _mm512_add_epi32(_mm512_add_epi32(h, sig1), _mm512_add_epi32(ch, w[t & 15])),
+                _mm512_set1_epi32(static_cast<int>(SHA_K[t])));
+
+            const __m512i sig0 = _mm512_ternarylogic_epi32(
+                _mm512_maskz_ror_epi32(0xFFFF, a, 2), _mm512_maskz_ror_epi32(0xFFFF, a, 13), _mm512_maskz_ror_epi32(0xFFFF, a, 22), 0x96);
+            const __m512i maj = _mm512_ternarylogic_epi32(a, b, c, 0xE8);
+
+            h = g, g = f, f = e;
+            e = _mm512_add_epi32(d, t1);
+            d = c, c = b, b = a;
+            a = _mm512_add_epi32(t1, _mm512_add_epi32(sig0, maj));
+        }
+
+        const __m512i x[8] = { a, b, c, d, e, f, g, h };
+        const __mmask16 active = static_cast<__mmask16>(arg_mask);
+
+        for (int i = 0; i < 8; i++)
+            _mm512_store_si512(arg_lanes.h[i], _mm512_mask_add_epi32(s[i], active, s[i], x[i]));
+    }
+
+
+    __attribute__((target("avx2")))
+    inline __m256i ror_x8(const __m256i arg_x, const int arg_n) {
+        return _mm256_or_si256(_mm256_srli_epi32(arg_x, arg_n), _mm256_slli_epi32(arg_x, 32 - arg_n));
+    }
+
+
+    /*
+     * do_compress_x8
+     *  As do_compress_x16 on a ymm, with shifts for rotations.
+     */
+    __attribute__((target("avx2")))
+    void do_compress_x8(Lanes<8>& arg_lanes, const uint32_t arg_mask) {
+
+        __m256i w[16], s[8];
+
+        for (int i = 0; i < 16; i++)
+            w[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(arg_lanes.w[i]));
+
+        for (int i = 0; i < 8; i++)
+            s[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(arg_lanes.h[i]));
+
+        __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+        __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+
+#pragma GCC unroll 64
+        for (int t = 0; t < 64; t++) {
+            if (t >= 16) {
+                const __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+
+                const __m256i s0 = _mm256_xor_si256(
+                    _mm256_xor_si256(ror_x8(w15, 7), ror_x8(w15, 18)), _mm256_srli_epi32(w15, 3));
+                const __m256i s1 = _mm256_xor_si256(
+                    _mm256_xor_si256(ror_x8(w2, 17), ror_x8(w2, 19)), _mm256_srli_epi32(w2, 10));
+
+                w[t & 15] = _mm256_add_epi32(
+                    _mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+            }
+
+            const __m256i sig1 = _mm256_xor_si256(
+                _mm256_xor_si256(ror_x8(e, 6), ror_x8(e, 11)), ror_x8(e, 25));
+            const __m256i ch = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+
+            const __m256i t1 = _mm256_add_epi32(
+                _mm256_add_epi32(_mm256_add_epi32(h, sig1), _mm256_add_epi32(ch, w[t & 15])),
+                _mm256_set1_epi32(static_cast<int>(SHA_K[t])));
+
+            const __m256i sig0 = _mm256_xor_si256(
+                _mm256_xor_si256(ror_x8(a, 2), ror_x8(a, 13)), ror_x8(a, 22));
+            const __m256i maj = _mm256_or_si256(
+                _mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+
+            h = g, g = f, f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c, c = b, b = a;
+            a = _mm256_add_epi32(t1, _mm256_add_epi32(sig0, maj));
+        }
+
+        /* Lane l active when bit l of the mask is set. */
+        const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i active = _mm256_cmpeq_epi32(
+            _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(arg_mask)), bits), bits);
+
+        const __m256i x[8] = { a, b, c, d, e, f, g, h };
+
+        for (int i = 0; i < 8; i++)
+            _mm256_store_si256(
+                reinterpret_cast<__m256i*>(arg_lanes.h[i]),
+                _mm256_blendv_epi8(s[i], _mm256_add_epi32(s[i], x[i]), active));
+    }
+
+#endif
+};
+
+
+
+/*
+ * do_sha256_multi
+ */
+void EE488::do_sha256_multi(unsigned char* arg_out, const shain_t* arg_in, const size_t arg_n) {
+
+    const size_t lanes = (arg_n > 1) ? get_sha256_lanes() : 1;
+
+    for (size_t i = 0; i < arg_n; i += lanes) {
+        const size_t n = std::min(lanes, arg_n - i);
+
+#ifdef __EE488_MBSHA_SIMD
+        if (lanes == 16) {
+            do_group<16, do_compress_x16>(arg_out + 32 * i, arg_in + i, n);
+            continue;
+        }
+
+        if (lanes == 8) {
+            do_group<8, do_compress_x8>(arg_out + 32 * i, arg_in + i, n);
+            continue;
+        }
+#endif
+
+        SHA256_CTX sha_context;
+
+        SHA256_Init(&sha_context);
+        SHA256_Update(&sha_context, arg_in[i].head, arg_in[i].head_len);
+
+        if (arg_in[i].tail_len > 0)
+            SHA256_Update(&sha_context, arg_in[i].tail, arg_in[i].tail_len);
+
+        SHA256_Final(arg_out + 32 * i, &sha_context);
+    }
+}
+
+
+
+/*
+ * get_sha256_lanes
+ */
+size_t EE488::get_sha256_lanes() {
+
+#ifdef __EE488_MBSHA_SIMD
+    if (has_avx512()) return 16;
+    if (has_avx2() && !has_sha_ni()) return 8;
+#endif
+
+    return 1;
+}
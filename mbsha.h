@@ -0,0 +1,55 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_MBSHA_H
+#define __EE488_MBSHA_H
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace EE488 {
+
+    const size_t MBSHA_LANES_MAX = 16;      // AVX-512, 8 on AVX2
+
+    /*
+     * struct ShaInput
+     *  One message of do_sha256_multi, in two parts hashed as head || tail,
+     *  thus m || r needs no copy. tail may be nullptr when tail_len is 0.
+     */
+    struct ShaInput {
+        const unsigned char* head;
+        size_t head_len;
+
+        const unsigned char* tail;
+        size_t tail_len;
+    };
+
+    using shain_t = ShaInput;
+
+    /* SHA-256 of n independent messages, 32 bytes each into arg_out. Goes
+     *  MBSHA_LANES_MAX, or 8, messages at a time through one SIMD kernel,
+     *  one lane per message, each lane stopping at the end of its own.
+     *  OpenSSL one by one for a lone message, without AVX-512 and AVX2, or
+     *  with AVX2 alone on a CPU of SHA extensions, which OpenSSL uses. */
+    void do_sha256_multi(unsigned char*, const shain_t*, const size_t);
+
+    /* Messages per kernel call on this CPU: 16, 8, or 1 for OpenSSL. */
+    size_t get_sha256_lanes();
+}
+
+#endif
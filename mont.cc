@@ -0,0 +1,659 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "./schnorr.h"
+#include "./mont.h"
+
+/* The products need AVX-512 IFMA, checked at run time. The rest of the
+ *  build stays on the baseline ISA. */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define __EE488_MONT_IFMA
+#include <immintrin.h>
+#endif
+
+
+#ifdef __EE488_MONT_IFMA
+
+namespace {
+
+    const uint64_t M52 = (1ULL << EE488::MONT_LIMB_BITS) - 1;
+
+    bool has_ifma() {
+        static const bool supported =
+            __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+        return supported;
+    }
+
+
+    /*
+     * do_amm
+     *  r = a b / R mod m, below 2m. Per limb b_i of b: T += a b_i + q m with
+     *  q making the lowest limb of T zero, then T shifts down a limb. The
+     *  low halves of the products add before the shift and the high halves
+     *  after, as those belong to the next limb up. Lanes carry beyond 52
+     *  bits until the end, only the lowest one is settled each round. r may
+     *  be a or b.
+     */
+    template <size_t L, size_t NVECS>
+    __attribute__((target("avx512f,avx512ifma")))
+    void do_amm(
+        uint64_t* arg_r,
+        const uint64_t* arg_a,
+        const uint64_t* arg_b,
+        const uint64_t* arg_m,
+        const uint64_t arg_k0) {
+
+        const __m512i zero = _mm512_setzero_si512();
+
+        __m512i a[NVECS], n[NVECS], t[NVECS];
+
+#pragma GCC unroll 8
+        for (size_t v = 0; v < NVECS; v++) {
+            a[v] = _mm512_loadu_si512(arg_a + 8 * v);
+            n[v] = _mm512_loadu_si512(arg_m + 8 * v);
+            t[v] = zero;
+        }
+
+        for (size_t i = 0; i < L; i++) {
+            const __m512i bi = _mm512_set1_epi64(arg_b[i]);
+
+#pragma GCC unroll 8
+            for (size_t v = 0; v < NVECS; v++)
+                t[v] = _mm512_madd52lo_epu64(t[v], a[v], bi);
+
+            const uint64_t t0 = (uint64_t)t[0][0];     // vmovq
+            const uint64_t q = (t0 * arg_k0) & M52;
+            const __m512i qv = _mm512_set1_epi64(q);
+
+#pragma GCC unroll 8
+            for (size_t v = 0; v < NVECS; v++)
+                t[v] = _mm512_madd52lo_epu64(t[v], n[v], qv);
+
+            const uint64_t carry = (t0 + ((q * arg_m[0]) & M52)) >> EE488::MONT_LIMB_BITS;
+
+#pragma GCC unroll 8
+            for (size_t v = 0; v + 1 < NVECS; v++)
+                t[v] = _mm512_maskz_alignr_epi64(0xFF, t[v + 1], t[v], 1);
+
+            t[NVECS - 1] = _mm512_maskz_alignr_epi64(0xFF, zero, t[NVECS - 1], 1);
+            t[0] = _mm512_mask_add_epi64(t[0], 1, t[0], _mm512_set1_epi64(carry));
+
+#pragma GCC unroll 8
+            for (size_t v = 0; v < NVECS; v++) {
+                t[v] = _mm512_madd52hi_epu64(t[v], a[v], bi);
+                t[v] = _mm512_madd52hi_epu64(t[v], n[v], qv);
+            }
+        }
+
+        uint64_t wide[8 * NVECS];
+
+#pragma GCC unroll 8
+        for (size_t v = 0; v < NVECS; v++)
+            _mm512_storeu_si512(wide + 8 * v, t[v]);
+
+        /* Carries into 52 bit limbs, the result is below 2m < R. */
+        uint64_t carry = 0;
+
+        for (size_t j = 0; j < L; j++) {
+            carry += wide[j];
+            arg_r[j] = carry & M52;
+            carry >>= EE488::MONT_LIMB_BITS;
+        }
+
+        for (size_t j = L; j < 8 * NVECS; j++)
+            arg_r[j] = 0;
+    }
+};
+
+
+
+/*
+ * FixedMont Actions */
+template <size_t L>
+EE488::FixedMont<L>::FixedMont(const BIGNUM* arg_m, BN_CTX* arg_ctx) : m{}, rr{}, k0(0) {
+
+    do_load(m, arg_m);
+
+    /* m^-1 mod 2^64 by Newton, each step doubles the bits. */
+    uint64_t inv = 1;
+    for (int i = 0; i < 6; i++)
+        inv *= 2 - m.n[0] * inv;
+
+    k0 = (0 - inv) & M52;
+
+    BN_CTX_start(arg_ctx);
+    BIGNUM* tbn_rr = BN_CTX_get(arg_ctx);
+
+    if (tbn_rr != nullptr) {
+        BN_zero(tbn_rr);
+        BN_set_bit(tbn_rr, 2 * MONT_LIMB_BITS * L);
+        BN_mod(tbn_rr, tbn_rr, arg_m, arg_ctx);
+
+        do_load(rr, tbn_rr);
+    }
+
+    BN_CTX_end(arg_ctx);
+}
+
+
+
+/*
+ * do_mul
+ */
+template <size_t L>
+void EE488::FixedMont<L>::do_mul(Num& arg_r, const Num& arg_a, const Num& arg_b) const {
+    do_amm<L, NVECS>(arg_r.n, arg_a.n, arg_b.n, m.n, k0);
+}
+
+
+
+/*
+ * do_load
+ */
+template <size_t L>
+void EE488::FixedMont<L>::do_load(Num& arg_r, const BIGNUM* arg_x) const {
+
+    /* Little-endian bytes, then limb j from bit 52 j. Room for the last
+     *  8 byte read. */
+    unsigned char arr_bytes[NWORDS * 8 + 8] = { 0, };
+    BN_bn2lebinpad(arg_x, arr_bytes, NWORDS * 8);
+
+    for (size_t j = 0; j < L; j++) {
+        const size_t bit = MONT_LIMB_BITS * j;
+        uint64_t word;
+
+        std::memcpy(&word, arr_bytes + bit / 8, sizeof(word));
+        arg_r.n[j] = (word >> (bit % 8)) & M52;
+    }
+
+    for (size_t j = L; j < NWORDS; j++)
+        arg_r.n[j] = 0;
+}
+
+
+
+/*
+ * do_store
+ */
+template <size_t L>
+void EE488::FixedMont<L>::do_store(BIGNUM* arg_r, const Num& arg_a) const {
+
+    /* From Montgomery form, a / R below m + 1, then m itself is zero. */
+    Num one = {}, x, d;
+    one.n[0] = 1;
+
+    do_mul(x, arg_a, one);
+
+    uint64_t borrow = 0;
+
+    for (size_t j = 0; j < L; j++) {
+        d.n[j] = x.n[j] - m.n[j] - borrow;
+        borrow = d.n[j] >> 63;
+        d.n[j] &= M52;
+    }
+
+    const Num& res = borrow ? x : d;
+    unsigned char arr_bytes[NWORDS * 8 + 8] = { 0, };
+
+    for (size_t j = 0; j < L; j++) {
+        const size_t bit = MONT_LIMB_BITS * j;
+        uint64_t word;
+
+        std::memcpy(&word, arr_bytes + bit / 8, sizeof(word));
+        word |= res.n[j] << (bit % 8);
+        std::memcpy(arr_bytes + bit / 8, &word, sizeof(word));
+    }
+
+    BN_lebin2bn(arr_bytes, NWORDS * 8, arg_r);
+}
+
+
+
+/*
+ * do_multi_exp
+ */
+template <size_t L>
+int EE488::FixedMont<L>::do_multi_exp(
+    BIGNUM* arg_r,
+    const BIGNUM* const* arg_bases,
+    const BIGNUM* const* arg_exps,
+    const size_t arg_n) const {
+
+    /* Same windows as EE488::do_multi_exp, the powers on the stack. */
+    struct ExpState {
+        const BIGNUM* exp;
+        int wbits;
+        int low;            // Lowest bit of the open window, -1 if none
+        unsigned val;       // Its value, odd
+        Num* pows;          // b, b^3, b^5, ...
+    };
+
+    ExpState stack_state[MONT_EXP_STACK];
+    Num stack_pows[MONT_EXP_STACK * 16];
+
+    std::vector<ExpState> heap_state;
+    std::vector<Num> heap_pows;
+
+    ExpState* state = stack_state;
+    Num* pows = stack_pows;
+
+    if (arg_n > MONT_EXP_STACK) {
+        heap_state.resize(arg_n);
+        heap_pows.resize(arg_n * 16);
+
+        state = heap_state.data();
+        pows = heap_pows.data();
+    }
+
+    Num sq, acc;
+    int max_bits = 0;
+
+    for (size_t j = 0; j < arg_n; j++) {
+        ExpState& st = state[j];
+        const int bits = BN_num_bits(arg_exps[j]);
+
+        st.exp = arg_exps[j];
+        st.low = -1;
+        st.pows = pows + 16 * j;
+        st.wbits = (bits == 0) ? 0 : (bits > 256 ? 5 : (bits > 80 ? 4 : (bits > 24 ? 3 : 1)));
+
+        if (st.wbits == 0) continue;
+
+        /* Below R, the first product reduces it. */
+        if (BN_is_negative(arg_bases[j]) || BN_is_negative(arg_exps[j]) ||
+            BN_num_bits(arg_bases[j]) > (int)(MONT_LIMB_BITS * L))
+            return -1;
+
+        max_bits = std::max(max_bits, bits);
+
+        const unsigned npows = 1u << (st.wbits - 1);
+
+        do_load(sq, arg_bases[j]);
+        do_mul(st.pows[0], sq, rr);
+
+        if (npows > 1) {
+            do_mul(sq, st.pows[0], st.pows[0]);
+
+            for (unsigned k = 1; k < npows; k++)
+                do_mul(st.pows[k], st.pows[k - 1], sq);
+        }
+    }
+
+    bool started = false;
+
+    for (int i = max_bits - 1; i >= 0; i--) {
+        if (started)
+            do_mul(acc, acc, acc);
+
+        for (size_t j = 0; j < arg_n; j++) {
+            ExpState& st = state[j];
+
+            if (st.wbits == 0) continue;
+
+            if (st.low < 0 && BN_is_bit_set(st.exp, i)) {
+                int low = std::max(i - st.wbits + 1, 0);
+                while (!BN_is_bit_set(st.exp, low)) low++;
+
+                st.val = 0;
+                for (int b = i; b >= low; b--)
+                    st.val = (st.val << 1) | BN_is_bit_set(st.exp, b);
+
+                st.low = low;
+            }
+
+            if (st.low != i) continue;
+
+            const Num& pow = st.pows[st.val >> 1];
+            st.low = -1;
+
+            if (!started) {
+                acc = pow;
+                started = true;
+            }
+            else
+                do_mul(acc, acc, pow);
+        }
+    }
+
+    if (started)
+        do_store(arg_r, acc);
+    else
+        BN_one(arg_r);
+
+    return 0;
+}
+
+
+
+/*
+ * do_build_table
+ */
+template <size_t L>
+int EE488::FixedMont<L>::do_build_table(
+    std::vector<uint64_t>& arg_table,
+    const BIGNUM* arg_g,
+    const int arg_nwindows,
+    const int arg_wbits) const {
+
+    if (BN_is_negative(arg_g) || BN_num_bits(arg_g) > (int)(MONT_LIMB_BITS * L))
+        return -1;
+
+    const size_t ndigits = (1u << arg_wbits) - 1;
+
+    Num base, entry;
+
+    do_load(entry, arg_g);
+    do_mul(base, entry, rr);     // g^(2^(w * i)), in Montgomery form
+
+    arg_table.assign(arg_nwindows * ndigits * NWORDS, 0);
+
+    for (int i = 0; i < arg_nwindows; i++) {
+        uint64_t* row = &arg_table[i * ndigits * NWORDS];
+
+        entry = base;
+        std::memcpy(row, entry.n, sizeof(entry.n));
+
+        for (size_t j = 1; j < ndigits; j++) {
+            do_mul(entry, entry, base);
+            std::memcpy(row + j * NWORDS, entry.n, sizeof(entry.n));
+        }
+
+        do_mul(base, entry, base);
+    }
+
+    return 0;
+}
+
+
+
+/*
+ * do_table_exp
+ */
+template <size_t L>
+int EE488::FixedMont<L>::do_table_exp(
+    BIGNUM* arg_r,
+    const std::vector<uint64_t>& arg_table,
+    const int arg_nwindows,
+    const int arg_wbits,
+    const BIGNUM* arg_k) const {
+
+    if (BN_is_negative(arg_k) || BN_num_bits(arg_k) > arg_nwindows * arg_wbits)
+        return -1;
+
+    const size_t ndigits = (1u << arg_wbits) - 1;
+
+    Num acc, pow;
+    bool started = false;
+
+    for (int i = 0; i < arg_nwindows; i++) {
+        unsigned digit = 0;
+
+        for (int b = arg_wbits - 1; b >= 0; b--)
+            digit = (digit << 1) | BN_is_bit_set(arg_k, i * arg_wbits + b);
+
+        if (digit == 0) continue;
+
+        std::memcpy(pow.n, &arg_table[(i * ndigits + digit - 1) * NWORDS], sizeof(pow.n));
+
+        if (!started) {
+            acc = pow;
+            started = true;
+        }
+        else
+            do_mul(acc, acc, pow);
+    }
+
+    if (started)
+        do_store(arg_r, acc);
+    else
+        BN_one(arg_r);
+
+    return 0;
+}
+
+
+template class EE488::FixedMont<20>;    // p of 1024 bits
+template class EE488::FixedMont<40>;    // 2048
+template class EE488::FixedMont<60>;    // 3072
+
+#endif
+
+
+
+/*
+ * get_mont_engine
+ */
+std::shared_ptr<const EE488::meng_t> EE488::get_mont_engine(const BIGNUM* arg_m) {
+
+#ifdef __EE488_MONT_IFMA
+    if (!has_ifma() || BN_is_negative(arg_m) || !BN_is_odd(arg_m))
+        return nullptr;
+
+    /* 4m below R */
+    const int nlimbs = (BN_num_bits(arg_m) + 2 + MONT_LIMB_BITS - 1) / MONT_LIMB_BITS;
+    BN_CTX* tbn_ctx = get_thread_ctx();
+
+    switch (nlimbs) {
+        case 20: return std::make_shared<const FixedMont<20>>(arg_m, tbn_ctx);
+        case 40: return std::make_shared<const FixedMont<40>>(arg_m, tbn_ctx);
+        case 60: return std::make_shared<const FixedMont<60>>(arg_m, tbn_ctx);
+        default: break;
+    }
+#endif
+
+    return nullptr;
+}
+
+
+
+
+namespace {
+
+    const int JACOBI_STEPS = 28;    // Per pass, 3 exact low bits left of 31
+
+    size_t get_nbits(const std::vector<uint64_t>& arg_x, size_t arg_nw) {
+        while (arg_nw > 0 && arg_x[arg_nw - 1] == 0) arg_nw--;
+        if (arg_nw == 0) return 0;
+
+        size_t nbits = 64 * (arg_nw - 1);
+        for (uint64_t w = arg_x[arg_nw - 1]; w != 0; w >>= 1) nbits++;
+        return nbits;
+    }
+
+    /* 64 bits of x from bit arg_pos on. */
+    uint64_t get_bits(const std::vector<uint64_t>& arg_x, size_t arg_pos) {
+        const size_t w = arg_pos / 64, o = arg_pos % 64;
+        uint64_t v = (w < arg_x.size()) ? arg_x[w] >> o : 0;
+        if (o > 0 && w + 1 < arg_x.size()) v |= arg_x[w + 1] << (64 - o);
+        return v;
+    }
+
+    /* One step on a odd b, a even after it: (a / b), sign in arg_t. */
+    template <typename T>
+    inline void do_jacobi_step(T& arg_a, T& arg_b, int64_t* arg_f, int64_t* arg_g, int& arg_t) {
+        if (arg_a & 1) {
+            if (arg_a < arg_b) {
+                std::swap(arg_a, arg_b), std::swap(arg_f[0], arg_f[1]), std::swap(arg_g[0], arg_g[1]);
+                if ((arg_a & arg_b & 3) == 3) arg_t = -arg_t;
+            }
+            arg_a -= arg_b, arg_f[0] -= arg_f[1], arg_g[0] -= arg_g[1];
+        }
+
+        arg_a >>= 1, arg_f[1] *= 2, arg_g[1] *= 2;
+        if ((arg_b & 7) == 3 || (arg_b & 7) == 5) arg_t = -arg_t;
+    }
+
+    /* r = (f a + g b) / 2^JACOBI_STEPS over arg_nw words, false if below 0. */
+    bool do_jacobi_comb(
+        std::vector<uint64_t>& arg_r,
+        const std::vector<uint64_t>& arg_a,
+        const std::vector<uint64_t>& arg_b,
+        size_t arg_nw,
+        int64_t arg_f,
+        int64_t arg_g) {
+
+        __int128 carry = 0;
+        uint64_t prev = 0;
+
+        for (size_t i = 0; i <= arg_nw; i++) {
+            __int128 acc = carry;
+            if (i < arg_nw)
+                acc += static_cast<__int128>(arg_f) * arg_a[i] + static_cast<__int128>(arg_g) * arg_b[i];
+
+            const uint64_t w = static_cast<uint64_t>(acc);
+            carry = acc >> 64;
+
+            if (i > 0)
+                arg_r[i - 1] = (prev >> JACOBI_STEPS) | (w << (64 - JACOBI_STEPS));
+            prev = w;
+        }
+
+        for (size_t i = arg_nw; i < arg_r.size(); i++) arg_r[i] = 0;
+
+        return carry >= 0;
+    }
+
+    /* The plain binary one, one bit at a time over all words. */
+    int do_jacobi_exact(std::vector<uint64_t>& a, std::vector<uint64_t>& n, int t) {
+
+        size_t na = a.size(), nn = n.size();
+        while (na > 0 && a[na - 1] == 0) na--;
+        while (nn > 0 && n[nn - 1] == 0) nn--;
+
+        for (;;) {
+            if (na == 0)
+                return (nn == 1 && n[0] == 1) ? t : 0;
+
+            size_t zw = 0;
+            while (a[zw] == 0) zw++;
+
+            int zb = 0;
+            while (((a[zw] >> zb) & 1) == 0) zb++;
+
+            if ((zw * 64 + zb) & 1)
+                if ((n[0] & 7) == 3 || (n[0] & 7) == 5) t = -t;
+
+            if (zw > 0 || zb > 0) {
+                for (size_t i = 0; i + zw < na; i++) {
+                    uint64_t hi = (zb > 0 && i + zw + 1 < na) ? a[i + zw + 1] << (64 - zb) : 0;
+                    a[i] = (a[i + zw] >> zb) | hi;
+                }
+
+                for (size_t i = na - zw; i < na; i++) a[i] = 0;
+                na -= zw;
+                while (na > 0 && a[na - 1] == 0) na--;
+            }
+
+            bool below = (na != nn) ? (na < nn) : false;
+
+            if (na == nn)
+                for (size_t i = na; i-- > 0;)
+                    if (a[i] != n[i]) {
+                        below = a[i] < n[i];
+                        break;
+                    }
+
+            if (below) {
+                std::swap(a, n), std::swap(na, nn);
+                if ((a[0] & n[0] & 3) == 3) t = -t;
+            }
+
+            uint64_t borrow = 0;
+            for (size_t i = 0; i < na; i++) {
+                uint64_t d = (i < nn) ? n[i] : 0;
+                uint64_t r = a[i] - d - borrow;
+                borrow = (a[i] < d) || (a[i] - d < borrow);
+                a[i] = r;
+            }
+
+            while (na > 0 && a[na - 1] == 0) na--;
+        }
+    }
+}
+
+
+
+/*
+ * do_jacobi
+ */
+int EE488::do_jacobi(const BIGNUM* arg_a, const BIGNUM* arg_n) {
+
+    if (BN_is_negative(arg_a) || BN_is_negative(arg_n) || !BN_is_odd(arg_n) || BN_cmp(arg_a, arg_n) >= 0)
+        return -2;
+
+    const size_t nwords = (BN_num_bits(arg_n) + 63) / 64;
+
+    std::vector<unsigned char> arr_bytes(nwords * 8);
+    std::vector<uint64_t> a(nwords, 0), b(nwords, 0), ta(nwords), tb(nwords);
+
+    BN_bn2lebinpad(arg_a, arr_bytes.data(), arr_bytes.size());
+    for (size_t i = 0; i < arr_bytes.size(); i++)
+        a[i / 8] |= static_cast<uint64_t>(arr_bytes[i]) << (8 * (i % 8));
+
+    BN_bn2lebinpad(arg_n, arr_bytes.data(), arr_bytes.size());
+    for (size_t i = 0; i < arr_bytes.size(); i++)
+        b[i / 8] |= static_cast<uint64_t>(arr_bytes[i]) << (8 * (i % 8));
+
+    /* (a / b) = (a / 2)^z ((a >> z) / b), (2 / b) = -1 for b = 3, 5 mod 8.
+     *  Both odd, (a / b) = (b / a) but for a = b = 3 mod 4, and
+     *  (a / b) = ((a - b) / b). JACOBI_STEPS of these run on the top 33 and
+     *  the low 31 bits of a and b, then apply to the whole of them at once.
+     *  The signs need the low bits only, exact. A wrong guess of a < b from
+     *  the top bits leaves a or b below 0, then the pass is redone exactly.
+     *
+     *  Refer to,
+     *  T. Pornin, "Optimized Binary GCD for Modular Inversion", 2020.
+     */
+    int t = 1;
+
+    for (;;) {
+        const size_t nbits = std::max(get_nbits(a, nwords), get_nbits(b, nwords));
+
+        if (get_nbits(a, nwords) == 0)
+            return (nbits == 1) ? t : 0;
+
+        int64_t f[2] = { 1, 0 }, g[2] = { 0, 1 };
+
+        if (nbits <= 64) {
+            uint64_t xa = a[0], xb = b[0];
+            while (xa != 0) {
+                do_jacobi_step(xa, xb, f, g, t);
+                f[1] = g[1] = 0;    // Not used
+            }
+            return (xb == 1) ? t : 0;
+        }
+
+        const uint64_t low = (1ULL << 31) - 1;
+        uint64_t xa = (a[0] & low) | (get_bits(a, nbits - 33) << 31);
+        uint64_t xb = (b[0] & low) | (get_bits(b, nbits - 33) << 31);
+        int tpass = t;
+
+        for (int i = 0; i < JACOBI_STEPS; i++)
+            do_jacobi_step(xa, xb, f, g, tpass);
+
+        const size_t nw = (nbits + 63) / 64;
+
+        if (!do_jacobi_comb(ta, a, b, nw, f[0], g[0]) ||
+            !do_jacobi_comb(tb, a, b, nw, f[1], g[1]))
+            return do_jacobi_exact(a, b, t);
+
+        std::swap(a, ta), std::swap(b, tb);
+        t = tpass;
+    }
+}
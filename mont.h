@@ -0,0 +1,137 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_MONT_H
+#define __EE488_MONT_H
+
+#include <openssl/bn.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+namespace EE488 {
+
+    const int MONT_LIMB_BITS = 52;
+    const size_t MONT_EXP_STACK = 4;    // Bases of do_multi_exp without heap
+
+    /*
+     * class MontEngine
+     *  Exponentiation mod a fixed odd m, by a FixedMont of the size of m.
+     *  Numbers in and out are BIGNUM, those in between never leave it.
+     *  Immutable after construction, thus shared among threads.
+     */
+    class MontEngine {
+    public:
+        virtual ~MontEngine() = default;
+
+        /* u64 words of a number, the entry size of a table. */
+        virtual size_t get_nwords() const = 0;
+        virtual int get_nlimbs() const = 0;
+
+        /* r = b_0^e_0 * b_1^e_1 * ... mod m, as EE488::do_multi_exp. Bases
+         *  below m, exponents not negative. */
+        virtual int do_multi_exp(
+            BIGNUM*,
+            const BIGNUM* const*,
+            const BIGNUM* const*,
+            const size_t) const = 0;
+
+        /* g^(j * 2^(w * i)) for window i and digit j > 0, as FixedBaseTable. */
+        virtual int do_build_table(std::vector<uint64_t>&, const BIGNUM*, const int, const int) const = 0;
+
+        /* g^k from the table, -1 if k does not fit in it. */
+        virtual int do_table_exp(
+            BIGNUM*,
+            const std::vector<uint64_t>&,
+            const int,
+            const int,
+            const BIGNUM*) const = 0;
+    };
+
+    using meng_t = MontEngine;
+
+
+    /*
+     * class FixedMont
+     *  Montgomery arithmetic of L limbs of 52 bits, L fixed at compile time,
+     *  with R = 2^(52 L) and m below R / 4. A product is an almost Montgomery
+     *  multiplication, a b / R mod m below 2m for inputs below 2m, thus no
+     *  subtraction until the result leaves. Each limb sits in a lane of
+     *  AVX-512, and a step of the product is vpmadd52luq/vpmadd52huq over
+     *  the whole number at once. Operands live on the stack, and the loops
+     *  over vectors unroll fully.
+     *
+     *  Refer to,
+     *  S. Gueron and V. Krasnov, "Accelerating Big Integer Arithmetic Using
+     *  Intel IFMA Extensions", ARITH 2016.
+     */
+    template <size_t L>
+    class FixedMont final : public MontEngine {
+    public:
+        static constexpr size_t NVECS = (L + 7) / 8;
+        static constexpr size_t NWORDS = 8 * NVECS;
+
+        struct Num {
+            alignas(64) uint64_t n[NWORDS];
+        };
+
+    private:
+        Num m, rr;          // m, R^2 mod m
+        uint64_t k0;        // -1 / m mod 2^52
+
+        void do_mul(Num&, const Num&, const Num&) const;
+        void do_load(Num&, const BIGNUM*) const;
+        void do_store(BIGNUM*, const Num&) const;
+
+    public:
+        FixedMont(const BIGNUM*, BN_CTX*);
+
+        size_t get_nwords() const override { return NWORDS; }
+        int get_nlimbs() const override { return L; }
+
+        int do_multi_exp(
+            BIGNUM*,
+            const BIGNUM* const*,
+            const BIGNUM* const*,
+            const size_t) const override;
+
+        int do_build_table(std::vector<uint64_t>&, const BIGNUM*, const int, const int) const override;
+
+        int do_table_exp(
+            BIGNUM*,
+            const std::vector<uint64_t>&,
+            const int,
+            const int,
+            const BIGNUM*) const override;
+    };
+
+    /* Engine for m, FixedMont<20>, <40> or <60> by the size of m, for p of
+     *  1024, 2048 and 3072 bits. nullptr when m is of another size or the
+     *  CPU has no AVX-512 IFMA, then BIGNUM goes on. There is no portable
+     *  engine, as BN_mod_mul_montgomery in assembly is faster than one of
+     *  u64 limbs in C++ would be. */
+    std::shared_ptr<const meng_t> get_mont_engine(const BIGNUM*);
+
+    /* Jacobi symbol (a / n), 1, -1 or 0, for 0 <= a < n and an odd n. -2
+     *  otherwise. Binary, over u64 words, no allocation per step. */
+    int do_jacobi(const BIGNUM*, const BIGNUM*);
+}
+
+#endif
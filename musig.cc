@@ -0,0 +1,335 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <cstring>
+
+#include "./musig.h"
+
+
+namespace {
+
+    /* Tags keep the hashes of MuSig apart from each other and from e. */
+    const char TAG_KEYLIST[] = "EE488/musig/keylist";
+    const char TAG_KEYCOEF[] = "EE488/musig/keycoef";
+    const char TAG_NONCECOEF[] = "EE488/musig/noncecoef";
+
+    /* Numbers left-padded to |p| bytes, thus of one length each. */
+    bool do_update_padded(SHA256_CTX* arg_ctx, const BIGNUM* arg_bn, std::vector<unsigned char>& arg_buf) {
+        return BN_bn2binpad(arg_bn, arg_buf.data(), static_cast<int>(arg_buf.size())) >= 0 &&
+            SHA256_Update(arg_ctx, arg_buf.data(), arg_buf.size());
+    }
+
+    /* A digest as a number mod q */
+    bool do_final_scalar(BIGNUM* arg_out, SHA256_CTX* arg_ctx, const BIGNUM* arg_q, BN_CTX* arg_bn_ctx) {
+        unsigned char arr_digest[SHA256_DIGEST_LENGTH];
+
+        return SHA256_Final(arr_digest, arg_ctx) &&
+            BN_bin2bn(arr_digest, sizeof(arr_digest), arg_out) != nullptr &&
+            BN_nnmod(arg_out, arg_out, arg_q, arg_bn_ctx);
+    }
+
+    /* In (1, p), a number a party may have sent as a group element. */
+    bool is_element(const BIGNUM* arg_x, const BIGNUM* arg_p) {
+        return !BN_is_negative(arg_x) && !BN_is_zero(arg_x) && !BN_is_one(arg_x) && BN_cmp(arg_x, arg_p) < 0;
+    }
+};
+
+
+
+/*
+ * do_musig_key_agg
+ */
+int EE488::do_musig_key_agg(
+    BIGNUM* arg_agg,
+    std::vector<bnw_t>* arg_coefs,
+    const sdm_t& arg_domain,
+    const BIGNUM* const* arg_pks,
+    const size_t arg_n) {
+
+    if (arg_n == 0)
+        return -1;
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    std::vector<unsigned char> buf(BN_num_bytes(arg_domain.get_p()));
+    std::vector<bnw_t> coefs(arg_n);
+
+    /* L */
+    unsigned char arr_list[SHA256_DIGEST_LENGTH];
+    SHA256_CTX sha_context;
+
+    SHA256_Init(&sha_context);
+    SHA256_Update(&sha_context, TAG_KEYLIST, sizeof(TAG_KEYLIST));
+
+    for (size_t i = 0; i < arg_n; i++) {
+        if (!is_element(arg_pks[i], arg_domain.get_p()) ||
+            !do_update_padded(&sha_context, arg_pks[i], buf))
+            return -1;
+    }
+
+    SHA256_Final(arr_list, &sha_context);
+
+    /* a_i */
+    std::vector<const BIGNUM*> exps(arg_n);
+
+    for (size_t i = 0; i < arg_n; i++) {
+        SHA256_Init(&sha_context);
+        SHA256_Update(&sha_context, TAG_KEYCOEF, sizeof(TAG_KEYCOEF));
+        SHA256_Update(&sha_context, arr_list, sizeof(arr_list));
+
+        if (!do_update_padded(&sha_context, arg_pks[i], buf) ||
+            !do_final_scalar(coefs[i].actor, &sha_context, arg_domain.get_q(), tbn_ctx))
+            return -1;
+
+        exps[i] = coefs[i].actor;
+    }
+
+    if (do_multi_exp(arg_agg, arg_pks, exps.data(), arg_n,
+        arg_domain.get_mont(), tbn_ctx, arg_domain.get_engine()) != 0)
+        return -1;
+
+    if (arg_coefs != nullptr)
+        arg_coefs->swap(coefs);
+
+    return 0;
+}
+
+
+
+/*
+ * MuSigSession Actions */
+EE488::MuSigSession::MuSigSession(
+    const skey_t& arg_key,
+    const BIGNUM* const* arg_pks,
+    const size_t arg_n) :
+    key(arg_key),
+    domain(arg_key.share_domain()),
+    pks(arg_n),
+    self(arg_n),
+    nonce_ready(false),
+    r1s(arg_n), r2s(arg_n),
+    has_nonce(arg_n, false),
+    partials(arg_n),
+    has_partial(arg_n, false),
+    challenge_ready(false) {
+
+    for (size_t i = 0; i < arg_n; i++) {
+        BN_copy(pks[i].actor, arg_pks[i]);
+
+        if (self == arg_n && BN_cmp(arg_pks[i], key.get_pk()) == 0)
+            self = i;
+    }
+
+    /* Not a signer of the list, or a list of no key: every action fails. */
+    if (self < arg_n && do_musig_key_agg(agg_pk.actor, &coefs, *domain, arg_pks, arg_n) != 0)
+        self = arg_n;
+}
+
+
+
+/*
+ * do_nonce_gen
+ */
+int EE488::MuSigSession::do_nonce_gen(BIGNUM* arg_r1, BIGNUM* arg_r2) {
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+
+    if (self == pks.size() || nonce_ready || challenge_ready || !key.is_sk_ready())
+        return -1;
+
+    if (do_rand_nonce(k1.actor, domain->get_q(), tbn_ctx) != 0 ||
+        do_rand_nonce(k2.actor, domain->get_q(), tbn_ctx) != 0 ||
+        domain->do_gexp(r1s[self].actor, k1.actor, tbn_ctx) != 0 ||
+        domain->do_gexp(r2s[self].actor, k2.actor, tbn_ctx) != 0)
+        return -1;
+
+    has_nonce[self] = nonce_ready = true;
+
+    BN_copy(arg_r1, r1s[self].actor);
+    BN_copy(arg_r2, r2s[self].actor);
+
+    return 0;
+}
+
+
+
+int EE488::MuSigSession::set_nonce(const size_t arg_i, const BIGNUM* arg_r1, const BIGNUM* arg_r2) {
+
+    if (arg_i >= pks.size() || arg_i == self || challenge_ready ||
+        !is_element(arg_r1, domain->get_p()) || !is_element(arg_r2, domain->get_p()))
+        return -1;
+
+    BN_copy(r1s[arg_i].actor, arg_r1);
+    BN_copy(r2s[arg_i].actor, arg_r2);
+    has_nonce[arg_i] = true;
+
+    return 0;
+}
+
+
+
+/*
+ * do_partial_sign
+ */
+int EE488::MuSigSession::do_partial_sign(
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    BIGNUM* arg_s,
+    const int arg_bitn) {
+
+    if (!nonce_ready)
+        return -1;
+
+    for (size_t i = 0; i < pks.size(); i++)
+        if (!has_nonce[i]) return -1;
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_r1 = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_r2 = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_r = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_k = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_c = BN_CTX_get(tbn_ctx);
+
+    const BIGNUM* p = domain->get_p();
+    const BIGNUM* q = domain->get_q();
+
+    std::vector<unsigned char> buf(BN_num_bytes(p));
+    int ret_code = -1;
+
+    SHA256_CTX sha_context;
+
+    if (tbn_c == nullptr)
+        goto out;
+
+    /* R1, R2 of all */
+    BN_one(tbn_r1), BN_one(tbn_r2);
+
+    for (size_t i = 0; i < pks.size(); i++) {
+        if (!BN_mod_mul(tbn_r1, tbn_r1, r1s[i].actor, p, tbn_ctx) ||
+            !BN_mod_mul(tbn_r2, tbn_r2, r2s[i].actor, p, tbn_ctx))
+            goto out;
+    }
+
+    /* b = H(X, R1, R2, m) */
+    SHA256_Init(&sha_context);
+    SHA256_Update(&sha_context, TAG_NONCECOEF, sizeof(TAG_NONCECOEF));
+
+    if (!do_update_padded(&sha_context, agg_pk.actor, buf) ||
+        !do_update_padded(&sha_context, tbn_r1, buf) ||
+        !do_update_padded(&sha_context, tbn_r2, buf) ||
+        !SHA256_Update(&sha_context, arg_msg, arg_len) ||
+        !do_final_scalar(b.actor, &sha_context, q, tbn_ctx))
+        goto out;
+
+    /* R = R1 * R2^b, then e = H(m || R) exactly as do_sign */
+    if (!BN_mod_exp_mont(tbn_r, tbn_r2, b.actor, p, tbn_ctx, domain->get_mont()) ||
+        !BN_mod_mul(tbn_r, tbn_r, tbn_r1, p, tbn_ctx))
+        goto out;
+
+    if (!SHA256_Init(&sha_context) ||
+        !SHA256_Update(&sha_context, arg_msg, arg_len) ||
+        do_challenge_final(e.actor, &sha_context, tbn_r, p, domain->is_toy(), arg_bitn, nullptr) != 0)
+        goto out;
+
+    /* s_i = (k1 + b * k2) + x_i * (e * a_i) mod q */
+    if (!BN_mod_mul(tbn_k, k2.actor, b.actor, q, tbn_ctx) ||
+        !BN_mod_add(tbn_k, tbn_k, k1.actor, q, tbn_ctx) ||
+        !BN_mod_mul(tbn_c, e.actor, coefs[self].actor, q, tbn_ctx) ||
+        key.do_respond(partials[self].actor, tbn_k, tbn_c, tbn_ctx) != 0)
+        goto out;
+
+    BN_copy(arg_s, partials[self].actor);
+    has_partial[self] = challenge_ready = true;
+
+    ret_code = 0;
+
+out:
+    /* Once, whether signed or not. */
+    BN_clear(k1.actor), BN_clear(k2.actor);
+    nonce_ready = false;
+
+    if (tbn_k != nullptr) BN_clear(tbn_k);
+    BN_CTX_end(tbn_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * set_partial
+ */
+int EE488::MuSigSession::set_partial(const size_t arg_i, const BIGNUM* arg_s) {
+
+    if (!challenge_ready || arg_i >= pks.size() || arg_i == self ||
+        BN_is_negative(arg_s) || BN_cmp(arg_s, domain->get_q()) >= 0)
+        return -1;
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_lhs = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_rhs = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_c = BN_CTX_get(tbn_ctx);
+
+    int ret_code = -1;
+
+    /* g^s_i = R1_i * R2_i^b * X_i^(e * a_i) */
+    if (tbn_c != nullptr &&
+        BN_mod_mul(tbn_c, e.actor, coefs[arg_i].actor, domain->get_q(), tbn_ctx) &&
+        domain->do_gexp(tbn_lhs, arg_s, tbn_ctx) == 0) {
+
+        const BIGNUM* bases[3] = { r1s[arg_i].actor, r2s[arg_i].actor, pks[arg_i].actor };
+        const BIGNUM* exps[3] = { BN_value_one(), b.actor, tbn_c };
+
+        if (do_multi_exp(tbn_rhs, bases, exps, 3, domain->get_mont(), tbn_ctx, domain->get_engine()) == 0 &&
+            BN_cmp(tbn_lhs, tbn_rhs) == 0) {
+
+            BN_copy(partials[arg_i].actor, arg_s);
+            has_partial[arg_i] = true;
+
+            ret_code = 0;
+        }
+    }
+
+    BN_CTX_end(tbn_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_aggregate
+ */
+int EE488::MuSigSession::do_aggregate(BIGNUM* arg_s, BIGNUM* arg_e) const {
+
+    if (!challenge_ready)
+        return -1;
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_zero(arg_s);
+
+    for (size_t i = 0; i < pks.size(); i++) {
+        if (!has_partial[i] ||
+            !BN_mod_add(arg_s, arg_s, partials[i].actor, domain->get_q(), tbn_ctx))
+            return -1;
+    }
+
+    BN_copy(arg_e, e.actor);
+    return 0;
+}
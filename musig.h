@@ -0,0 +1,116 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_MUSIG_H
+#define __EE488_MUSIG_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "./schnorr.h"
+
+
+namespace EE488 {
+
+    /* Aggregate key X = X_1^a_1 * ... * X_n^a_n mod p, with a_i = H(L, X_i)
+     *  mod q and L = H(X_1, ..., X_n). The coefficients keep a signer from
+     *  choosing its key against the others. Every party, the verifier too,
+     *  should list the keys in the same order. The a_i into arg_coefs when
+     *  not nullptr. */
+    int do_musig_key_agg(
+        BIGNUM*,
+        std::vector<bnw_t>*,
+        const sdm_t&,
+        const BIGNUM* const*,
+        const size_t);
+
+
+    /*
+     * class MuSigSession
+     *  One signer of n, over one message, as MuSig2. Two rounds:
+     *
+     *  1. do_nonce_gen draws (k1, k2) and gives (R1, R2) = (g^k1, g^k2) to
+     *     every other signer, who set_nonce them. No message yet, thus the
+     *     round may run ahead of it.
+     *  2. With all nonces, do_partial_sign takes b = H(X, R1, R2, m) of the
+     *     products of all, R = R1 * R2^b, e = H(m || R) as do_sign, and
+     *     s_i = k1 + b * k2 + e * a_i * x_i mod q, then clears (k1, k2).
+     *     Each gives s_i to every other, who set_partial them, checking
+     *     g^s_i = R1_i * R2_i^b * X_i^(e * a_i).
+     *
+     *  do_aggregate gives (s = sum of s_i, e), an ordinary signature under
+     *  the aggregate key, thus a single do_verify for any n. A session
+     *  signs once, nonces are never reused.
+     */
+    class MuSigSession {
+    private:
+        skey_t key;
+        std::shared_ptr<const sdm_t> domain;
+
+        std::vector<bnw_t> pks, coefs;
+        bnw_t agg_pk;
+        size_t self;                    // Own index, n if not listed
+
+        bnw_t k1, k2;                   // Cleared by do_partial_sign
+        bool nonce_ready;
+
+        std::vector<bnw_t> r1s, r2s;    // Public nonces of each
+        std::vector<bool> has_nonce;
+
+        std::vector<bnw_t> partials;
+        std::vector<bool> has_partial;
+
+        bnw_t b, e;
+        bool challenge_ready;
+
+    public:
+        /* Own key, and the keys of all n in order, own among them. */
+        MuSigSession(const skey_t&, const BIGNUM* const*, const size_t);
+        MuSigSession(const MuSigSession&) = delete;
+        ~MuSigSession() { BN_clear(k1.actor), BN_clear(k2.actor); }
+
+        MuSigSession& operator =(const MuSigSession&) = delete;
+
+        /* Round 1 */
+        int do_nonce_gen(BIGNUM*, BIGNUM*);
+        int set_nonce(const size_t, const BIGNUM*, const BIGNUM*);
+
+        /* Round 2, -1 until every nonce is in. */
+        int do_partial_sign(const unsigned char*, size_t, BIGNUM*, const int);
+        int set_partial(const size_t, const BIGNUM*);
+
+        /* (s, e) under get_agg_pk, -1 until every partial is in. */
+        int do_aggregate(BIGNUM*, BIGNUM*) const;
+
+        const BIGNUM* get_agg_pk() const { return agg_pk.actor; }
+        const BIGNUM* get_r1(const size_t i) const { return r1s.at(i).actor; }
+        const BIGNUM* get_r2(const size_t i) const { return r2s.at(i).actor; }
+        const BIGNUM* get_partial(const size_t i) const { return partials.at(i).actor; }
+        const BIGNUM* get_challenge() const { return e.actor; }
+
+        size_t get_nsigners() const { return pks.size(); }
+        size_t get_self() const { return self; }
+
+        const sdm_t* get_domain() const { return domain.get(); }
+        std::shared_ptr<const sdm_t> share_domain() const { return domain; }
+    };
+
+    using msig_t = MuSigSession;
+}
+
+#endif
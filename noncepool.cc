@@ -0,0 +1,199 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+
+#include "./noncepool.h"
+
+
+/*
+ * NoncePool Actions */
+EE488::NoncePool::NoncePool(
+    std::shared_ptr<const sdm_t> arg_domain,
+    const size_t arg_capacity,
+    const size_t arg_nthreads) :
+    domain(arg_domain),
+    pairs(std::max<size_t>(1, arg_capacity)),
+    head(0),
+    count(0),
+    low_water(std::max<size_t>(1, arg_capacity) / 2),
+    stopping(false),
+    refill_requested(false),
+    nhits(0),
+    nmisses(0) {
+
+    /* Slots sized once, thus BN_copy into them never allocates. */
+    const int nbits = BN_num_bits(domain->get_p());
+
+    for (auto& pair: pairs) {
+        BN_set_bit(pair.k.actor, nbits), BN_clear(pair.k.actor);
+        BN_set_bit(pair.r.actor, nbits), BN_clear(pair.r.actor);
+    }
+
+    for (size_t i = 0; i < std::max<size_t>(1, arg_nthreads); i++)
+        fillers.emplace_back(&NoncePool::do_work, this);
+}
+
+
+
+EE488::NoncePool::~NoncePool() {
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+
+    fill_cv.notify_all();
+
+    for (auto& t: fillers) t.join();
+
+    /* Unused nonces never leave. */
+    for (auto& pair: pairs)
+        BN_clear(pair.k.actor), BN_clear(pair.r.actor);
+}
+
+
+
+/*
+ * do_make_pair
+ */
+int EE488::NoncePool::do_make_pair(BIGNUM* arg_k, BIGNUM* arg_r, BN_CTX* arg_ctx) const {
+
+    if (do_rand_nonce(arg_k, domain->get_q(), arg_ctx) != 0 ||
+        domain->do_gexp(arg_r, arg_k, arg_ctx) != 0)
+        return -1;
+
+    return 0;
+}
+
+
+
+/*
+ * do_work
+ */
+void EE488::NoncePool::do_work() {
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    bnw_t k, r;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+
+            /* Sleeps until half is used, or a full pool is asked for, then
+             *  fills up to the capacity. */
+            fill_cv.wait(guard, [&]() { return stopping || refill_requested || count <= low_water; });
+
+            if (stopping) break;
+        }
+
+        for (;;) {
+            /* g^k outside of the lock. */
+            if (do_make_pair(k.actor, r.actor, tbn_ctx) != 0)
+                break;
+
+            std::lock_guard<std::mutex> guard(lock);
+
+            if (stopping || count == pairs.size()) {
+                refill_requested = false;
+                full_cv.notify_all();
+                break;
+            }
+
+            NoncePair& slot = pairs[(head + count) % pairs.size()];
+            BN_copy(slot.k.actor, k.actor);
+            BN_copy(slot.r.actor, r.actor);
+            count++;
+
+            if (count == pairs.size()) {
+                refill_requested = false;
+                full_cv.notify_all();
+                break;
+            }
+        }
+    }
+
+    BN_clear(k.actor), BN_clear(r.actor);
+}
+
+
+
+/*
+ * do_take
+ */
+int EE488::NoncePool::do_take(BIGNUM* arg_k, BIGNUM* arg_r, BN_CTX* arg_ctx) {
+
+    bool taken = false, wake = false;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (count > 0) {
+            NoncePair& slot = pairs[head];
+
+            BN_copy(arg_k, slot.k.actor);
+            BN_copy(arg_r, slot.r.actor);
+            BN_clear(slot.k.actor), BN_clear(slot.r.actor);     // Used once
+
+            head = (head + 1) % pairs.size();
+            count--;
+
+            taken = true;
+        }
+
+        /* Only the take crossing the mark wakes the fillers, or a dry one. */
+        wake = (count == low_water) || !taken;
+    }
+
+    if (wake)
+        fill_cv.notify_all();
+
+    if (taken) {
+        nhits.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    /* Dry, computed in place. */
+    nmisses.fetch_add(1, std::memory_order_relaxed);
+
+    return do_make_pair(arg_k, arg_r, arg_ctx);
+}
+
+
+
+/*
+ * do_wait_full
+ */
+void EE488::NoncePool::do_wait_full() {
+
+    std::unique_lock<std::mutex> guard(lock);
+
+    /* Above the mark the fillers sleep, thus they are asked for the rest. */
+    if (count < pairs.size()) {
+        refill_requested = true;
+        fill_cv.notify_all();
+    }
+
+    full_cv.wait(guard, [&]() { return stopping || count == pairs.size(); });
+}
+
+
+
+size_t EE488::NoncePool::get_size() {
+
+    std::lock_guard<std::mutex> guard(lock);
+    return count;
+}
@@ -0,0 +1,94 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_NONCEPOOL_H
+#define __EE488_NONCEPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./schnorr.h"
+
+
+namespace EE488 {
+
+    const size_t NONCE_POOL_SIZE = 256;     // Default capacity
+
+    /*
+     * class NoncePool
+     *  Offline half of signing. Background threads keep up to a capacity of
+     *  (k, r = g^k mod p) pairs for a domain, which depend on no message.
+     *  do_take hands out each pair exactly once, and clears the slot. When
+     *  the pool runs dry, the pair is computed in place and counted as a
+     *  miss. The fillers wake when half of the pool is used, or when
+     *  do_wait_full asks for the rest.
+     */
+    class NoncePool {
+    private:
+        struct NoncePair {
+            bnw_t k, r;
+        };
+
+        std::shared_ptr<const sdm_t> domain;
+
+        std::vector<NoncePair> pairs;   // Ring
+        size_t head, count;
+        const size_t low_water;
+
+        std::mutex lock;
+        std::condition_variable fill_cv;
+        std::condition_variable full_cv;    // For do_wait_full
+
+        std::vector<std::thread> fillers;
+        bool stopping;
+        bool refill_requested;          // By do_wait_full, above the mark
+
+        std::atomic<unsigned long> nhits, nmisses;
+
+        int do_make_pair(BIGNUM*, BIGNUM*, BN_CTX*) const;
+        void do_work();
+
+    public:
+        NoncePool(std::shared_ptr<const sdm_t>, const size_t = NONCE_POOL_SIZE, const size_t = 1);
+        NoncePool(const NoncePool&) = delete;
+        ~NoncePool();
+
+        NoncePool& operator =(const NoncePool&) = delete;
+
+        /* Copies a fresh pair into (k, r), and erases it from the pool. */
+        int do_take(BIGNUM*, BIGNUM*, BN_CTX*);
+
+        /* Blocks until the pool is full, e.g. before a burst. */
+        void do_wait_full();
+
+        const sdm_t* get_domain() const { return domain.get(); }
+
+        size_t get_capacity() const { return pairs.size(); }
+        size_t get_size();
+
+        unsigned long get_nhits() const { return nhits.load(std::memory_order_relaxed); }
+        unsigned long get_nmisses() const { return nmisses.load(std::memory_order_relaxed); }
+    };
+
+    using npool_t = NoncePool;
+}
+
+#endif
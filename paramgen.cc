@@ -0,0 +1,207 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "./paramgen.h"
+
+#include <openssl/err.h>     // After the API level of schnorr.h
+
+
+namespace {
+
+    struct RaceState {
+        std::atomic<int> winner;
+        std::atomic<uint64_t> callbacks;
+        std::atomic<bool> timed_out;
+
+        bool has_deadline;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    /* BN_GENCB callback of every racer. 0 stops the search it is in. */
+    int do_progress(int, int, BN_GENCB* arg_cb) {
+        RaceState* state = static_cast<RaceState*>(BN_GENCB_get_arg(arg_cb));
+
+        state->callbacks.fetch_add(1, std::memory_order_relaxed);
+
+        if (state->winner.load(std::memory_order_acquire) >= 0)
+            return 0;
+
+        if (state->has_deadline && std::chrono::steady_clock::now() >= state->deadline) {
+            state->timed_out.store(true, std::memory_order_relaxed);
+            return 0;
+        }
+
+        return 1;
+    }
+};
+
+
+
+/*
+ * ParamGenerator Actions */
+EE488::ParamGenerator::ParamGenerator(size_t arg_nracers, long arg_deadline_ms) :
+    nracers(arg_nracers),
+    deadline_ms(arg_deadline_ms > 0 ? arg_deadline_ms : 0),
+    stats{} {
+
+    if (nracers == 0)
+        nracers = std::max(1u, std::thread::hardware_concurrency());
+
+    stats.nracers = nracers;
+    stats.winner = -1;
+}
+
+
+
+/*
+ * do_race
+ */
+int EE488::ParamGenerator::do_race(
+    const std::function<bool(size_t, BN_GENCB*)>& arg_search,
+    const std::chrono::steady_clock::time_point& arg_deadline) {
+
+    RaceState state;
+
+    state.winner.store(-1);
+    state.callbacks.store(0);
+    state.timed_out.store(false);
+    state.has_deadline = (deadline_ms > 0);
+    state.deadline = arg_deadline;
+
+    auto do_racer = [&](const size_t arg_i) {
+        BN_GENCB* cb = BN_GENCB_new();
+        if (cb == nullptr)
+            return;
+
+        BN_GENCB_set(cb, do_progress, &state);
+
+        /* A search stopped by the callback fails, thus never wins. Its
+         *  error stays off the queue of the caller, who runs racer 0. */
+        if (arg_search(arg_i, cb)) {
+            int none = -1;
+            state.winner.compare_exchange_strong(none, static_cast<int>(arg_i), std::memory_order_acq_rel);
+        }
+        else
+            ERR_clear_error();
+
+        BN_GENCB_free(cb);
+    };
+
+    std::vector<std::thread> racers;
+
+    for (size_t i = 1; i < nracers; i++)
+        racers.emplace_back(do_racer, i);
+
+    do_racer(0);
+
+    for (auto& t: racers) t.join();
+
+    stats.callbacks += state.callbacks.load();
+    stats.timed_out = stats.timed_out || state.timed_out.load();
+
+    return state.winner.load();
+}
+
+
+
+/*
+ * do_generate_dsa
+ */
+int EE488::ParamGenerator::do_generate_dsa(BIGNUM* arg_p, BIGNUM* arg_q, BIGNUM* arg_g, const int arg_bits) {
+
+    const auto t_begin = std::chrono::steady_clock::now();
+
+    stats = pgstats_t{ nracers, -1, 0, 0, false };
+
+    std::vector<DSA*> dsas(nracers, nullptr);
+
+    for (auto& dsa: dsas) {
+        if ((dsa = DSA_new()) == nullptr)
+            break;
+    }
+
+    /* Refer to,
+     * https://www.openssl.org/docs/man1.1.1/man3/DSA_generate_parameters_ex.html
+     *  Each racer with its own DSA, no seed, thus its own random walk.
+     */
+    const int winner = do_race([&](const size_t arg_i, BN_GENCB* arg_cb) {
+        return dsas[arg_i] != nullptr &&
+            DSA_generate_parameters_ex(dsas[arg_i], arg_bits, NULL, 0, NULL, NULL, arg_cb) == 1;
+
+    }, t_begin + std::chrono::milliseconds(deadline_ms));
+
+    int ret_code = -1;
+
+    if (winner >= 0 &&
+        BN_copy(arg_p, DSA_get0_p(dsas[winner])) != nullptr &&
+        BN_copy(arg_q, DSA_get0_q(dsas[winner])) != nullptr &&
+        BN_copy(arg_g, DSA_get0_g(dsas[winner])) != nullptr)
+        ret_code = 0;
+
+    for (auto dsa: dsas)
+        DSA_free(dsa);
+
+    stats.winner = (ret_code == 0) ? winner : -1;
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_begin).count();
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_generate_toy
+ */
+int EE488::ParamGenerator::do_generate_toy(BIGNUM* arg_p, BIGNUM* arg_q, const int arg_l, const int arg_n) {
+
+    /* https://www.openssl.org/docs/man1.1.1/man3/BN_generate_prime.html
+     * If add is not NULL, the prime will fulfill the condition
+     * p % add == rem (p % add == 1 if rem == NULL) in order to suit a given generator.
+     */
+    const auto t_begin = std::chrono::steady_clock::now();
+    const auto deadline = t_begin + std::chrono::milliseconds(deadline_ms);
+
+    stats = pgstats_t{ nracers, -1, 0, 0, false };
+
+    std::vector<bnw_t> found(nracers);
+    int winner = -1;
+
+    /* q, then p over the q of the winner. Both under one deadline. */
+    winner = do_race([&](const size_t arg_i, BN_GENCB* arg_cb) {
+        return BN_generate_prime_ex(found[arg_i].actor, arg_n, false, NULL, NULL, arg_cb) == 1;
+    }, deadline);
+
+    if (winner < 0 || BN_copy(arg_q, found[winner].actor) == nullptr)
+        goto out;
+
+    winner = do_race([&](const size_t arg_i, BN_GENCB* arg_cb) {
+        return BN_generate_prime_ex(found[arg_i].actor, arg_l, false, arg_q, NULL, arg_cb) == 1;
+    }, deadline);
+
+    if (winner < 0 || BN_copy(arg_p, found[winner].actor) == nullptr)
+        winner = -1;
+
+out:
+    stats.winner = winner;
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_begin).count();
+
+    return (winner >= 0) ? 0 : -1;
+}
@@ -0,0 +1,82 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_PARAMGEN_H
+#define __EE488_PARAMGEN_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "./schnorr.h"
+
+
+namespace EE488 {
+
+    struct ParamGenStats {
+        size_t nracers;
+        int winner;             // Racer that found it, -1 if none did
+        uint64_t callbacks;     // BN_GENCB calls of all, about candidates and rounds
+        double elapsed_ms;
+        bool timed_out;
+    };
+
+    using pgstats_t = ParamGenStats;
+
+
+    /*
+     * class ParamGenerator
+     *  Races n independent searches for (p, q), one per thread, the caller
+     *  among them. A search is a random walk of heavy-tailed length, thus
+     *  the first of n ends far sooner than one alone, and the tail is cut
+     *  the most. Each search runs under a BN_GENCB, whose callback comes
+     *  once per candidate and per Miller-Rabin round: it stops the search
+     *  once another has won, or once the deadline has passed. The result is
+     *  a valid (p, q) as one search gives, but not of the same distribution:
+     *  the first to finish wins, thus pairs of a shorter search come more
+     *  often.
+     */
+    class ParamGenerator {
+    private:
+        size_t nracers;
+        long deadline_ms;       // 0 for none
+
+        pgstats_t stats;
+
+        /* Runs the search on every racer, index and callback given, and
+         *  returns the index of the first that succeeded, -1 if none. */
+        int do_race(const std::function<bool(size_t, BN_GENCB*)>&, const std::chrono::steady_clock::time_point&);
+
+    public:
+        /* 0 racers, as many as cores. The deadline is of each do_generate_*. */
+        explicit ParamGenerator(size_t arg_nracers = 0, long arg_deadline_ms = 0);
+
+        /* (p, q, g) of DSA_generate_parameters_ex, as do_rkeygen took. */
+        int do_generate_dsa(BIGNUM*, BIGNUM*, BIGNUM*, const int);
+
+        /* q of n bits, then p of l bits with p = 1 mod q, as do_tkeygen. */
+        int do_generate_toy(BIGNUM*, BIGNUM*, const int, const int);
+
+        const pgstats_t& get_stats() const { return stats; }
+        size_t get_nracers() const { return nracers; }
+    };
+
+    using pgen_t = ParamGenerator;
+}
+
+#endif
@@ -0,0 +1,188 @@
+/* Author: SukJoon Oh
+ * Test Environment: 
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n 
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+
+#include "./pool.h"
+
+
+/* Which pool, and which queue the running thread owns. */
+static thread_local const EE488::ThreadPool* tls_pool = nullptr;
+static thread_local size_t tls_idx = 0;
+
+
+/* 
+ * ThreadPool Actions */
+EE488::ThreadPool::ThreadPool(size_t arg_nthreads) : 
+    npending(0), 
+    next_queue(0), 
+    stopping(false) {
+
+    if (arg_nthreads == 0)
+        arg_nthreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < arg_nthreads; i++)
+        queues.emplace_back(new WorkQueue());
+
+    for (size_t i = 0; i < arg_nthreads; i++)
+        workers.emplace_back(&ThreadPool::do_work, this, i);
+}
+
+
+
+EE488::ThreadPool::~ThreadPool() {
+
+    {
+        std::lock_guard<std::mutex> guard(idle_lock);
+        stopping = true;
+    }
+
+    idle_cv.notify_all();
+
+    for (auto& w: workers) w.join();
+}
+
+
+
+/*
+ * do_pop
+ */
+bool EE488::ThreadPool::do_pop(const size_t arg_home, task_t& arg_task) {
+
+    const size_t nqueues = queues.size();
+
+    /* Own queue first, newest first. */
+    {
+        WorkQueue& q = *queues[arg_home];
+        std::lock_guard<std::mutex> guard(q.lock);
+
+        if (!q.tasks.empty()) {
+            arg_task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            npending--;
+
+            return true;
+        }
+    }
+
+    /* Then steal, oldest first. */
+    for (size_t i = 1; i < nqueues; i++) {
+        WorkQueue& q = *queues[(arg_home + i) % nqueues];
+        std::lock_guard<std::mutex> guard(q.lock);
+
+        if (!q.tasks.empty()) {
+            arg_task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            npending--;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+/*
+ * do_work
+ */
+void EE488::ThreadPool::do_work(const size_t arg_idx) {
+
+    tls_pool = this;
+    tls_idx = arg_idx;
+
+    task_t task;
+
+    while (true) {
+        if (do_pop(arg_idx, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(idle_lock);
+        idle_cv.wait(guard, [this]() { return stopping || npending > 0; });
+
+        if (stopping && npending == 0)
+            break;
+    }
+}
+
+
+
+/*
+ * do_submit
+ */
+void EE488::ThreadPool::do_submit(task_t arg_task) {
+
+    const size_t home = (tls_pool == this) ? 
+        tls_idx : (next_queue++ % queues.size());
+
+    /* Counted once visible, under the lock its pop takes, thus a worker
+     *  that sees npending > 0 finds a task, and a pop never runs below zero. */
+    {
+        WorkQueue& q = *queues[home];
+        std::lock_guard<std::mutex> guard(q.lock);
+
+        q.tasks.push_back(std::move(arg_task));
+        npending++;
+    }
+
+    /* A worker between its check and its wait holds idle_lock, thus this
+     *  notify is not lost. */
+    {
+        std::lock_guard<std::mutex> guard(idle_lock);
+    }
+
+    idle_cv.notify_one();
+}
+
+
+
+/*
+ * do_parallel_for
+ */
+void EE488::ThreadPool::do_parallel_for(
+    const size_t arg_n, 
+    const size_t arg_grain, 
+    const std::function<void(size_t, size_t)>& arg_func) {
+
+    if (arg_n == 0)
+        return;
+
+    const size_t grain = std::max<size_t>(arg_grain, 1);
+    std::atomic<size_t> nremain((arg_n + grain - 1) / grain);
+
+    for (size_t begin = 0; begin < arg_n; begin += grain) {
+        const size_t end = std::min(arg_n, begin + grain);
+
+        do_submit([&arg_func, &nremain, begin, end]() {
+            arg_func(begin, end);
+            nremain--;
+        });
+    }
+
+    /* Help, instead of blocking a thread. */
+    const size_t home = (tls_pool == this) ? tls_idx : 0;
+    task_t task;
+
+    while (nremain > 0) {
+        if (do_pop(home, task))
+            task();
+        else
+            std::this_thread::yield();
+    }
+}
@@ -0,0 +1,85 @@
+/* Author: SukJoon Oh
+ * Test Environment: 
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n 
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_POOL_H
+#define __EE488_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace EE488 {
+
+    using task_t = std::function<void()>;
+
+    /* 
+     * class ThreadPool
+     *  Work-stealing thread pool. Every worker owns a queue. A worker takes
+     *  its own tasks from the back (newest first), and when it runs out, 
+     *  steals from the front of the others (oldest first). Tasks submitted
+     *  from a worker go to its own queue, others are spread round-robin.
+     */
+    class ThreadPool {
+    private:
+        struct WorkQueue {
+            std::mutex lock;
+            std::deque<task_t> tasks;
+        };
+
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex idle_lock;
+        std::condition_variable idle_cv;
+
+        std::atomic<size_t> npending;
+        std::atomic<size_t> next_queue;
+        std::atomic<bool> stopping;
+
+        bool do_pop(const size_t, task_t&);
+        void do_work(const size_t);
+
+    public:
+        explicit ThreadPool(size_t arg_nthreads = 0);   // 0, as many as cores
+        ThreadPool(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        ThreadPool& operator =(const ThreadPool&) = delete;
+
+        void do_submit(task_t);
+
+        /* Runs arg_func(begin, end) over [0, arg_n) in chunks of arg_grain, 
+         *  and returns when all are done. The caller runs tasks too while 
+         *  waiting, thus it may be called from a worker. */
+        void do_parallel_for(
+            const size_t, 
+            const size_t, 
+            const std::function<void(size_t, size_t)>&);
+
+        size_t get_nthreads() const { return workers.size(); }
+    };
+
+    using pool_t = ThreadPool;
+};
+
+#endif
@@ -18,18 +18,22 @@
  *  https://www.openssl.org, specifically https://www.openssl.org/docs/man1.1.1/man3/
  */
 
-#ifdef __PRINT
-#include <iostream>
-#endif
-
 #ifndef __OPENSSL
 #define __OPENSSL
 #endif
 
 #include <string>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 
 #include "./schnorr.h"
+#include "./pool.h"
+#include "./logger.h"
+#include "./noncepool.h"
+#include "./ecschnorr.h"
+#include "./paramgen.h"
 #define __BN_MODIFIABLE__(X) const_cast<BIGNUM*>((X))
 
 
@@ -44,7 +48,7 @@ EE488::BigNumberWrapper::~BigNumberWrapper() {
 }
 
 
-EE488::BigNumberWrapper::BigNumberWrapper(const BigNumberWrapper& arg_bnw) {
+EE488::BigNumberWrapper::BigNumberWrapper(const BigNumberWrapper& arg_bnw) : actor(BN_new()) {
 
     // Free all actors
     if (arg_bnw.actor != nullptr)
@@ -52,7 +56,7 @@ EE488::BigNumberWrapper::BigNumberWrapper(const BigNumberWrapper& arg_bnw) {
 }
 
 
-EE488::BigNumberWrapper::BigNumberWrapper(const BigNumberWrapper&& arg_bnw) {
+EE488::BigNumberWrapper::BigNumberWrapper(const BigNumberWrapper&& arg_bnw) : actor(BN_new()) {
 
     // Free all actors
     if (arg_bnw.actor != nullptr)
@@ -117,484 +121,474 @@ void EE488::BigNumberManager::reset_asset() {
 
 
 
-void EE488::SchnorrSignature::console_msg(const char* arg_fname, const char* arg_msg) {
-
-#ifdef __PRINT
-    std::cout << "\t" << arg_fname << ":: " << arg_msg;
-#endif
-    ;
-};
+/* 
+ * Per-thread scratch */
+namespace {
 
+    /* Freed when the thread exits. */
+    struct ThreadCtx {
+        BN_CTX* ctx;
 
+        ThreadCtx() : ctx(BN_CTX_new()) {}
+        ~ThreadCtx() { BN_CTX_free(ctx); }
+    };
 
-void EE488::SchnorrSignature::console_msg(const char* arg_fname, const std::string& arg_str) {
-    this->console_msg(arg_fname, arg_str.c_str());
-};
+    std::atomic<unsigned long> nallocs(0);
 
+    void* do_count_malloc(size_t arg_len, const char*, int) {
+        nallocs++;
+        return std::malloc(arg_len);
+    }
 
+    void* do_count_realloc(void* arg_ptr, size_t arg_len, const char*, int) {
+        nallocs++;
+        return std::realloc(arg_ptr, arg_len);
+    }
 
-void EE488::SchnorrSignature::console_msgn(const char* arg_fname, const char* arg_msg) {
+    void do_count_free(void* arg_ptr, const char*, int) {
+        std::free(arg_ptr);
+    }
 
-#ifdef __PRINT
-    std::cout << "\t" << arg_fname << ":: " << arg_msg << std::endl;
-#endif
-    ;
-};
+    /* HMAC-SHA256 on two SHA256_CTX, thus on the stack. RFC 2104. */
+    struct HmacSha256 {
+        SHA256_CTX inner, outer;
 
+        void do_init(const unsigned char* arg_key, size_t arg_len) {
+            unsigned char arr_pad[SHA256_CBLOCK] = { 0, };
 
-void EE488::SchnorrSignature::console_msgn(const char* arg_fname, const std::string& arg_str) {
-    this->console_msgn(arg_fname, arg_str.c_str());
-};
+            if (arg_len > SHA256_CBLOCK)
+                SHA256(arg_key, arg_len, arr_pad);
+            else
+                std::memcpy(arr_pad, arg_key, arg_len);
 
+            for (auto& c: arr_pad) c ^= 0x36;
+            SHA256_Init(&inner), SHA256_Update(&inner, arr_pad, sizeof(arr_pad));
 
-/*
- * do_tkeygen
- */
-int EE488::SchnorrSignature::do_tkeygen(const int arg_l, const int arg_n) {
+            for (auto& c: arr_pad) c ^= 0x36 ^ 0x5c;
+            SHA256_Init(&outer), SHA256_Update(&outer, arr_pad, sizeof(arr_pad));
 
-    /* https://www.openssl.org/docs/man1.1.1/man3/BN_generate_prime.html
-     * If add is not NULL, the prime will fulfill the condition 
-     * p % add == rem (p % add == 1 if rem == NULL) in order to suit a given generator.
-     */
+            OPENSSL_cleanse(arr_pad, sizeof(arr_pad));
+        }
 
-    console_msgn(__FUNCTION__, "Toy key generation start.");
-    
-    if (!BN_generate_prime_ex(
-        __BN_MODIFIABLE__(manager.get_asset(BN_Q)),
-        arg_n, 
-        false,      // Safe prime?
-        NULL,       // ADD
-        NULL,       // REM
-        NULL        // CALLBACK
-        )) {
-        
-        console_msg(__FUNCTION__, "Error, Generation of Q failed.");
-    }
+        void do_update(const unsigned char* arg_data, size_t arg_len) {
+            SHA256_Update(&inner, arg_data, arg_len);
+        }
 
-    if (!BN_generate_prime_ex(
-        __BN_MODIFIABLE__(manager.get_asset(BN_P)),
-        arg_l, 
-        false,                      // Safe prime?
-        manager.get_asset(BN_Q),    // ADD
-        NULL,                       // REM
-        NULL                        // CALLBACK
-        )) {
-        
-        console_msg(__FUNCTION__, "Error, Generation of P failed.");
-    }
+        void do_final(unsigned char* arg_out) {
+            unsigned char arr_inner[SHA256_DIGEST_LENGTH];
 
+            SHA256_Final(arr_inner, &inner);
+            SHA256_Update(&outer, arr_inner, sizeof(arr_inner));
+            SHA256_Final(arg_out, &outer);
+        }
 
-#ifdef __PRINT
-    console_msg(__FUNCTION__, "Generated P:");
-    BN_print_fp(
-        stdout, 
-        manager.get_asset(BN_P)
-        );
+        ~HmacSha256() { 
+            OPENSSL_cleanse(&inner, sizeof(inner)), OPENSSL_cleanse(&outer, sizeof(outer)); 
+        }
+    };
 
-    std::cout << std::endl;
-#endif
+    /* Length, then the big-endian bytes, thus no two lists of numbers are
+     *  hashed alike. On the stack up to 4096 bits. */
+    bool do_update_bn(SHA256_CTX* arg_ctx, const BIGNUM* arg_bn) {
 
-#ifdef __PRINT
-    console_msg(__FUNCTION__, "Generated Q:");
-    BN_print_fp(
-        stdout, 
-        manager.get_asset(BN_Q)
-        );
+        unsigned char arr_bin[512];
+        const size_t len = BN_num_bytes(arg_bn);
+        const unsigned char arr_len[4] = {
+            static_cast<unsigned char>(len >> 24), static_cast<unsigned char>(len >> 16),
+            static_cast<unsigned char>(len >> 8), static_cast<unsigned char>(len) };
 
-    std::cout << std::endl;
-#endif
+        if (!SHA256_Update(arg_ctx, arr_len, sizeof(arr_len)))
+            return false;
 
-    /* P and Q are generated, --till here. */
+        if (len <= sizeof(arr_bin)) {
+            BN_bn2bin(arg_bn, arr_bin);
+            return SHA256_Update(arg_ctx, arr_bin, len);
+        }
 
-    /* Generate Parameter g */
-    {   
-        BIGNUM* tbn_h   = BN_new();
-        BIGNUM* tbn_p_1 = BN_new();
-        BIGNUM* tbn_div = BN_new();
+        std::vector<unsigned char> bin(len);
+        BN_bn2bin(arg_bn, bin.data());
 
-        BN_CTX* tbn_ctx = BN_CTX_new();
+        return SHA256_Update(arg_ctx, bin.data(), len);
+    }
+};
 
-        BN_set_word(tbn_h, 2);  // Init to 2.
 
-        BN_copy(tbn_p_1, manager.get_asset(BN_P));  // tbn_p_1 = BN_P
-        BN_sub_word(tbn_p_1, 1);                    // tbn_p_1 = BN_P - 1
 
-        BN_div(tbn_div, NULL, tbn_p_1, manager.get_asset(BN_Q), tbn_ctx);
+BN_CTX* EE488::get_thread_ctx() {
 
-        // Get random number 'g'
-        // Refered to, https://en.wikipedia.org/wiki/Digital_Signature_Algorithm
-        do {
+    static thread_local ThreadCtx thread_ctx;
+    return thread_ctx.ctx;
+}
 
-            BN_mod_exp(                     // g = h^k mod p
-                __BN_MODIFIABLE__(manager.get_asset(BN_G)),                        
-                                            // Save to, g
-                tbn_h,                      // h
-                tbn_div,                    // p - 1 / q
-                manager.get_asset(BN_P),    // p
-                tbn_ctx);  
 
-            BN_add_word(tbn_h, 1);          // Incr tbn_h by one.
 
-            console_msg(__FUNCTION__, "Test g: ");
+/*
+ * do_rand_nonce
+ */
+int EE488::do_rand_nonce(BIGNUM* arg_k, const BIGNUM* arg_q, BN_CTX* arg_ctx) {
 
-        } while (BN_is_one(
-            manager.get_asset(BN_G)
-        ));
+    /* k in [1, q - 1]. BN_rand_range allocates a buffer on every call, thus
+     *  the bytes are drawn on the stack. 64 more bits than q keep the bias of
+     *  the reduction below 2^-64.
+     */
+    unsigned char arr_rand[NONCE_MAX_BYTES + 8];
+    const int nbytes = BN_num_bytes(arg_q) + 8;
 
-        BN_free(tbn_h), BN_free(tbn_p_1), BN_free(tbn_div);
-        BN_CTX_free(tbn_ctx);
+    if (nbytes > static_cast<int>(sizeof(arr_rand))) {
+        do {
+            if (!BN_rand_range(arg_k, arg_q)) return -1;
+        } while (BN_is_zero(arg_k));
 
-        console_msgn(__FUNCTION__, "Generated g.");
+        return 0;
     }
 
-    /* Generate Secrey Key x */
-    /*  If zero, generate again. 
-     */
-    do {
-        BN_rand_range(
-            __BN_MODIFIABLE__(manager.get_asset(BN_SK)), 
-            manager.get_asset(BN_Q));
-
-    } while (BN_is_zero(
-        manager.get_asset(BN_SK)
-    ));
+    int ret_code = -1;
 
+    do {
+        if (RAND_priv_bytes(arr_rand, nbytes) != 1 ||
+            BN_bin2bn(arr_rand, nbytes, arg_k) == nullptr ||
+            !BN_nnmod(arg_k, arg_k, arg_q, arg_ctx))
+            goto out;
 
-    /* Generate Public Key */
-    {
-        BN_CTX* tbn_ctx = BN_CTX_new();
+    } while (BN_is_zero(arg_k));
 
-        BN_mod_exp(
-            __BN_MODIFIABLE__(manager.get_asset(BN_PK)), 
-            manager.get_asset(BN_G),
-            manager.get_asset(BN_SK),
-            manager.get_asset(BN_P),
-            tbn_ctx
-        );
+    ret_code = 0;
 
-        BN_CTX_free(tbn_ctx);
-    }
+out:
+    /* A draw cut short may have left bytes behind, of either. */
+    OPENSSL_cleanse(arr_rand, sizeof(arr_rand));
 
-    console_msgn(__FUNCTION__, "Toy key generation end.");
-    pk_ready = sk_ready = true;
+    if (ret_code != 0)
+        BN_clear(arg_k);
 
-    return 0;
+    return ret_code;
 }
 
 
+
 /*
- * do_rkeygen
+ * do_derive_nonce
  */
-int EE488::SchnorrSignature::do_rkeygen(const int arg_bits) {
-    
-    DSA* dsa_key = DSA_new();
+int EE488::do_derive_nonce(
+    BIGNUM* arg_k, 
+    const BIGNUM* arg_q, 
+    const BIGNUM* arg_x, 
+    const unsigned char* arg_h1, 
+    size_t arg_h1_len, 
+    BN_CTX* arg_ctx,
+    const unsigned char* arg_extra,
+    size_t arg_extra_len) {
 
     /* Refer to,
-     * https://www.openssl.org/docs/man1.1.1/man3/DSA_generate_parameters_ex.html
-     * https://www.openssl.org/docs/man1.1.1/man3/BN_generate_prime.html
-     * DSA_generate_parameters_ex : Creates two primes, p and q and a generator g.
-     *      The results are stored in the DSA container, dsa_key.
+     * https://www.rfc-editor.org/rfc/rfc6979, 3.2, 3.6 and 2.3
+     *  K, V of the HMAC-DRBG are seeded with int2octets(x) || bits2octets(h1)
+     *  || k', then V is drawn until bits2int(V || V || ...) lands in 
+     *  [1, q - 1]. k' is the additional data, none for plain 3.2.
      */
-    DSA_generate_parameters_ex(
-        dsa_key,    // DSA, stores the result in here.
-        arg_bits,   // BITS, length of primes p and q and a generator g
-        NULL,       // SEED, when given null, the primes will be generated at random.
-        0,          // SEED_LEN, when it is less then len(q), error is returned.
-        NULL,       // COUNTER_RET, iteration count.
-        NULL,       // H_RET, counter used for finding a generator.
-        NULL        // CALLBACK, feedback about the progress of the key generation
-    );
+    const int qlen = BN_num_bits(arg_q);
+    const int rlen = (qlen + 7) / 8;
 
-    if (!DSA_generate_key(dsa_key)) {
-        console_msgn(__FUNCTION__, "ERROR, DSA_generate_key");
+    if (rlen > NONCE_MAX_BYTES || qlen < 2)
         return -1;
-    }
-    
-    /* Setting three parameters, p q g */
-    manager.set_asset(__BN_MODIFIABLE__(DSA_get0_p(dsa_key)), BN_P);
-    manager.set_asset(__BN_MODIFIABLE__(DSA_get0_q(dsa_key)), BN_Q);
-    manager.set_asset(__BN_MODIFIABLE__(DSA_get0_g(dsa_key)), BN_G);
-
-    /* Official API returns it as const BIGNUM. 
-     *  Safe to convert, since no modifications are done.
-     */
 
-    manager.set_keys(
-        __BN_MODIFIABLE__(DSA_get0_pub_key(dsa_key)),
-        __BN_MODIFIABLE__(DSA_get0_priv_key(dsa_key))
-    );
+    unsigned char arr_k[SHA256_DIGEST_LENGTH], arr_v[SHA256_DIGEST_LENGTH];
+    unsigned char arr_x[NONCE_MAX_BYTES], arr_h[NONCE_MAX_BYTES];
+    unsigned char arr_t[NONCE_MAX_BYTES + SHA256_DIGEST_LENGTH];
+
+    const unsigned char sep[2] = { 0x00, 0x01 };
+    const int h1_bits = static_cast<int>(arg_h1_len) * 8;
+
+    int ret_code = -1;
+    HmacSha256 hmac;
+
+    BN_CTX_start(arg_ctx);
+    BIGNUM* tbn = BN_CTX_get(arg_ctx);
+
+    if (tbn == nullptr || BN_bn2binpad(arg_x, arr_x, rlen) != rlen)
+        goto out;
+
+    /* bits2octets(h1) = int2octets(bits2int(h1) mod q) */
+    BN_bin2bn(arg_h1, static_cast<int>(arg_h1_len), tbn);
+    if (h1_bits > qlen)
+        BN_rshift(tbn, tbn, h1_bits - qlen);
+    BN_nnmod(tbn, tbn, arg_q, arg_ctx);
+    BN_bn2binpad(tbn, arr_h, rlen);
+
+    std::memset(arr_v, 0x01, sizeof(arr_v));
+    std::memset(arr_k, 0x00, sizeof(arr_k));
+
+    for (int i = 0; i < 2; i++) {
+        /* K = HMAC_K(V || i || x || h), V = HMAC_K(V) */
+        hmac.do_init(arr_k, sizeof(arr_k));
+        hmac.do_update(arr_v, sizeof(arr_v));
+        hmac.do_update(&sep[i], 1);
+        hmac.do_update(arr_x, rlen);
+        hmac.do_update(arr_h, rlen);
+        if (arg_extra_len > 0)
+            hmac.do_update(arg_extra, arg_extra_len);
+        hmac.do_final(arr_k);
+
+        hmac.do_init(arr_k, sizeof(arr_k));
+        hmac.do_update(arr_v, sizeof(arr_v));
+        hmac.do_final(arr_v);
+    }
 
-    /* Record to file when __PRINT is enabled.
-     *  Best for debugging purpose.
-     */
-    {
+    for (;;) {
+        int tlen = 0;
 
-#ifdef __PRINT
-        console_msgn(__FUNCTION__, "Writing to log...");
+        while (tlen < rlen) {
+            hmac.do_init(arr_k, sizeof(arr_k));
+            hmac.do_update(arr_v, sizeof(arr_v));
+            hmac.do_final(arr_v);
 
-        FILE* fp = std::fopen("./params.log", "w");
+            std::memcpy(arr_t + tlen, arr_v, sizeof(arr_v));
+            tlen += sizeof(arr_v);
+        }
 
-        std::fprintf(fp, "p\t"),    BN_print_fp(fp, manager.get_asset(BN_P));
-        std::fprintf(fp, "\nq\t"),  BN_print_fp(fp, manager.get_asset(BN_Q));
-        std::fprintf(fp, "\ng\t"),  BN_print_fp(fp, manager.get_asset(BN_G));
-        std::fprintf(fp, "\npk\t"),  BN_print_fp(fp, manager.get_asset(BN_PK));
-        std::fprintf(fp, "\nsk\t"),  BN_print_fp(fp, manager.get_asset(BN_SK));
-        std::fprintf(fp, "\n");
+        /* bits2int(T), leftmost qlen bits */
+        BN_bin2bn(arr_t, rlen, arg_k);
+        if (rlen * 8 > qlen)
+            BN_rshift(arg_k, arg_k, rlen * 8 - qlen);
 
-        std::fclose(fp);
+        if (!BN_is_zero(arg_k) && BN_cmp(arg_k, arg_q) < 0)
+            break;
 
-        console_msgn(__FUNCTION__, "Done.");
-#endif
+        /* K = HMAC_K(V || 0x00), V = HMAC_K(V) */
+        hmac.do_init(arr_k, sizeof(arr_k));
+        hmac.do_update(arr_v, sizeof(arr_v));
+        hmac.do_update(&sep[0], 1);
+        hmac.do_final(arr_k);
 
+        hmac.do_init(arr_k, sizeof(arr_k));
+        hmac.do_update(arr_v, sizeof(arr_v));
+        hmac.do_final(arr_v);
     }
 
-    /* OpenSSL's API is only used for generating keys.
-     * No more use further. Thus just delete the object.
-     */
-    DSA_free(dsa_key);  
+    ret_code = 0;
 
-    pk_ready = sk_ready = true; // Now the key is ready to go.
+out:
+    OPENSSL_cleanse(arr_k, sizeof(arr_k)), OPENSSL_cleanse(arr_v, sizeof(arr_v));
+    OPENSSL_cleanse(arr_x, sizeof(arr_x)), OPENSSL_cleanse(arr_t, sizeof(arr_t));
 
-    return 0;
-}
+    if (tbn != nullptr)
+        BN_clear(tbn);
 
+    BN_CTX_end(arg_ctx);
 
+    return ret_code;
+}
 
-/*
- * do_regmsg
- */
-int EE488::SchnorrSignature::do_regmsg(const char* arg_pmsg) {
-    std::strcpy(reinterpret_cast<char *>(mstr), arg_pmsg);
 
-    console_msgn(__FUNCTION__, "Registered string:");
-    console_msgn(__FUNCTION__, reinterpret_cast<char *>(mstr));
 
-    msg_ready = true;// Now the original message is ready to go.
-    return 0;
+bool EE488::do_install_alloc_counter() {
+    return CRYPTO_set_mem_functions(do_count_malloc, do_count_realloc, do_count_free) == 1;
 }
 
 
-/*
- * do_rhash
- */
-BIGNUM* EE488::SchnorrSignature::do_rhash() {
 
-    return this->do_rhash(reinterpret_cast<char *>(this->mstr));
+unsigned long EE488::get_alloc_count() {
+    return nallocs;
 }
 
 
-BIGNUM* EE488::SchnorrSignature::do_rhash(const char* arg_str) {
-    
-    return this->do_rhash(std::string(arg_str));
-}
-
 
-BIGNUM* EE488::SchnorrSignature::do_rhash(std::string arg_str) {
+/* 
+ * FixedBaseTable Actions */
+EE488::FixedBaseTable::FixedBaseTable(
+    const BIGNUM* arg_p, 
+    const BIGNUM* arg_g, 
+    const int arg_maxbits, 
+    const int arg_wbits) : 
+        mont(BN_MONT_CTX_new()),
+        engine(get_mont_engine(arg_p)),
+        wbits(std::min(std::max(arg_wbits, 1), 8)),
+        nwindows((arg_maxbits + wbits - 1) / wbits) {
+
+    const size_t ndigits = (1u << wbits) - 1;
+
+    BN_CTX* tbn_ctx = BN_CTX_new();
+    BN_MONT_CTX_set(mont, arg_p, tbn_ctx);
+
+    /* One form of the table only. */
+    if (engine != nullptr && engine->do_build_table(fixed, arg_g, nwindows, wbits) == 0) {
+        BN_CTX_free(tbn_ctx);
+        return;
+    }
 
-    SHA256_CTX sha_context; // Local
+    engine.reset();
 
-    if (!SHA256_Init(&sha_context)) {
-        console_msgn(__FUNCTION__, "Error, SHA256_Init");
-        return nullptr;
-    }
+    BIGNUM* tbn_base = BN_new();    // g^(2^(w * i)), in Montgomery form
+    BN_to_montgomery(tbn_base, arg_g, mont, tbn_ctx);
 
-    if(!SHA256_Update(&sha_context, arg_str.c_str(), arg_str.length())) {
-        console_msgn(__FUNCTION__, "Error, SHA256_Update");
-        return nullptr;
-    }
+    table = std::vector<bnw_t>(nwindows * ndigits);
 
-	if(!SHA256_Final(sha_digest, &sha_context)) {
-        console_msgn(__FUNCTION__, "Error, SHA256_Final");
-        return nullptr;
-    }
+    for (int i = 0; i < nwindows; i++) {
+        bnw_t* row = &table[i * ndigits];
 
-    /* Register the hash value. */
-    
-    BIGNUM* hash_val = BN_new();
-    // __BN_MODIFIABLE__(manager.get_asset(BN_E));
+        BN_copy(row[0].actor, tbn_base);
 
-    /* Conversion */
-    BN_bin2bn(sha_digest, sizeof(sha_digest), hash_val);
-    
-    console_msg(__FUNCTION__, "SHA256 hashed: ");
-#ifdef __PRINT 
-    BN_print_fp(stdout, hash_val);
-    std::cout << std::endl;
-
-    FILE* fp = std::fopen("./hash.log", "w");
-    std::fprintf(fp, "Given string\t");
-    std::fprintf(fp, arg_str.c_str());
-    std::fprintf(fp, "\nHashed\t"), BN_print_fp(fp, hash_val);
-    std::fclose(fp);
-#endif
+        for (size_t j = 1; j < ndigits; j++)
+            BN_mod_mul_montgomery(row[j].actor, row[j - 1].actor, tbn_base, mont, tbn_ctx);
 
+        // base^(2^w) = base^(2^w - 1) * base
+        BN_mod_mul_montgomery(tbn_base, row[ndigits - 1].actor, tbn_base, mont, tbn_ctx);
+    }
 
-    return hash_val;
+    BN_free(tbn_base);
+    BN_CTX_free(tbn_ctx);
 }
 
 
-/*
- * do_thash
- */
-BIGNUM* EE488::SchnorrSignature::do_thash(const int arg_bitn) {
 
-    return this->do_thash(arg_bitn, reinterpret_cast<char *>(this->mstr));
+EE488::FixedBaseTable::~FixedBaseTable() {
+    BN_MONT_CTX_free(mont);
 }
 
 
-BIGNUM* EE488::SchnorrSignature::do_thash(const int arg_bitn, const char* arg_str) {
-    
-    return this->do_thash(arg_bitn, std::string(arg_str));
-}
 
+/* Returns -1 when the exponent does not fit in the table. */
+int EE488::FixedBaseTable::do_exp(BIGNUM* arg_r, const BIGNUM* arg_k, BN_CTX* arg_ctx) const {
 
+    if (engine != nullptr)
+        return engine->do_table_exp(arg_r, fixed, nwindows, wbits, arg_k);
 
-BIGNUM* EE488::SchnorrSignature::do_thash(const int arg_bitn, std::string arg_str) {
+    if (BN_is_negative(arg_k) || BN_num_bits(arg_k) > nwindows * wbits)
+        return -1;
 
-    SHA256_CTX sha_context; // Local
+    const size_t ndigits = (1u << wbits) - 1;
 
-    /* Almost identical to do_rhash */
-    if (!SHA256_Init(&sha_context)) {
-        console_msgn(__FUNCTION__, "Error, SHA256_Init");
-        return nullptr;
-    }
+    BN_CTX_start(arg_ctx);
+    BIGNUM* tbn_acc = BN_CTX_get(arg_ctx);
 
-    if(!SHA256_Update(&sha_context, arg_str.c_str(), arg_str.length())) {
-        console_msgn(__FUNCTION__, "Error, SHA256_Update");
-        return nullptr;
+    if (tbn_acc == nullptr) {
+        BN_CTX_end(arg_ctx);
+        return -1;
     }
 
-	if(!SHA256_Final(sha_digest, &sha_context)) {
-        console_msgn(__FUNCTION__, "Error, SHA256_Final");
-        return nullptr;
+    bool started = false;
+
+    for (int i = 0; i < nwindows; i++) {
+        unsigned digit = 0;
+
+        for (int b = wbits - 1; b >= 0; b--)
+            digit = (digit << 1) | BN_is_bit_set(arg_k, i * wbits + b);
+
+        if (digit == 0) continue;
+
+        const BIGNUM* tbn_pow = table[i * ndigits + digit - 1].actor;
+
+        if (!started) {
+            BN_copy(tbn_acc, tbn_pow);
+            started = true;
+        }
+        else
+            BN_mod_mul_montgomery(tbn_acc, tbn_acc, tbn_pow, mont, arg_ctx);
     }
 
-    /* Register the hash value. */
+    if (started)
+        BN_from_montgomery(arg_r, tbn_acc, mont, arg_ctx);
+    else
+        BN_one(arg_r);
 
-    BIGNUM* hash_val = BN_new();
-    // __BN_MODIFIABLE__(manager.get_asset(BN_E));
+    BN_CTX_end(arg_ctx);
 
-    /* Conversion */
-    BN_bin2bn(sha_digest, sizeof(sha_digest), hash_val);
+    return 0;
+}
 
-    /* Toy case, use only leftmost arg_bitn bits.*/
-    console_msg(__FUNCTION__, "SHA256 hashed: ");
-#ifdef __PRINT 
-    BN_print_fp(stdout, hash_val);
-    std::cout << std::endl;
-#endif
 
-    /* Cut! and Re-register */
-    BN_rshift(
-        hash_val, hash_val, arg_bitn
-    );
-    
-    console_msg(__FUNCTION__, "SHA256 cut-hashed: ");
-#ifdef __PRINT 
-    BN_print_fp(stdout, hash_val);
-    std::cout << std::endl;
-#endif
 
-    return hash_val;
+/* 
+ * SchnorrDomain Actions */
+EE488::SchnorrDomain::SchnorrDomain(
+    const BIGNUM* arg_p, 
+    const BIGNUM* arg_q, 
+    const BIGNUM* arg_g, 
+    const bool arg_toy, 
+    const int arg_wbits) : 
+        SchnorrDomain(arg_p, arg_q, arg_g, arg_toy, 
+            (arg_wbits > 0) ? 
+                std::make_shared<const fbt_t>(arg_p, arg_g, BN_num_bits(arg_q), arg_wbits) : 
+                nullptr) { }
+
+
+
+EE488::SchnorrDomain::SchnorrDomain(
+    const BIGNUM* arg_p, 
+    const BIGNUM* arg_q, 
+    const BIGNUM* arg_g, 
+    const bool arg_toy, 
+    std::shared_ptr<const fbt_t> arg_gtable) : 
+        mont(BN_MONT_CTX_new()),
+        gtable(arg_gtable),
+        toy_enable(arg_toy) {
+
+    BN_copy(p.actor, arg_p);
+    BN_copy(q.actor, arg_q);
+    BN_copy(g.actor, arg_g);
+
+    /* The table of p has one already. */
+    engine = (gtable != nullptr && gtable->get_engine() != nullptr) ? 
+        gtable->share_engine() : get_mont_engine(p.actor);
+
+    BN_CTX* tbn_ctx = BN_CTX_new();
+    BN_MONT_CTX_set(mont, p.actor, tbn_ctx);
+    BN_CTX_free(tbn_ctx);
+
+    const unsigned char toy = toy_enable ? 1 : 0;
+    SHA256_CTX sha_context;
+
+    SHA256_Init(&sha_context);
+    SHA256_Update(&sha_context, &toy, 1);
+    do_update_bn(&sha_context, p.actor);
+    do_update_bn(&sha_context, q.actor);
+    do_update_bn(&sha_context, g.actor);
+    SHA256_Final(fingerprint, &sha_context);
 }
 
 
-/*
- * do_sign
- */
-int EE488::SchnorrSignature::do_sign(const int arg_bitn) {
-    
-    if (!is_sk_ready() || !is_msg_ready()) {
-        console_msgn(__FUNCTION__, "Error, key/msg is not ready.");
-        return -1;
-    }
 
-    {
-        BIGNUM* tbn = BN_new();         // Temporary big number.
-        BN_CTX* tbn_ctx = BN_CTX_new();
-            /* Big number context is a temporary variable
-             * used in the library.
-             */
-
-        BN_rand_range(                  // Random number
-            tbn,                        // Save to, tbn
-            manager.get_asset(BN_Q));
+EE488::SchnorrDomain::~SchnorrDomain() {
+    BN_MONT_CTX_free(mont);
+}
 
-        manager.set_asset(tbn, BN_K);   // Set k.
-        BN_clear(tbn);                  // reset the temporary value.
-
-        /* 
-         * Signing message, 
-         * for randomly chosen k(tbn, BN_K), r = g^k mod p where:
-         * r: BN_R
-         * g: BN_G
-         * p: BN_P
-         */
-        BN_mod_exp(                     // r = g^k mod p
-            tbn,                        // Save to, r
-            manager.get_asset(BN_G),    // g
-            manager.get_asset(BN_K),    // k
-            manager.get_asset(BN_P),    // p
-            tbn_ctx);  
-
-        /* Set BN_R */
-        manager.set_asset(tbn, BN_R);
-        BN_clear(tbn);
 
-        /* Second round.
-         */
-        unsigned char arr_r2bin[512] = { 0, };
 
-        BN_bn2bin(manager.get_asset(BN_R), arr_r2bin);
+int EE488::SchnorrDomain::do_gexp(BIGNUM* arg_r, const BIGNUM* arg_k, BN_CTX* arg_ctx) const {
 
-        std::strcat(
-            reinterpret_cast<char*>(mstr), 
-            reinterpret_cast<char*>(arr_r2bin)
-        );
+    if (gtable != nullptr && gtable->do_exp(arg_r, arg_k, arg_ctx) == 0)
+        return 0;
 
-        /* Run hashing */
-        BIGNUM* hash_value = do_hash(arg_bitn);
+    const BIGNUM* base = g.actor;
 
-        BN_mod_mul(
-            tbn,                        // Save to, r
-            manager.get_asset(BN_SK),   // secret key
-            hash_value,                 // hashed?
-            manager.get_asset(BN_Q),    // q
-            tbn_ctx
-        );
+    if (engine != nullptr && engine->do_multi_exp(arg_r, &base, &arg_k, 1) == 0)
+        return 0;
 
-        BN_mod_add(
-            __BN_MODIFIABLE__(manager.get_asset(BN_S)),
-            tbn,
-            manager.get_asset(BN_K),
-            manager.get_asset(BN_Q),
-            tbn_ctx
-        );
-        
-        manager.set_asset(hash_value, BN_E);
-        BN_free(hash_value);
+    return BN_mod_exp_mont(arg_r, g.actor, arg_k, p.actor, arg_ctx, mont) ? 0 : -1;
+}
 
-        console_msg(__FUNCTION__, "Signed [S]: ");
-#ifdef __PRINT
-        BN_print_fp(stdout, manager.get_asset(BN_S)), 
-        std::cout << "\n";
-#endif
 
-        console_msg(__FUNCTION__, "Signed [E]: ");
-#ifdef __PRINT
-        BN_print_fp(stdout, manager.get_asset(BN_E)), 
-        std::cout << "\n";
-#endif
 
-        /* Remove temporary values */
-        BN_free(tbn);
-        BN_CTX_free(tbn_ctx);
-    }
+/*
+ * do_check_pk
+ */
+int EE488::SchnorrDomain::do_check_pk(const BIGNUM* arg_pk, BN_CTX* arg_ctx) const {
 
-    sign_ready = true;
+    if (arg_pk == nullptr || BN_is_negative(arg_pk) || BN_is_zero(arg_pk) || BN_is_one(arg_pk) ||
+        BN_cmp(arg_pk, p.actor) >= 0)
+        return -1;
 
-    console_msgn(__FUNCTION__, "Done.");
-    return 0;
+    BN_CTX_start(arg_ctx);
+
+    BIGNUM* tbn = BN_CTX_get(arg_ctx);
+    const BIGNUM* exp = q.actor;
+
+    const int ret_code = (tbn != nullptr &&
+        EE488::do_multi_exp(tbn, &arg_pk, &exp, 1, mont, arg_ctx, engine.get()) == 0 &&
+        BN_is_one(tbn)) ? 0 : -1;
+
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
 }
 
 
@@ -602,141 +596,2061 @@ int EE488::SchnorrSignature::do_sign(const int arg_bitn) {
 /*
  * do_verify
  */
-int EE488::SchnorrSignature::do_verify(const int arg_bitn) {
+int EE488::SchnorrDomain::do_verify(
+    const BIGNUM* arg_pk,
+    const unsigned char* arg_msg, 
+    size_t arg_len, 
+    const BIGNUM* arg_s, 
+    const BIGNUM* arg_e, 
+    const int arg_bitn, 
+    vcache_t* arg_cache) const {
 
-    int ret_code = 0;
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_VERIFY);
 
-    if (
-        !is_msg_ready() ||
-        !is_pk_ready()  ||  // All threes should be ready.
-        !is_sign_ready()
-        ) {
-
-        console_msgn(__FUNCTION__, "Error, key/msg is not ready.");
-        return -1;
-    }
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
 
-        console_msg(__FUNCTION__, "Current signed [S]: ");
-#ifdef __PRINT
-        BN_print_fp(stdout, manager.get_asset(BN_S)), 
-        std::cout << "\n";
-#endif
+    BIGNUM* tbn_v = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_ne = BN_CTX_get(tbn_ctx);
 
-        console_msg(__FUNCTION__, "Current signed [E]: ");
-#ifdef __PRINT
-        BN_print_fp(stdout, manager.get_asset(BN_E)), 
-        std::cout << "\n";
-#endif
+    int ret_code = -1;
+    SHA256_CTX sha_context; // Local
 
-    {
-        BIGNUM* tbn_1 = BN_new();           // Temporary Big Number
-        BIGNUM* tbn_2 = BN_new();           // Temporary Big Number
-        BIGNUM* ipk = BN_new();             // Inverse of Public Key
-        BN_CTX* tbn_ctx = BN_CTX_new();     // Temporary BN Context
-
-        /* 
-         * tbn_1 = g^s
-         */
-        BN_mod_exp(
-            tbn_1,                          // Return value lies here.
-            manager.get_asset(BN_G),        // g
-            manager.get_asset(BN_S),        // s
-            manager.get_asset(BN_P),        // p
-            tbn_ctx);
-
-        /*
-         * ipk = {PK^{-1}}
-         */
-        BN_mod_inverse(
-            ipk,                            // Return value lies here.
-            manager.get_asset(BN_PK),       // public key
-            manager.get_asset(BN_P),        // p
-            tbn_ctx
-        );
-        
-        /*
-         * tbn_2 = {PK^{-1}}^e
-         */
-        BN_mod_exp(
-            tbn_2,                          // Return value lies here.
-            ipk,                            // Inverse of public key
-            manager.get_asset(BN_E),        // public key
-            manager.get_asset(BN_P),        // e
-            tbn_ctx
-        );
+    unsigned char arr_key[VCACHE_KEY_LEN];
 
-        /*
-         * tbn_1 * tbn_2 = g^s * {PK^{-1}}^e
-         */
-        BN_mod_mul(
-            __BN_MODIFIABLE__(manager.get_asset(BN_V)),
-                                            // v
-            tbn_1,                          // g^s
-            tbn_2,                          // {PK^{-1}}^e
-            manager.get_asset(BN_P),        // p
-            tbn_ctx                     
-        );
+    /* pk of 0, 1 or p - 1 verifies whatever comes, as a zeroed slot would. */
+    if (tbn_ne == nullptr ||
+        BN_is_negative(arg_pk) || BN_is_zero(arg_pk) || BN_is_one(arg_pk) ||
+        !BN_add(tbn_v, arg_pk, BN_value_one()) || BN_cmp(tbn_v, p.actor) >= 0)
+        goto out;
 
-        /* From here, follows same with do_sign()
-         */
+    if (!SHA256_Init(&sha_context) ||
+        !SHA256_Update(&sha_context, arg_msg, arg_len))
+        goto out;
 
-        unsigned char arr_v2bin[512] = { 0, };
+    /* H(m) from a copy of the state over m, which H(m || v) goes on from. */
+    if (arg_cache != nullptr) {
+        SHA256_CTX msg_context = sha_context;
+        unsigned char arr_digest[SHA256_DIGEST_LENGTH];
 
-        BN_bn2bin(
-            manager.get_asset(BN_V),        // From?
-            arr_v2bin                       // Destination
-        );
+        if (!SHA256_Final(arr_digest, &msg_context) ||
+            do_cache_key(arr_key, arg_pk, arr_digest, arg_s, arg_e, arg_bitn) != 0)
+            goto out;
 
-        std::strcat(
-            reinterpret_cast<char*>(mstr),  
-            reinterpret_cast<char*>(arr_v2bin)
-        );
+        if (arg_cache->do_lookup(arr_key)) {
+            __STAT_COUNT__(COUNT_VERIFY_CACHED);
 
-        BN_free(tbn_1), BN_free(tbn_2);
+            ret_code = 0;
+            goto out;
+        }
     }
 
-    BIGNUM* hash_value = do_hash(arg_bitn);
-    manager.set_asset(hash_value, BN_NE);
+    if (EE488::do_recover_commit(
+        tbn_v, 
+        g.actor, q.actor, 
+        arg_pk, arg_s, arg_e, 
+        mont, tbn_ctx, engine.get()) != 0)
+        goto out;
 
-    BN_bin2bn(
-        get_sha_digest(),
-        sizeof(sha_digest),
-        __BN_MODIFIABLE__(manager.get_asset(BN_NE))
-        );
-    
-    /* Is toy? */
-    if (toy_enable) {
-        BN_rshift(
-            __BN_MODIFIABLE__(manager.get_asset(BN_NE)), 
-            manager.get_asset(BN_NE), 
-            arg_bitn
-        );
-    }
+    __STAT_LAP__(timer, STAGE_VERIFY_COMMIT);
 
-    /* Prints out. */
-        console_msg(__FUNCTION__, "New [E]: ");
-#ifdef __PRINT
-        BN_print_fp(stdout, manager.get_asset(BN_NE)), 
-        std::cout << "\n";
-#endif
+    if (EE488::do_challenge_final(
+            tbn_ne, &sha_context, tbn_v, p.actor, toy_enable, arg_bitn, nullptr) != 0)
+        goto out;
 
-        console_msg(__FUNCTION__, "Old [E]: ");
-#ifdef __PRINT
-        BN_print_fp(stdout, manager.get_asset(BN_E)), 
-        std::cout << "\n";
-#endif
+    __STAT_LAP__(timer, STAGE_VERIFY_HASH);
 
-    ret_code = BN_cmp(
-        manager.get_asset(BN_E),
-        manager.get_asset(BN_NE)
-        );
+    ret_code = BN_cmp(tbn_ne, arg_e) ? 1 : 0;
+
+    if (ret_code == 0 && arg_cache != nullptr)
+        arg_cache->do_insert(arr_key);
 
-    BN_free(hash_value);
+out:
+    BN_CTX_end(tbn_ctx);
+
+    if (ret_code != 0)
+        __STAT_COUNT__(COUNT_VERIFY_FAIL);
 
     return ret_code;
 }
 
 
+
+/*
+ * do_cache_key
+ */
+int EE488::SchnorrDomain::do_cache_key(
+    unsigned char* arg_key, 
+    const BIGNUM* arg_pk, 
+    const unsigned char* arg_digest, 
+    const BIGNUM* arg_s, 
+    const BIGNUM* arg_e, 
+    const int arg_bitn) const {
+
+    /* e is cut to bitn on a toy domain, thus bitn is part of the tuple. */
+    const unsigned char arr_bitn[4] = {
+        static_cast<unsigned char>(arg_bitn >> 24), static_cast<unsigned char>(arg_bitn >> 16),
+        static_cast<unsigned char>(arg_bitn >> 8), static_cast<unsigned char>(arg_bitn) };
+
+    SHA256_CTX sha_context;
+
+    if (!SHA256_Init(&sha_context) ||
+        !SHA256_Update(&sha_context, fingerprint, sizeof(fingerprint)) ||
+        !SHA256_Update(&sha_context, arr_bitn, sizeof(arr_bitn)) ||
+        !SHA256_Update(&sha_context, arg_digest, SHA256_DIGEST_LENGTH) ||
+        !do_update_bn(&sha_context, arg_pk) ||
+        !do_update_bn(&sha_context, arg_s) ||
+        !do_update_bn(&sha_context, arg_e) ||
+        !SHA256_Final(arg_key, &sha_context))
+        return -1;
+
+    return 0;
+}
+
+
+
+/* 
+ * SchnorrKey Actions */
+EE488::SchnorrKey::SchnorrKey(
+    std::shared_ptr<const sdm_t> arg_domain, 
+    const BIGNUM* arg_pk, 
+    const BIGNUM* arg_sk) : 
+        domain(arg_domain),
+        sk_ready(arg_sk != nullptr),
+        deterministic(false) {
+
+    BN_copy(pk.actor, arg_pk);
+
+    if (arg_sk != nullptr)
+        BN_copy(sk.actor, arg_sk);
+}
+
+
+
+int EE488::SchnorrKey::do_sign(
+    const unsigned char* arg_msg, 
+    size_t arg_len, 
+    BIGNUM* arg_s, 
+    BIGNUM* arg_e, 
+    const int arg_bitn, 
+    BIGNUM* arg_r) const {
+
+    if (!sk_ready)
+        return -1;
+
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_SIGN);
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_k = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_r = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn = BN_CTX_get(tbn_ctx);
+
+    int ret_code = -1;
+    SHA256_CTX sha_context; // Local
+
+    if (tbn == nullptr)
+        goto out;
+
+    /* The message first. H(m) is a copy of the context, for the nonce. */
+    if (!SHA256_Init(&sha_context) ||
+        !SHA256_Update(&sha_context, arg_msg, arg_len))
+        goto out;
+
+    if (deterministic) {
+        unsigned char arr_h1[SHA256_DIGEST_LENGTH];
+        SHA256_CTX h1_context = sha_context;
+
+        /* A toy e is cut by bitn, thus bitn goes into k as well. */
+        const unsigned char arr_bitn[4] = {
+            static_cast<unsigned char>(arg_bitn >> 24), static_cast<unsigned char>(arg_bitn >> 16),
+            static_cast<unsigned char>(arg_bitn >> 8), static_cast<unsigned char>(arg_bitn) };
+
+        if (!SHA256_Final(arr_h1, &h1_context) ||
+            do_derive_nonce(tbn_k, domain->get_q(), sk.actor, arr_h1, sizeof(arr_h1), tbn_ctx,
+                arr_bitn, domain->is_toy() ? sizeof(arr_bitn) : 0) != 0)
+            goto out;
+
+        __STAT_LAP__(timer, STAGE_SIGN_NONCE);
+
+        if (domain->do_gexp(tbn_r, tbn_k, tbn_ctx) != 0)
+            goto out;
+
+        __STAT_LAP__(timer, STAGE_SIGN_COMMIT);
+    }
+    else if (nonce_pool != nullptr) {
+        /* Online, only the hash and arithmetic mod q are left. */
+        if (nonce_pool->do_take(tbn_k, tbn_r, tbn_ctx) != 0)
+            goto out;
+
+        __STAT_LAP__(timer, STAGE_SIGN_NONCE);
+    }
+    else {
+        if (do_rand_nonce(tbn_k, domain->get_q(), tbn_ctx) != 0)
+            goto out;
+
+        __STAT_LAP__(timer, STAGE_SIGN_NONCE);
+
+        if (domain->do_gexp(tbn_r, tbn_k, tbn_ctx) != 0)
+            goto out;
+
+        __STAT_LAP__(timer, STAGE_SIGN_COMMIT);
+    }
+
+    if (EE488::do_challenge_final(
+            arg_e, &sha_context, tbn_r, domain->get_p(), domain->is_toy(), arg_bitn, nullptr) != 0)
+        goto out;
+
+    __STAT_LAP__(timer, STAGE_SIGN_HASH);
+
+    /* s = k + x * e mod q */
+    BN_mod_mul(tbn, sk.actor, arg_e, domain->get_q(), tbn_ctx);
+    BN_mod_add(arg_s, tbn, tbn_k, domain->get_q(), tbn_ctx);
+
+    __STAT_LAP__(timer, STAGE_SIGN_FINAL);
+
+    if (arg_r != nullptr)
+        BN_copy(arg_r, tbn_r);
+
+    ret_code = 0;
+
+out:
+    if (tbn_k != nullptr) 
+        BN_clear(tbn_k);
+
+    BN_CTX_end(tbn_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * set_nonce_pool
+ */
+int EE488::SchnorrKey::set_nonce_pool(std::shared_ptr<NoncePool> arg_pool) {
+
+    if (arg_pool != nullptr) {
+        const sdm_t* pool_domain = arg_pool->get_domain();
+
+        if (pool_domain != domain.get() && (
+            BN_cmp(pool_domain->get_p(), domain->get_p()) ||
+            BN_cmp(pool_domain->get_q(), domain->get_q()) ||
+            BN_cmp(pool_domain->get_g(), domain->get_g())))
+            return -1;
+    }
+
+    nonce_pool = arg_pool;
+    return 0;
+}
+
+
+
+/* 0 when verified, 1 when not, -1 on error. */
+int EE488::SchnorrKey::do_verify(
+    const unsigned char* arg_msg, 
+    size_t arg_len, 
+    const BIGNUM* arg_s, 
+    const BIGNUM* arg_e, 
+    const int arg_bitn) const {
+
+    return domain->do_verify(pk.actor, arg_msg, arg_len, arg_s, arg_e, arg_bitn, verify_cache.get());
+}
+
+
+
+/*
+ * do_respond
+ */
+int EE488::SchnorrKey::do_respond(
+    BIGNUM* arg_s, 
+    const BIGNUM* arg_k, 
+    const BIGNUM* arg_c, 
+    BN_CTX* arg_ctx) const {
+
+    if (!sk_ready)
+        return -1;
+
+    BN_CTX_start(arg_ctx);
+    BIGNUM* tbn = BN_CTX_get(arg_ctx);
+
+    const int ret_code = (tbn != nullptr &&
+        BN_mod_mul(tbn, sk.actor, arg_c, domain->get_q(), arg_ctx) &&
+        BN_mod_add(arg_s, tbn, arg_k, domain->get_q(), arg_ctx)) ? 0 : -1;
+
+    if (tbn != nullptr) BN_clear(tbn);
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_batch_sign
+ */
+int EE488::SchnorrKey::do_batch_sign(
+    const std::string_view* arg_msgs, 
+    size_t arg_n, 
+    ssig_t* arg_sigs, 
+    const int arg_bitn, 
+    ThreadPool* arg_pool) const {
+
+    if (!sk_ready)
+        return -1;
+
+    std::atomic<int> nfails(0);
+
+    auto sign_range = [&](size_t arg_begin, size_t arg_end) {
+        for (size_t i = arg_begin; i < arg_end; i++) {
+            if (do_sign(
+                reinterpret_cast<const unsigned char*>(arg_msgs[i].data()), 
+                arg_msgs[i].size(), 
+                arg_sigs[i].s.actor, 
+                arg_sigs[i].e.actor, 
+                arg_bitn, 
+                arg_sigs[i].r.actor) != 0)
+                nfails++;
+        }
+    };
+
+    if (arg_pool == nullptr) {
+        sign_range(0, arg_n);
+        return nfails;
+    }
+
+    /* Small chunks, so that idle workers have something to steal. */
+    const size_t grain = std::max<size_t>(1, arg_n / (8 * arg_pool->get_nthreads()));
+
+    arg_pool->do_parallel_for(arg_n, grain, sign_range);
+
+    return nfails;
+}
+
+
+
+/* 
+ * SchnorrVerifier Actions */
+EE488::SchnorrVerifier::SchnorrVerifier(
+    std::shared_ptr<const sdm_t> arg_domain, 
+    const BIGNUM* arg_pk) : domain(arg_domain) {
+
+    if (domain == nullptr || domain->do_check_pk(arg_pk, get_thread_ctx()) != 0 ||
+        BN_copy(pk.actor, arg_pk) == nullptr)
+        BN_zero(pk.actor);
+}
+
+
+
+EE488::SchnorrVerifier::SchnorrVerifier(
+    std::shared_ptr<const sdm_t> arg_domain, 
+    const unsigned char* arg_pk, 
+    size_t arg_len) : domain(arg_domain) {
+
+    if (BN_bin2bn(arg_pk, static_cast<int>(arg_len), pk.actor) == nullptr ||
+        domain == nullptr || domain->do_check_pk(pk.actor, get_thread_ctx()) != 0)
+        BN_zero(pk.actor);
+}
+
+
+
+/* 0 when verified, 1 when not, -1 on error. */
+int EE488::SchnorrVerifier::do_verify(
+    const unsigned char* arg_msg, 
+    size_t arg_len, 
+    const BIGNUM* arg_s, 
+    const BIGNUM* arg_e, 
+    const int arg_bitn, 
+    vcache_t* arg_cache) const {
+
+    if (domain == nullptr || BN_is_zero(pk.actor))
+        return -1;
+
+    return domain->do_verify(pk.actor, arg_msg, arg_len, arg_s, arg_e, arg_bitn, arg_cache);
+}
+
+
+
+size_t EE488::SchnorrVerifier::get_size() const {
+
+    /* BIGNUM is opaque since 1.1.0: d, top, dmax, neg, flags. Words as 
+     *  many as pk needs, BN_copy allocates no more. */
+    const size_t bn_struct = sizeof(BN_ULONG*) + 4 * sizeof(int);
+    const size_t nwords = (BN_num_bytes(pk.actor) + BN_BYTES - 1) / BN_BYTES;
+
+    return sizeof(*this) + bn_struct + nwords * BN_BYTES;
+}
+
+
+
+void EE488::SchnorrSignature::console_msg(const char* arg_fname, const char* arg_msg) {
+
+    /* Into the ring of the logger, written out by its own thread. Messages
+     *  starting with "Error" are errors, others are for debugging. */
+    const int level = 
+        (!std::strncmp(arg_msg, "Error", 5) || !std::strncmp(arg_msg, "ERROR", 5)) ? LOG_ERROR : LOG_DEBUG;
+
+    EE488::do_log(level, arg_fname, arg_msg);
+};
+
+
+
+void EE488::SchnorrSignature::console_msg(const char* arg_fname, const std::string& arg_str) {
+    this->console_msg(arg_fname, arg_str.c_str());
+};
+
+
+
+void EE488::SchnorrSignature::console_msgn(const char* arg_fname, const char* arg_msg) {
+
+    /* Every record is a line, thus same as console_msg. */
+    this->console_msg(arg_fname, arg_msg);
+};
+
+
+void EE488::SchnorrSignature::console_msgn(const char* arg_fname, const std::string& arg_str) {
+    this->console_msgn(arg_fname, arg_str.c_str());
+};
+
+
+
+void EE488::SchnorrSignature::console_bn(const char* arg_fname, const char* arg_label, const BIGNUM* arg_num) {
+    EE488::do_log_bn(LOG_TRACE, arg_fname, arg_label, arg_num);
+};
+
+
+/*
+ * do_tkeygen
+ */
+int EE488::SchnorrSignature::do_tkeygen(const int arg_l, const int arg_n) {
+
+    /* https://www.openssl.org/docs/man1.1.1/man3/BN_generate_prime.html
+     * If add is not NULL, the prime will fulfill the condition 
+     * p % add == rem (p % add == 1 if rem == NULL) in order to suit a given generator.
+     */
+
+    console_msgn(__FUNCTION__, "Toy key generation start.");
+
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_KEYGEN);
+
+    /* Q of arg_n bits, then P of arg_l bits with P = 1 mod Q, each raced
+     *  over keygen_threads. Refer to paramgen.h. */
+    pgen_t generator(keygen_threads, keygen_deadline_ms);
+
+    if (generator.do_generate_toy(
+        __BN_MODIFIABLE__(manager.get_asset(BN_P)),
+        __BN_MODIFIABLE__(manager.get_asset(BN_Q)),
+        arg_l,
+        arg_n) != 0) {
+
+        console_msgn(__FUNCTION__, generator.get_stats().timed_out ?
+            "Error, Generation of P, Q past the deadline." : "Error, Generation of P, Q failed.");
+        return -1;
+    }
+
+
+    console_bn(__FUNCTION__, "Generated P: ", manager.get_asset(BN_P));
+    console_bn(__FUNCTION__, "Generated Q: ", manager.get_asset(BN_Q));
+
+    /* P and Q are generated, --till here. */
+
+    /* Generate Parameter g */
+    {   
+        BN_CTX* tbn_ctx = get_thread_ctx();
+        BN_CTX_start(tbn_ctx);
+
+        BIGNUM* tbn_h   = BN_CTX_get(tbn_ctx);
+        BIGNUM* tbn_p_1 = BN_CTX_get(tbn_ctx);
+        BIGNUM* tbn_div = BN_CTX_get(tbn_ctx);
+
+        BN_set_word(tbn_h, 2);  // Init to 2.
+
+        BN_copy(tbn_p_1, manager.get_asset(BN_P));  // tbn_p_1 = BN_P
+        BN_sub_word(tbn_p_1, 1);                    // tbn_p_1 = BN_P - 1
+
+        BN_div(tbn_div, NULL, tbn_p_1, manager.get_asset(BN_Q), tbn_ctx);
+
+        // Get random number 'g'
+        // Refered to, https://en.wikipedia.org/wiki/Digital_Signature_Algorithm
+        do {
+
+            BN_mod_exp(                     // g = h^k mod p
+                __BN_MODIFIABLE__(manager.get_asset(BN_G)),                        
+                                            // Save to, g
+                tbn_h,                      // h
+                tbn_div,                    // p - 1 / q
+                manager.get_asset(BN_P),    // p
+                tbn_ctx);  
+
+            BN_add_word(tbn_h, 1);          // Incr tbn_h by one.
+
+            console_msg(__FUNCTION__, "Test g: ");
+
+        } while (BN_is_one(
+            manager.get_asset(BN_G)
+        ));
+
+        BN_CTX_end(tbn_ctx);
+
+        console_msgn(__FUNCTION__, "Generated g.");
+    }
+
+    __STAT_LAP__(timer, STAGE_KEYGEN_PARAMS);
+
+    /* Generate Secrey Key x */
+    /*  If zero, generate again. 
+     */
+    do {
+        BN_rand_range(
+            __BN_MODIFIABLE__(manager.get_asset(BN_SK)), 
+            manager.get_asset(BN_Q));
+
+    } while (BN_is_zero(
+        manager.get_asset(BN_SK)
+    ));
+
+
+    /* Generate Public Key, 
+     *  pk = g^x. New (p, g), thus the table of g is built here.
+     */
+    {
+        gtable.reset(), mont_p.reset(), engine_p.reset();
+        batch_safe = -1;
+        do_gexp(
+            __BN_MODIFIABLE__(manager.get_asset(BN_PK)), 
+            manager.get_asset(BN_SK),
+            get_thread_ctx()
+        );
+    }
+
+    __STAT_LAP__(timer, STAGE_KEYGEN_KEY);
+
+    console_msgn(__FUNCTION__, "Toy key generation end.");
+    pk_ready = sk_ready = true;
+
+    return 0;
+}
+
+
+/*
+ * do_rkeygen
+ */
+int EE488::SchnorrSignature::do_rkeygen(const int arg_bits) {
+    
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_KEYGEN);
+
+    /* Refer to,
+     * https://www.openssl.org/docs/man1.1.1/man3/DSA_generate_parameters_ex.html
+     * DSA_generate_parameters_ex : Creates two primes, p and q and a generator g.
+     *      Raced over keygen_threads, the first of them taken, the rest
+     *      stopped. Refer to paramgen.h.
+     */
+    pgen_t generator(keygen_threads, keygen_deadline_ms);
+
+    if (generator.do_generate_dsa(
+        __BN_MODIFIABLE__(manager.get_asset(BN_P)),
+        __BN_MODIFIABLE__(manager.get_asset(BN_Q)),
+        __BN_MODIFIABLE__(manager.get_asset(BN_G)),
+        arg_bits) != 0) {
+
+        console_msgn(__FUNCTION__, generator.get_stats().timed_out ?
+            "ERROR, DSA_generate_parameters_ex past the deadline" : "ERROR, DSA_generate_parameters_ex");
+        return -1;
+    }
+
+    __STAT_LAP__(timer, STAGE_KEYGEN_PARAMS);
+
+    /* Key pair, same as DSA_generate_key does: x in [1, q - 1], pk = g^x.
+     *  The table of g is built here, and reused by do_sign.
+     */
+    do {
+        BN_rand_range(
+            __BN_MODIFIABLE__(manager.get_asset(BN_SK)), 
+            manager.get_asset(BN_Q));
+
+    } while (BN_is_zero(
+        manager.get_asset(BN_SK)
+    ));
+
+    {
+        gtable.reset(), mont_p.reset(), engine_p.reset();
+        batch_safe = -1;
+        do_gexp(
+            __BN_MODIFIABLE__(manager.get_asset(BN_PK)), 
+            manager.get_asset(BN_SK),
+            get_thread_ctx()
+        );
+    }
+
+    __STAT_LAP__(timer, STAGE_KEYGEN_KEY);
+
+    /* Parameters, at LOG_TRACE. Best for debugging purpose. 
+     *  sk is never logged.
+     */
+    console_bn(__FUNCTION__, "p\t", manager.get_asset(BN_P));
+    console_bn(__FUNCTION__, "q\t", manager.get_asset(BN_Q));
+    console_bn(__FUNCTION__, "g\t", manager.get_asset(BN_G));
+    console_bn(__FUNCTION__, "pk\t", manager.get_asset(BN_PK));
+
+    pk_ready = sk_ready = true; // Now the key is ready to go.
+
+    return 0;
+}
+
+
+
+/*
+ * do_keygen_pqg
+ */
+int EE488::SchnorrSignature::do_keygen_pqg() {
+
+    if (is_curve() || BN_is_zero(manager.get_asset(BN_Q)) || BN_is_zero(manager.get_asset(BN_P))) {
+        console_msgn(__FUNCTION__, "Error, no (p, q, g), use set_pqg.");
+        return -1;
+    }
+
+    __STAT_COUNT__(COUNT_KEYGEN);
+
+    if (do_rand_nonce(
+            __BN_MODIFIABLE__(manager.get_asset(BN_SK)), 
+            manager.get_asset(BN_Q), 
+            get_thread_ctx()) != 0 ||
+        do_gexp(
+            __BN_MODIFIABLE__(manager.get_asset(BN_PK)), 
+            manager.get_asset(BN_SK),
+            get_thread_ctx()) != 0) {
+
+        console_msgn(__FUNCTION__, "Error, key pair.");
+        return -1;
+    }
+
+    console_bn(__FUNCTION__, "pk\t", manager.get_asset(BN_PK));
+
+    pk_ready = sk_ready = true;
+    sign_ready = false;
+
+    return 0;
+}
+
+
+
+/*
+ * do_regmsg
+ */
+int EE488::SchnorrSignature::do_regmsg(const char* arg_pmsg) {
+
+    if (std::strlen(arg_pmsg) > MAX_SLEN) {
+        console_msgn(__FUNCTION__, "Error, longer than MAX_SLEN, use do_stream_init.");
+        return -1;
+    }
+
+    std::strcpy(reinterpret_cast<char *>(mstr), arg_pmsg);
+
+    console_msgn(__FUNCTION__, "Registered string:");
+    console_msgn(__FUNCTION__, reinterpret_cast<char *>(mstr));
+
+    /* Midstate after m, and H(m) from a copy of it. Only r is hashed per
+     *  sign and verify from here on. */
+    SHA256_CTX h1_context;
+
+    if (!SHA256_Init(&msg_ctx) ||
+        !SHA256_Update(&msg_ctx, mstr, std::strlen(arg_pmsg)) ||
+        !(h1_context = msg_ctx, SHA256_Final(msg_digest, &h1_context))) {
+
+        console_msgn(__FUNCTION__, "Error, SHA256");
+        msg_ready = false;
+        return -1;
+    }
+
+    msg_ready = true;// Now the original message is ready to go.
+    return 0;
+}
+
+
+int EE488::SchnorrSignature::do_regmsg(std::string arg_str) {
+    return this->do_regmsg(arg_str.c_str());
+}
+
+
+/*
+ * do_digest_into
+ */
+int EE488::SchnorrSignature::do_digest_into(
+    BIGNUM* arg_e, 
+    const unsigned char* arg_msg, 
+    size_t arg_len, 
+    const int arg_cut) {
+
+    /* SHA256 into sha_digest, then into arg_e. The rightmost arg_cut 
+     *  bits are removed, as the toy series does. No allocation.
+     */
+    SHA256_CTX sha_context; // Local
+
+    if (!SHA256_Init(&sha_context)) {
+        console_msgn(__FUNCTION__, "Error, SHA256_Init");
+        return -1;
+    }
+
+    if(!SHA256_Update(&sha_context, arg_msg, arg_len)) {
+        console_msgn(__FUNCTION__, "Error, SHA256_Update");
+        return -1;
+    }
+
+	if(!SHA256_Final(sha_digest, &sha_context)) {
+        console_msgn(__FUNCTION__, "Error, SHA256_Final");
+        return -1;
+    }
+
+    /* Conversion */
+    BN_bin2bn(sha_digest, sizeof(sha_digest), arg_e);
+    
+    if (is_log_enabled(LOG_TRACE)) {
+        Logger::get_instance().do_logf(LOG_TRACE, __FUNCTION__, 
+            "Given string\t%.*s", static_cast<int>(arg_len), reinterpret_cast<const char*>(arg_msg));
+        console_bn(__FUNCTION__, "SHA256 hashed: ", arg_e);
+    }
+
+    if (arg_cut > 0) {
+        /* Toy case, use only leftmost bits. Cut! */
+        BN_rshift(arg_e, arg_e, arg_cut);
+
+        console_bn(__FUNCTION__, "SHA256 cut-hashed: ", arg_e);
+    }
+
+    return 0;
+}
+
+
+
+BIGNUM* EE488::SchnorrSignature::do_hash_bytes(
+    const unsigned char* arg_msg, 
+    size_t arg_len, 
+    const int arg_cut) {
+
+    /* Register the hash value. The caller frees it. */
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_HASH);
+
+    BIGNUM* hash_val = BN_new();
+
+    if (do_digest_into(hash_val, arg_msg, arg_len, arg_cut) != 0) {
+        BN_free(hash_val);
+        return nullptr;
+    }
+
+    __STAT_LAP__(timer, STAGE_HASH);
+
+    return hash_val;
+}
+
+
+BIGNUM* EE488::SchnorrSignature::do_hash_registered(const int arg_cut) {
+
+    /* H(m) of the registered m was kept by do_regmsg, no hashing again. */
+    if (!is_msg_ready()) {
+        console_msgn(__FUNCTION__, "Error, msg is not ready.");
+        return nullptr;
+    }
+
+    __STAT_COUNT__(COUNT_HASH);
+
+    BIGNUM* hash_val = BN_bin2bn(msg_digest, sizeof(msg_digest), nullptr);
+
+    if (hash_val != nullptr && arg_cut > 0)
+        BN_rshift(hash_val, hash_val, arg_cut);
+
+    return hash_val;
+}
+
+
+/*
+ * do_rhash
+ */
+BIGNUM* EE488::SchnorrSignature::do_rhash() {
+
+    return this->do_hash_registered(0);
+}
+
+
+BIGNUM* EE488::SchnorrSignature::do_rhash(const char* arg_str) {
+    
+    return this->do_hash_bytes(
+        reinterpret_cast<const unsigned char*>(arg_str), std::strlen(arg_str), 0);
+}
+
+
+BIGNUM* EE488::SchnorrSignature::do_rhash(std::string arg_str) {
+
+    return this->do_hash_bytes(
+        reinterpret_cast<const unsigned char*>(arg_str.c_str()), arg_str.length(), 0);
+}
+
+
+/*
+ * do_thash
+ */
+BIGNUM* EE488::SchnorrSignature::do_thash(const int arg_bitn) {
+
+    return this->do_hash_registered(arg_bitn);
+}
+
+
+BIGNUM* EE488::SchnorrSignature::do_thash(const int arg_bitn, const char* arg_str) {
+    
+    return this->do_hash_bytes(
+        reinterpret_cast<const unsigned char*>(arg_str), std::strlen(arg_str), arg_bitn);
+}
+
+
+
+BIGNUM* EE488::SchnorrSignature::do_thash(const int arg_bitn, std::string arg_str) {
+
+    return this->do_hash_bytes(
+        reinterpret_cast<const unsigned char*>(arg_str.c_str()), arg_str.length(), arg_bitn);
+}
+
+
+/*
+ * do_sign
+ */
+int EE488::SchnorrSignature::do_sign(const int arg_bitn) {
+    
+    if (!is_sk_ready() || !is_msg_ready()) {
+        console_msgn(__FUNCTION__, "Error, key/msg is not ready.");
+        return -1;
+    }
+
+    if (is_curve())
+        return do_esign();
+
+    /* m was absorbed by do_regmsg, r goes on a copy. */
+    SHA256_CTX sha_context = msg_ctx;
+
+    if (do_sign_commit(&sha_context, arg_bitn, msg_digest) != 0) {
+        console_msgn(__FUNCTION__, "Error, not signed.");
+        return -1;
+    }
+
+    console_bn(__FUNCTION__, "Signed [S]: ", manager.get_asset(BN_S));
+
+    console_bn(__FUNCTION__, "Signed [E]: ", manager.get_asset(BN_E));
+
+    console_msgn(__FUNCTION__, "Done.");
+    return 0;
+}
+
+
+
+/*
+ * do_verify
+ */
+int EE488::SchnorrSignature::do_verify(const int arg_bitn) {
+
+    if (
+        !is_msg_ready() ||
+        !is_pk_ready()  ||  // All threes should be ready.
+        !is_sign_ready()
+        ) {
+
+        console_msgn(__FUNCTION__, "Error, key/msg is not ready.");
+        return -1;
+    }
+
+    if (is_curve())
+        return do_everify();
+
+    console_bn(__FUNCTION__, "Current signed [S]: ", manager.get_asset(BN_S));
+    console_bn(__FUNCTION__, "Current signed [E]: ", manager.get_asset(BN_E));
+
+    /* Same as do_sign, v goes on a copy of the midstate of m. */
+    SHA256_CTX sha_context = msg_ctx;
+
+    int ret_code = do_verify_commit(&sha_context, arg_bitn);
+
+    /* Prints out. */
+    console_bn(__FUNCTION__, "New [E]: ", manager.get_asset(BN_NE));
+    console_bn(__FUNCTION__, "Old [E]: ", manager.get_asset(BN_E));
+
+    return ret_code;
+}
+
+
+/*
+ * do_ekeygen
+ */
+int EE488::SchnorrSignature::do_ekeygen() {
+
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_KEYGEN);
+
+    auto domain = get_ec_domain(curve_nid);
+
+    if (domain == nullptr) {
+        console_msgn(__FUNCTION__, "Error, curve not supported.");
+        return -1;
+    }
+
+    __STAT_LAP__(timer, STAGE_KEYGEN_PARAMS);
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn = BN_CTX_get(tbn_ctx);
+
+    /* d in [1, n - 1]. The key negates it when d * G has odd y. */
+    if (tbn == nullptr || do_rand_nonce(tbn, domain->get_n(), tbn_ctx) != 0) {
+        BN_CTX_end(tbn_ctx);
+
+        console_msgn(__FUNCTION__, "Error, secret not drawn.");
+        return -1;
+    }
+
+    auto key = std::make_shared<const eckey_t>(domain, nullptr, tbn);
+
+    BN_clear(tbn);
+
+    if (!key->is_sk_ready()) {
+        BN_CTX_end(tbn_ctx);
+
+        console_msgn(__FUNCTION__, "Error, key not made.");
+        return -1;
+    }
+
+    /* p, n and x of G stand for p, q and g. */
+    EC_POINT_get_affine_coordinates(
+        domain->get_group(), EC_GROUP_get0_generator(domain->get_group()), tbn, nullptr, tbn_ctx);
+
+    manager.set_asset(__BN_MODIFIABLE__(domain->get_p()), BN_P);
+    manager.set_asset(__BN_MODIFIABLE__(domain->get_n()), BN_Q);
+    manager.set_asset(tbn, BN_G);
+
+    BN_bin2bn(key->get_pk(), EC_KEY_BYTES, tbn);
+    manager.set_keys(tbn, __BN_MODIFIABLE__(key->get_sk()));
+
+    BN_CTX_end(tbn_ctx);
+
+    ec_key = key;
+    sk_ready = pk_ready = true;
+
+    __STAT_LAP__(timer, STAGE_KEYGEN_KEY);
+
+    console_bn(__FUNCTION__, "Public key [X]: ", manager.get_asset(BN_PK));
+    console_msgn(__FUNCTION__, "Done.");
+
+    return 0;
+}
+
+
+
+/*
+ * do_get_eckey
+ */
+const EE488::EcSchnorrKey* EE488::SchnorrSignature::do_get_eckey() {
+
+    if (ec_key != nullptr)
+        return ec_key.get();
+
+    unsigned char arr_pk[EC_KEY_BYTES];
+
+    if (!is_pk_ready() || BN_bn2binpad(manager.get_asset(BN_PK), arr_pk, EC_KEY_BYTES) < 0)
+        return nullptr;
+
+    /* The secret goes along only if it matches the public key. */
+    ec_key = std::make_shared<const eckey_t>(
+        get_ec_domain(curve_nid), 
+        arr_pk, 
+        is_sk_ready() ? manager.get_asset(BN_SK) : nullptr
+    );
+
+    if (!ec_key->is_pk_ready()) {
+        ec_key.reset();
+        return nullptr;
+    }
+
+    return ec_key.get();
+}
+
+
+
+/*
+ * do_esign
+ */
+int EE488::SchnorrSignature::do_esign() {
+
+    const eckey_t* key = do_get_eckey();
+
+    if (key == nullptr || !key->is_sk_ready()) {
+        console_msgn(__FUNCTION__, "Error, not a key of the curve.");
+        return -1;
+    }
+
+    /* m as registered, nothing appended. Zeros as aux when deterministic. */
+    const unsigned char arr_zeros[EC_KEY_BYTES] = { 0, };
+
+    if (key->do_sign(
+        mstr, std::strlen(reinterpret_cast<char*>(mstr)), 
+        __BN_MODIFIABLE__(manager.get_asset(BN_S)), 
+        __BN_MODIFIABLE__(manager.get_asset(BN_E)),
+        deterministic_enable ? arr_zeros : nullptr) != 0) {
+
+        console_msgn(__FUNCTION__, "Error, not signed.");
+        return -1;
+    }
+
+    console_bn(__FUNCTION__, "Signed [S]: ", manager.get_asset(BN_S));
+    console_bn(__FUNCTION__, "Signed [E]: ", manager.get_asset(BN_E));
+
+    sign_ready = true;
+
+    console_msgn(__FUNCTION__, "Done.");
+    return 0;
+}
+
+
+
+/*
+ * do_everify
+ */
+int EE488::SchnorrSignature::do_everify() {
+
+    const eckey_t* key = do_get_eckey();
+
+    if (key == nullptr) {
+        console_msgn(__FUNCTION__, "Error, public key not on the curve.");
+        return -1;
+    }
+
+    return key->do_verify(
+        mstr, std::strlen(reinterpret_cast<char*>(mstr)), 
+        manager.get_asset(BN_S), 
+        manager.get_asset(BN_E));
+}
+
+
+
+/*
+ * do_build_gtable
+ */
+int EE488::SchnorrSignature::do_build_gtable() {
+
+    gtable.reset();
+
+    if (gtable_wbits <= 0 ||
+        BN_is_zero(manager.get_asset(BN_P)) || 
+        BN_is_zero(manager.get_asset(BN_Q)) || 
+        BN_is_zero(manager.get_asset(BN_G)))
+        return -1;
+
+    /* Exponents are reduced mod q, thus the table covers |q| bits. */
+    gtable = std::make_shared<fbt_t>(
+        manager.get_asset(BN_P),
+        manager.get_asset(BN_G),
+        BN_num_bits(manager.get_asset(BN_Q)),
+        gtable_wbits
+    );
+
+    console_msgn(__FUNCTION__, "Built table of g, " + std::to_string(gtable->get_size()) + " entries.");
+
+    return 0;
+}
+
+
+
+/*
+ * do_get_mont
+ */
+BN_MONT_CTX* EE488::SchnorrSignature::do_get_mont() {
+
+    /* The table of g has one already. Otherwise built once per p. */
+    if (gtable != nullptr)
+        return gtable->get_mont();
+
+    if (mont_p == nullptr) {
+        mont_p = std::shared_ptr<BN_MONT_CTX>(BN_MONT_CTX_new(), BN_MONT_CTX_free);
+        BN_MONT_CTX_set(mont_p.get(), manager.get_asset(BN_P), get_thread_ctx());
+    }
+
+    return mont_p.get();
+}
+
+
+
+/*
+ * do_get_engine
+ */
+const EE488::meng_t* EE488::SchnorrSignature::do_get_engine() {
+
+    if (gtable != nullptr)
+        return gtable->get_engine();
+
+    if (engine_p == nullptr)
+        engine_p = get_mont_engine(manager.get_asset(BN_P));
+
+    return engine_p.get();
+}
+
+
+
+/*
+ * do_batch_safe
+ */
+bool EE488::SchnorrSignature::do_batch_safe() {
+
+    /* p - 1 = 2 * q * k with k = 1 or a prime of more than BATCH_WEIGHT_BITS
+     *  bits. The squares mod p are then of order q * k, with no small factor,
+     *  thus a square r out of the subgroup of q still fails the random
+     *  weights. Any other cofactor, a DSA one of do_keygen, has small torsion
+     *  a weight of the batch can cancel. Once per p.
+     */
+    if (batch_safe >= 0)
+        return batch_safe == 1;
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn_k = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_rem = BN_CTX_get(tbn_ctx);
+
+    batch_safe = 0;
+
+    if (tbn_rem != nullptr &&
+        BN_sub(tbn_k, manager.get_asset(BN_P), BN_value_one()) &&
+        BN_rshift1(tbn_k, tbn_k) &&
+        BN_div(tbn_k, tbn_rem, tbn_k, manager.get_asset(BN_Q), tbn_ctx) &&
+        BN_is_zero(tbn_rem)) {
+
+        if (BN_is_one(tbn_k))
+            batch_safe = 1;
+        else if (BN_num_bits(tbn_k) > static_cast<int>(BATCH_WEIGHT_BITS))
+            batch_safe = (BN_check_prime(tbn_k, tbn_ctx, nullptr) == 1) ? 1 : 0;
+    }
+
+    BN_CTX_end(tbn_ctx);
+
+    return batch_safe == 1;
+}
+
+
+
+/*
+ * do_gexp
+ */
+int EE488::SchnorrSignature::do_gexp(BIGNUM* arg_r, const BIGNUM* arg_k, BN_CTX* arg_ctx) {
+
+    /* r = g^k mod p. Uses the table of g, falls back to BN_mod_exp. */
+    if (gtable == nullptr && gtable_wbits > 0)
+        do_build_gtable();
+
+    if (gtable != nullptr && gtable->do_exp(arg_r, arg_k, arg_ctx) == 0)
+        return 0;
+
+    const meng_t* engine = do_get_engine();
+    const BIGNUM* base = manager.get_asset(BN_G);
+
+    if (engine != nullptr && engine->do_multi_exp(arg_r, &base, &arg_k, 1) == 0)
+        return 0;
+
+    return BN_mod_exp(
+        arg_r, 
+        manager.get_asset(BN_G), 
+        arg_k, 
+        manager.get_asset(BN_P), 
+        arg_ctx) ? 0 : -1;
+}
+
+
+
+/*
+ * do_multi_exp
+ */
+int EE488::do_multi_exp(
+    BIGNUM* arg_r, 
+    const BIGNUM* const* arg_bases, 
+    const BIGNUM* const* arg_exps, 
+    const size_t arg_n,
+    BN_MONT_CTX* arg_mont, 
+    BN_CTX* arg_ctx,
+    const meng_t* arg_engine) {
+
+    if (arg_engine != nullptr && arg_engine->do_multi_exp(arg_r, arg_bases, arg_exps, arg_n) == 0)
+        return 0;
+
+    /* Refer to,
+     * https://cacr.uwaterloo.ca/hac/about/chap14.pdf, 14.6.1 and 14.88
+     * Each exponent is scanned with its own sliding window, and a window
+     * contributes by a single multiplication at its lowest bit. All bases
+     * share the squarings of the accumulator. Windows are found on the way
+     * down, and the powers come from arg_ctx, thus a few bases need no heap.
+     */
+    struct ExpState {
+        const BIGNUM* exp;
+        int wbits;
+        int low;            // Lowest bit of the open window, -1 if none
+        unsigned val;       // Its value, odd
+        BIGNUM* pows[16];   // b, b^3, b^5, ...
+    };
+
+    ExpState stack_state[MULTI_EXP_STACK];
+    std::vector<ExpState> heap_state;
+    ExpState* state = stack_state;
+
+    if (arg_n > MULTI_EXP_STACK) {
+        heap_state.resize(arg_n);
+        state = heap_state.data();
+    }
+
+    BN_CTX_start(arg_ctx);
+
+    BIGNUM* tbn_sq  = BN_CTX_get(arg_ctx);
+    BIGNUM* tbn_acc = BN_CTX_get(arg_ctx);
+
+    int max_bits = 0;
+    int ret_code = -1;
+
+    if (tbn_acc == nullptr)
+        goto out;
+
+    for (size_t j = 0; j < arg_n; j++) {
+        ExpState& st = state[j];
+        const int bits = BN_num_bits(arg_exps[j]);
+
+        st.exp = arg_exps[j];
+        st.low = -1;
+        st.wbits = (bits == 0) ? 0 : (bits > 256 ? 5 : (bits > 80 ? 4 : (bits > 24 ? 3 : 1)));
+
+        if (st.wbits == 0) continue;
+
+        max_bits = std::max(max_bits, bits);
+
+        const unsigned npows = 1u << (st.wbits - 1);
+
+        for (unsigned k = 0; k < npows; k++)
+            if ((st.pows[k] = BN_CTX_get(arg_ctx)) == nullptr)
+                goto out;
+
+        BN_to_montgomery(st.pows[0], arg_bases[j], arg_mont, arg_ctx);
+        
+        if (npows > 1) {
+            BN_mod_mul_montgomery(tbn_sq, st.pows[0], st.pows[0], arg_mont, arg_ctx);
+
+            for (unsigned k = 1; k < npows; k++)
+                BN_mod_mul_montgomery(st.pows[k], st.pows[k - 1], tbn_sq, arg_mont, arg_ctx);
+        }
+    }
+
+    {
+        bool started = false;
+
+        for (int i = max_bits - 1; i >= 0; i--) {
+            if (started)
+                BN_mod_mul_montgomery(tbn_acc, tbn_acc, tbn_acc, arg_mont, arg_ctx);
+
+            for (size_t j = 0; j < arg_n; j++) {
+                ExpState& st = state[j];
+
+                if (st.wbits == 0) continue;
+
+                /* Left to right, windows always end with a set bit. */
+                if (st.low < 0 && BN_is_bit_set(st.exp, i)) {
+                    int low = std::max(i - st.wbits + 1, 0);
+                    while (!BN_is_bit_set(st.exp, low)) low++;
+
+                    st.val = 0;
+                    for (int b = i; b >= low; b--)
+                        st.val = (st.val << 1) | BN_is_bit_set(st.exp, b);
+
+                    st.low = low;
+                }
+
+                if (st.low != i) continue;
+
+                const BIGNUM* tbn_pow = st.pows[st.val >> 1];
+                st.low = -1;
+
+                if (!started) {
+                    BN_copy(tbn_acc, tbn_pow);
+                    started = true;
+                }
+                else 
+                    BN_mod_mul_montgomery(tbn_acc, tbn_acc, tbn_pow, arg_mont, arg_ctx);
+            }
+        }
+
+        if (started)
+            BN_from_montgomery(arg_r, tbn_acc, arg_mont, arg_ctx);
+        else
+            BN_one(arg_r);
+    }
+
+    ret_code = 0;
+
+out:
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_challenge
+ */
+int EE488::SchnorrSignature::do_challenge(
+    BIGNUM* arg_e, 
+    const unsigned char* arg_msg, 
+    size_t arg_len, 
+    const BIGNUM* arg_r, 
+    const int arg_bitn) {
+
+    /* Same as the value do_sign hashes, e = H(m || r), r padded to |p|. */
+    SHA256_CTX sha_context; // Local
+
+    if (!SHA256_Init(&sha_context) ||
+        !SHA256_Update(&sha_context, arg_msg, arg_len)) {
+
+        console_msgn(__FUNCTION__, "Error, SHA256");
+        return -1;
+    }
+
+    return do_challenge_final(arg_e, &sha_context, arg_r, arg_bitn, nullptr);
+}
+
+
+
+/*
+ * do_challenge_final
+ */
+int EE488::SchnorrSignature::do_challenge_final(
+    BIGNUM* arg_e, 
+    SHA256_CTX* arg_sha_context, 
+    const BIGNUM* arg_r, 
+    const int arg_bitn,
+    unsigned char* arg_digest) {
+
+    if (EE488::do_challenge_final(
+        arg_e, arg_sha_context, arg_r, manager.get_asset(BN_P), toy_enable, arg_bitn, arg_digest) != 0) {
+
+        console_msgn(__FUNCTION__, "Error, SHA256");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+int EE488::do_challenge_final(
+    BIGNUM* arg_e, 
+    SHA256_CTX* arg_sha_context, 
+    const BIGNUM* arg_r, 
+    const BIGNUM* arg_p,
+    const bool arg_toy,
+    const int arg_bitn,
+    unsigned char* arg_digest) {
+
+    /* The context has absorbed the message already. Appends r, finalizes. 
+     *  The digest is copied out when arg_digest is given. All of r counts,
+     *  an r cut at its first zero byte lets a forger pick e before r.
+     */
+    unsigned char arr_r2bin[512] = { 0, };
+    unsigned char arr_digest[SHA256_DIGEST_LENGTH] = { 0, };
+
+    const int rlen = BN_num_bytes(arg_p);
+
+    if (rlen > static_cast<int>(sizeof(arr_r2bin)) ||
+        BN_bn2binpad(arg_r, arr_r2bin, rlen) != rlen)
+        return -1;
+
+    if (!SHA256_Update(arg_sha_context, arr_r2bin, rlen) ||
+        !SHA256_Final(arr_digest, arg_sha_context))
+        return -1;
+
+    BN_bin2bn(arr_digest, sizeof(arr_digest), arg_e);
+    
+    if (arg_toy)
+        BN_rshift(arg_e, arg_e, arg_bitn);
+
+    if (arg_digest != nullptr)
+        std::memcpy(arg_digest, arr_digest, sizeof(arr_digest));
+
+    return 0;
+}
+
+
+
+/*
+ * do_batch_challenge
+ */
+int EE488::do_batch_challenge(
+    BIGNUM* const* arg_e, 
+    const unsigned char* const* arg_msgs, 
+    const size_t* arg_lens, 
+    const BIGNUM* const* arg_r, 
+    const size_t arg_n,
+    const BIGNUM* arg_p,
+    const bool arg_toy,
+    const int arg_bitn) {
+
+    /* r padded to |p|, as do_challenge_final does. Lanes of one length. */
+    unsigned char arr_r2bin[MBSHA_LANES_MAX][512];
+    unsigned char arr_digest[MBSHA_LANES_MAX][SHA256_DIGEST_LENGTH];
+    shain_t arr_in[MBSHA_LANES_MAX];
+
+    const int rlen = BN_num_bytes(arg_p);
+
+    if (rlen > static_cast<int>(sizeof(arr_r2bin[0])))
+        return -1;
+
+    for (size_t i = 0; i < arg_n; i += MBSHA_LANES_MAX) {
+        const size_t n = std::min(MBSHA_LANES_MAX, arg_n - i);
+
+        for (size_t l = 0; l < n; l++) {
+            if (BN_bn2binpad(arg_r[i + l], arr_r2bin[l], rlen) != rlen)
+                return -1;
+
+            arr_in[l] = shain_t{ arg_msgs[i + l], arg_lens[i + l], arr_r2bin[l], static_cast<size_t>(rlen) };
+        }
+
+        do_sha256_multi(arr_digest[0], arr_in, n);
+
+        for (size_t l = 0; l < n; l++) {
+            if (BN_bin2bn(arr_digest[l], SHA256_DIGEST_LENGTH, arg_e[i + l]) == nullptr)
+                return -1;
+
+            if (arg_toy)
+                BN_rshift(arg_e[i + l], arg_e[i + l], arg_bitn);
+        }
+    }
+
+    return 0;
+}
+
+
+
+/*
+ * do_sign_commit
+ */
+int EE488::SchnorrSignature::do_sign_commit(
+    SHA256_CTX* arg_sha_context, 
+    const int arg_bitn, 
+    const unsigned char* arg_mdigest) {
+
+    /* k, r = g^k, e = H(m || r), s = k + x * e mod q. 
+     *  The context has absorbed the message already. H(m) is taken from
+     *  arg_mdigest when given, only the deterministic nonce needs it.
+     */
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_SIGN);
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn = BN_CTX_get(tbn_ctx);
+    int ret_code = -1;
+
+    /* (s, e) of before is gone, whether or not this one is made. */
+    sign_ready = false;
+
+    if (tbn == nullptr)
+        goto out;
+
+    if (deterministic_enable) {
+        /* H(m) from a copy, the context goes on with r. */
+        if (arg_mdigest == nullptr) {
+            SHA256_CTX h1_context = *arg_sha_context;
+            SHA256_Final(sha_digest, &h1_context);
+            arg_mdigest = sha_digest;
+        }
+
+        /* As SchnorrKey::do_sign, bitn of a toy e goes into k. */
+        const unsigned char arr_bitn[4] = {
+            static_cast<unsigned char>(arg_bitn >> 24), static_cast<unsigned char>(arg_bitn >> 16),
+            static_cast<unsigned char>(arg_bitn >> 8), static_cast<unsigned char>(arg_bitn) };
+
+        if (do_derive_nonce(
+            tbn, manager.get_asset(BN_Q), manager.get_asset(BN_SK), 
+            arg_mdigest, SHA256_DIGEST_LENGTH, tbn_ctx,
+            arr_bitn, toy_enable ? sizeof(arr_bitn) : 0) != 0)
+            goto out;
+    }
+    else if (do_rand_nonce(tbn, manager.get_asset(BN_Q), tbn_ctx) != 0)
+        goto out;
+
+    manager.set_asset(tbn, BN_K);
+
+    __STAT_LAP__(timer, STAGE_SIGN_NONCE);
+
+    if (do_gexp(tbn, manager.get_asset(BN_K), tbn_ctx) != 0)
+        goto out;
+
+    manager.set_asset(tbn, BN_R);
+
+    __STAT_LAP__(timer, STAGE_SIGN_COMMIT);
+
+    if (do_challenge_final(
+        __BN_MODIFIABLE__(manager.get_asset(BN_E)),
+        arg_sha_context,
+        manager.get_asset(BN_R),
+        arg_bitn,
+        sha_digest) != 0)
+        goto out;
+
+    __STAT_LAP__(timer, STAGE_SIGN_HASH);
+
+    if (!BN_mod_mul(
+        tbn, 
+        manager.get_asset(BN_SK), 
+        manager.get_asset(BN_E), 
+        manager.get_asset(BN_Q), 
+        tbn_ctx) ||
+        !BN_mod_add(
+        __BN_MODIFIABLE__(manager.get_asset(BN_S)),
+        tbn,
+        manager.get_asset(BN_K),
+        manager.get_asset(BN_Q),
+        tbn_ctx))
+        goto out;
+
+    __STAT_LAP__(timer, STAGE_SIGN_FINAL);
+
+    ret_code = 0;
+    sign_ready = true;
+
+out:
+    /* Without k, s = x * e would give sk away, thus no s at all. */
+    if (ret_code != 0) {
+        BN_clear(__BN_MODIFIABLE__(manager.get_asset(BN_K)));
+        BN_zero(__BN_MODIFIABLE__(manager.get_asset(BN_S)));
+    }
+
+    if (tbn != nullptr)
+        BN_clear(tbn);
+
+    BN_CTX_end(tbn_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_verify_commit
+ */
+int EE488::SchnorrSignature::do_verify_commit(SHA256_CTX* arg_sha_context, const int arg_bitn) {
+
+    /* v = g^s * pk^(q - e), then compares H(m || v) with e. */
+    __STAT_TIMER__(timer);
+    __STAT_COUNT__(COUNT_VERIFY);
+
+    /* A v not made is an error, never the v of a call before. */
+    if (do_recover_commit(
+        __BN_MODIFIABLE__(manager.get_asset(BN_V)),
+        manager.get_asset(BN_PK),
+        manager.get_asset(BN_S),
+        manager.get_asset(BN_E),
+        do_get_mont(),
+        get_thread_ctx()) != 0) {
+
+        BN_zero(__BN_MODIFIABLE__(manager.get_asset(BN_V)));
+        __STAT_COUNT__(COUNT_VERIFY_FAIL);
+        return -1;
+    }
+
+    __STAT_LAP__(timer, STAGE_VERIFY_COMMIT);
+
+    if (do_challenge_final(
+        __BN_MODIFIABLE__(manager.get_asset(BN_NE)),
+        arg_sha_context,
+        manager.get_asset(BN_V),
+        arg_bitn,
+        sha_digest) != 0) {
+
+        __STAT_COUNT__(COUNT_VERIFY_FAIL);
+        return -1;
+    }
+
+    __STAT_LAP__(timer, STAGE_VERIFY_HASH);
+
+    int ret_code = BN_cmp(
+        manager.get_asset(BN_E),
+        manager.get_asset(BN_NE)
+        );
+
+    if (ret_code != 0)
+        __STAT_COUNT__(COUNT_VERIFY_FAIL);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_stream_init
+ */
+int EE488::SchnorrSignature::do_stream_init() {
+
+    if (!SHA256_Init(&stream_ctx)) {
+        console_msgn(__FUNCTION__, "Error, SHA256_Init");
+        return -1;
+    }
+
+    stream_ready = true;
+    return 0;
+}
+
+
+
+/*
+ * do_stream_update
+ */
+int EE488::SchnorrSignature::do_stream_update(const void* arg_chunk, size_t arg_len) {
+
+    if (!is_stream_ready()) {
+        console_msgn(__FUNCTION__, "Error, stream is not initialized.");
+        return -1;
+    }
+
+    if (!SHA256_Update(&stream_ctx, arg_chunk, arg_len)) {
+        console_msgn(__FUNCTION__, "Error, SHA256_Update");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+/*
+ * do_stream_digest
+ */
+int EE488::SchnorrSignature::do_stream_digest(const unsigned char* arg_digest, size_t arg_len) {
+
+    /* Pre-hashed mode, the digest is the message to sign. */
+    if (do_stream_init() != 0)
+        return -1;
+
+    return do_stream_update(arg_digest, arg_len);
+}
+
+
+
+/*
+ * do_sign_final
+ */
+int EE488::SchnorrSignature::do_sign_final(const int arg_bitn) {
+
+    if (!is_sk_ready() || !is_stream_ready()) {
+        console_msgn(__FUNCTION__, "Error, key/stream is not ready.");
+        return -1;
+    }
+
+    /* H_nonce and H_challenge take m last, after what m decides. */
+    if (is_curve()) {
+        console_msgn(__FUNCTION__, "Error, no streaming on a curve.");
+        return -1;
+    }
+
+    stream_ready = false;   // Consumed.
+
+    return do_sign_commit(&stream_ctx, arg_bitn);
+}
+
+
+
+/*
+ * do_verify_final
+ */
+int EE488::SchnorrSignature::do_verify_final(const int arg_bitn) {
+
+    if (!is_stream_ready() || !is_pk_ready() || !is_sign_ready()) {
+        console_msgn(__FUNCTION__, "Error, key/stream is not ready.");
+        return -1;
+    }
+
+    if (is_curve()) {
+        console_msgn(__FUNCTION__, "Error, no streaming on a curve.");
+        return -1;
+    }
+
+    stream_ready = false;   // Consumed.
+
+    return do_verify_commit(&stream_ctx, arg_bitn);
+}
+
+
+
+/*
+ * do_recover_commit
+ */
+int EE488::SchnorrSignature::do_recover_commit(
+    BIGNUM* arg_v, 
+    const BIGNUM* arg_pk, 
+    const BIGNUM* arg_s, 
+    const BIGNUM* arg_e, 
+    BN_MONT_CTX* arg_mont, 
+    BN_CTX* arg_ctx) {
+
+    return EE488::do_recover_commit(
+        arg_v, 
+        manager.get_asset(BN_G), 
+        manager.get_asset(BN_Q), 
+        arg_pk, arg_s, arg_e, arg_mont, arg_ctx, do_get_engine());
+}
+
+
+
+int EE488::do_recover_commit(
+    BIGNUM* arg_v, 
+    const BIGNUM* arg_g, 
+    const BIGNUM* arg_q, 
+    const BIGNUM* arg_pk, 
+    const BIGNUM* arg_s, 
+    const BIGNUM* arg_e, 
+    BN_MONT_CTX* arg_mont, 
+    BN_CTX* arg_ctx,
+    const meng_t* arg_engine) {
+
+    /* v = g^s * pk^(q - e), where pk^q = 1. No inverse of pk is needed. */
+    BN_CTX_start(arg_ctx);
+
+    BIGNUM* tbn_ne = BN_CTX_get(arg_ctx);
+    
+    if (tbn_ne == nullptr ||
+        !BN_nnmod(tbn_ne, arg_e, arg_q, arg_ctx) ||
+        !BN_sub(tbn_ne, arg_q, tbn_ne)) {
+        BN_CTX_end(arg_ctx);
+        return -1;
+    }
+
+    const BIGNUM* bases[2] = { arg_g, arg_pk };
+    const BIGNUM* exps[2] = { arg_s, tbn_ne };
+
+    int ret_code = do_multi_exp(arg_v, bases, exps, 2, arg_mont, arg_ctx, arg_engine);
+
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_batch_check
+ */
+int EE488::SchnorrSignature::do_batch_check(
+    const std::vector<SchnorrBatchItem>& arg_items, 
+    const std::vector<size_t>& arg_idx, 
+    BN_MONT_CTX* arg_mont, 
+    BN_CTX* arg_ctx) {
+
+    /* Random weights a_i, checks
+     *  g^(sum a_i * s_i) == prod r_i^a_i * pk_i^(a_i * e_i)
+     * A single item is weighted by 1, then it is an exact check.
+     */
+    const size_t nitems = arg_idx.size();
+
+    std::vector<bnw_t> weights(nitems), exps(nitems);
+    std::vector<const BIGNUM*> bases, powers;
+    std::vector<const BIGNUM*> pk_bases;    // Each with the sum of its a_i * e_i
+
+    bases.reserve(2 * nitems);
+    powers.reserve(2 * nitems);
+
+    BN_CTX_start(arg_ctx);
+
+    BIGNUM* tbn_sum = BN_CTX_get(arg_ctx);
+    BIGNUM* tbn_lhs = BN_CTX_get(arg_ctx);
+    BIGNUM* tbn_rhs = BN_CTX_get(arg_ctx);
+
+    if (tbn_rhs == nullptr) {
+        BN_CTX_end(arg_ctx);
+        return -1;
+    }
+
+    BN_zero(tbn_sum);
+
+    /* Non-zero, and below q for small (toy) q. */
+    const int wbits = std::min(
+        static_cast<int>(BATCH_WEIGHT_BITS), BN_num_bits(manager.get_asset(BN_Q)) - 1);
+
+    for (size_t i = 0; i < nitems; i++) {
+        const SchnorrBatchItem& item = arg_items[arg_idx[i]];
+
+        if (nitems == 1)
+            BN_one(weights[i].actor);
+        else
+            BN_rand(weights[i].actor, wbits, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ANY);
+
+        BN_mod_mul(tbn_lhs, weights[i].actor, item.s, manager.get_asset(BN_Q), arg_ctx);
+        BN_mod_add(tbn_sum, tbn_sum, tbn_lhs, manager.get_asset(BN_Q), arg_ctx);
+
+        bases.push_back(item.r), powers.push_back(weights[i].actor);
+
+        /* Items of one signer in a row share a base of pk. */
+        BN_mod_mul(tbn_lhs, weights[i].actor, item.e, manager.get_asset(BN_Q), arg_ctx);
+
+        if (pk_bases.empty() || pk_bases.back() != item.pk)
+            pk_bases.push_back(item.pk), BN_zero(exps[pk_bases.size() - 1].actor);
+
+        BIGNUM* tbn_exp = exps[pk_bases.size() - 1].actor;
+        BN_mod_add(tbn_exp, tbn_exp, tbn_lhs, manager.get_asset(BN_Q), arg_ctx);
+    }
+
+    for (size_t j = 0; j < pk_bases.size(); j++)
+        bases.push_back(pk_bases[j]), powers.push_back(exps[j].actor);
+
+    do_gexp(tbn_lhs, tbn_sum, arg_ctx);
+    do_multi_exp(tbn_rhs, bases.data(), powers.data(), bases.size(), arg_mont, arg_ctx, do_get_engine());
+
+    int ret_code = BN_cmp(tbn_lhs, tbn_rhs);
+
+    BN_CTX_end(arg_ctx);
+
+    return ret_code;
+}
+
+
+
+/*
+ * do_batch_bisect
+ */
+void EE488::SchnorrSignature::do_batch_bisect(
+    const std::vector<SchnorrBatchItem>& arg_items, 
+    const std::vector<size_t>& arg_idx, 
+    std::vector<int>& arg_results, 
+    BN_MONT_CTX* arg_mont, 
+    BN_CTX* arg_ctx) {
+
+    if (arg_idx.empty())
+        return;
+
+    if (do_batch_check(arg_items, arg_idx, arg_mont, arg_ctx) == 0) {
+        for (auto i: arg_idx) arg_results[i] = 0;
+        return;
+    }
+
+    if (arg_idx.size() == 1) {
+        arg_results[arg_idx[0]] = 1;
+        return;
+    }
+
+    /* Failed, some of them are bad. Split and run again. */
+    const size_t half = arg_idx.size() / 2;
+
+    do_batch_bisect(
+        arg_items, 
+        std::vector<size_t>(arg_idx.begin(), arg_idx.begin() + half), 
+        arg_results, arg_mont, arg_ctx);
+
+    do_batch_bisect(
+        arg_items, 
+        std::vector<size_t>(arg_idx.begin() + half, arg_idx.end()), 
+        arg_results, arg_mont, arg_ctx);
+}
+
+
+
+/*
+ * do_batch_verify
+ */
+int EE488::SchnorrSignature::do_batch_verify(
+    const std::vector<SchnorrBatchItem>& arg_items, 
+    std::vector<int>& arg_results,
+    const int arg_bitn) {
+
+    /* Every result is 0 when verified, 1 when not.
+     * Returns the number of signatures not verified, -1 on error.
+     */
+    if (is_curve()) {
+        console_msgn(__FUNCTION__, "Error, not on a curve.");
+        return -1;
+    }
+
+    if (BN_is_zero(manager.get_asset(BN_P)) ||
+        BN_is_zero(manager.get_asset(BN_Q)) ||
+        BN_is_zero(manager.get_asset(BN_G))) {
+
+        console_msgn(__FUNCTION__, "Error, p, q, g is not ready.");
+        return -1;
+    }
+
+    arg_results.assign(arg_items.size(), 1);
+
+    std::vector<size_t> pending;
+    pending.reserve(arg_items.size());
+
+    BN_CTX* tbn_ctx = get_thread_ctx();
+    BN_MONT_CTX* tbn_mont = do_get_mont();
+
+    BN_CTX_start(tbn_ctx);
+
+    BIGNUM* tbn = BN_CTX_get(tbn_ctx);
+    BIGNUM* tbn_ne = BN_CTX_get(tbn_ctx);
+
+    std::vector<size_t> hashing;
+    hashing.reserve(arg_items.size());
+
+    const BIGNUM* q = manager.get_asset(BN_Q);
+    const BIGNUM* pk_checked = nullptr;     // Items of one signer share it
+    bool pk_in_group = false;
+
+    /* Membership of r in the batch is a Jacobi symbol, sound on a domain of
+     *  do_batch_safe only. Elsewhere r^q per item costs more than the batch
+     *  saves, thus every item is verified one by one. */
+    const bool batching = do_batch_safe();
+
+    for (size_t i = 0; i < arg_items.size(); i++) {
+        const SchnorrBatchItem& item = arg_items[i];
+
+        /* No commitment given, or no batch, recover one. */
+        if (item.r == nullptr || !batching) {
+            if (do_recover_commit(tbn, item.pk, item.s, item.e, tbn_mont, tbn_ctx) == 0 &&
+                do_challenge(tbn_ne, item.msg, item.msg_len, tbn, arg_bitn) == 0)
+                arg_results[i] = BN_cmp(tbn_ne, item.e) ? 1 : 0;
+
+            continue;
+        }
+
+        if (BN_is_zero(item.r) || BN_cmp(item.r, manager.get_asset(BN_P)) >= 0)
+            continue;
+
+        /* r a square, of order q * k. Else p - r, of order 2q, passes the
+         *  batch under every even weight, half of the time. */
+        if (do_jacobi(item.r, manager.get_asset(BN_P)) != 1)
+            continue;
+
+        if (item.pk != pk_checked) {
+            pk_in_group = !BN_is_zero(item.pk) && BN_cmp(item.pk, manager.get_asset(BN_P)) < 0 &&
+                do_multi_exp(tbn, &item.pk, &q, 1, tbn_mont, tbn_ctx, do_get_engine()) == 0 && BN_is_one(tbn);
+            pk_checked = item.pk;
+        }
+
+        if (!pk_in_group)
+            continue;
+
+        hashing.push_back(i);
+    }
+
+    /* The hash binds r, the exponentiations are left for the batch. The
+     *  challenges go through the SIMD lanes, MBSHA_LANES_MAX at a time. */
+    BIGNUM* arr_ne[MBSHA_LANES_MAX];
+    const unsigned char* arr_msgs[MBSHA_LANES_MAX];
+    const BIGNUM* arr_r[MBSHA_LANES_MAX];
+    size_t arr_lens[MBSHA_LANES_MAX];
+
+    for (size_t l = 0; l < MBSHA_LANES_MAX; l++)
+        arr_ne[l] = BN_CTX_get(tbn_ctx);
+
+    if (arr_ne[MBSHA_LANES_MAX - 1] == nullptr) {
+        console_msgn(__FUNCTION__, "Error, BN_CTX_get");
+        BN_CTX_end(tbn_ctx);
+        return -1;
+    }
+
+    for (size_t i = 0; i < hashing.size(); i += MBSHA_LANES_MAX) {
+        const size_t n = std::min(MBSHA_LANES_MAX, hashing.size() - i);
+
+        for (size_t l = 0; l < n; l++) {
+            const SchnorrBatchItem& item = arg_items[hashing[i + l]];
+
+            arr_msgs[l] = item.msg;
+            arr_lens[l] = item.msg_len;
+            arr_r[l] = item.r;
+        }
+
+        if (do_batch_challenge(arr_ne, arr_msgs, arr_lens, arr_r, n, manager.get_asset(BN_P), toy_enable, arg_bitn) != 0) {
+            console_msgn(__FUNCTION__, "Error, do_batch_challenge");
+            BN_CTX_end(tbn_ctx);
+            return -1;
+        }
+
+        for (size_t l = 0; l < n; l++)
+            if (BN_cmp(arr_ne[l], arg_items[hashing[i + l]].e) == 0)
+                pending.push_back(hashing[i + l]);
+    }
+
+    do_batch_bisect(arg_items, pending, arg_results, tbn_mont, tbn_ctx);
+
+    BN_CTX_end(tbn_ctx);
+
+    int nfails = static_cast<int>(
+        std::count(arg_results.begin(), arg_results.end(), 1));
+
+    console_msgn(__FUNCTION__, std::to_string(nfails) + " not verified.");
+
+    return nfails;
+}
+
+
+
+/*
+ * do_export_key
+ */
+EE488::skey_t EE488::SchnorrSignature::do_export_key(const bool arg_with_sk) {
+
+    if (is_curve())
+        console_msgn(__FUNCTION__, "Error, keyed on a curve, use do_export_eckey.");
+
+    if (gtable == nullptr && gtable_wbits > 0)
+        do_build_gtable();
+
+    auto domain = std::make_shared<const sdm_t>(
+        manager.get_asset(BN_P),
+        manager.get_asset(BN_Q),
+        manager.get_asset(BN_G),
+        toy_enable,
+        gtable
+    );
+
+    skey_t key(
+        domain, 
+        manager.get_asset(BN_PK), 
+        (arg_with_sk && is_sk_ready()) ? manager.get_asset(BN_SK) : nullptr
+    );
+
+    key.set_deterministic(deterministic_enable);
+
+    return key;
+}
+
+
+
+/*
+ * do_export_verifier
+ */
+EE488::sver_t EE488::SchnorrSignature::do_export_verifier() {
+
+    const skey_t key = do_export_key(false);
+
+    return sver_t(key.share_domain(), key.get_pk());
+}
+
+
+
+/*
+ * do_export_eckey
+ */
+EE488::eckey_t EE488::SchnorrSignature::do_export_eckey(const bool arg_with_sk) {
+
+    const eckey_t* key = is_curve() ? do_get_eckey() : nullptr;
+
+    if (key == nullptr)
+        return eckey_t(nullptr, nullptr, nullptr);
+
+    eckey_t copied = arg_with_sk ? *key : eckey_t(key->share_domain(), key->get_pk(), nullptr);
+    copied.set_deterministic(deterministic_enable);
+
+    return copied;
+}
+
+
+
 /*
  * do_reset
  */
@@ -745,7 +2659,10 @@ int EE488::SchnorrSignature::do_reset() {
     console_msgn(__FUNCTION__, "Reset.");
 
     manager.reset_asset(); // Clear all containers
-    toy_enable = pk_ready = sk_ready = msg_ready = sign_ready = false;
+    gtable.reset(), mont_p.reset(), engine_p.reset();
+    batch_safe = -1;
+    ec_key.reset(), curve_nid = 0;
+    toy_enable = pk_ready = sk_ready = msg_ready = sign_ready = stream_ready = false;
 
     return 0;
 }
@@ -15,6 +15,8 @@
  * Legal Stuff: None
  */
 
+#ifndef __EE488_SCHNORR_H
+#define __EE488_SCHNORR_H
 
 #ifndef __OPENSSL
 #define __OPENSSL
@@ -32,18 +34,39 @@
 
 #include <openssl/bn.h>     // Big number lib
 #include <openssl/sha.h>    // SHA256 lib
+#include <openssl/rand.h>   // Random bytes
+#include <openssl/crypto.h> // Memory functions
 #endif
 
 #include <chrono>
+#include <memory>
 #include <vector>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "./stats.h"
+#include "./mont.h"
+#include "./mbsha.h"
+#include "./vcache.h"
 
 
 namespace EE488 {
 
+    class ThreadPool;
+    class NoncePool;
+    class EcDomain;
+    class EcSchnorrKey;
+
     const unsigned NPARAMS  = 11;
     const unsigned MAX_SLEN = 90000;
     const unsigned MAX_CLEN = MAX_SLEN + 1;
 
+    const unsigned BATCH_WEIGHT_BITS = 64;  // Random weights of do_batch_verify
+    const int GTABLE_WBITS = 4;             // Default window of FixedBaseTable
+    const size_t MULTI_EXP_STACK = 4;       // do_multi_exp bases without heap
+    const int NONCE_MAX_BYTES = 64;         // |q| of do_rand_nonce without heap
+
     enum {
         BN_P = 0x00,    //  0: p
         BN_Q,           //  1: q
@@ -97,6 +120,327 @@ namespace EE488 {
     using bnm_t = BigNumberManager;
 
 
+    /* 
+     * class FixedBaseTable
+     *  Precomputed powers of a fixed base g, for a fixed modulus p. Holds
+     *  g^(j * 2^(w * i)) for every window i of the exponent and digit j > 0, in
+     *  Montgomery form. Then g^k is a product of one entry per window, with no
+     *  squarings. The table size is (max_bits / w) * (2^w - 1) numbers.
+     *  With a MontEngine for p, the entries are kept in its form instead.
+     *  Read only once built.
+     */
+    class FixedBaseTable {
+    private:
+        std::vector<bnw_t> table;
+        BN_MONT_CTX* mont;
+
+        std::shared_ptr<const meng_t> engine;
+        std::vector<uint64_t> fixed;        // get_nwords per entry
+
+        int wbits, nwindows;
+
+    public:
+        FixedBaseTable(const BIGNUM*, const BIGNUM*, const int, const int);
+        FixedBaseTable(const FixedBaseTable&) = delete;
+        ~FixedBaseTable();
+
+        FixedBaseTable& operator =(const FixedBaseTable&) = delete;
+
+        int do_exp(BIGNUM*, const BIGNUM*, BN_CTX*) const;
+
+        BN_MONT_CTX* get_mont() const { return mont; }
+        const meng_t* get_engine() const { return engine.get(); }
+        std::shared_ptr<const meng_t> share_engine() const { return engine; }
+        int get_wbits() const { return wbits; }
+        size_t get_size() const { return engine ? fixed.size() / engine->get_nwords() : table.size(); }
+    };
+
+    using fbt_t = FixedBaseTable;
+
+
+    /* 
+     * struct SchnorrBatchItem
+     *  A single (pk, message, s, e) tuple for do_batch_verify. r is the 
+     *  commitment g^k the signer got in do_sign (get_signature_r). When r is
+     *  shipped along, on a domain of do_batch_safe, the item joins the
+     *  randomized batch check. Otherwise r is recovered as g^s * pk^(q - e),
+     *  thus the item is verified one by one.
+     */
+    struct SchnorrBatchItem {
+        const BIGNUM* pk;
+        const unsigned char* msg;   // Message, as registered by do_regmsg
+        size_t msg_len;
+
+        const BIGNUM* s;
+        const BIGNUM* e;
+        const BIGNUM* r;            // Optional, nullptr if not given.
+    };
+
+    /* e = H(m || r), from a context that has absorbed m. r goes in whole,
+     *  left-padded with zeros to the bytes of p, thus of fixed length. The
+     *  toy series cuts e by arg_bitn. The digest is copied out when not
+     *  nullptr. */
+    int do_challenge_final(
+        BIGNUM*, 
+        SHA256_CTX*, 
+        const BIGNUM*,                  // r
+        const BIGNUM*,                  // p, of the padding
+        const bool, 
+        const int, 
+        unsigned char*);
+
+    /* e_i = H(m_i || r_i) of do_challenge_final for n messages at once,
+     *  MBSHA_LANES_MAX at a time through do_sha256_multi. No heap. */
+    int do_batch_challenge(
+        BIGNUM* const*,                 // e, n of them
+        const unsigned char* const*,    // Messages
+        const size_t*,                  // Their lengths
+        const BIGNUM* const*,           // r
+        const size_t,
+        const BIGNUM*,                  // p
+        const bool, 
+        const int);
+
+    /* v = g^s * pk^(q - e) mod p, the commitment r of a valid signature. */
+    int do_recover_commit(
+        BIGNUM*, 
+        const BIGNUM*,  // g
+        const BIGNUM*,  // q
+        const BIGNUM*,  // pk
+        const BIGNUM*,  // s
+        const BIGNUM*,  // e
+        BN_MONT_CTX*, 
+        BN_CTX*,
+        const meng_t* = nullptr);
+
+    /* Interleaved sliding window multi-exponentiation, 
+     *  r = b_0^e_0 * b_1^e_1 * ... mod m, where m is the modulus of the BN_MONT_CTX.
+     *  Squarings are shared among all bases. Bases should be reduced. Goes
+     *  to the MontEngine of m when given one. */
+    int do_multi_exp(
+        BIGNUM*, 
+        const BIGNUM* const*,   // Bases
+        const BIGNUM* const*,   // Exponents
+        const size_t, 
+        BN_MONT_CTX*, 
+        BN_CTX*,
+        const meng_t* = nullptr);
+
+    /* BN_CTX of the calling thread, created on its first use and reused
+     *  until the thread exits. Take scratch numbers with BN_CTX_start and 
+     *  BN_CTX_get, release with BN_CTX_end. Never free it. */
+    BN_CTX* get_thread_ctx();
+
+    /* Nonce k in [1, q - 1], without heap allocation. -1, k cleared, if
+     *  the RNG fails. The stack buffer is cleansed either way. */
+    int do_rand_nonce(BIGNUM*, const BIGNUM*, BN_CTX*);
+
+    /* Deterministic nonce k in [1, q - 1] of RFC 6979, 3.2, HMAC-DRBG with
+     *  SHA-256 over (sk, H(m)). Same key and digest, same k. No RNG, no heap.
+     *  |q| up to NONCE_MAX_BYTES. Additional data, of 3.6, goes in after
+     *  H(m): whatever else e depends on, bitn of a toy domain, should, or 
+     *  one k meets two e and gives sk away. */
+    int do_derive_nonce(
+        BIGNUM*, const BIGNUM*, const BIGNUM*, 
+        const unsigned char*, size_t, 
+        BN_CTX*,
+        const unsigned char* = nullptr, size_t = 0);
+
+    /* Counts OpenSSL heap allocations through CRYPTO_set_mem_functions.
+     *  Only works before the first OpenSSL allocation, false otherwise. */
+    bool do_install_alloc_counter();
+    unsigned long get_alloc_count();
+
+
+    /* 
+     * class SchnorrDomain
+     *  Public parameters p, q, g, with what is derived from them once: the 
+     *  Montgomery context of p, its MontEngine, the table of g and a digest
+     *  of all, which keys of a VerifyCache begin with. Immutable after
+     *  construction, thus shared among keys and threads.
+     */
+    class SchnorrDomain {
+    private:
+        bnw_t p, q, g;
+        BN_MONT_CTX* mont;
+        std::shared_ptr<const meng_t> engine;   // nullptr if p has none
+
+        std::shared_ptr<const fbt_t> gtable;
+        bool toy_enable;
+
+        unsigned char fingerprint[SHA256_DIGEST_LENGTH];   // H(toy, p, q, g)
+
+        /* Key of (pk, H(m), s, e, bitn) in a VerifyCache. */
+        int do_cache_key(
+            unsigned char*, 
+            const BIGNUM*, const unsigned char*, 
+            const BIGNUM*, const BIGNUM*, 
+            const int) const;
+
+    public:
+        SchnorrDomain(const BIGNUM*, const BIGNUM*, const BIGNUM*, const bool, const int);
+        SchnorrDomain(const BIGNUM*, const BIGNUM*, const BIGNUM*, const bool, std::shared_ptr<const fbt_t>);
+        SchnorrDomain(const SchnorrDomain&) = delete;
+        ~SchnorrDomain();
+
+        SchnorrDomain& operator =(const SchnorrDomain&) = delete;
+
+        int do_gexp(BIGNUM*, const BIGNUM*, BN_CTX*) const;
+
+        /* 0 when pk is of the subgroup of order q, pk in [2, p - 2] and
+         *  pk^q = 1 mod p, -1 otherwise. pk = 0 or 1 would accept anything,
+         *  one of small order half of everything. One exponentiation. */
+        int do_check_pk(const BIGNUM*, BN_CTX*) const;
+
+        /* (s, e) of a message under pk, 0 verified, 1 not, -1 on error. The
+         *  verify of SchnorrKey and SchnorrVerifier. With a cache, a tuple
+         *  found there is 0 at the cost of two hashes, and one verified
+         *  goes in. pk out of [2, p - 2] is an error, without do_check_pk. */
+        int do_verify(
+            const BIGNUM*,              // pk
+            const unsigned char*, size_t, 
+            const BIGNUM*, const BIGNUM*, 
+            const int, 
+            vcache_t* = nullptr) const;
+
+        const BIGNUM* get_p() const { return p.actor; }
+        const BIGNUM* get_q() const { return q.actor; }
+        const BIGNUM* get_g() const { return g.actor; }
+
+        BN_MONT_CTX* get_mont() const { return mont; }
+        const meng_t* get_engine() const { return engine.get(); }
+        const fbt_t* get_gtable() const { return gtable.get(); }
+
+        const unsigned char* get_fingerprint() const { return fingerprint; }
+
+        bool is_toy() const { return toy_enable; }
+    };
+
+    using sdm_t = SchnorrDomain;
+
+
+    /* 
+     * struct SchnorrSig
+     *  Output slot of do_batch_sign. r is kept as well, for do_batch_verify.
+     */
+    struct SchnorrSig {
+        bnw_t s, e;
+        bnw_t r;
+    };
+
+    using ssig_t = SchnorrSig;
+
+
+    /* 
+     * class SchnorrKey
+     *  A key pair, or a public key alone, over a shared domain. do_sign and
+     *  do_verify are const and keep their scratch per call, thus a single key
+     *  can serve many threads at once without a lock. Messages are raw bytes.
+     */
+    class SchnorrKey {
+    private:
+        std::shared_ptr<const sdm_t> domain;
+        bnw_t pk, sk;
+        bool sk_ready;
+
+        std::shared_ptr<NoncePool> nonce_pool;  // Optional, (k, r) made offline
+        bool deterministic;                     // k by do_derive_nonce
+
+        std::shared_ptr<vcache_t> verify_cache; // Optional, shared by keys
+
+    public:
+        SchnorrKey(std::shared_ptr<const sdm_t>, const BIGNUM*, const BIGNUM*);
+        ~SchnorrKey() { BN_clear(sk.actor); }
+
+        int do_sign(
+            const unsigned char*, size_t, 
+            BIGNUM*, BIGNUM*,           // s, e
+            const int, 
+            BIGNUM* = nullptr) const;   // r, optional
+
+        int do_verify(
+            const unsigned char*, size_t, 
+            const BIGNUM*, const BIGNUM*, 
+            const int) const;
+
+        /* s = k + x * c mod q, the response of do_sign for a nonce k and a
+         *  challenge c made elsewhere, as by a MuSigSession. -1 without sk. */
+        int do_respond(BIGNUM*, const BIGNUM*, const BIGNUM*, BN_CTX*) const;
+
+        /* Signs arg_n messages into the caller's array, spread over the pool.
+         *  Sequential when the pool is nullptr. Returns the number of failures. */
+        int do_batch_sign(
+            const std::string_view*, size_t, 
+            ssig_t*, 
+            const int, 
+            ThreadPool*) const;
+
+        /* do_sign takes (k, r) from the pool instead of computing g^k. The
+         *  pool should be of the same domain, -1 otherwise. nullptr detaches. */
+        int set_nonce_pool(std::shared_ptr<NoncePool>);
+
+        /* k derived from sk and H(m), instead of the RNG. Reproducible, and 
+         *  needs no shared state. Overrides the nonce pool. Refused, false,
+         *  when |q| is over NONCE_MAX_BYTES, as do_derive_nonce is. */
+        bool set_deterministic(const bool arg_det) { 
+            return (deterministic = arg_det && BN_num_bytes(domain->get_q()) <= NONCE_MAX_BYTES); 
+        }
+        bool is_deterministic() const { return deterministic; }
+
+        /* do_verify looks up the cache first, and adds what verifies. One
+         *  cache may serve any number of keys and domains. nullptr detaches. */
+        void set_verify_cache(std::shared_ptr<vcache_t> arg_cache) { verify_cache = arg_cache; }
+        vcache_t* get_verify_cache() const { return verify_cache.get(); }
+
+        const sdm_t* get_domain() const { return domain.get(); }
+        std::shared_ptr<const sdm_t> share_domain() const { return domain; }
+
+        const BIGNUM* get_pk() const { return pk.actor; }
+
+        bool is_sk_ready() const { return sk_ready; }
+    };
+
+    using skey_t = SchnorrKey;
+
+
+    /* 
+     * class SchnorrVerifier
+     *  A public key alone over a shared domain, for holding one per signer
+     *  by the million. Only pk is its own, a BIGNUM of |p| bits, thus about
+     *  300 bytes at 2048 bits against some 90 KB of a SchnorrSignature. No
+     *  staging buffer, the message is given per call. const, as SchnorrKey.
+     *  pk goes through do_check_pk once, when built. One that fails is held
+     *  as 0, and every do_verify of it is -1.
+     */
+    class SchnorrVerifier {
+    private:
+        std::shared_ptr<const sdm_t> domain;
+        bnw_t pk;
+
+    public:
+        SchnorrVerifier(std::shared_ptr<const sdm_t>, const BIGNUM*);
+        SchnorrVerifier(std::shared_ptr<const sdm_t>, const unsigned char*, size_t);  // Big-endian pk
+
+        /* The cache is given per call, not held, to keep the object small. */
+        int do_verify(
+            const unsigned char*, size_t, 
+            const BIGNUM*, const BIGNUM*, 
+            const int, 
+            vcache_t* = nullptr) const;
+
+        const sdm_t* get_domain() const { return domain.get(); }
+        const BIGNUM* get_pk() const { return pk.actor; }
+
+        bool is_valid() const { return !BN_is_zero(pk.actor); }
+
+        /* Bytes held per key, the object and the BIGNUM of pk with its words,
+         *  without the shared domain and the allocator's own. */
+        size_t get_size() const;
+    };
+
+    using sver_t = SchnorrVerifier;
+
+
     /* 
      * class SchnorrSignature 
      */
@@ -109,11 +453,39 @@ namespace EE488 {
             msg_ready, 
             sign_ready;
 
+        bool deterministic_enable;  // k by do_derive_nonce
+
         // SHA256_CTX sha_context;
         unsigned char sha_digest[SHA256_DIGEST_LENGTH] = { 0, };
 
         unsigned char mstr[MAX_CLEN] = { 0, };
 
+        /* Registered message, absorbed once by do_regmsg. Sign and verify 
+         *  go on from a copy with r, thus mstr stays as registered. */
+        SHA256_CTX msg_ctx;
+        unsigned char msg_digest[SHA256_DIGEST_LENGTH] = { 0, };   // H(m)
+
+        /* Streamed message, absorbed chunk by chunk. */
+        SHA256_CTX stream_ctx;
+        bool stream_ready;
+
+        /* Fixed-base table of g, built once per (p, g). */
+        std::shared_ptr<fbt_t> gtable;
+        int gtable_wbits;
+
+        std::shared_ptr<BN_MONT_CTX> mont_p;  // When there is no table
+        std::shared_ptr<const meng_t> engine_p;
+
+        int batch_safe;             // -1 not known yet, refer to do_batch_safe
+
+        /* Curve, instead of the subgroup of p. Refer to ecschnorr.h. */
+        int curve_nid;
+        std::shared_ptr<const EcSchnorrKey> ec_key;  // Built once per key
+
+        /* Parameter search of do_keygen, raced. Refer to paramgen.h. */
+        int keygen_threads;         // 0, as many as cores
+        long keygen_deadline_ms;    // 0, none
+
         /* 
          * Inner interface 
          *  Toy series: prefix 't'
@@ -121,7 +493,12 @@ namespace EE488 {
          */
         int do_rkeygen(const int);             // Real
         int do_tkeygen(const int, const int);  // Toy
+        int do_ekeygen();                      // Curve
         
+        int do_digest_into(BIGNUM*, const unsigned char*, size_t, const int);
+        BIGNUM* do_hash_bytes(const unsigned char*, size_t, const int);
+        BIGNUM* do_hash_registered(const int);     // From msg_digest
+
         BIGNUM* do_rhash();                         // Uses registered string
         BIGNUM* do_rhash(const char*);
         BIGNUM* do_rhash(std::string);
@@ -133,10 +510,30 @@ namespace EE488 {
         int do_sign(const char*);
         int do_sign(std::string);
 
+        const EcSchnorrKey* do_get_eckey();
+        int do_esign();
+        int do_everify();
+
+        int do_build_gtable();
+        BN_MONT_CTX* do_get_mont();
+        const meng_t* do_get_engine();
+        int do_gexp(BIGNUM*, const BIGNUM*, BN_CTX*);
+
+        int do_challenge(BIGNUM*, const unsigned char*, size_t, const BIGNUM*, const int);
+        int do_challenge_final(BIGNUM*, SHA256_CTX*, const BIGNUM*, const int, unsigned char*);
+
+        int do_sign_commit(SHA256_CTX*, const int, const unsigned char* = nullptr);
+        int do_verify_commit(SHA256_CTX*, const int);
+        int do_recover_commit(BIGNUM*, const BIGNUM*, const BIGNUM*, const BIGNUM*, BN_MONT_CTX*, BN_CTX*);
+
+        int do_batch_check(const std::vector<SchnorrBatchItem>&, const std::vector<size_t>&, BN_MONT_CTX*, BN_CTX*);
+        void do_batch_bisect(const std::vector<SchnorrBatchItem>&, const std::vector<size_t>&, std::vector<int>&, BN_MONT_CTX*, BN_CTX*);
+
         void console_msg(const char*, const char*);
         void console_msg(const char*, const std::string&);
         void console_msgn(const char*, const char*);    // Next line?
         void console_msgn(const char*, const std::string&);
+        void console_bn(const char*, const char*, const BIGNUM*);  // LOG_TRACE
 
         // void console_msgn(const char*, const char*);
 
@@ -148,7 +545,15 @@ namespace EE488 {
             sk_ready(false),
             pk_ready(false),
             msg_ready(false),
-            sign_ready(false) { }
+            sign_ready(false),
+            deterministic_enable(false),
+            stream_ready(false),
+            gtable(nullptr),
+            gtable_wbits(GTABLE_WBITS),
+            batch_safe(-1),
+            curve_nid(0),
+            keygen_threads(0),
+            keygen_deadline_ms(0) { }
         ~SchnorrSignature() = default;
     
         /* Core Intefaces */
@@ -156,9 +561,14 @@ namespace EE488 {
         // int do_tkeygen(const int, const int);  // Toy
 
         int do_keygen(const int arg_l, const int arg_n) {
+            if (curve_nid != 0) return do_ekeygen();
             return toy_enable ? do_tkeygen(arg_l, arg_n) : do_rkeygen(arg_l); 
         };
 
+        /* A key pair over the (p, q, g) of set_pqg, thus parties of one 
+         *  domain, e.g. co-signers of a MuSigSession. */
+        int do_keygen_pqg();
+
         int do_regmsg(const char*);
         int do_regmsg(std::string);
 
@@ -172,8 +582,34 @@ namespace EE488 {
         int do_sign(const int);
         int do_verify(const int);
 
+        int do_batch_verify(const std::vector<SchnorrBatchItem>&, std::vector<int>&, const int);
+        bool do_batch_safe();     // Else do_batch_verify runs one by one
+
+        /* Streaming interface, for messages of any size and content.
+         *  do_stream_init, do_stream_update as many times as needed, then
+         *  do_sign_final or do_verify_final. Same (s, e) as do_regmsg/do_sign
+         *  for the same bytes. do_stream_digest registers a pre-hashed digest 
+         *  as the message itself. */
+        int do_stream_init();
+        int do_stream_update(const void*, size_t);
+        int do_stream_digest(const unsigned char*, size_t);
+
+        int do_sign_final(const int);
+        int do_verify_final(const int);
+
         int do_reset();
 
+        /* Snapshot of the current domain and keys, for the const interface.
+         *  The table of g is shared, not copied. */
+        skey_t do_export_key(const bool arg_with_sk = true);
+
+        /* pk alone, over the domain of do_export_key. Share the domain
+         *  of one verifier to make the others of the same (p, q, g). */
+        sver_t do_export_verifier();
+
+        /* Same, for a curve. Not ready unless keyed on one. */
+        EcSchnorrKey do_export_eckey(const bool arg_with_sk = true);
+
         /* 
          * Getters, inline */
         const unsigned char* get_mstr() { return this->mstr; }
@@ -182,6 +618,7 @@ namespace EE488 {
 
         const BIGNUM* get_signature_s() { return manager.get_asset(BN_S); }
         const BIGNUM* get_signature_e() { return manager.get_asset(BN_E); }
+        const BIGNUM* get_signature_r() { return manager.get_asset(BN_R); }
 
         const bnm_t* get_manager() const { return &manager; } // General
 
@@ -191,8 +628,40 @@ namespace EE488 {
 
         const BIGNUM* get_pk() { return manager.get_asset(BN_PK); }
 
+        const fbt_t* get_gtable() const { return gtable.get(); }
+
+        /* Per-stage timing and counters, process-wide. Empty unless built
+         *  with __STATS. Refer to stats.h. */
+        static StatsSnapshot get_stats() { return EE488::get_stats(); }
+        static void reset_stats() { EE488::reset_stats(); }
+
         /* Setters */
         bool set_toy(bool arg_toy) { return (toy_enable = arg_toy); };
+        /* Refused when the q held is over NONCE_MAX_BYTES. Set before the
+         *  keys, a q that is over makes do_sign fail instead. */
+        bool set_deterministic(bool arg_det) { 
+            return (deterministic_enable = arg_det && BN_num_bytes(manager.get_asset(BN_Q)) <= NONCE_MAX_BYTES); 
+        };
+
+        /* EC_SECP256K1 or EC_P256 of ecschnorr.h, 0 for the subgroup of p.
+         *  do_keygen, do_sign and do_verify follow the curve, the bit
+         *  arguments are ignored. Keys and signatures are dropped. */
+        int set_curve(const int arg_nid) {
+            ec_key.reset();
+            sk_ready = pk_ready = sign_ready = false;
+            return (curve_nid = arg_nid);
+        }
+
+        /* Window bits of the table of g, 0 disables it. Rebuilt on next use. */
+        int set_gtable_wbits(const int arg_wbits) {
+            gtable.reset(), mont_p.reset(), engine_p.reset();
+            return (gtable_wbits = arg_wbits);
+        }
+
+        /* Racers of the (p, q) search of do_keygen, 0 for as many as cores,
+         *  and its deadline in ms, 0 for none. do_keygen fails past it. */
+        int set_keygen_threads(const int arg_n) { return (keygen_threads = (arg_n > 0) ? arg_n : 0); }
+        long set_keygen_deadline(const long arg_ms) { return (keygen_deadline_ms = (arg_ms > 0) ? arg_ms : 0); }
 
         void set_signature_s(BIGNUM* arg_s) { manager.set_asset(arg_s, BN_S); }
         void set_signature_e(BIGNUM* arg_e) { manager.set_asset(arg_e, BN_E); }
@@ -208,21 +677,32 @@ namespace EE488 {
             manager.set_asset(arg_p, BN_P);
             manager.set_asset(arg_q, BN_Q);
             manager.set_asset(arg_g, BN_G);
+
+            gtable.reset(), mont_p.reset(), engine_p.reset(); // Stale, for the old (p, g).
+            batch_safe = -1;
+            ec_key.reset();
         }
 
         void set_pk(BIGNUM* arg_pk) { 
             manager.set_asset(arg_pk, BN_PK); 
             pk_ready = true;
+            ec_key.reset();
         }
 
         /* Validation Checker */
         inline const bool is_toy() { return this->toy_enable; }
+        inline const bool is_curve() { return this->curve_nid != 0; }
+        inline const int get_curve() { return this->curve_nid; }
+        inline const bool is_deterministic() { return this->deterministic_enable; }
         inline const bool is_sk_ready() { return this->sk_ready; }
         inline const bool is_pk_ready() { return this->pk_ready; }
         inline const bool is_msg_ready() { return this->msg_ready; }
         inline const bool is_sign_ready() { return this->sign_ready; }
+        inline const bool is_stream_ready() { return this->stream_ready; }
     
     private:
         void do_show_assets(); // Inaccessible, for now.
     };
 };
+
+#endif
@@ -0,0 +1,904 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <openssl/sha.h>
+
+#include "./secp256k1.h"
+
+
+namespace {
+
+    using u64 = uint64_t;
+    using u128 = unsigned __int128;
+
+    const u64 K1_C = 0x1000003D1ULL;    // 2^256 - p
+
+    const u64 M52 = 0xFFFFFFFFFFFFFULL;
+    const u64 M48 = 0xFFFFFFFFFFFFULL;
+
+    /* 4p in 52 bit limbs, above any weakly normalized subtrahend limb by limb. */
+    const u64 K1_P4[5] = {
+        4 * 0xFFFFEFFFFFC2FULL, 4 * M52, 4 * M52, 4 * M52, 4 * M48
+    };
+
+    const unsigned char K1_P_BYTES[32] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF, 0xFC, 0x2F
+    };
+
+    const u64 K1_GX[4] = {
+        0x59F2815B16F81798ULL, 0x029BFCDB2DCE28D9ULL, 0x55A06295CE870B07ULL, 0x79BE667EF9DCBBACULL
+    };
+
+    const u64 K1_GY[4] = {
+        0x9C47D08FFB10D4B8ULL, 0xFD17B448A6855419ULL, 0x5DA4FBFC0E1108A8ULL, 0x483ADA7726A3C465ULL
+    };
+
+
+    /*
+     * Field, five 52 bit limbs. Every operation leaves the limbs weakly
+     *  normalized, limbs 0 to 3 of about 52 bits (1 or 2 may hold a small
+     *  carry) and limb 4 of 48 bits. Thus no magnitude is tracked, and
+     *  fe_normalize reduces below p only for output.
+     */
+    struct Fe {
+        u64 n[5];
+    };
+
+
+    inline void fe_normalize_weak(Fe& r) {
+        u64 c;
+
+        c = r.n[0] >> 52; r.n[0] &= M52; r.n[1] += c;
+        c = r.n[1] >> 52; r.n[1] &= M52; r.n[2] += c;
+        c = r.n[2] >> 52; r.n[2] &= M52; r.n[3] += c;
+        c = r.n[3] >> 52; r.n[3] &= M52; r.n[4] += c;
+
+        /* 2^256 = C mod p */
+        c = r.n[4] >> 48; r.n[4] &= M48; r.n[0] += c * K1_C;
+        c = r.n[0] >> 52; r.n[0] &= M52; r.n[1] += c;
+    }
+
+
+    inline void fe_add(Fe& r, const Fe& a, const Fe& b) {
+        for (int i = 0; i < 5; i++)
+            r.n[i] = a.n[i] + b.n[i];
+
+        fe_normalize_weak(r);
+    }
+
+
+    /* a + 4p - b */
+    inline void fe_sub(Fe& r, const Fe& a, const Fe& b) {
+        for (int i = 0; i < 5; i++)
+            r.n[i] = a.n[i] + K1_P4[i] - b.n[i];
+
+        fe_normalize_weak(r);
+    }
+
+
+    inline void fe_neg(Fe& r, const Fe& a) {
+        for (int i = 0; i < 5; i++)
+            r.n[i] = K1_P4[i] - a.n[i];
+
+        fe_normalize_weak(r);
+    }
+
+
+    /* Product columns into five limbs. Column i + 5 folds into column i by
+     *  2^260 = 16C as soon as both are summed, thus at most two columns are
+     *  live. Bits from 2^256 fold in by C at the end. */
+    inline void fe_reduce(
+        Fe& r,
+        const u128 d0, const u128 d1, const u128 d2, const u128 d3, const u128 d4,
+        const u128 d5, const u128 d6, const u128 d7, const u128 d8) {
+
+        const u64 R = K1_C << 4;
+        u128 c, d;
+
+        d = d5;
+        c = d0 + (u128)((u64)d & M52) * R; d >>= 52;
+        r.n[0] = (u64)c & M52; c >>= 52;
+
+        d += d6;
+        c += d1 + (u128)((u64)d & M52) * R; d >>= 52;
+        r.n[1] = (u64)c & M52; c >>= 52;
+
+        d += d7;
+        c += d2 + (u128)((u64)d & M52) * R; d >>= 52;
+        r.n[2] = (u64)c & M52; c >>= 52;
+
+        d += d8;
+        c += d3 + (u128)((u64)d & M52) * R; d >>= 52;
+        r.n[3] = (u64)c & M52; c >>= 52;
+
+        c += d4 + (u128)(u64)d * R;
+        r.n[4] = (u64)c & M48; c >>= 48;
+
+        c = c * K1_C + r.n[0];
+        r.n[0] = (u64)c & M52; c >>= 52;
+        c += r.n[1];
+        r.n[1] = (u64)c & M52; c >>= 52;
+        r.n[2] += (u64)c;
+    }
+
+
+    inline void fe_mul(Fe& r, const Fe& a, const Fe& b) {
+        const u64 x0 = a.n[0], x1 = a.n[1], x2 = a.n[2], x3 = a.n[3], x4 = a.n[4];
+        const u64 y0 = b.n[0], y1 = b.n[1], y2 = b.n[2], y3 = b.n[3], y4 = b.n[4];
+
+        fe_reduce(r,
+            (u128)x0 * y0,
+            (u128)x0 * y1 + (u128)x1 * y0,
+            (u128)x0 * y2 + (u128)x1 * y1 + (u128)x2 * y0,
+            (u128)x0 * y3 + (u128)x1 * y2 + (u128)x2 * y1 + (u128)x3 * y0,
+            (u128)x0 * y4 + (u128)x1 * y3 + (u128)x2 * y2 + (u128)x3 * y1 + (u128)x4 * y0,
+            (u128)x1 * y4 + (u128)x2 * y3 + (u128)x3 * y2 + (u128)x4 * y1,
+            (u128)x2 * y4 + (u128)x3 * y3 + (u128)x4 * y2,
+            (u128)x3 * y4 + (u128)x4 * y3,
+            (u128)x4 * y4);
+    }
+
+
+    inline void fe_sqr(Fe& r, const Fe& a) {
+        const u64 x0 = a.n[0], x1 = a.n[1], x2 = a.n[2], x3 = a.n[3], x4 = a.n[4];
+        const u64 x0_2 = 2 * x0, x1_2 = 2 * x1, x2_2 = 2 * x2, x3_2 = 2 * x3;
+
+        fe_reduce(r,
+            (u128)x0 * x0,
+            (u128)x0_2 * x1,
+            (u128)x0_2 * x2 + (u128)x1 * x1,
+            (u128)x0_2 * x3 + (u128)x1_2 * x2,
+            (u128)x0_2 * x4 + (u128)x1_2 * x3 + (u128)x2 * x2,
+            (u128)x1_2 * x4 + (u128)x2_2 * x3,
+            (u128)x2_2 * x4 + (u128)x3 * x3,
+            (u128)x3_2 * x4,
+            (u128)x4 * x4);
+    }
+
+
+    inline void fe_sqr_n(Fe& r, const Fe& a, int arg_n) {
+        r = a;
+        while (arg_n--) fe_sqr(r, r);
+    }
+
+
+    /* Below p, limbs of exactly 52 and 48 bits. */
+    inline void fe_normalize(Fe& r) {
+        fe_normalize_weak(r);
+        fe_normalize_weak(r);   // Limb 1 settled, thus r < 2^256
+
+        /* r < 2^256 < 2p. r + C reaches 2^256 exactly when r >= p. */
+        Fe t = r;
+        u64 c;
+
+        t.n[0] += K1_C;
+        c = t.n[0] >> 52; t.n[0] &= M52; t.n[1] += c;
+        c = t.n[1] >> 52; t.n[1] &= M52; t.n[2] += c;
+        c = t.n[2] >> 52; t.n[2] &= M52; t.n[3] += c;
+        c = t.n[3] >> 52; t.n[3] &= M52; t.n[4] += c;
+        c = t.n[4] >> 48; t.n[4] &= M48;
+
+        const u64 mask = 0 - c;
+
+        for (int i = 0; i < 5; i++)
+            r.n[i] = (t.n[i] & mask) | (r.n[i] & ~mask);
+    }
+
+
+    inline bool fe_is_zero(const Fe& a) {
+        Fe t = a;
+        fe_normalize(t);
+        return (t.n[0] | t.n[1] | t.n[2] | t.n[3] | t.n[4]) == 0;
+    }
+
+
+    inline bool fe_equal(const Fe& a, const Fe& b) {
+        Fe t;
+        fe_sub(t, a, b);
+        return fe_is_zero(t);
+    }
+
+
+    inline void fe_from_words(Fe& r, const u64* w) {
+        r.n[0] = w[0] & M52;
+        r.n[1] = ((w[0] >> 52) | (w[1] << 12)) & M52;
+        r.n[2] = ((w[1] >> 40) | (w[2] << 24)) & M52;
+        r.n[3] = ((w[2] >> 28) | (w[3] << 36)) & M52;
+        r.n[4] = w[3] >> 16;
+    }
+
+
+    /* a^(2^k - 1) for the chains of fe_inv and fe_sqrt, as libsecp256k1. */
+    struct FeChain {
+        Fe x2, x3, x22, x223;
+
+        FeChain(const Fe& a) {
+            Fe x6, x9, x11, x44, x88, x176, x220, t;
+
+            fe_sqr(t, a);           fe_mul(x2, t, a);
+            fe_sqr(t, x2);          fe_mul(x3, t, a);
+            fe_sqr_n(t, x3, 3);     fe_mul(x6, t, x3);
+            fe_sqr_n(t, x6, 3);     fe_mul(x9, t, x3);
+            fe_sqr_n(t, x9, 2);     fe_mul(x11, t, x2);
+            fe_sqr_n(t, x11, 11);   fe_mul(x22, t, x11);
+            fe_sqr_n(t, x22, 22);   fe_mul(x44, t, x22);
+            fe_sqr_n(t, x44, 44);   fe_mul(x88, t, x44);
+            fe_sqr_n(t, x88, 88);   fe_mul(x176, t, x88);
+            fe_sqr_n(t, x176, 44);  fe_mul(x220, t, x44);
+            fe_sqr_n(t, x220, 3);   fe_mul(x223, t, x3);
+        }
+    };
+
+
+    /* a^(p - 2) */
+    void fe_inv(Fe& r, const Fe& a) {
+        FeChain c(a);
+        Fe t;
+
+        fe_sqr_n(t, c.x223, 23);    fe_mul(t, t, c.x22);
+        fe_sqr_n(t, t, 5);          fe_mul(t, t, a);
+        fe_sqr_n(t, t, 3);          fe_mul(t, t, c.x2);
+        fe_sqr_n(t, t, 2);          fe_mul(r, t, a);
+    }
+
+
+    /* a^((p + 1) / 4), false when a is not a square. */
+    bool fe_sqrt(Fe& r, const Fe& a) {
+        FeChain c(a);
+        Fe t;
+
+        fe_sqr_n(t, c.x223, 23);    fe_mul(t, t, c.x22);
+        fe_sqr_n(t, t, 6);          fe_mul(t, t, c.x2);
+        fe_sqr_n(r, t, 2);
+
+        fe_sqr(t, r);
+        return fe_equal(t, a);
+    }
+
+
+    void fe_from_bytes(Fe& r, const unsigned char* arg_in) {
+        u64 w[4];
+
+        for (int i = 0; i < 4; i++) {
+            w[3 - i] = 0;
+            for (int j = 0; j < 8; j++)
+                w[3 - i] = (w[3 - i] << 8) | arg_in[8 * i + j];
+        }
+
+        fe_from_words(r, w);
+        fe_normalize_weak(r);
+    }
+
+
+    void fe_to_bytes(unsigned char* arg_out, const Fe& a) {
+        Fe t = a;
+        fe_normalize(t);
+
+        const u64 w[4] = {
+            t.n[0] | (t.n[1] << 52),
+            (t.n[1] >> 12) | (t.n[2] << 40),
+            (t.n[2] >> 24) | (t.n[3] << 28),
+            (t.n[3] >> 36) | (t.n[4] << 16)
+        };
+
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 8; j++)
+                arg_out[8 * i + j] = (unsigned char)(w[3 - i] >> (56 - 8 * j));
+    }
+
+
+    inline void fe_cmov(Fe& r, const Fe& a, const u64 mask) {
+        for (int i = 0; i < 5; i++)
+            r.n[i] = (a.n[i] & mask) | (r.n[i] & ~mask);
+    }
+
+
+    /*
+     * Group, Jacobian (X, Y, Z) is (X / Z^2, Y / Z^3). */
+    struct Gej {
+        Fe x, y, z;
+        bool infinity;
+    };
+
+    struct Ge {
+        Fe x, y;
+    };
+
+
+    inline Ge ge_of(const EE488::K1Point& arg_point) {
+        Ge r;
+        std::memcpy(r.x.n, arg_point.x, sizeof(r.x.n));
+        std::memcpy(r.y.n, arg_point.y, sizeof(r.y.n));
+        return r;
+    }
+
+
+    inline Gej gej_of(const Ge& a) {
+        Gej r = { a.x, a.y, { { 1, 0, 0, 0, 0 } }, false };
+        return r;
+    }
+
+
+    /* dbl-2009-l, a = 0. No point of order two on the curve. */
+    void gej_double(Gej& r, const Gej& a) {
+        if (a.infinity) {
+            r.infinity = true;
+            return;
+        }
+
+        Fe A, B, C, D, E, F, t;
+
+        fe_sqr(A, a.x);
+        fe_sqr(B, a.y);
+        fe_sqr(C, B);
+
+        fe_add(t, a.x, B);
+        fe_sqr(t, t);
+        fe_sub(t, t, A);
+        fe_sub(t, t, C);
+        fe_add(D, t, t);                // D = 2((X + B)^2 - A - C)
+
+        fe_add(E, A, A);
+        fe_add(E, E, A);                // E = 3A
+        fe_sqr(F, E);
+
+        fe_mul(r.z, a.y, a.z);
+        fe_add(r.z, r.z, r.z);          // Z3 = 2YZ, before Y is overwritten
+
+        fe_add(t, D, D);
+        fe_sub(r.x, F, t);              // X3 = F - 2D
+
+        fe_add(C, C, C);
+        fe_add(C, C, C);
+        fe_add(C, C, C);                // 8C
+        fe_sub(t, D, r.x);
+        fe_mul(t, E, t);
+        fe_sub(r.y, t, C);              // Y3 = E(D - X3) - 8C
+
+        r.infinity = false;
+    }
+
+
+    /* madd-2007-bl, a + b with b affine. */
+    void gej_add_ge(Gej& r, const Gej& a, const Ge& b) {
+        if (a.infinity) {
+            r = gej_of(b);
+            return;
+        }
+
+        Fe z1z1, u2, s2, H, HH, I, J, rr, V, t;
+
+        fe_sqr(z1z1, a.z);
+        fe_mul(u2, b.x, z1z1);
+        fe_mul(s2, b.y, a.z);
+        fe_mul(s2, s2, z1z1);
+
+        fe_sub(H, u2, a.x);
+        fe_sub(rr, s2, a.y);
+
+        if (fe_is_zero(H)) {
+            if (fe_is_zero(rr))
+                gej_double(r, a);
+            else
+                r.infinity = true;
+            return;
+        }
+
+        fe_sqr(HH, H);
+        fe_add(I, HH, HH);
+        fe_add(I, I, I);                // I = 4HH
+        fe_mul(J, H, I);
+        fe_add(rr, rr, rr);             // r = 2(S2 - Y1)
+        fe_mul(V, a.x, I);
+
+        Gej o;
+
+        fe_sqr(t, rr);
+        fe_sub(t, t, J);
+        fe_sub(t, t, V);
+        fe_sub(o.x, t, V);              // X3 = r^2 - J - 2V
+
+        fe_sub(t, V, o.x);
+        fe_mul(t, rr, t);
+        fe_mul(J, a.y, J);
+        fe_add(J, J, J);
+        fe_sub(o.y, t, J);              // Y3 = r(V - X3) - 2 Y1 J
+
+        fe_add(t, a.z, H);
+        fe_sqr(t, t);
+        fe_sub(t, t, z1z1);
+        fe_sub(o.z, t, HH);             // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+
+        o.infinity = false;
+        r = o;
+    }
+
+
+    /* add-2007-bl */
+    void gej_add(Gej& r, const Gej& a, const Gej& b) {
+        if (a.infinity) { r = b; return; }
+        if (b.infinity) { r = a; return; }
+
+        Fe z1z1, z2z2, u1, u2, s1, s2, H, I, J, rr, V, t;
+
+        fe_sqr(z1z1, a.z);
+        fe_sqr(z2z2, b.z);
+        fe_mul(u1, a.x, z2z2);
+        fe_mul(u2, b.x, z1z1);
+        fe_mul(s1, a.y, b.z);
+        fe_mul(s1, s1, z2z2);
+        fe_mul(s2, b.y, a.z);
+        fe_mul(s2, s2, z1z1);
+
+        fe_sub(H, u2, u1);
+        fe_sub(rr, s2, s1);
+
+        if (fe_is_zero(H)) {
+            if (fe_is_zero(rr))
+                gej_double(r, a);
+            else
+                r.infinity = true;
+            return;
+        }
+
+        fe_add(I, H, H);
+        fe_sqr(I, I);                   // I = (2H)^2
+        fe_mul(J, H, I);
+        fe_add(rr, rr, rr);
+        fe_mul(V, u1, I);
+
+        Gej o;
+
+        fe_sqr(t, rr);
+        fe_sub(t, t, J);
+        fe_sub(t, t, V);
+        fe_sub(o.x, t, V);
+
+        fe_sub(t, V, o.x);
+        fe_mul(t, rr, t);
+        fe_mul(J, s1, J);
+        fe_add(J, J, J);
+        fe_sub(o.y, t, J);
+
+        fe_add(t, a.z, b.z);
+        fe_sqr(t, t);
+        fe_sub(t, t, z1z1);
+        fe_sub(t, t, z2z2);
+        fe_mul(o.z, t, H);
+
+        o.infinity = false;
+        r = o;
+    }
+
+
+    /* false when infinity */
+    bool gej_to_ge(Ge& r, const Gej& a) {
+        if (a.infinity)
+            return false;
+
+        Fe zi, zi2;
+
+        fe_inv(zi, a.z);
+        fe_sqr(zi2, zi);
+        fe_mul(r.x, a.x, zi2);
+        fe_mul(zi2, zi2, zi);
+        fe_mul(r.y, a.y, zi2);
+
+        fe_normalize(r.x);
+        fe_normalize(r.y);
+
+        return true;
+    }
+
+
+    inline EE488::K1Point point_of(const Ge& a) {
+        EE488::K1Point r;
+        std::memcpy(r.x, a.x.n, sizeof(r.x));
+        std::memcpy(r.y, a.y.n, sizeof(r.y));
+        return r;
+    }
+
+
+    /* 4 bit digit i of a big-endian scalar, from the least significant. */
+    inline unsigned do_digit(const unsigned char* arg_k, const int arg_i) {
+        const unsigned char byte = arg_k[31 - arg_i / 2];
+        return (arg_i & 1) ? (byte >> 4) : (byte & 0x0f);
+    }
+
+
+    /* Width-w NAF of a big-endian scalar, 257 digits. */
+    void do_wnaf(int* arg_wnaf, const unsigned char* arg_k, const int w) {
+
+        auto get_bits = [&](int arg_pos, int arg_count) {
+            unsigned v = 0;
+
+            for (int i = arg_count - 1; i >= 0; i--) {
+                const int pos = arg_pos + i;
+                unsigned bit = (pos < 256) ? ((arg_k[31 - pos / 8] >> (pos % 8)) & 1) : 0;
+                v = (v << 1) | bit;
+            }
+
+            return v;
+        };
+
+        std::memset(arg_wnaf, 0, sizeof(int) * 257);
+
+        int carry = 0;
+
+        for (int bit = 0; bit < 257;) {
+            if ((int)get_bits(bit, 1) == carry) {
+                bit++;
+                continue;
+            }
+
+            const int now = (257 - bit < w) ? 257 - bit : w;
+            int word = (int)get_bits(bit, now) + carry;
+
+            carry = (word >> (w - 1)) & 1;
+            word -= carry << w;
+
+            arg_wnaf[bit] = word;
+            bit += now;
+        }
+    }
+
+
+    /* P, 3P, ..., 15P, for a width-5 NAF. */
+    void do_odd_multiples(Gej* arg_odd, const unsigned char* arg_px, const unsigned char* arg_py) {
+        Ge p;
+        fe_from_bytes(p.x, arg_px);
+        fe_from_bytes(p.y, arg_py);
+
+        Gej twice;
+        arg_odd[0] = gej_of(p);
+        gej_double(twice, arg_odd[0]);
+
+        for (int i = 1; i < 8; i++)
+            gej_add(arg_odd[i], arg_odd[i - 1], twice);
+    }
+
+
+    /* Affine of n points at one inversion, Montgomery's trick. None is
+     *  infinity. */
+    void gej_to_ge_all(Ge* arg_out, const Gej* arg_in, const size_t arg_n, Fe* arg_scratch) {
+        if (arg_n == 0)
+            return;
+
+        arg_scratch[0] = arg_in[0].z;
+
+        for (size_t i = 1; i < arg_n; i++)
+            fe_mul(arg_scratch[i], arg_scratch[i - 1], arg_in[i].z);
+
+        Fe inv, zi, zi2;
+        fe_inv(inv, arg_scratch[arg_n - 1]);
+
+        for (size_t i = arg_n; i-- > 0;) {
+            if (i > 0) {
+                fe_mul(zi, inv, arg_scratch[i - 1]);
+                fe_mul(inv, inv, arg_in[i].z);
+            }
+            else
+                zi = inv;
+
+            fe_sqr(zi2, zi);
+            fe_mul(arg_out[i].x, arg_in[i].x, zi2);
+            fe_mul(zi2, zi2, zi);
+            fe_mul(arg_out[i].y, arg_in[i].y, zi2);
+
+            fe_normalize(arg_out[i].x);
+            fe_normalize(arg_out[i].y);
+        }
+    }
+
+
+    /* acc + d * P for a NAF digit d, odd multiples of P given. */
+    inline void gej_add_digit(Gej& acc, const Gej* arg_odd, const int d) {
+        if (d > 0)
+            gej_add(acc, acc, arg_odd[(d - 1) / 2]);
+
+        else if (d < 0) {
+            Gej neg = arg_odd[(-d - 1) / 2];
+            fe_neg(neg.y, neg.y);
+
+            gej_add(acc, acc, neg);
+        }
+    }
+
+
+    /* Same, over affine multiples. */
+    inline void gej_add_digit(Gej& acc, const Ge* arg_odd, const int d) {
+        if (d > 0)
+            gej_add_ge(acc, acc, arg_odd[(d - 1) / 2]);
+
+        else if (d < 0) {
+            Ge neg = arg_odd[(-d - 1) / 2];
+            fe_neg(neg.y, neg.y);
+
+            gej_add_ge(acc, acc, neg);
+        }
+    }
+
+
+    inline void gej_add_digit(Gej& acc, const EE488::K1Point* arg_odd, const int d) {
+        if (d > 0)
+            gej_add_ge(acc, acc, ge_of(arg_odd[(d - 1) / 2]));
+
+        else if (d < 0) {
+            Ge neg = ge_of(arg_odd[(-d - 1) / 2]);
+            fe_neg(neg.y, neg.y);
+
+            gej_add_ge(acc, acc, neg);
+        }
+    }
+};
+
+
+
+/*
+ * Secp256k1 Actions */
+EE488::Secp256k1::Secp256k1() :
+    comb(K1_COMB_WINDOWS * K1_COMB_ENTRIES),
+    odd_g(K1_ODD_G_ENTRIES) {
+
+    Ge g;
+    fe_from_words(g.x, K1_GX);
+    fe_from_words(g.y, K1_GY);
+
+    /* Row i holds j * 16^i * G, for j in [1, 15]. */
+    Gej base = gej_of(g);
+
+    for (int i = 0; i < K1_COMB_WINDOWS; i++) {
+        Gej acc = base;
+        Ge affine;
+
+        for (int j = 0; j < K1_COMB_ENTRIES; j++) {
+            gej_to_ge(affine, acc);
+            comb[i * K1_COMB_ENTRIES + j] = point_of(affine);
+
+            gej_add(acc, acc, base);
+        }
+
+        base = acc;     // 16 * 16^i * G
+    }
+
+    /* G, 3G, 5G, ... for the NAF of s in verify. */
+    Gej acc = gej_of(g), twice;
+    gej_double(twice, acc);
+
+    for (int i = 0; i < K1_ODD_G_ENTRIES; i++) {
+        Ge affine;
+
+        gej_to_ge(affine, acc);
+        odd_g[i] = point_of(affine);
+
+        gej_add(acc, acc, twice);
+    }
+
+    /* Blinding point of unknown discrete log, x from a hash. */
+    unsigned char arr_x[SHA256_DIGEST_LENGTH];
+    unsigned char arr_y[SHA256_DIGEST_LENGTH];
+
+    SHA256(reinterpret_cast<const unsigned char*>("EE488/secp256k1/blind"), 21, arr_x);
+
+    while (do_lift_x(arr_y, arr_x) != 0)
+        SHA256(arr_x, sizeof(arr_x), arr_x);
+
+    Ge b;
+    fe_from_bytes(b.x, arr_x);
+    fe_from_bytes(b.y, arr_y);
+
+    blind = point_of(b);
+
+    fe_neg(b.y, b.y);
+    fe_normalize(b.y);
+    neg_blind = point_of(b);
+}
+
+
+
+/*
+ * do_base_mul
+ */
+int EE488::Secp256k1::do_base_mul(unsigned char* arg_x, unsigned char* arg_y, const unsigned char* arg_k) const {
+
+    Gej acc = gej_of(ge_of(blind));
+
+    for (int i = 0; i < K1_COMB_WINDOWS; i++) {
+        const unsigned d = do_digit(arg_k, i);
+        const unsigned want = d ? d - 1 : 0;    // Zero digit adds entry 1 for nothing
+
+        /* Whole row scanned, thus the access does not depend on d. */
+        Ge entry = { { { 0, } }, { { 0, } } };
+        const K1Point* row = &comb[i * K1_COMB_ENTRIES];
+
+        for (unsigned j = 0; j < (unsigned)K1_COMB_ENTRIES; j++) {
+            const u64 mask = 0 - (u64)(j == want);
+            Ge e = ge_of(row[j]);
+
+            fe_cmov(entry.x, e.x, mask);
+            fe_cmov(entry.y, e.y, mask);
+        }
+
+        Gej sum;
+        gej_add_ge(sum, acc, entry);
+
+        const u64 keep = 0 - (u64)(d != 0);
+
+        fe_cmov(acc.x, sum.x, keep);
+        fe_cmov(acc.y, sum.y, keep);
+        fe_cmov(acc.z, sum.z, keep);
+    }
+
+    gej_add_ge(acc, acc, ge_of(neg_blind));
+
+    Ge r;
+    if (!gej_to_ge(r, acc))
+        return -1;
+
+    fe_to_bytes(arg_x, r.x);
+    fe_to_bytes(arg_y, r.y);
+
+    return 0;
+}
+
+
+
+/*
+ * do_dual_mul
+ */
+int EE488::Secp256k1::do_dual_mul(
+    unsigned char* arg_x,
+    unsigned char* arg_y,
+    const unsigned char* arg_s,
+    const unsigned char* arg_px,
+    const unsigned char* arg_py,
+    const unsigned char* arg_e) const {
+
+    Gej odd_p[8];
+    do_odd_multiples(odd_p, arg_px, arg_py);
+
+    /* Both scalars on one chain of doublings, Strauss-Shamir. s has the
+     *  wider NAF, its table of G being affine and built once. */
+    int wnaf_s[257], wnaf_e[257];
+    do_wnaf(wnaf_s, arg_s, K1_ODD_G_WBITS);
+    do_wnaf(wnaf_e, arg_e, 5);
+
+    Gej sum_p = { { { 0, } }, { { 0, } }, { { 0, } }, true };
+
+    for (int i = 256; i >= 0; i--) {
+        gej_double(sum_p, sum_p);
+
+        gej_add_digit(sum_p, odd_p, wnaf_e[i]);
+        gej_add_digit(sum_p, odd_g.data(), wnaf_s[i]);
+    }
+
+    Ge r;
+    if (!gej_to_ge(r, sum_p))
+        return 1;
+
+    fe_to_bytes(arg_x, r.x);
+    fe_to_bytes(arg_y, r.y);
+
+    return 0;
+}
+
+
+
+/*
+ * do_multi_mul
+ */
+int EE488::Secp256k1::do_multi_mul(
+    unsigned char* arg_x,
+    unsigned char* arg_y,
+    const unsigned char* arg_s,
+    const unsigned char* const* arg_pxs,
+    const unsigned char* const* arg_pys,
+    const unsigned char* const* arg_es,
+    const size_t arg_n) const {
+
+    /* Strauss over K1_MULTI_CHUNK points at a time: one chain of doublings
+     *  for all of them, and s * G on the first. The odd multiples go affine
+     *  at one inversion per chunk, thus every addition is a mixed one. */
+    const size_t chunk = std::min(arg_n, K1_MULTI_CHUNK);
+
+    std::vector<Gej> odd_j(chunk * 8);
+    std::vector<Ge> odd_p(chunk * 8);
+    std::vector<Fe> scratch(chunk * 8);
+    std::vector<int> wnaf_e(chunk * 257);
+    int wnaf_s[257] = { 0, };
+
+    if (arg_s != nullptr)
+        do_wnaf(wnaf_s, arg_s, K1_ODD_G_WBITS);
+
+    Gej total = { { { 0, } }, { { 0, } }, { { 0, } }, true };
+    size_t base = 0;
+
+    do {
+        const size_t m = std::min(arg_n - base, K1_MULTI_CHUNK);
+
+        for (size_t j = 0; j < m; j++) {
+            do_odd_multiples(&odd_j[j * 8], arg_pxs[base + j], arg_pys[base + j]);
+            do_wnaf(&wnaf_e[j * 257], arg_es[base + j], 5);
+        }
+
+        gej_to_ge_all(odd_p.data(), odd_j.data(), m * 8, scratch.data());
+
+        Gej sum_p = { { { 0, } }, { { 0, } }, { { 0, } }, true };
+
+        for (int i = 256; i >= 0; i--) {
+            gej_double(sum_p, sum_p);
+
+            for (size_t j = 0; j < m; j++)
+                gej_add_digit(sum_p, &odd_p[j * 8], wnaf_e[j * 257 + i]);
+
+            if (base == 0)
+                gej_add_digit(sum_p, odd_g.data(), wnaf_s[i]);
+        }
+
+        gej_add(total, total, sum_p);
+        base += m;
+
+    } while (base < arg_n);
+
+    Ge r;
+    if (!gej_to_ge(r, total))
+        return 1;
+
+    fe_to_bytes(arg_x, r.x);
+    fe_to_bytes(arg_y, r.y);
+
+    return 0;
+}
+
+
+
+/*
+ * do_lift_x
+ */
+int EE488::Secp256k1::do_lift_x(unsigned char* arg_y, const unsigned char* arg_x) const {
+
+    Fe x, y, t;
+
+    if (std::memcmp(arg_x, K1_P_BYTES, sizeof(K1_P_BYTES)) >= 0)
+        return 1;
+
+    fe_from_bytes(x, arg_x);
+
+    /* y^2 = x^3 + 7 */
+    const Fe seven = { { 7, 0, 0, 0, 0 } };
+
+    fe_sqr(t, x);
+    fe_mul(t, t, x);
+    fe_add(t, t, seven);
+
+    if (!fe_sqrt(y, t))
+        return 1;
+
+    fe_normalize(y);
+
+    if (y.n[0] & 1) {
+        fe_neg(y, y);
+        fe_normalize(y);
+    }
+
+    fe_to_bytes(arg_y, y);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_SECP256K1_H
+#define __EE488_SECP256K1_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+namespace EE488 {
+
+    const int K1_COMB_WBITS = 4;
+    const int K1_COMB_WINDOWS = 256 / K1_COMB_WBITS;
+    const int K1_COMB_ENTRIES = (1 << K1_COMB_WBITS) - 1;  // Digit 0 not kept
+
+    const int K1_ODD_G_WBITS = 8;
+    const int K1_ODD_G_ENTRIES = 1 << (K1_ODD_G_WBITS - 2);  // G, 3G, ..., 127G
+
+    const size_t K1_MULTI_CHUNK = 64;   // Points per chain of doublings in do_multi_mul
+
+    /* Affine point, coordinates below p in five 52 bit limbs, little-endian. */
+    struct K1Point {
+        uint64_t x[5], y[5];
+    };
+
+
+    /*
+     * class Secp256k1
+     *  Built-in arithmetic of secp256k1, y^2 = x^3 + 7 over p = 2^256 - 2^32
+     *  - 977. OpenSSL has no dedicated code for this curve, and its generic
+     *  one is about fifty times slower than its P-256. The field uses that
+     *  2^256 = 2^32 + 977 mod p, points are Jacobian.
+     *
+     *  k * G sums one entry of a comb table per 4 bit digit of k, with no
+     *  doublings. The entry is read by a scan of the whole row, the sum
+     *  starts from a blinding point thus never meets infinity, and a zero
+     *  digit adds anyway and drops the result. s * G + e * P of verify is
+     *  variable time, on public values: one chain of doublings for both,
+     *  a width-8 NAF of s over odd multiples of G kept affine, and a width-5
+     *  NAF of e over those of P. Scalars and coordinates are 32 bytes,
+     *  big-endian.
+     *  Immutable after construction.
+     */
+    class Secp256k1 {
+    private:
+        std::vector<K1Point> comb;          // K1_COMB_WINDOWS rows of K1_COMB_ENTRIES
+        std::vector<K1Point> odd_g;
+        K1Point blind, neg_blind;
+
+    public:
+        Secp256k1();
+
+        /* Affine k * G, constant time in k. -1 if k * G is infinity. */
+        int do_base_mul(unsigned char*, unsigned char*, const unsigned char*) const;
+
+        /* Affine s * G + e * P, 1 if infinity. */
+        int do_dual_mul(
+            unsigned char*, unsigned char*,
+            const unsigned char*,                           // s
+            const unsigned char*, const unsigned char*,     // P.x, P.y
+            const unsigned char*) const;                    // e
+
+        /* Affine s * G + e_1 * P_1 + ... + e_n * P_n, 1 if infinity. s may
+         *  be nullptr. Variable time, as do_dual_mul, with the doublings
+         *  shared among K1_MULTI_CHUNK points. */
+        int do_multi_mul(
+            unsigned char*, unsigned char*,
+            const unsigned char*,                           // s
+            const unsigned char* const*,                    // P_i.x
+            const unsigned char* const*,                    // P_i.y
+            const unsigned char* const*,                    // e_i
+            const size_t) const;
+
+        /* Even y of x, 1 if x is not on the curve or not below p. */
+        int do_lift_x(unsigned char*, const unsigned char*) const;
+
+        size_t get_table_size() const { return (comb.size() + odd_g.size()) * sizeof(K1Point); }
+    };
+}
+
+#endif
@@ -0,0 +1,321 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include "./shmring.h"
+
+
+namespace {
+
+    inline void do_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    /* Relax, then yield. false once past the deadline, if any. */
+    inline bool do_backoff(const unsigned arg_spins, const bool arg_timed, 
+        const std::chrono::steady_clock::time_point& arg_deadline) {
+
+        if (arg_spins < EE488::SHMRING_SPINS) {
+            do_relax();
+            return true;
+        }
+
+        if (arg_timed && std::chrono::steady_clock::now() >= arg_deadline)
+            return false;
+
+        ::sched_yield();
+        return true;
+    }
+
+    inline std::chrono::steady_clock::time_point get_deadline(const long arg_timeout_ms) {
+        return std::chrono::steady_clock::now() + std::chrono::milliseconds(arg_timeout_ms > 0 ? arg_timeout_ms : 0);
+    }
+};
+
+static_assert(sizeof(EE488::ShmRingHeader) <= EE488::SHMRING_HDR_LEN, "ShmRingHeader over a page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Atomics across processes should be lock-free");
+
+
+
+/*
+ * ShmRing Actions */
+int EE488::ShmRing::do_map(const int arg_fd, const size_t arg_len) {
+
+    void* mapped = ::mmap(nullptr, arg_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, arg_fd, 0);
+    ::close(arg_fd);
+
+    if (mapped == MAP_FAILED)
+        return -1;
+
+    hdr = static_cast<ShmRingHeader*>(mapped);
+    slots = static_cast<unsigned char*>(mapped) + SHMRING_HDR_LEN;
+    len = arg_len;
+
+    return 0;
+}
+
+
+
+/*
+ * do_create
+ */
+int EE488::ShmRing::do_create(const char* arg_name, const size_t arg_record_len, const size_t arg_capacity) {
+
+    do_close();
+
+    if (arg_record_len == 0 || arg_record_len > UINT32_MAX || arg_capacity == 0)
+        return -1;
+
+    size_t capacity = 1;
+    while (capacity < arg_capacity) capacity <<= 1;
+
+    const size_t record_stride = (arg_record_len + 7) / 8 * 8;
+    const size_t total = SHMRING_HDR_LEN + capacity * record_stride;
+
+    ::shm_unlink(arg_name);     // Stale, of a producer gone
+
+    const int fd = ::shm_open(arg_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return -1;
+
+    if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        ::close(fd);
+        ::shm_unlink(arg_name);
+        return -1;
+    }
+
+    if (do_map(fd, total) != 0) {
+        ::shm_unlink(arg_name);
+        return -1;
+    }
+
+    new (hdr) ShmRingHeader();
+
+    std::memcpy(hdr->magic, SHMRING_MAGIC, sizeof(SHMRING_MAGIC));
+    hdr->version = SHMRING_VERSION;
+    hdr->record_len = static_cast<uint32_t>(arg_record_len);
+    hdr->stride = record_stride;
+    hdr->capacity = capacity;
+
+    stride = record_stride, mask = capacity - 1;
+    head = tail = 0;
+
+    name = arg_name;
+    owner = true;
+
+    return 0;
+}
+
+
+
+/*
+ * do_open
+ */
+int EE488::ShmRing::do_open(const char* arg_name) {
+
+    do_close();
+
+    const int fd = ::shm_open(arg_name, O_RDWR, 0);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < SHMRING_HDR_LEN) {
+        ::close(fd);
+        return -1;
+    }
+
+    if (do_map(fd, static_cast<size_t>(st.st_size)) != 0)
+        return -1;
+
+    const uint64_t capacity = hdr->capacity;
+
+    if (std::memcmp(hdr->magic, SHMRING_MAGIC, sizeof(SHMRING_MAGIC)) != 0 ||
+        hdr->version != SHMRING_VERSION ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        hdr->stride < hdr->record_len ||
+        SHMRING_HDR_LEN + capacity * hdr->stride != len) {
+
+        do_close();
+        return -1;
+    }
+
+    stride = hdr->stride, mask = capacity - 1;
+    head = hdr->head.load(std::memory_order_acquire);
+    tail = hdr->tail.load(std::memory_order_acquire);
+
+    name = arg_name;
+    owner = false;
+
+    return 0;
+}
+
+
+
+void EE488::ShmRing::do_close() {
+
+    if (hdr != nullptr) {
+        if (!producer)
+            hdr->consumer_closed.store(1, std::memory_order_release);
+
+        ::munmap(hdr, len);
+    }
+
+    if (owner)
+        ::shm_unlink(name.c_str());
+
+    hdr = nullptr, slots = nullptr, len = 0;
+    stride = mask = 0;
+    head = tail = 0;
+
+    name.clear();
+    owner = producer = false;
+}
+
+
+
+/*
+ * Producer
+ *  head is its own, tail is cached, read again only when the ring looks
+ *  full by it.
+ */
+size_t EE488::ShmRing::get_writable() {
+
+    producer = true;
+
+    size_t free = mask + 1 - (head - tail);
+
+    if (free == 0) {
+        tail = hdr->tail.load(std::memory_order_acquire);
+        free = mask + 1 - (head - tail);
+    }
+
+    return free;
+}
+
+
+
+void EE488::ShmRing::do_commit(const size_t arg_n) {
+
+    head += arg_n;
+    hdr->head.store(head, std::memory_order_release);
+}
+
+
+
+size_t EE488::ShmRing::do_push(const unsigned char* arg_records, size_t arg_n) {
+
+    const size_t record_len = hdr->record_len;
+    size_t done = 0;
+
+    while (done < arg_n) {
+        const size_t n = std::min(arg_n - done, do_wait_writable());
+        if (n == 0)
+            break;
+
+        for (size_t i = 0; i < n; i++)
+            std::memcpy(get_slot(i), arg_records + (done + i) * record_len, record_len);
+
+        do_commit(n);
+        done += n;
+    }
+
+    return done;
+}
+
+
+
+void EE488::ShmRing::do_finish() {
+    hdr->closed.store(1, std::memory_order_release);
+}
+
+
+
+size_t EE488::ShmRing::do_wait_writable(const long arg_timeout_ms) {
+
+    const bool timed = (arg_timeout_ms > 0);
+    const auto deadline = timed ? get_deadline(arg_timeout_ms) : std::chrono::steady_clock::time_point();
+
+    for (unsigned spins = 0;; spins++) {
+        const size_t n = get_writable();
+        if (n > 0)
+            return n;
+
+        /* Full, and no one left to empty it. */
+        if (is_abandoned() || !do_backoff(spins, timed, deadline))
+            return 0;
+    }
+}
+
+
+
+/*
+ * Consumer
+ *  tail is its own, head is cached, read again only when the ring looks
+ *  empty by it.
+ */
+size_t EE488::ShmRing::get_readable() {
+
+    size_t avail = head - tail;
+
+    if (avail == 0) {
+        head = hdr->head.load(std::memory_order_acquire);
+        avail = head - tail;
+    }
+
+    return avail;
+}
+
+
+
+void EE488::ShmRing::do_release(const size_t arg_n) {
+
+    tail += arg_n;
+    hdr->tail.store(tail, std::memory_order_release);
+}
+
+
+
+size_t EE488::ShmRing::do_wait_readable(const long arg_timeout_ms) {
+
+    const bool timed = (arg_timeout_ms > 0);
+    const auto deadline = timed ? get_deadline(arg_timeout_ms) : std::chrono::steady_clock::time_point();
+
+    for (unsigned spins = 0;; spins++) {
+        size_t n = get_readable();
+        if (n > 0)
+            return n;
+
+        /* Finished before its last commit was seen, thus once more. */
+        if (is_finished())
+            return get_readable();
+
+        if (!do_backoff(spins, timed, deadline))
+            return 0;
+    }
+}
@@ -0,0 +1,124 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_SHMRING_H
+#define __EE488_SHMRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace EE488 {
+
+    /*
+     * Shared ring
+     *  A POSIX shared memory object of a header page, then capacity slots of
+     *  stride bytes, the record length up to a multiple of 8. capacity is a
+     *  power of two. head and tail count records ever written and read, on
+     *  cache lines of their own, thus slot i is at (i & (capacity - 1)).
+     */
+    const char SHMRING_MAGIC[8] = { 'E', 'E', '4', '8', '8', 'S', 'H', 'R' };
+    const uint32_t SHMRING_VERSION = 2;     // 2: consumer_closed
+
+    const size_t SHMRING_CAPACITY = 4096;   // Default, records
+    const size_t SHMRING_HDR_LEN = 4096;
+    const unsigned SHMRING_SPINS = 1024;    // Before yielding, in do_wait_*
+
+    struct ShmRingHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_len;
+        uint64_t stride;
+        uint64_t capacity;
+
+        alignas(64) std::atomic<uint64_t> head;     // Producer
+        alignas(64) std::atomic<uint64_t> tail;     // Consumer
+        alignas(64) std::atomic<uint32_t> closed;   // No more records
+        std::atomic<uint32_t> consumer_closed;      // No more reads
+    };
+
+
+    /*
+     * class ShmRing
+     *  Lock-free single-producer single-consumer ring between processes.
+     *  Either side works on slots in place: the producer fills what
+     *  get_writable gives and publishes them by do_commit, the consumer
+     *  reads what get_readable gives and hands them back by do_release.
+     *  Thus records are never copied, and an index is stored once per
+     *  batch. Each side caches the index of the other, and reads it again
+     *  only when the cached one says full or empty. No syscall but in
+     *  do_wait_*, after SHMRING_SPINS, and in create, open and close.
+     *  A side that never wrote is the consumer, and its close tells the
+     *  producer, whose do_wait_writable then gives 0 once the ring is
+     *  full. A consumer killed outright never closes, thus the timeout.
+     */
+    class ShmRing {
+    private:
+        ShmRingHeader* hdr;
+        unsigned char* slots;
+        size_t len;
+        size_t stride, mask;
+
+        std::string name;
+        bool owner;                 // Unlinks the name on close
+        bool producer;              // Has written, thus not the consumer
+
+        uint64_t head, tail;        // Own, or cached of the other side
+
+        int do_map(const int, const size_t);
+
+    public:
+        ShmRing() : hdr(nullptr), slots(nullptr), len(0), stride(0), mask(0),
+            owner(false), producer(false), head(0), tail(0) {}
+        ShmRing(const ShmRing&) = delete;
+        ~ShmRing() { do_close(); }
+
+        ShmRing& operator =(const ShmRing&) = delete;
+
+        /* The name is of shm_open, "/name". Create replaces a stale one. */
+        int do_create(const char*, const size_t, const size_t = SHMRING_CAPACITY);
+        int do_open(const char*);
+        void do_close();
+
+        /* Producer */
+        size_t get_writable();
+        unsigned char* get_slot(const size_t i) { return slots + ((head + i) & mask) * stride; }
+        void do_commit(const size_t);
+        size_t do_push(const unsigned char*, size_t);   // n records back to back, copied, fewer if 0 below
+        void do_finish();                               // The consumer sees it when empty
+        size_t do_wait_writable(const long = 0);        // 0 when the consumer closed, or after ms
+
+        /* Consumer */
+        size_t get_readable();
+        const unsigned char* get_record(const size_t i) const { return slots + ((tail + i) & mask) * stride; }
+        void do_release(const size_t);
+        size_t do_wait_readable(const long = 0);        // 0 when finished and empty, or after ms
+
+        bool is_finished() const { return hdr->closed.load(std::memory_order_acquire) != 0; }
+        bool is_abandoned() const { return hdr->consumer_closed.load(std::memory_order_acquire) != 0; }
+        bool is_open() const { return hdr != nullptr; }
+
+        size_t get_record_len() const { return hdr->record_len; }
+        size_t get_capacity() const { return mask + 1; }
+    };
+
+    using shmring_t = ShmRing;
+}
+
+#endif
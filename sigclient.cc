@@ -0,0 +1,303 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "./sigclient.h"
+
+
+/*
+ * SignClient Actions */
+int EE488::SignClient::do_connect(const char* arg_path, const uint64_t arg_id) {
+
+    do_close();
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+
+    if (std::strlen(arg_path) >= sizeof(addr.sun_path))
+        return -1;
+
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, arg_path);
+
+    fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        do_close();
+        return -1;
+    }
+
+    key_id = arg_id;
+
+    /* The domain and pk of the key */
+    SigdReply reply;
+    WirePqgView pqg_view;
+    WirePkView pk_view;
+    int n = -1;
+
+    do_append_request(outbox, SIGD_OP_KEY, next_seq++, key_id, 0, nullptr, 0);
+
+    if (do_send() != 0 || do_recv(reply) != 0 || reply.status != SIGD_OK ||
+        (n = do_parse_pqg(reply.body, reply.body_len, pqg_view)) < 0 ||
+        do_parse_pk(reply.body + n, reply.body_len - n, pk_view) < 0 ||
+        do_load_pqg(pqg_view, p.actor, q.actor, g.actor) != 0 ||
+        do_load_pk(pk_view, pk.actor) != 0) {
+
+        do_close();
+        return -1;
+    }
+
+    sig_width = get_sig_width(q.actor);
+    return 0;
+}
+
+
+
+void EE488::SignClient::do_close() {
+
+    if (fd >= 0)
+        ::close(fd);
+
+    fd = -1;
+    outbox.clear();
+    inbox_len = inbox_off = 0;
+}
+
+
+
+/* The whole outbox, then empties it. */
+int EE488::SignClient::do_send() {
+
+    size_t off = 0;
+
+    while (off < outbox.size()) {
+        const ssize_t n = ::send(fd, &outbox[off], outbox.size() - off, MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0) {
+            outbox.clear();
+            return -1;
+        }
+
+        off += static_cast<size_t>(n);
+    }
+
+    outbox.clear();
+    return 0;
+}
+
+
+
+/* The next reply. Its body is valid until the next call. */
+int EE488::SignClient::do_recv(SigdReply& arg_reply) {
+
+    if (fd < 0)
+        return -1;
+
+    /* What the last one used */
+    if (inbox_off > 0) {
+        std::memmove(inbox.data(), &inbox[inbox_off], inbox_len - inbox_off);
+        inbox_len -= inbox_off;
+        inbox_off = 0;
+    }
+
+    for (;;) {
+        const long n = do_parse_reply(inbox.data(), inbox_len, arg_reply);
+
+        if (n < 0)
+            return -1;
+
+        if (n > 0) {
+            inbox_off = static_cast<size_t>(n);
+            return 0;
+        }
+
+        if (inbox.size() - inbox_len < 4096)
+            inbox.resize(inbox_len + 64 * 1024);
+
+        const ssize_t got = ::read(fd, &inbox[inbox_len], inbox.size() - inbox_len);
+
+        if (got < 0 && errno == EINTR)
+            continue;
+
+        if (got <= 0)
+            return -1;
+
+        inbox_len += static_cast<size_t>(got);
+    }
+}
+
+
+
+/*
+ * do_sign
+ */
+int EE488::SignClient::do_sign(
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    BIGNUM* arg_s,
+    BIGNUM* arg_e,
+    const int arg_bitn) {
+
+    const std::string_view view(reinterpret_cast<const char*>(arg_msg), arg_len);
+    ssig_t sig;
+
+    if (do_sign_many(&view, 1, &sig, arg_bitn) != 0)
+        return -1;
+
+    BN_copy(arg_s, sig.s.actor);
+    BN_copy(arg_e, sig.e.actor);
+
+    return 0;
+}
+
+
+
+/*
+ * do_verify
+ */
+int EE488::SignClient::do_verify(
+    const unsigned char* arg_msg,
+    size_t arg_len,
+    const BIGNUM* arg_s,
+    const BIGNUM* arg_e,
+    const int arg_bitn) {
+
+    const std::string_view view(reinterpret_cast<const char*>(arg_msg), arg_len);
+    ssig_t sig;
+    int result = -1;
+
+    BN_copy(sig.s.actor, arg_s);
+    BN_copy(sig.e.actor, arg_e);
+
+    do_verify_many(&view, &sig, 1, &result, arg_bitn);
+    return result;
+}
+
+
+
+/*
+ * do_sign_many
+ */
+int EE488::SignClient::do_sign_many(
+    const std::string_view* arg_msgs,
+    size_t arg_n,
+    ssig_t* arg_sigs,
+    const int arg_bitn) {
+
+    if (fd < 0)
+        return static_cast<int>(arg_n);
+
+    const uint32_t first = next_seq;
+
+    for (size_t i = 0; i < arg_n; i++)
+        do_append_request(outbox, SIGD_OP_SIGN, next_seq++, key_id, arg_bitn,
+            reinterpret_cast<const unsigned char*>(arg_msgs[i].data()), arg_msgs[i].size());
+
+    if (do_send() != 0) {
+        do_close();
+        return static_cast<int>(arg_n);
+    }
+
+    int nfails = 0;
+
+    for (size_t i = 0; i < arg_n; i++) {
+        SigdReply reply;
+        WireSigView view;
+
+        if (do_recv(reply) != 0 || reply.seq != first + i) {
+            do_close();
+            return nfails + static_cast<int>(arg_n - i);
+        }
+
+        if (reply.status != SIGD_OK ||
+            do_parse_sig(reply.body, reply.body_len, view) < 0 ||
+            do_load_sig(view, arg_sigs[i].s.actor, arg_sigs[i].e.actor) != 0)
+            nfails++;
+    }
+
+    return nfails;
+}
+
+
+
+/*
+ * do_verify_many
+ */
+int EE488::SignClient::do_verify_many(
+    const std::string_view* arg_msgs,
+    const ssig_t* arg_sigs,
+    size_t arg_n,
+    int* arg_results,
+    const int arg_bitn) {
+
+    for (size_t i = 0; i < arg_n; i++) arg_results[i] = -1;
+
+    if (fd < 0)
+        return static_cast<int>(arg_n);
+
+    const uint32_t first = next_seq;
+    std::vector<unsigned char> record(get_sig_len(sig_width));
+
+    for (size_t i = 0; i < arg_n; i++) {
+        if (do_encode_sig(record.data(), record.size(),
+            arg_sigs[i].s.actor, arg_sigs[i].e.actor, sig_width) < 0) {
+
+            outbox.clear();
+            next_seq = first;
+
+            return static_cast<int>(arg_n);
+        }
+
+        do_append_request(outbox, SIGD_OP_VERIFY, next_seq++, key_id, arg_bitn,
+            record.data(), record.size(),
+            reinterpret_cast<const unsigned char*>(arg_msgs[i].data()), arg_msgs[i].size());
+    }
+
+    if (do_send() != 0) {
+        do_close();
+        return static_cast<int>(arg_n);
+    }
+
+    int nfails = 0;
+
+    for (size_t i = 0; i < arg_n; i++) {
+        SigdReply reply;
+
+        if (do_recv(reply) != 0 || reply.seq != first + i) {
+            do_close();
+            return nfails + static_cast<int>(arg_n - i);
+        }
+
+        arg_results[i] =
+            (reply.status == SIGD_OK) ? 0 : (reply.status == SIGD_NOT_VERIFIED) ? 1 : -1;
+
+        if (arg_results[i] != 0)
+            nfails++;
+    }
+
+    return nfails;
+}
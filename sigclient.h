@@ -0,0 +1,115 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_SIGCLIENT_H
+#define __EE488_SIGCLIENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./schnorr.h"
+#include "./sigd.h"
+
+
+namespace EE488 {
+
+    /*
+     * class SignClient
+     *  A communicator whose key lives in a SignDaemon. Connecting to a key
+     *  id fetches its domain and pk once, thus signatures can be encoded and
+     *  checked locally too. prepare_msg, generate_sig and run_verify work
+     *  on the registered message and the last signature as Communicator
+     *  does. The *_many calls send n requests in one write before reading
+     *  any reply, so the daemon takes them as one batch. Blocking, and one
+     *  thread at a time.
+     */
+    class SignClient {
+    private:
+        std::string name;               // Who am I?
+        int fd;
+        uint64_t key_id;
+        uint32_t next_seq;
+
+        std::vector<unsigned char> outbox, inbox;
+        size_t inbox_len, inbox_off;
+
+        bnw_t p, q, g, pk;              // Of the key, by do_connect
+        size_t sig_width;
+
+        std::string msg;                // Registered
+        bnw_t sig_s, sig_e;             // Last signature
+
+        int do_send();
+        int do_recv(SigdReply&);
+
+    public:
+        SignClient(const char* arg_name) : name(arg_name), fd(-1), key_id(0), next_seq(0),
+            inbox_len(0), inbox_off(0), sig_width(0) {}
+        SignClient(const SignClient&) = delete;
+        ~SignClient() { do_close(); }
+
+        SignClient& operator =(const SignClient&) = delete;
+
+        /* Connects to the socket and fetches the key of the id. -1 if the
+         *  daemon is not there or has no such key. */
+        int do_connect(const char*, const uint64_t);
+        void do_close();
+
+        /* 0 signed or verified, 1 not verified, -1 on error. */
+        int do_sign(const unsigned char*, size_t, BIGNUM*, BIGNUM*, const int);
+        int do_verify(const unsigned char*, size_t, const BIGNUM*, const BIGNUM*, const int);
+
+        /* n at once. Results of verify into the array, as do_verify. Returns
+         *  the number of failures, not verified counted as well. */
+        int do_sign_many(const std::string_view*, size_t, ssig_t*, const int);
+        int do_verify_many(const std::string_view*, const ssig_t*, size_t, int*, const int);
+
+        /* Run do_ series, as Communicator */
+        int prepare_msg(const char* arg_msg) { msg = arg_msg; return 0; }
+        int generate_sig(const int arg_nbits) {
+            return do_sign(reinterpret_cast<const unsigned char*>(msg.data()), msg.size(),
+                sig_s.actor, sig_e.actor, arg_nbits);
+        }
+        int run_verify(const int arg_nbits) {
+            return do_verify(reinterpret_cast<const unsigned char*>(msg.data()), msg.size(),
+                sig_s.actor, sig_e.actor, arg_nbits);
+        }
+
+        void set_signature_pair(const BIGNUM* arg_s, const BIGNUM* arg_e) {
+            BN_copy(sig_s.actor, arg_s), BN_copy(sig_e.actor, arg_e);
+        }
+
+        const std::string& get_name() const { return name; }
+
+        const BIGNUM* get_p() const { return p.actor; }
+        const BIGNUM* get_q() const { return q.actor; }
+        const BIGNUM* get_g() const { return g.actor; }
+        const BIGNUM* get_pk() const { return pk.actor; }
+
+        const BIGNUM* get_signature_s() const { return sig_s.actor; }
+        const BIGNUM* get_signature_e() const { return sig_e.actor; }
+
+        bool is_connected() const { return fd >= 0; }
+    };
+
+    using sigc_t = SignClient;
+}
+
+#endif
@@ -0,0 +1,639 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "./sigd.h"
+
+
+namespace {
+
+    const size_t READ_CHUNK = 64 * 1024;
+
+    inline void do_put_u16(unsigned char* arg_out, const uint16_t arg_val) {
+        arg_out[0] = static_cast<unsigned char>(arg_val >> 8);
+        arg_out[1] = static_cast<unsigned char>(arg_val);
+    }
+
+    inline void do_put_u32(unsigned char* arg_out, const uint32_t arg_val) {
+        for (int i = 0; i < 4; i++)
+            arg_out[i] = static_cast<unsigned char>(arg_val >> (24 - 8 * i));
+    }
+
+    inline void do_put_u64(unsigned char* arg_out, const uint64_t arg_val) {
+        for (int i = 0; i < 8; i++)
+            arg_out[i] = static_cast<unsigned char>(arg_val >> (56 - 8 * i));
+    }
+
+    inline uint16_t do_get_u16(const unsigned char* arg_in) {
+        return static_cast<uint16_t>((arg_in[0] << 8) | arg_in[1]);
+    }
+
+    inline uint32_t do_get_u32(const unsigned char* arg_in) {
+        uint32_t val = 0;
+        for (int i = 0; i < 4; i++) val = (val << 8) | arg_in[i];
+        return val;
+    }
+
+    inline uint64_t do_get_u64(const unsigned char* arg_in) {
+        uint64_t val = 0;
+        for (int i = 0; i < 8; i++) val = (val << 8) | arg_in[i];
+        return val;
+    }
+};
+
+
+
+/*
+ * do_append_request
+ */
+void EE488::do_append_request(
+    std::vector<unsigned char>& arg_buf,
+    const uint8_t arg_op,
+    const uint32_t arg_seq,
+    const uint64_t arg_id,
+    const int arg_bitn,
+    const unsigned char* arg_a,
+    size_t arg_alen,
+    const unsigned char* arg_b,
+    size_t arg_blen) {
+
+    const size_t at = arg_buf.size();
+    arg_buf.resize(at + SIGD_REQ_HDR_LEN + arg_alen + arg_blen);
+
+    unsigned char* frame = &arg_buf[at];
+
+    do_put_u32(frame, static_cast<uint32_t>(SIGD_REQ_HDR_LEN - 4 + arg_alen + arg_blen));
+    frame[4] = arg_op;
+    do_put_u32(frame + 5, arg_seq);
+    do_put_u64(frame + 9, arg_id);
+    do_put_u16(frame + 17, static_cast<uint16_t>(arg_bitn));
+
+    if (arg_alen > 0) std::memcpy(frame + SIGD_REQ_HDR_LEN, arg_a, arg_alen);
+    if (arg_blen > 0) std::memcpy(frame + SIGD_REQ_HDR_LEN + arg_alen, arg_b, arg_blen);
+}
+
+
+
+/*
+ * do_append_reply
+ */
+void EE488::do_append_reply(
+    std::vector<unsigned char>& arg_buf,
+    const uint32_t arg_seq,
+    const uint8_t arg_status,
+    const unsigned char* arg_body,
+    size_t arg_len) {
+
+    const size_t at = arg_buf.size();
+    arg_buf.resize(at + SIGD_REPLY_HDR_LEN + arg_len);
+
+    unsigned char* frame = &arg_buf[at];
+
+    do_put_u32(frame, static_cast<uint32_t>(SIGD_REPLY_HDR_LEN - 4 + arg_len));
+    do_put_u32(frame + 4, arg_seq);
+    frame[8] = arg_status;
+
+    if (arg_len > 0) std::memcpy(frame + SIGD_REPLY_HDR_LEN, arg_body, arg_len);
+}
+
+
+
+/*
+ * do_parse_request
+ */
+long EE488::do_parse_request(const unsigned char* arg_buf, size_t arg_len, SigdRequest& arg_req) {
+
+    if (arg_len < 4)
+        return 0;
+
+    const size_t len = do_get_u32(arg_buf);
+
+    if (len < SIGD_REQ_HDR_LEN - 4 || len > SIGD_MAX_FRAME)
+        return -1;
+
+    if (arg_len < 4 + len)
+        return 0;
+
+    arg_req.op = arg_buf[4];
+    arg_req.seq = do_get_u32(arg_buf + 5);
+    arg_req.key_id = do_get_u64(arg_buf + 9);
+    arg_req.bitn = do_get_u16(arg_buf + 17);
+    arg_req.body = arg_buf + SIGD_REQ_HDR_LEN;
+    arg_req.body_len = 4 + len - SIGD_REQ_HDR_LEN;
+
+    return static_cast<long>(4 + len);
+}
+
+
+
+/*
+ * do_parse_reply
+ */
+long EE488::do_parse_reply(const unsigned char* arg_buf, size_t arg_len, SigdReply& arg_reply) {
+
+    if (arg_len < 4)
+        return 0;
+
+    const size_t len = do_get_u32(arg_buf);
+
+    if (len < SIGD_REPLY_HDR_LEN - 4 || len > SIGD_MAX_FRAME)
+        return -1;
+
+    if (arg_len < 4 + len)
+        return 0;
+
+    arg_reply.seq = do_get_u32(arg_buf + 4);
+    arg_reply.status = arg_buf[8];
+    arg_reply.body = arg_buf + SIGD_REPLY_HDR_LEN;
+    arg_reply.body_len = 4 + len - SIGD_REPLY_HDR_LEN;
+
+    return static_cast<long>(4 + len);
+}
+
+
+
+/*
+ * SignDaemon Actions */
+EE488::SignDaemon::SignDaemon(
+    const size_t arg_nthreads,
+    const size_t arg_batch_max,
+    const long arg_batch_wait) :
+    pool(arg_nthreads > 0 ? new ThreadPool(arg_nthreads) : nullptr),
+    batch_max(std::max<size_t>(1, arg_batch_max)),
+    batch_wait(std::max<long>(0, arg_batch_wait)),
+    listen_fd(-1),
+    stopping(false),
+    nrequests(0), nbatches(0), nlargest(0), nconns(0) {
+
+    if (::pipe2(wake_fds, O_NONBLOCK | O_CLOEXEC) != 0)
+        wake_fds[0] = wake_fds[1] = -1;
+}
+
+
+
+EE488::SignDaemon::~SignDaemon() {
+
+    for (auto& conn: conns) ::close(conn->fd);
+
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        ::unlink(path.c_str());
+    }
+
+    if (wake_fds[0] >= 0) ::close(wake_fds[0]), ::close(wake_fds[1]);
+}
+
+
+
+int EE488::SignDaemon::do_add_key(const uint64_t arg_id, std::shared_ptr<const skey_t> arg_key) {
+
+    if (arg_key == nullptr || keys.count(arg_id))
+        return -1;
+
+    keys[arg_id] = arg_key;
+    return 0;
+}
+
+
+
+/*
+ * do_listen
+ */
+int EE488::SignDaemon::do_listen(const char* arg_path, const mode_t arg_mode) {
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+
+    if (std::strlen(arg_path) >= sizeof(addr.sun_path) || listen_fd >= 0 || wake_fds[0] < 0)
+        return -1;
+
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, arg_path);
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+        return -1;
+
+    ::unlink(arg_path);     // Stale, of a daemon gone
+
+    /* Refused until listen, thus none connects before the mode is set. */
+    const bool bound = ::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+
+    if (!bound ||
+        ::chmod(arg_path, arg_mode) != 0 ||
+        ::listen(listen_fd, SOMAXCONN) != 0) {
+
+        ::close(listen_fd);
+        if (bound) ::unlink(arg_path);
+        listen_fd = -1;
+
+        return -1;
+    }
+
+    path = arg_path;
+    return 0;
+}
+
+
+
+/*
+ * do_serve
+ */
+int EE488::SignDaemon::do_serve() {
+
+    using clock = std::chrono::steady_clock;
+
+    if (listen_fd < 0)
+        return -1;
+
+    while (!stopping) {
+        if (do_poll(-1)) {
+            /* More from anyone, until idle or the window closes. */
+            const auto deadline = clock::now() + std::chrono::microseconds(batch_wait);
+
+            while (!stopping) {
+                const long left = std::chrono::duration_cast<std::chrono::microseconds>(
+                    deadline - clock::now()).count();
+
+                if (left <= 0 || !do_poll(left))
+                    break;
+            }
+
+            do_run_batch();
+        }
+
+        /* Gone, once their replies are out */
+        conns.erase(std::remove_if(conns.begin(), conns.end(),
+            [](const std::unique_ptr<Conn>& arg_conn) {
+                if (!arg_conn->closing || arg_conn->out_off < arg_conn->out.size())
+                    return false;
+
+                ::close(arg_conn->fd);
+                return true;
+            }), conns.end());
+    }
+
+    for (auto& conn: conns) ::close(conn->fd);
+    conns.clear();
+
+    return 0;
+}
+
+
+
+void EE488::SignDaemon::do_stop() {
+
+    stopping = true;
+
+    const char c = 0;
+    if (::write(wake_fds[1], &c, 1) < 0)
+        return;     // Full, thus awake anyway
+}
+
+
+
+/*
+ * do_poll
+ *  One poll over the wake pipe, the listener and every connection, -1 to
+ *  block. true if any connection has read bytes.
+ */
+bool EE488::SignDaemon::do_poll(const long arg_wait_us) {
+
+    std::vector<pollfd> fds(2 + conns.size());
+
+    fds[0] = { wake_fds[0], POLLIN, 0 };
+    fds[1] = { listen_fd, POLLIN, 0 };
+
+    for (size_t i = 0; i < conns.size(); i++) {
+        const Conn& conn = *conns[i];
+        const bool pending = conn.out_off < conn.out.size();
+        const bool full =
+            conn.in_len - conn.parsed >= SIGD_MAX_BUFFERED ||
+            conn.out.size() - conn.out_off >= SIGD_MAX_BUFFERED;
+
+        fds[2 + i] = { conn.fd, static_cast<short>((conn.closing || full ? 0 : POLLIN) | (pending ? POLLOUT : 0)), 0 };
+    }
+
+    timespec wait = { arg_wait_us / 1000000, (arg_wait_us % 1000000) * 1000 };
+
+    if (::ppoll(fds.data(), fds.size(), arg_wait_us < 0 ? nullptr : &wait, nullptr) <= 0)
+        return false;
+
+    if (fds[0].revents & POLLIN) {
+        char arr_drain[64];
+        while (::read(wake_fds[0], arr_drain, sizeof(arr_drain)) > 0) { }
+    }
+
+    bool got = false;
+
+    /* Connections first, do_accept appends to them. */
+    for (size_t i = 0; i < fds.size() - 2; i++) {
+        Conn& conn = *conns[i];
+        const short rev = fds[2 + i].revents;
+
+        /* Requests held back for their replies, now with room for them. */
+        if (rev & POLLOUT) {
+            do_write(conn);
+            got |= conn.in_len > conn.parsed && conn.out.size() - conn.out_off < SIGD_MAX_BUFFERED;
+        }
+
+        if (rev & (POLLIN | POLLHUP | POLLERR)) {
+            const size_t before = conn.in_len;
+
+            if (!do_read(conn))
+                conn.closing = true;
+
+            got |= conn.in_len > before;
+        }
+    }
+
+    if (fds[1].revents & POLLIN)
+        do_accept();
+
+    return got;
+}
+
+
+
+void EE488::SignDaemon::do_accept() {
+
+    for (;;) {
+        const int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        std::unique_ptr<Conn> conn(new Conn());
+
+        conn->fd = fd;
+        conn->in_len = conn->parsed = conn->out_off = 0;
+        conn->closing = false;
+
+        conns.push_back(std::move(conn));
+        nconns++;
+    }
+}
+
+
+
+/* false on the end of the stream or an error. Stops at SIGD_MAX_BUFFERED. */
+bool EE488::SignDaemon::do_read(Conn& arg_conn) {
+
+    while (arg_conn.in_len - arg_conn.parsed < SIGD_MAX_BUFFERED) {
+        if (arg_conn.in.size() - arg_conn.in_len < READ_CHUNK)
+            arg_conn.in.resize(arg_conn.in_len + READ_CHUNK);
+
+        const ssize_t n = ::read(arg_conn.fd,
+            &arg_conn.in[arg_conn.in_len], arg_conn.in.size() - arg_conn.in_len);
+
+        if (n > 0) {
+            arg_conn.in_len += static_cast<size_t>(n);
+            continue;
+        }
+
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true;
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/* false on an error, the rest of the replies dropped. */
+bool EE488::SignDaemon::do_write(Conn& arg_conn) {
+
+    while (arg_conn.out_off < arg_conn.out.size()) {
+        const ssize_t n = ::send(arg_conn.fd,
+            &arg_conn.out[arg_conn.out_off], arg_conn.out.size() - arg_conn.out_off, MSG_NOSIGNAL);
+
+        if (n > 0) {
+            arg_conn.out_off += static_cast<size_t>(n);
+            continue;
+        }
+
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true;
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        arg_conn.out_off = arg_conn.out.size();
+        arg_conn.closing = true;
+
+        return false;
+    }
+
+    arg_conn.out.clear();
+    arg_conn.out_off = 0;
+
+    return true;
+}
+
+
+
+/*
+ * do_run_batch
+ *  Whole frames of every connection, batch_max at a time. Replies go out
+ *  in the order of the frames of each connection.
+ */
+void EE488::SignDaemon::do_run_batch() {
+
+    jobs.clear();
+
+    /* A connection closed by the client still gets the replies of what it
+     *  has sent. A malformed frame ends it. */
+    for (auto& conn: conns) {
+        size_t owed = conn->out.size() - conn->out_off;
+
+        /* Held back while its replies are not read, for a later batch. */
+        while (owed < SIGD_MAX_BUFFERED) {
+            Job job = { conn.get(), {}, SIGD_ERROR };
+
+            const long n = do_parse_request(
+                conn->in.data() + conn->parsed, conn->in_len - conn->parsed, job.req);
+
+            if (n == 0) break;
+            if (n < 0) {
+                conn->closing = true;
+                conn->in_len = conn->parsed;
+                break;
+            }
+
+            jobs.push_back(job);
+            conn->parsed += static_cast<size_t>(n);
+
+            owed += get_reply_len(job.req);
+        }
+    }
+
+    std::vector<unsigned char> record;
+
+    for (size_t base = 0; base < jobs.size(); base += batch_max) {
+        const size_t n = std::min(batch_max, jobs.size() - base);
+
+        if (slots.size() < n)
+            slots.resize(n);
+
+        if (pool != nullptr)
+            pool->do_parallel_for(n, 1, [&](size_t arg_begin, size_t arg_end) {
+                for (size_t i = arg_begin; i < arg_end; i++)
+                    do_run_job(jobs[base + i], slots[i]);
+            });
+        else
+            for (size_t i = 0; i < n; i++)
+                do_run_job(jobs[base + i], slots[i]);
+
+        for (size_t i = 0; i < n; i++) {
+            const Job& job = jobs[base + i];
+            record.clear();
+
+            if (job.status == SIGD_OK && job.req.op != SIGD_OP_VERIFY) {
+                const sdm_t* domain = keys.at(job.req.key_id)->get_domain();
+
+                if (job.req.op == SIGD_OP_SIGN) {
+                    const size_t w = get_sig_width(domain->get_q());
+
+                    record.resize(get_sig_len(w));
+                    do_encode_sig(record.data(), record.size(), slots[i].s.actor, slots[i].e.actor, w);
+                }
+                else {
+                    const size_t w = get_pk_width(domain->get_p());
+                    const size_t pqg_len = get_pqg_len(w, BN_num_bytes(domain->get_q()));
+
+                    record.resize(pqg_len + get_pk_len(w));
+                    do_encode_pqg(record.data(), pqg_len, domain->get_p(), domain->get_q(), domain->get_g());
+                    do_encode_pk(&record[pqg_len], get_pk_len(w), keys.at(job.req.key_id)->get_pk(), w);
+                }
+            }
+
+            do_append_reply(job.conn->out, job.req.seq, job.status, record.data(), record.size());
+        }
+
+        nrequests += n;
+        nbatches++;
+
+        uint64_t largest = nlargest;
+        while (n > largest && !nlargest.compare_exchange_weak(largest, n)) { }
+    }
+
+    /* Parsed bytes out, the rest of a frame stays for the next read. */
+    for (auto& conn: conns) {
+        if (conn->parsed > 0) {
+            std::memmove(conn->in.data(), &conn->in[conn->parsed], conn->in_len - conn->parsed);
+            conn->in_len -= conn->parsed;
+            conn->parsed = 0;
+        }
+
+        if (conn->out_off < conn->out.size())
+            do_write(*conn);
+    }
+
+    jobs.clear();
+}
+
+
+
+/*
+ * get_reply_len
+ *  Bytes of the reply to a request, at most, before it runs.
+ */
+size_t EE488::SignDaemon::get_reply_len(const SigdRequest& arg_req) const {
+
+    const auto it = keys.find(arg_req.key_id);
+
+    if (it == keys.end() || arg_req.op == SIGD_OP_VERIFY)
+        return SIGD_REPLY_HDR_LEN;
+
+    const sdm_t* domain = it->second->get_domain();
+
+    if (arg_req.op == SIGD_OP_SIGN)
+        return SIGD_REPLY_HDR_LEN + get_sig_len(get_sig_width(domain->get_q()));
+
+    const size_t w = get_pk_width(domain->get_p());
+
+    return SIGD_REPLY_HDR_LEN + get_pqg_len(w, BN_num_bytes(domain->get_q())) + get_pk_len(w);
+}
+
+
+
+/*
+ * do_run_job
+ *  In a worker of the pool. Keys and their domain are only read.
+ */
+void EE488::SignDaemon::do_run_job(Job& arg_job, ssig_t& arg_slot) const {
+
+    const SigdRequest& req = arg_job.req;
+    const auto it = keys.find(req.key_id);
+
+    if (it == keys.end()) {
+        arg_job.status = SIGD_NO_KEY;
+        return;
+    }
+
+    const skey_t& key = *it->second;
+
+    switch (req.op) {
+    case SIGD_OP_SIGN:
+        arg_job.status = key.do_sign(req.body, req.body_len,
+            arg_slot.s.actor, arg_slot.e.actor, req.bitn) == 0 ? SIGD_OK : SIGD_ERROR;
+        break;
+
+    case SIGD_OP_VERIFY: {
+        WireSigView view;
+        const int n = do_parse_sig(req.body, req.body_len, view);
+
+        if (n < 0 || do_load_sig(view, arg_slot.s.actor, arg_slot.e.actor) != 0) {
+            arg_job.status = SIGD_ERROR;
+            break;
+        }
+
+        const int rc = key.do_verify(req.body + n, req.body_len - n,
+            arg_slot.s.actor, arg_slot.e.actor, req.bitn);
+
+        arg_job.status = (rc == 0) ? SIGD_OK : (rc == 1) ? SIGD_NOT_VERIFIED : SIGD_ERROR;
+        break;
+    }
+
+    case SIGD_OP_KEY:
+        arg_job.status = SIGD_OK;
+        break;
+
+    default:
+        arg_job.status = SIGD_ERROR;
+    }
+}
+
+
+
+EE488::sigdstats_t EE488::SignDaemon::get_stats() const {
+    return { nrequests.load(), nbatches.load(), nlargest.load(), nconns.load() };
+}
@@ -0,0 +1,202 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_SIGD_H
+#define __EE488_SIGD_H
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./schnorr.h"
+#include "./pool.h"
+#include "./wire.h"
+
+
+namespace EE488 {
+
+    /*
+     * Daemon protocol
+     *  Frames over a UNIX stream socket, integers big-endian as wire.h. len
+     *  counts the bytes after itself. A client may send any number of
+     *  requests before reading, and replies come back in the order of the
+     *  requests of the connection, with the same seq.
+     *
+     *  Request: len (u32) | op (u8) | seq (u32) | key id (u64) | bitn (u16) | body
+     *      's' sign  : message
+     *      'v' verify: signature record | message
+     *      'k' key   : none
+     *  Reply  : len (u32) | seq (u32) | status (u8) | body
+     *      's' signature record, 'k' domain record | public key record
+     */
+    const uint8_t SIGD_OP_SIGN = 's';
+    const uint8_t SIGD_OP_VERIFY = 'v';
+    const uint8_t SIGD_OP_KEY = 'k';
+
+    const uint8_t SIGD_OK = 0;              // Signed, verified, found
+    const uint8_t SIGD_NOT_VERIFIED = 1;
+    const uint8_t SIGD_NO_KEY = 2;
+    const uint8_t SIGD_ERROR = 0xff;
+
+    const size_t SIGD_REQ_HDR_LEN = 19;
+    const size_t SIGD_REPLY_HDR_LEN = 9;
+    const size_t SIGD_MAX_FRAME = 1 << 20;  // Longer closes the connection
+    const size_t SIGD_MAX_BUFFERED = 4 * SIGD_MAX_FRAME;   // Per connection and way
+
+    const size_t SIGD_BATCH_MAX = 256;      // Requests per batch
+    const long SIGD_BATCH_WAIT_US = 100;    // For more after the first
+
+    struct SigdRequest {
+        uint8_t op;
+        uint32_t seq;
+        uint64_t key_id;
+        int bitn;
+
+        const unsigned char* body;
+        size_t body_len;
+    };
+
+    struct SigdReply {
+        uint32_t seq;
+        uint8_t status;
+
+        const unsigned char* body;
+        size_t body_len;
+    };
+
+    /* Frames appended to a buffer. The body of a request is a || b, thus a
+     *  signature record and the message need no copy between them. */
+    void do_append_request(
+        std::vector<unsigned char>&,
+        const uint8_t, const uint32_t, const uint64_t, const int,
+        const unsigned char*, size_t,
+        const unsigned char* = nullptr, size_t = 0);
+
+    void do_append_reply(
+        std::vector<unsigned char>&,
+        const uint32_t, const uint8_t,
+        const unsigned char*, size_t);
+
+    /* Parsers return the bytes of a whole frame, 0 if cut short for now,
+     *  -1 if malformed. Views point into the buffer. */
+    long do_parse_request(const unsigned char*, size_t, SigdRequest&);
+    long do_parse_reply(const unsigned char*, size_t, SigdReply&);
+
+
+    struct SigdStats {
+        uint64_t requests;
+        uint64_t batches;
+        uint64_t largest;       // Requests in the largest batch
+        uint64_t connections;   // Accepted, so far
+    };
+
+    using sigdstats_t = SigdStats;
+
+
+    /*
+     * class SignDaemon
+     *  Holds keys by id and serves them over a UNIX socket. One thread polls
+     *  every connection, reading whatever has come. After the first bytes,
+     *  it keeps reading for up to batch_wait microseconds, or until idle,
+     *  then parses every whole frame of every connection into one batch,
+     *  signs and verifies it over the thread pool, and writes the replies of
+     *  each connection at once. Thus concurrent clients, and requests of one
+     *  client sent ahead, share the syscalls and the pool. Keys share their
+     *  domain, nonce pool and verify cache, all made once in the daemon.
+     *  A connection is not read while SIGD_MAX_BUFFERED of its requests
+     *  wait, and its requests are not parsed while as many bytes of its
+     *  replies are unsent, thus a client that sends without reading holds
+     *  a bounded amount of memory.
+     */
+    class SignDaemon {
+    private:
+        struct Conn {
+            int fd;
+            std::vector<unsigned char> in, out;
+            size_t in_len, parsed;      // in is grown, never shrunk
+            size_t out_off;
+            bool closing;
+        };
+
+        struct Job {
+            Conn* conn;
+            SigdRequest req;
+            uint8_t status;
+        };
+
+        std::unordered_map<uint64_t, std::shared_ptr<const skey_t>> keys;
+        std::vector<std::unique_ptr<Conn>> conns;
+
+        std::unique_ptr<ThreadPool> pool;   // nullptr, jobs in the poll thread
+        const size_t batch_max;
+        const long batch_wait;
+
+        std::vector<Job> jobs;
+        std::vector<ssig_t> slots;          // Of jobs, reused
+
+        std::string path;
+        int listen_fd;
+        int wake_fds[2];                    // do_stop to poll
+        std::atomic<bool> stopping;
+
+        std::atomic<uint64_t> nrequests, nbatches, nlargest, nconns;
+
+        bool do_poll(const long);
+        void do_accept();
+        bool do_read(Conn&);
+        bool do_write(Conn&);
+        void do_run_batch();
+        void do_run_job(Job&, ssig_t&) const;
+
+        size_t get_reply_len(const SigdRequest&) const;
+
+    public:
+        /* Threads of the pool, 0 for none, the requests per batch, and the
+         *  microseconds to wait for more after the first. */
+        SignDaemon(const size_t = 0, const size_t = SIGD_BATCH_MAX, const long = SIGD_BATCH_WAIT_US);
+        SignDaemon(const SignDaemon&) = delete;
+        ~SignDaemon();
+
+        SignDaemon& operator =(const SignDaemon&) = delete;
+
+        /* Before do_serve. A key without sk verifies only. */
+        int do_add_key(const uint64_t, std::shared_ptr<const skey_t>);
+
+        /* Binds the path, replacing a stale socket, of the mode given before
+         *  any connect, thus of the owner alone by default, whatever the
+         *  umask. Who may connect may sign. -1 on failure. */
+        int do_listen(const char*, const mode_t = 0600);
+
+        /* Serves until do_stop, then closes every connection. */
+        int do_serve();
+
+        /* From any thread, or a signal handler. */
+        void do_stop();
+
+        sigdstats_t get_stats() const;
+    };
+
+    using sigd_t = SignDaemon;
+}
+
+#endif
@@ -0,0 +1,278 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+/* Signing daemon.
+ *  Usage: ./sigd.run [--socket=PATH] [--keyring=PATH] [--generate]
+ *                    [--bits=N] [--keys=N] [--threads=N] [--batch=N]
+ *                    [--wait-us=N] [--cache-mb=N] [--nonces=N]
+ *
+ *  Loads its keys from a secret keyring (keyring.h), the same ids and keys
+ *  on every start, and serves them on the socket until SIGINT or SIGTERM.
+ *  With --generate, and no keyring at the path yet, it first makes one
+ *  domain of --bits and --keys keys in it with ids 1 to N, and writes
+ *  them there, of mode 0600, with the public keyring at PATH.pub for the
+ *  verifiers. Keys share the table of g, a nonce pool of --nonces pairs
+ *  and a verify cache of --cache-mb, 0 for none. Clients link sigclient.o,
+ *  refer to sigclient.h.
+ */
+
+#include <sys/stat.h>
+
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "schnorr.h"
+#include "noncepool.h"
+#include "keyring.h"
+#include "sigd.h"
+using namespace EE488;
+
+
+struct DaemonConfig {
+    std::string socket_path = "./sigd.sock";
+    std::string keyring_path = "./sigd.kr";
+    bool generate = false;
+    int bits = 2048;
+    int nkeys = 1;
+    int nthreads = 0;
+    int batch_max = static_cast<int>(SIGD_BATCH_MAX);
+    long wait_us = SIGD_BATCH_WAIT_US;
+    int cache_mb = 16;
+    int nnonces = static_cast<int>(NONCE_POOL_SIZE);
+};
+
+sigd_t* serving = nullptr;
+
+
+void do_on_signal(int) {
+    if (serving != nullptr)
+        serving->do_stop();
+}
+
+
+
+/*
+ * do_parse_args
+ */
+int do_parse_args(int argc, char* argv[], DaemonConfig& arg_cfg) {
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+
+        if (arg.rfind("--socket=", 0) == 0)
+            arg_cfg.socket_path = arg.substr(9);
+
+        else if (arg.rfind("--keyring=", 0) == 0)
+            arg_cfg.keyring_path = arg.substr(10);
+
+        else if (arg == "--generate")
+            arg_cfg.generate = true;
+
+        else if (arg.rfind("--bits=", 0) == 0)
+            arg_cfg.bits = std::stoi(arg.substr(7));
+
+        else if (arg.rfind("--keys=", 0) == 0)
+            arg_cfg.nkeys = std::stoi(arg.substr(7));
+
+        else if (arg.rfind("--threads=", 0) == 0)
+            arg_cfg.nthreads = std::stoi(arg.substr(10));
+
+        else if (arg.rfind("--batch=", 0) == 0)
+            arg_cfg.batch_max = std::stoi(arg.substr(8));
+
+        else if (arg.rfind("--wait-us=", 0) == 0)
+            arg_cfg.wait_us = std::stol(arg.substr(10));
+
+        else if (arg.rfind("--cache-mb=", 0) == 0)
+            arg_cfg.cache_mb = std::stoi(arg.substr(11));
+
+        else if (arg.rfind("--nonces=", 0) == 0)
+            arg_cfg.nnonces = std::stoi(arg.substr(9));
+
+        else {
+            std::cerr << "Usage: " << argv[0]
+                << " [--socket=PATH] [--keyring=PATH] [--generate]\n"
+                << "    [--bits=N] [--keys=N] [--threads=N] [--batch=N]\n"
+                << "    [--wait-us=N] [--cache-mb=N] [--nonces=N]\n";
+            return -1;
+        }
+    }
+
+    if (arg_cfg.bits < 512 || arg_cfg.nkeys < 1 || arg_cfg.nthreads < 0 ||
+        arg_cfg.batch_max < 1 || arg_cfg.wait_us < 0 || arg_cfg.cache_mb < 0 || arg_cfg.nnonces < 0) {
+        std::cerr << "Error, arguments out of range.\n";
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+/*
+ * do_generate_keyring
+ */
+int do_generate_keyring(const DaemonConfig& arg_cfg) {
+
+    /* Never over keys that exist, their ids are out there. */
+    struct stat st;
+    if (::stat(arg_cfg.keyring_path.c_str(), &st) == 0)
+        return 0;
+
+    /* The domain, once for every key */
+    SchnorrSignature manager;
+
+    if (manager.do_keygen(arg_cfg.bits, 0) != 0) {
+        std::cerr << "Error, keygen failed.\n";
+        return -1;
+    }
+
+    const skey_t first = manager.do_export_key(false);
+    const sdm_t* domain = first.get_domain();
+
+    const size_t nkeys = static_cast<size_t>(arg_cfg.nkeys);
+
+    std::vector<uint64_t> ids(nkeys);
+    std::vector<bnw_t> sks(nkeys), pks(nkeys);
+    std::vector<const BIGNUM*> psks(nkeys), ppks(nkeys);
+
+    int ret_code = 0;
+
+    for (size_t i = 0; i < nkeys; i++) {
+        ids[i] = i + 1;
+        psks[i] = sks[i].actor, ppks[i] = pks[i].actor;
+
+        if (do_rand_nonce(sks[i].actor, domain->get_q(), get_thread_ctx()) != 0 ||
+            domain->do_gexp(pks[i].actor, sks[i].actor, get_thread_ctx()) != 0)
+            ret_code = -1;
+    }
+
+    /* The public one first, a secret one alone would be of no verifier. */
+    const std::string pub_path = arg_cfg.keyring_path + ".pub";
+
+    if (ret_code != 0 ||
+        do_write_keyring(pub_path.c_str(), domain->get_p(), domain->get_q(), domain->get_g(),
+            domain->is_toy(), ids.data(), ppks.data(), nkeys) != 0 ||
+        do_write_keyring(arg_cfg.keyring_path.c_str(), domain->get_p(), domain->get_q(), domain->get_g(),
+            domain->is_toy(), ids.data(), psks.data(), nkeys, true) != 0) {
+        std::cerr << "Error, cannot write " << arg_cfg.keyring_path << ".\n";
+        ret_code = -1;
+    }
+
+    for (auto& sk: sks)
+        BN_clear(sk.actor);
+
+    return ret_code;
+}
+
+
+
+int main(int argc, char* argv[]) {
+
+    DaemonConfig cfg;
+
+    try {
+        if (do_parse_args(argc, argv, cfg) != 0)
+            return 1;
+    }
+    catch (const std::exception&) {
+        std::cerr << "Error, malformed number in arguments.\n";
+        return 1;
+    }
+
+    if (cfg.generate && do_generate_keyring(cfg) != 0)
+        return 1;
+
+    kring_t ring;
+
+    if (ring.do_open(cfg.keyring_path.c_str()) != 0 || !ring.is_secret()) {
+        std::cerr << "Error, " << cfg.keyring_path << " is not a secret keyring, "
+            << "--generate makes one.\n";
+        return 1;
+    }
+
+    /* The domain, once for every key, with the table of g for signing. */
+    auto domain = std::make_shared<const sdm_t>(
+        ring.get_domain()->get_p(), ring.get_domain()->get_q(), ring.get_domain()->get_g(),
+        ring.get_domain()->is_toy(), GTABLE_WBITS);
+
+    std::shared_ptr<NoncePool> nonce_pool;
+    std::shared_ptr<vcache_t> cache;
+
+    if (cfg.nnonces > 0)
+        nonce_pool = std::make_shared<NoncePool>(domain, cfg.nnonces);
+
+    if (cfg.cache_mb > 0)
+        cache = std::make_shared<vcache_t>(static_cast<size_t>(cfg.cache_mb) << 20);
+
+    sigd_t daemon(cfg.nthreads, cfg.batch_max, cfg.wait_us);
+
+    /* Every key of the keyring by its id, pk made again from sk. */
+    for (uint64_t i = 0; i < ring.get_nkeys(); i++) {
+        uint64_t id;
+        WirePkView view;
+        bnw_t sk, pk;
+
+        if (ring.do_get_slot(i, id, view) != 0 ||
+            do_load_pk(view, sk.actor) != 0 ||
+            BN_is_zero(sk.actor) || BN_cmp(sk.actor, domain->get_q()) >= 0 ||
+            domain->do_gexp(pk.actor, sk.actor, get_thread_ctx()) != 0) {
+            std::cerr << "Error, key " << i << " of " << cfg.keyring_path << " is malformed.\n";
+            return 1;
+        }
+
+        auto key = std::make_shared<skey_t>(domain, pk.actor, sk.actor);
+        BN_clear(sk.actor);
+
+        key->set_nonce_pool(nonce_pool);
+        key->set_verify_cache(cache);
+
+        if (daemon.do_add_key(id, key) != 0) {
+            std::cerr << "Error, key id " << id << " twice.\n";
+            return 1;
+        }
+    }
+
+    const uint64_t nkeys = ring.get_nkeys();
+    const int bits = BN_num_bits(domain->get_p());
+
+    ring.do_close();
+
+    if (daemon.do_listen(cfg.socket_path.c_str()) != 0) {
+        std::cerr << "Error, cannot listen on " << cfg.socket_path << ".\n";
+        return 1;
+    }
+
+    serving = &daemon;
+    std::signal(SIGINT, do_on_signal);
+    std::signal(SIGTERM, do_on_signal);
+
+    std::cerr << "Serving " << nkeys << " keys of " << bits << " bits on "
+        << cfg.socket_path << "\n";
+
+    daemon.do_serve();
+    serving = nullptr;
+
+    const sigdstats_t stats = daemon.get_stats();
+
+    std::cerr << stats.requests << " requests in " << stats.batches << " batches, largest "
+        << stats.largest << ", " << stats.connections << " connections\n";
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "./stats.h"
+
+
+namespace {
+
+    const char* stage_names[EE488::NSTAGES] = {
+        "keygen_params",
+        "keygen_key",
+        "sign_nonce",
+        "sign_commit",
+        "sign_hash",
+        "sign_final",
+        "verify_commit",
+        "verify_hash",
+        "hash"
+    };
+
+    const char* counter_names[EE488::NCOUNTERS] = {
+        "keygen",
+        "sign",
+        "verify",
+        "verify_fail",
+        "verify_cached",
+        "hash"
+    };
+
+#ifdef __STATS
+    /* Relaxed, thus a snapshot taken while others record may be slightly
+     *  inconsistent between fields. Each field is exact by itself. */
+    struct alignas(64) AtomicStage {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> total_ns;
+        std::atomic<uint64_t> max_ns;
+        std::atomic<uint64_t> buckets[EE488::STAT_NBUCKETS];
+    };
+
+    AtomicStage stages[EE488::NSTAGES];
+    std::atomic<uint64_t> counters[EE488::NCOUNTERS];
+#endif
+};
+
+
+
+/*
+ * Names */
+const char* EE488::get_stage_name(const int arg_stage) {
+    return (arg_stage >= 0 && arg_stage < NSTAGES) ? stage_names[arg_stage] : "unknown";
+}
+
+
+
+const char* EE488::get_counter_name(const int arg_counter) {
+    return (arg_counter >= 0 && arg_counter < NCOUNTERS) ? counter_names[arg_counter] : "unknown";
+}
+
+
+
+uint64_t EE488::StageStat::get_percentile_ns(const double arg_p) const {
+
+    if (count == 0)
+        return 0;
+
+    const uint64_t rank = static_cast<uint64_t>(arg_p * count + 0.5);
+    uint64_t seen = 0;
+
+    for (int i = 0; i < STAT_NBUCKETS; i++) {
+        seen += buckets[i];
+
+        if (seen >= rank && seen > 0)
+            return std::min(max_ns, (uint64_t(1) << (i + 1)) - 1);
+    }
+
+    return max_ns;
+}
+
+
+
+/*
+ * Recording */
+#ifdef __STATS
+void EE488::do_stat_record(const int arg_stage, const uint64_t arg_ns) {
+
+    AtomicStage& st = stages[arg_stage];
+
+    int bucket = 0;
+    for (uint64_t v = arg_ns >> 1; v != 0 && bucket < STAT_NBUCKETS - 1; v >>= 1)
+        bucket++;
+
+    st.count.fetch_add(1, std::memory_order_relaxed);
+    st.total_ns.fetch_add(arg_ns, std::memory_order_relaxed);
+    st.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t prev = st.max_ns.load(std::memory_order_relaxed);
+    while (prev < arg_ns &&
+        !st.max_ns.compare_exchange_weak(prev, arg_ns, std::memory_order_relaxed));
+}
+
+
+
+void EE488::do_stat_count(const int arg_counter) {
+    counters[arg_counter].fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+
+
+/*
+ * Query */
+EE488::StatsSnapshot EE488::get_stats() {
+
+    StatsSnapshot snap;
+    std::memset(&snap, 0, sizeof(snap));
+
+#ifdef __STATS
+    snap.enabled = true;
+
+    for (int i = 0; i < NSTAGES; i++) {
+        snap.stages[i].count = stages[i].count.load(std::memory_order_relaxed);
+        snap.stages[i].total_ns = stages[i].total_ns.load(std::memory_order_relaxed);
+        snap.stages[i].max_ns = stages[i].max_ns.load(std::memory_order_relaxed);
+
+        for (int b = 0; b < STAT_NBUCKETS; b++)
+            snap.stages[i].buckets[b] = stages[i].buckets[b].load(std::memory_order_relaxed);
+    }
+
+    for (int i = 0; i < NCOUNTERS; i++)
+        snap.counters[i] = counters[i].load(std::memory_order_relaxed);
+#endif
+
+    return snap;
+}
+
+
+
+void EE488::reset_stats() {
+
+#ifdef __STATS
+    for (auto& st: stages) {
+        st.count = 0, st.total_ns = 0, st.max_ns = 0;
+        for (auto& b: st.buckets) b = 0;
+    }
+
+    for (auto& c: counters) c = 0;
+#endif
+}
@@ -0,0 +1,115 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_STATS_H
+#define __EE488_STATS_H
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace EE488 {
+
+    /*
+     * Per-stage timing and operation counters.
+     *  Compiled in only with __STATS (make STATS=1). Otherwise the macros
+     *  below are empty, and get_stats returns an empty snapshot with
+     *  enabled == false. Process-wide, shared by all instances and threads.
+     */
+    enum StatStage {
+        STAGE_KEYGEN_PARAMS = 0,    // p, q, g
+        STAGE_KEYGEN_KEY,           // sk, pk = g^sk
+        STAGE_SIGN_NONCE,           // k
+        STAGE_SIGN_COMMIT,          // r = g^k
+        STAGE_SIGN_HASH,            // e = H(m || r)
+        STAGE_SIGN_FINAL,           // s = k + sk * e mod q
+        STAGE_VERIFY_COMMIT,        // v = g^s * pk^(q - e)
+        STAGE_VERIFY_HASH,          // H(m || v)
+        STAGE_HASH,                 // do_hash
+        NSTAGES
+    };
+
+    enum StatCounter {
+        COUNT_KEYGEN = 0,
+        COUNT_SIGN,
+        COUNT_VERIFY,
+        COUNT_VERIFY_FAIL,          // Not verified, or error
+        COUNT_VERIFY_CACHED,        // Verified by a VerifyCache
+        COUNT_HASH,
+        NCOUNTERS
+    };
+
+    /* Bucket i holds latencies in [2^i, 2^(i+1)) ns. */
+    const int STAT_NBUCKETS = 40;
+
+    struct StageStat {
+        uint64_t count;
+        uint64_t total_ns;
+        uint64_t max_ns;
+        uint64_t buckets[STAT_NBUCKETS];
+
+        double get_mean_ns() const { return count ? static_cast<double>(total_ns) / count : 0; }
+        uint64_t get_percentile_ns(const double) const;    // Upper bound of the bucket
+    };
+
+    struct StatsSnapshot {
+        bool enabled;
+        StageStat stages[NSTAGES];
+        uint64_t counters[NCOUNTERS];
+    };
+
+    const char* get_stage_name(const int);
+    const char* get_counter_name(const int);
+
+    StatsSnapshot get_stats();
+    void reset_stats();
+
+#ifdef __STATS
+    void do_stat_record(const int, const uint64_t);
+    void do_stat_count(const int);
+
+    /*
+     * class StatTimer
+     *  Each do_lap records the time since the previous lap (or construction)
+     *  to the stage, thus consecutive stages of an operation are split.
+     */
+    class StatTimer {
+    private:
+        std::chrono::steady_clock::time_point last;
+
+    public:
+        StatTimer() : last(std::chrono::steady_clock::now()) {}
+
+        void do_lap(const int arg_stage) {
+            auto now = std::chrono::steady_clock::now();
+            do_stat_record(arg_stage,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+            last = now;
+        }
+    };
+
+#define __STAT_TIMER__(T)       EE488::StatTimer T
+#define __STAT_LAP__(T, S)      (T).do_lap(S)
+#define __STAT_COUNT__(C)       EE488::do_stat_count(C)
+#else
+#define __STAT_TIMER__(T)
+#define __STAT_LAP__(T, S)      ((void)0)
+#define __STAT_COUNT__(C)       ((void)0)
+#endif
+}
+
+#endif
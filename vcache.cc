@@ -0,0 +1,164 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <cstring>
+
+#include "./vcache.h"
+
+
+/*
+ * VerifyCache Actions */
+EE488::VerifyCache::VerifyCache(const size_t arg_bytes) : nbuckets(VCACHE_SHARDS) {
+
+    while (nbuckets * 2 * sizeof(Bucket) <= arg_bytes)
+        nbuckets *= 2;
+
+    buckets.reset(new Bucket[nbuckets]);
+    do_clear();
+}
+
+
+
+size_t EE488::VerifyCache::get_bucket(const unsigned char* arg_key) const {
+
+    uint64_t head;
+    std::memcpy(&head, arg_key, sizeof(head));
+
+    return static_cast<size_t>(head) & (nbuckets - 1);
+}
+
+
+
+/*
+ * do_lookup
+ */
+bool EE488::VerifyCache::do_lookup(const unsigned char* arg_key) {
+
+    const size_t b = get_bucket(arg_key);
+    Bucket& bucket = buckets[b];
+    Shard& shard = shards[b & (VCACHE_SHARDS - 1)];
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    for (size_t i = 0; i < VCACHE_WAYS; i++) {
+        if ((bucket.used >> i & 1) &&
+            std::memcmp(bucket.keys[i], arg_key, VCACHE_KEY_LEN) == 0) {
+
+            bucket.ref |= static_cast<uint8_t>(1 << i);
+            shard.hits++;
+
+            return true;
+        }
+    }
+
+    shard.misses++;
+    return false;
+}
+
+
+
+/*
+ * do_insert
+ */
+void EE488::VerifyCache::do_insert(const unsigned char* arg_key) {
+
+    const size_t b = get_bucket(arg_key);
+    Bucket& bucket = buckets[b];
+    Shard& shard = shards[b & (VCACHE_SHARDS - 1)];
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    size_t way = VCACHE_WAYS;
+
+    for (size_t i = 0; i < VCACHE_WAYS; i++) {
+        if (!(bucket.used >> i & 1)) {
+            if (way == VCACHE_WAYS) way = i;
+            continue;
+        }
+
+        /* Another thread has verified the same. */
+        if (std::memcmp(bucket.keys[i], arg_key, VCACHE_KEY_LEN) == 0) {
+            bucket.ref |= static_cast<uint8_t>(1 << i);
+            return;
+        }
+    }
+
+    if (way == VCACHE_WAYS) {
+        /* CLOCK, the hand clears reference bits until one is clear. Ends
+         *  within a round, the clearing of the first. */
+        while (bucket.ref >> bucket.hand & 1) {
+            bucket.ref &= static_cast<uint8_t>(~(1 << bucket.hand));
+            bucket.hand = static_cast<uint8_t>((bucket.hand + 1) % VCACHE_WAYS);
+        }
+
+        way = bucket.hand;
+        bucket.hand = static_cast<uint8_t>((bucket.hand + 1) % VCACHE_WAYS);
+
+        shard.evictions++;
+    }
+    else shard.entries++;
+
+    std::memcpy(bucket.keys[way], arg_key, VCACHE_KEY_LEN);
+
+    bucket.used |= static_cast<uint8_t>(1 << way);
+    bucket.ref &= static_cast<uint8_t>(~(1 << way));    // Once more to stay
+
+    shard.inserts++;
+}
+
+
+
+/*
+ * do_clear
+ */
+void EE488::VerifyCache::do_clear() {
+
+    for (size_t s = 0; s < VCACHE_SHARDS; s++) {
+        std::lock_guard<std::mutex> guard(shards[s].lock);
+
+        for (size_t b = s; b < nbuckets; b += VCACHE_SHARDS)
+            buckets[b].used = buckets[b].ref = buckets[b].hand = 0;
+
+        shards[s].hits = shards[s].misses = 0;
+        shards[s].inserts = shards[s].evictions = 0;
+        shards[s].entries = 0;
+    }
+}
+
+
+
+/*
+ * get_stats
+ */
+EE488::vcstats_t EE488::VerifyCache::get_stats() {
+
+    vcstats_t stats = {};
+
+    for (size_t s = 0; s < VCACHE_SHARDS; s++) {
+        std::lock_guard<std::mutex> guard(shards[s].lock);
+
+        stats.hits += shards[s].hits;
+        stats.misses += shards[s].misses;
+        stats.inserts += shards[s].inserts;
+        stats.evictions += shards[s].evictions;
+        stats.entries += shards[s].entries;
+    }
+
+    stats.capacity = get_capacity();
+    stats.bytes = get_bytes();
+
+    return stats;
+}
@@ -0,0 +1,111 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_VCACHE_H
+#define __EE488_VCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+
+namespace EE488 {
+
+    const size_t VCACHE_KEY_LEN = 32;       // SHA-256 of the tuple
+    const size_t VCACHE_WAYS = 4;           // Keys per bucket
+    const size_t VCACHE_SHARDS = 64;        // Locks
+    const size_t VCACHE_BYTES = 1 << 20;    // Default cap
+
+    /*
+     * struct VerifyCacheStats
+     *  Snapshot of a VerifyCache, summed over the shards.
+     */
+    struct VerifyCacheStats {
+        uint64_t hits, misses;
+        uint64_t inserts, evictions;
+
+        size_t entries;     // Now held
+        size_t capacity;    // At most
+        size_t bytes;       // Of the buckets
+
+        double get_hit_rate() const {
+            return (hits + misses) ? static_cast<double>(hits) / (hits + misses) : 0.0;
+        }
+    };
+
+    using vcstats_t = VerifyCacheStats;
+
+
+    /*
+     * class VerifyCache
+     *  Digests of (domain, pk, H(m), s, e) that have verified, thus verify
+     *  again without any exponentiation. Only positive results go in, a
+     *  miss is always a full verify. Set-associative, a key has one bucket
+     *  of VCACHE_WAYS keys by its first bytes, already uniform as a hash,
+     *  and CLOCK within the bucket picks whom to evict. A bucket is three
+     *  cache lines, and lookups touch nothing else. Buckets are striped
+     *  over VCACHE_SHARDS locks, with the counters of each under its lock.
+     */
+    class VerifyCache {
+    private:
+        struct alignas(64) Bucket {
+            unsigned char keys[VCACHE_WAYS][VCACHE_KEY_LEN];
+            uint8_t used, ref;      // A bit per way
+            uint8_t hand;
+        };
+
+        struct alignas(64) Shard {
+            std::mutex lock;
+            uint64_t hits, misses;
+            uint64_t inserts, evictions;
+            size_t entries;
+        };
+
+        std::unique_ptr<Bucket[]> buckets;
+        size_t nbuckets;
+
+        Shard shards[VCACHE_SHARDS];
+
+        size_t get_bucket(const unsigned char*) const;
+
+    public:
+        /* Buckets as many as fit in arg_bytes, a power of two, at least one
+         *  per shard. */
+        VerifyCache(const size_t = VCACHE_BYTES);
+        VerifyCache(const VerifyCache&) = delete;
+
+        VerifyCache& operator =(const VerifyCache&) = delete;
+
+        /* true if the key has verified before, and marks it recently used. */
+        bool do_lookup(const unsigned char*);
+
+        /* Adds a key that has verified, evicting one of its bucket if full. */
+        void do_insert(const unsigned char*);
+
+        void do_clear();
+
+        vcstats_t get_stats();
+
+        size_t get_capacity() const { return nbuckets * VCACHE_WAYS; }
+        size_t get_bytes() const { return nbuckets * sizeof(Bucket); }
+    };
+
+    using vcache_t = VerifyCache;
+}
+
+#endif
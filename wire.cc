@@ -0,0 +1,259 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#include <algorithm>
+
+#include "./wire.h"
+
+
+namespace {
+
+    inline void do_put_u16(unsigned char* arg_out, const size_t arg_val) {
+        arg_out[0] = static_cast<unsigned char>(arg_val >> 8);
+        arg_out[1] = static_cast<unsigned char>(arg_val);
+    }
+
+    inline size_t do_get_u16(const unsigned char* arg_in) {
+        return (static_cast<size_t>(arg_in[0]) << 8) | arg_in[1];
+    }
+
+    inline void do_put_header(unsigned char* arg_out, const uint8_t arg_tag, const size_t arg_w) {
+        arg_out[0] = arg_tag;
+        arg_out[1] = EE488::WIRE_VERSION;
+        do_put_u16(arg_out + 2, arg_w);
+    }
+
+    /* Width of the record, 0 if the header is not of the tag. */
+    inline size_t do_check_header(const unsigned char* arg_in, size_t arg_len, const uint8_t arg_tag) {
+        if (arg_len < EE488::WIRE_HDR_LEN ||
+            arg_in[0] != arg_tag ||
+            arg_in[1] != EE488::WIRE_VERSION)
+            return 0;
+
+        return do_get_u16(arg_in + 2);
+    }
+
+    /* BN_bn2binpad fails when the number is longer than the width. */
+    inline bool do_put_bn(unsigned char* arg_out, const BIGNUM* arg_num, const size_t arg_w) {
+        return BN_bn2binpad(arg_num, arg_out, static_cast<int>(arg_w)) == static_cast<int>(arg_w);
+    }
+};
+
+
+
+/*
+ * Widths */
+size_t EE488::get_sig_width(const BIGNUM* arg_q) {
+    return std::max<size_t>(BN_num_bytes(arg_q), SHA256_DIGEST_LENGTH);
+}
+
+
+
+size_t EE488::get_pk_width(const BIGNUM* arg_p) {
+    return BN_num_bytes(arg_p);
+}
+
+
+
+/*
+ * Encoders */
+int EE488::do_encode_sig(
+    unsigned char* arg_out, size_t arg_cap, const BIGNUM* arg_s, const BIGNUM* arg_e, const size_t arg_w) {
+
+    const size_t len = get_sig_len(arg_w);
+
+    if (arg_w == 0 || arg_w > WIRE_MAX_WIDTH || arg_cap < len)
+        return -1;
+
+    do_put_header(arg_out, WIRE_TAG_SIG, arg_w);
+
+    if (!do_put_bn(arg_out + WIRE_HDR_LEN, arg_s, arg_w) ||
+        !do_put_bn(arg_out + WIRE_HDR_LEN + arg_w, arg_e, arg_w))
+        return -1;
+
+    return static_cast<int>(len);
+}
+
+
+
+int EE488::do_encode_pk(unsigned char* arg_out, size_t arg_cap, const BIGNUM* arg_pk, const size_t arg_w) {
+
+    const size_t len = get_pk_len(arg_w);
+
+    if (arg_w == 0 || arg_w > WIRE_MAX_WIDTH || arg_cap < len)
+        return -1;
+
+    do_put_header(arg_out, WIRE_TAG_PK, arg_w);
+
+    if (!do_put_bn(arg_out + WIRE_HDR_LEN, arg_pk, arg_w))
+        return -1;
+
+    return static_cast<int>(len);
+}
+
+
+
+int EE488::do_encode_pqg(
+    unsigned char* arg_out, size_t arg_cap, const BIGNUM* arg_p, const BIGNUM* arg_q, const BIGNUM* arg_g) {
+
+    const size_t w = BN_num_bytes(arg_p);
+    const size_t wq = BN_num_bytes(arg_q);
+    const size_t len = get_pqg_len(w, wq);
+
+    if (w == 0 || wq == 0 || w > WIRE_MAX_WIDTH || wq > WIRE_MAX_WIDTH || arg_cap < len)
+        return -1;
+
+    do_put_header(arg_out, WIRE_TAG_PQG, w);
+    do_put_u16(arg_out + WIRE_HDR_LEN, wq);
+
+    unsigned char* pos = arg_out + WIRE_HDR_LEN + 2;
+
+    if (!do_put_bn(pos, arg_p, w) ||
+        !do_put_bn(pos + w, arg_q, wq) ||
+        !do_put_bn(pos + w + wq, arg_g, w))
+        return -1;
+
+    return static_cast<int>(len);
+}
+
+
+
+/*
+ * Parsers */
+int EE488::do_parse_sig(const unsigned char* arg_in, size_t arg_len, WireSigView& arg_view) {
+
+    const size_t w = do_check_header(arg_in, arg_len, WIRE_TAG_SIG);
+
+    if (w == 0 || arg_len < get_sig_len(w))
+        return -1;
+
+    arg_view.s = arg_in + WIRE_HDR_LEN;
+    arg_view.e = arg_view.s + w;
+    arg_view.width = w;
+
+    return static_cast<int>(get_sig_len(w));
+}
+
+
+
+int EE488::do_parse_pk(const unsigned char* arg_in, size_t arg_len, WirePkView& arg_view) {
+
+    const size_t w = do_check_header(arg_in, arg_len, WIRE_TAG_PK);
+
+    if (w == 0 || arg_len < get_pk_len(w))
+        return -1;
+
+    arg_view.pk = arg_in + WIRE_HDR_LEN;
+    arg_view.width = w;
+
+    return static_cast<int>(get_pk_len(w));
+}
+
+
+
+int EE488::do_parse_pqg(const unsigned char* arg_in, size_t arg_len, WirePqgView& arg_view) {
+
+    const size_t w = do_check_header(arg_in, arg_len, WIRE_TAG_PQG);
+
+    if (w == 0 || arg_len < WIRE_HDR_LEN + 2)
+        return -1;
+
+    const size_t wq = do_get_u16(arg_in + WIRE_HDR_LEN);
+
+    if (wq == 0 || arg_len < get_pqg_len(w, wq))
+        return -1;
+
+    arg_view.p = arg_in + WIRE_HDR_LEN + 2;
+    arg_view.q = arg_view.p + w;
+    arg_view.g = arg_view.q + wq;
+    arg_view.width = w;
+    arg_view.q_width = wq;
+
+    return static_cast<int>(get_pqg_len(w, wq));
+}
+
+
+
+/*
+ * Loaders */
+int EE488::do_load_sig(const WireSigView& arg_view, BIGNUM* arg_s, BIGNUM* arg_e) {
+
+    const int w = static_cast<int>(arg_view.width);
+
+    if (BN_bin2bn(arg_view.s, w, arg_s) == nullptr ||
+        BN_bin2bn(arg_view.e, w, arg_e) == nullptr)
+        return -1;
+
+    return 0;
+}
+
+
+
+int EE488::do_load_pk(const WirePkView& arg_view, BIGNUM* arg_pk) {
+    return BN_bin2bn(arg_view.pk, static_cast<int>(arg_view.width), arg_pk) == nullptr ? -1 : 0;
+}
+
+
+
+int EE488::do_load_pqg(const WirePqgView& arg_view, BIGNUM* arg_p, BIGNUM* arg_q, BIGNUM* arg_g) {
+
+    const int w = static_cast<int>(arg_view.width);
+
+    if (BN_bin2bn(arg_view.p, w, arg_p) == nullptr ||
+        BN_bin2bn(arg_view.q, static_cast<int>(arg_view.q_width), arg_q) == nullptr ||
+        BN_bin2bn(arg_view.g, w, arg_g) == nullptr)
+        return -1;
+
+    return 0;
+}
+
+
+
+/*
+ * Bulk */
+long EE488::do_encode_sigs(
+    unsigned char* arg_out, size_t arg_cap, const ssig_t* arg_sigs, const size_t arg_n, const size_t arg_w) {
+
+    const size_t len = get_sig_len(arg_w);
+
+    if (arg_cap < len * arg_n)
+        return -1;
+
+    for (size_t i = 0; i < arg_n; i++)
+        if (do_encode_sig(arg_out + i * len, len, arg_sigs[i].s.actor, arg_sigs[i].e.actor, arg_w) < 0)
+            return -1;
+
+    return static_cast<long>(len * arg_n);
+}
+
+
+
+long EE488::do_decode_sigs(const unsigned char* arg_in, size_t arg_len, ssig_t* arg_sigs, const size_t arg_n) {
+
+    size_t pos = 0;
+    WireSigView view;
+
+    for (size_t i = 0; i < arg_n; i++) {
+        const int nread = do_parse_sig(arg_in + pos, arg_len - pos, view);
+
+        if (nread < 0 || do_load_sig(view, arg_sigs[i].s.actor, arg_sigs[i].e.actor) != 0)
+            return -1;
+
+        pos += nread;
+    }
+
+    return static_cast<long>(pos);
+}
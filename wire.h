@@ -0,0 +1,102 @@
+/* Author: SukJoon Oh
+ * Test Environment:
+ *  - Manjaro Quonos 21.2, Native Desktop
+ *      g++ (GCC) 11.2.0,
+ *      OpenSSL 1.1.1n
+ *      (comes default in coreutils, no additional installation needed)
+ *  - Ubuntu 20.04.4 LTS (Focal Fossa), VM Instance
+ *      g++ (GCC) 9.4.0
+ *      OpenSSL 1.1.1f
+ *      libssl-dev needed, not default in RAW Ubuntu 20.04.
+ *          run: apt install libssl-dev
+ * Compilation Option: -lssl -lcrypto -pthread
+ *      Please compile with -std=c++17.
+ *      Refer to Makefile for more information.
+ * Legal Stuff: None
+ */
+
+#ifndef __EE488_WIRE_H
+#define __EE488_WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "./schnorr.h"
+
+
+namespace EE488 {
+
+    /*
+     * Wire format
+     *  All integers are big-endian. Every record starts with a 4 byte header,
+     *  a tag, the version, and the width w (u16) of the numbers that follow.
+     *  Each number is left-padded with zeros to its width, thus a record has
+     *  a fixed size for a given domain, and n records sit at i * size.
+     *
+     *  Signature : 'S' | ver | w | s[w] | e[w]         w = get_sig_width(q)
+     *  Public key: 'K' | ver | w | pk[w]               w = get_pk_width(p)
+     *  Domain    : 'D' | ver | w | wq (u16) | p[w] | q[wq] | g[w]
+     */
+    const uint8_t WIRE_VERSION = 2;     // 2: e hashes r padded to |p|
+
+    const uint8_t WIRE_TAG_SIG = 'S';
+    const uint8_t WIRE_TAG_PK  = 'K';
+    const uint8_t WIRE_TAG_PQG = 'D';
+
+    const size_t WIRE_HDR_LEN = 4;
+    const size_t WIRE_MAX_WIDTH = 0xffff;
+
+    /*
+     * Views
+     *  Point into the parsed buffer, nothing is copied. Valid as long as
+     *  the buffer is. do_load_* then reads the numbers straight from it.
+     */
+    struct WireSigView {
+        const unsigned char* s;
+        const unsigned char* e;
+        size_t width;
+    };
+
+    struct WirePkView {
+        const unsigned char* pk;
+        size_t width;
+    };
+
+    struct WirePqgView {
+        const unsigned char* p;
+        const unsigned char* q;
+        const unsigned char* g;
+        size_t width, q_width;
+    };
+
+    /* Widths. e is a full SHA-256 unless toyed, thus may be longer than q. */
+    size_t get_sig_width(const BIGNUM*);    // Of q
+    size_t get_pk_width(const BIGNUM*);     // Of p
+
+    /* Record sizes */
+    inline size_t get_sig_len(const size_t arg_w) { return WIRE_HDR_LEN + 2 * arg_w; }
+    inline size_t get_pk_len(const size_t arg_w) { return WIRE_HDR_LEN + arg_w; }
+    inline size_t get_pqg_len(const size_t arg_w, const size_t arg_wq) { return WIRE_HDR_LEN + 2 + 2 * arg_w + arg_wq; }
+
+    /* Encoders return the number of bytes written, -1 if the buffer is too
+     *  short or a number does not fit the width. */
+    int do_encode_sig(unsigned char*, size_t, const BIGNUM*, const BIGNUM*, const size_t);
+    int do_encode_pk(unsigned char*, size_t, const BIGNUM*, const size_t);
+    int do_encode_pqg(unsigned char*, size_t, const BIGNUM*, const BIGNUM*, const BIGNUM*);
+
+    /* Parsers return the number of bytes consumed, -1 if malformed. */
+    int do_parse_sig(const unsigned char*, size_t, WireSigView&);
+    int do_parse_pk(const unsigned char*, size_t, WirePkView&);
+    int do_parse_pqg(const unsigned char*, size_t, WirePqgView&);
+
+    int do_load_sig(const WireSigView&, BIGNUM*, BIGNUM*);
+    int do_load_pk(const WirePkView&, BIGNUM*);
+    int do_load_pqg(const WirePqgView&, BIGNUM*, BIGNUM*, BIGNUM*);
+
+    /* Bulk, n records of get_sig_len(w) bytes back to back. Decoding into
+     *  the same slots again does not allocate. Returns the bytes done, or -1. */
+    long do_encode_sigs(unsigned char*, size_t, const ssig_t*, const size_t, const size_t);
+    long do_decode_sigs(const unsigned char*, size_t, ssig_t*, const size_t);
+}
+
+#endif